@@ -6,12 +6,35 @@
 #include "dialog.hpp"
 #include "internal.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 namespace irt {
 
 bool application::init()
 {
     c_editor.init();
 
+    // Keep a core for the graphical user interface.
+    const auto threads = std::thread::hardware_concurrency();
+    task_manager_parameters task_init{
+        .thread_number           = threads > 2 ? static_cast<i32>(threads) - 1
+                                               : 1,
+        .simple_task_list_number = 1,
+        .multi_task_list_number  = 0
+    };
+
+    if (auto ret = task_mgr.init(task_init); is_bad(ret)) {
+        log_w.log(
+          2, "Fail to start simulation workers: %s\n", status_string(ret));
+        return false;
+    }
+
+    for (auto& w : task_mgr.workers)
+        w.task_lists.emplace_back(&task_mgr.task_lists[0]);
+    task_mgr.start();
+
     if (auto ret = editors.init(50u); is_bad(ret)) {
         log_w.log(2, "Fail to initialize irritator: %s\n", status_string(ret));
         std::fprintf(
@@ -64,6 +87,14 @@ bool application::init()
         log_w.log(7, "Add component directory: %s\n", new_dir.path.c_str());
     }
 
+    if (auto ret = c_editor.sim.init(256u * 64u, 32768u); is_bad(ret)) {
+        log_w.log(2,
+                  "Fail to initialize component simulation: %s\n",
+                  status_string(ret));
+        return false;
+    }
+
+    c_editor.mod.task_mgr = &task_mgr;
     c_editor.mod.fill_components();
     c_editor.mod.head           = undefined<tree_node_id>();
     c_editor.selected_component = undefined<tree_node_id>();
@@ -124,8 +155,8 @@ bool application::show()
     while (editors.next(ed)) {
         if (ed->show) {
             if (!ed->show_window()) {
-                editor* next = ed;
-                editors.next(next);
+                // next() resumes at the freed position, filled by the last
+                // editor.
                 free_editor(*ed);
             } else {
                 if (ed->show_settings)
@@ -169,6 +200,8 @@ editor* application::alloc_editor()
         return nullptr;
     }
 
+    ed.runner.tasks = &task_mgr.task_lists[0];
+
     log_w.log(5, "Open editor %s\n", ed.name.c_str());
     return &ed;
 }
@@ -176,6 +209,7 @@ editor* application::alloc_editor()
 void application::free_editor(editor& ed)
 {
     log_w.log(5, "Close editor %s\n", ed.name.c_str());
+    ed.stop_simulation();
     editors.free(ed);
 }
 
@@ -230,105 +264,354 @@ void application::show_settings_window()
 
 void application::shutdown()
 {
+    editor* ed = nullptr;
+    while (editors.next(ed))
+        ed->stop_simulation();
+
+    task_mgr.finalize();
+
     c_editor.shutdown();
     editors.clear();
     log_w.clear();
 }
 
-static void run_for(editor& ed, long long int duration_in_microseconds) noexcept
+//! Incremented by the workers, outlives the editors: the graphical user
+//! interface waits on it instead of a runner state destroyed with its editor.
+static std::atomic<u32> simulation_runner_epoch = 0u;
+
+void notify_simulation_runners() noexcept
+{
+    simulation_runner_epoch.fetch_add(1u, std::memory_order_release);
+    simulation_runner_epoch.notify_all();
+}
+
+static bool is_running(const editor_status st) noexcept
+{
+    return match(st,
+                 editor_status::running,
+                 editor_status::running_1_step,
+                 editor_status::running_10_step,
+                 editor_status::running_100_step);
+}
+
+static void apply_command(editor& ed, const simulation_command& cmd) noexcept
+{
+    auto& r = ed.runner;
+    r.speed = cmd.speed;
+
+    switch (cmd.type) {
+    case simulation_command_type::run:
+    case simulation_command_type::step:
+        if (r.st == editor_status::editing) {
+            r.begin  = cmd.begin;
+            r.events = -1;
+        }
+
+        r.end       = cmd.end;
+        r.remaining = cmd.bags;
+        r.st        = cmd.type == simulation_command_type::run
+                        ? editor_status::running
+                      : cmd.bags <= 1  ? editor_status::running_1_step
+                      : cmd.bags <= 10 ? editor_status::running_10_step
+                                       : editor_status::running_100_step;
+        break;
+
+    case simulation_command_type::pause:
+        if (is_running(r.st))
+            r.st = editor_status::running_pause;
+        break;
+
+    case simulation_command_type::stop:
+        if (r.st != editor_status::editing && r.events >= 0)
+            ed.sim.finalize(r.current);
+
+        r.current = r.begin;
+        r.events  = -1;
+        r.st      = editor_status::editing;
+        break;
+
+    case simulation_command_type::speed:
+        break;
+    }
+}
+
+//! Run the bags until @c events transitions (one bag with one event) and
+//! return false at the end of the simulation.
+static bool run_bags(editor& ed, const i64 events) noexcept
+{
+    auto& r      = ed.runner;
+    auto  budget = events;
+
+    r.sim_st = ed.sim.run_until(r.current, r.end, budget);
+    r.events += events - budget;
+
+    if (is_bad(r.sim_st) || r.current >= r.end) {
+        r.st = editor_status::editing;
+        ed.sim.finalize(r.end);
+        return false;
+    }
+
+    return true;
+}
+
+static void publish_snapshot(editor& ed) noexcept
+{
+    auto& r    = ed.runner;
+    auto& snap = r.snapshots.write_buffer();
+
+    snap.st        = r.st;
+    snap.sim_st    = r.sim_st;
+    snap.current   = r.current;
+    snap.events    = r.events;
+    snap.scheduled = ed.sim.sched.size();
+    snap.next_time =
+      ed.sim.sched.empty() ? time_domain<time>::infinity : ed.sim.sched.tn();
+
+    // The buffers keep their capacity: only the first snapshots allocate.
+    snap.indices.clear();
+    snap.models.clear();
+    snap.transitions.clear();
+
+    try {
+        for (const auto id : ed.sim.immediate_models)
+            snap.transitions.emplace_back(get_index(id));
+
+        // The indices may be older than a clear of the simulation.
+        r.watched.update();
+        for (const auto index : r.watched.read_buffer()) {
+            if (index >= ed.sim.models.max_used())
+                break;
+
+            if (auto* mdl = ed.sim.models.try_to_get(index); mdl) {
+                snap.indices.emplace_back(index);
+                snap.models.emplace_back(*mdl);
+            }
+        }
+    } catch (const std::bad_alloc& /*e*/) {
+        snap.indices.clear();
+        snap.models.clear();
+        snap.transitions.clear();
+    }
+
+    r.snapshots.publish();
+}
+
+//! Run the simulation of the editor during 10ms (or less with a speed lower
+//! than one) or the number of bags of a step, then publish a snapshot.
+static void run_simulation_slice(void* parameter) noexcept
 {
     namespace stdc = std::chrono;
 
-    auto          start_at             = stdc::high_resolution_clock::now();
-    long long int duration_since_start = 0;
+    auto& ed = *reinterpret_cast<editor*>(parameter);
+    auto& r  = ed.runner;
 
-    if (ed.simulation_bag_id < 0) {
+    simulation_command cmd;
+    while (r.commands.pop(cmd))
+        apply_command(ed, cmd);
+
+    if (is_running(r.st) && r.events < 0) {
         ed.sim.clean();
-        ed.simulation_current     = ed.simulation_begin;
-        ed.simulation_during_date = ed.simulation_begin;
-        ed.models_make_transition.resize(ed.sim.models.capacity(), false);
+        r.current = r.begin;
 
-        if (ed.sim_st = ed.sim.initialize(ed.simulation_current);
-            irt::is_bad(ed.sim_st)) {
-            log_w.log(3,
-                      "Simulation initialisation failure (%s)\n",
-                      irt::status_string(ed.sim_st));
-            return;
-        }
+        if (r.sim_st = ed.sim.initialize(r.current); is_bad(r.sim_st))
+            r.st = editor_status::editing;
+        else
+            r.events = 0;
+    }
+
+    if (r.st == editor_status::running) {
+        const auto start_at = stdc::steady_clock::now();
+        const auto budget   = stdc::microseconds(
+          static_cast<long long int>(10000.f * std::min(r.speed, 1.f)));
+
+        // Check the clock every 1024 transitions or every bag when slowed.
+        const i64 events = r.speed >= 1.f ? 1024 : 1;
+
+        while (run_bags(ed, events) &&
+               stdc::steady_clock::now() - start_at < budget)
+            ;
+    } else if (is_running(r.st)) {
+        for (; r.remaining > 0; --r.remaining)
+            if (!run_bags(ed, 1))
+                break;
 
-        ed.simulation_next_time = ed.sim.sched.empty()
-                                    ? time_domain<time>::infinity
-                                    : ed.sim.sched.tn();
-        ed.simulation_bag_id    = 0;
+        if (r.st != editor_status::editing)
+            r.st = editor_status::running_pause;
     }
 
-    if (ed.st == editor_status::running) {
-        do {
-            ++ed.simulation_bag_id;
-            if (ed.sim_st = ed.sim.run(ed.simulation_current);
-                is_bad(ed.sim_st)) {
-                ed.st = editor_status::editing;
-                ed.sim.finalize(ed.simulation_end);
-                return;
-            }
+    publish_snapshot(ed);
 
-            if (ed.simulation_current >= ed.simulation_end) {
-                ed.st = editor_status::editing;
-                ed.sim.finalize(ed.simulation_end);
-                return;
-            }
+    if (r.st == editor_status::running && r.speed >= 1.f) {
+        r.tasks->add(&run_simulation_slice, parameter);
+        return;
+    }
+
+    // Release the simulation: the graphical user interface wakes up the
+    // waiting simulations at the next frame.
+    r.state.store(r.st == editor_status::running ? runner_state::waiting
+                                                 : runner_state::idle,
+                  std::memory_order_release);
+
+    // The editor may be destroyed as soon as the state is idle.
+    notify_simulation_runners();
+}
+
+//! Give the simulation to a worker if the graphical user interface owns it
+//! or if it waits for the next frame.
+static void wake_simulation(editor& ed) noexcept
+{
+    auto& r = ed.runner;
 
-            auto end_at   = stdc::high_resolution_clock::now();
-            auto duration = end_at - start_at;
-            auto duration_cast =
-              stdc::duration_cast<stdc::microseconds>(duration);
-            duration_since_start = duration_cast.count();
-        } while (duration_since_start < duration_in_microseconds);
+    auto expected = runner_state::idle;
+    if (r.state.compare_exchange_strong(expected, runner_state::queued) ||
+        (expected == runner_state::waiting &&
+         r.state.compare_exchange_strong(expected, runner_state::queued)))
+        r.tasks->add(&run_simulation_slice, &ed);
+}
+
+void editor::request_simulation(simulation_command_type type, int bags) noexcept
+{
+    if (!runner.tasks)
+        return;
+
+    const simulation_command cmd{ .type  = type,
+                                  .bags  = bags,
+                                  .begin = simulation_begin,
+                                  .end   = simulation_end,
+                                  .speed = synchronize_timestep };
+
+    if (!runner.commands.push(cmd)) {
+        log_w.log(4, "Too many simulation commands\n");
         return;
     }
 
-    const int loop = ed.st == editor_status::running_1_step    ? 1
-                     : ed.st == editor_status::running_10_step ? 10
-                                                               : 100;
+    wake_simulation(*this);
+}
 
-    for (int i = 0; i < loop; ++i) {
-        ++ed.simulation_bag_id;
-        if (ed.sim_st = ed.sim.run(ed.simulation_current); is_bad(ed.sim_st)) {
-            ed.st = editor_status::editing;
-            ed.sim.finalize(ed.simulation_end);
-            return;
-        }
+static void push_data(std::vector<float>& xs,
+                      std::vector<float>& ys,
+                      const double        x,
+                      const double        y) noexcept
+{
+    if (xs.size() < xs.capacity()) {
+        xs.emplace_back(static_cast<float>(x));
+        ys.emplace_back(static_cast<float>(y));
+    }
+}
 
-        if (ed.simulation_current >= ed.simulation_end) {
-            ed.st = editor_status::editing;
-            ed.sim.finalize(ed.simulation_end);
-            return;
+//! Publish the indices of the models displayed by the node editor: the
+//! snapshots copy only these models.
+static void publish_watched_models(editor& ed) noexcept
+{
+    auto& watched = ed.runner.watched.write_buffer();
+    watched.clear();
+
+    if (ed.simulation_show_value && !ed.simplified_view) {
+        try {
+            for (const auto index : ed.visible_nodes)
+                watched.emplace_back(static_cast<u32>(index));
+        } catch (const std::bad_alloc& /*e*/) {
+            watched.clear();
         }
+
+        std::sort(watched.begin(), watched.end());
     }
 
-    ed.st = editor_status::running_pause;
+    ed.runner.watched.publish();
 }
 
-void application::run_simulations()
+void editor::update_simulation() noexcept
 {
-    auto running_simulation = 0.f;
+    const auto state = runner.state.load(std::memory_order_acquire);
+
+    plot_message msg;
+    while (runner.observations.pop(msg)) {
+        auto* out = plot_outs.try_to_get(msg.id);
+        if (!out)
+            continue;
+
+        switch (msg.type) {
+        case plot_message_type::initialize:
+            out->xs.clear();
+            out->ys.clear();
+            out->xs.reserve(4096u * 4096u);
+            out->ys.reserve(4096u * 4096u);
+            break;
+
+        case plot_message_type::truncate:
+            while (!out->xs.empty() && out->xs.back() == msg.x) {
+                out->xs.pop_back();
+                out->ys.pop_back();
+            }
+            break;
 
-    editor* ed = nullptr;
-    while (editors.next(ed))
-        if (ed->is_running())
-            ++running_simulation;
+        case plot_message_type::point:
+            push_data(out->xs, out->ys, msg.x, msg.y);
+            break;
+        }
+    }
+
+    // Clear the transitions of the previous snapshot before the update
+    // releases it.
+    for (const auto index : runner.snapshots.read_buffer().transitions)
+        if (index < models_make_transition.size())
+            models_make_transition[index] = false;
+
+    if (runner.snapshots.update()) {
+        const auto& snap = runner.snapshots.read_buffer();
+
+        if (is_bad(snap.sim_st) && is_success(sim_st))
+            log_w.log(3,
+                      "Simulation failure (%s)\n",
+                      irt::status_string(snap.sim_st));
+
+        st                   = snap.st;
+        sim_st               = snap.sim_st;
+        simulation_current   = snap.current;
+        simulation_next_time = snap.next_time;
+        simulation_events    = snap.events;
+        simulation_scheduled = snap.scheduled;
+
+    }
 
-    if (!running_simulation)
+    for (const auto index : runner.snapshots.read_buffer().transitions)
+        if (index < models_make_transition.size())
+            models_make_transition[index] = true;
+
+    publish_watched_models(*this);
+
+    // A command pushed when the worker was releasing the simulation.
+    if (state == runner_state::waiting ||
+        (state == runner_state::idle && !runner.commands.empty()))
+        wake_simulation(*this);
+}
+
+void editor::stop_simulation() noexcept
+{
+    if (!runner.tasks)
         return;
 
-    const auto duration = 10000.f / running_simulation;
+    request_simulation(simulation_command_type::stop);
+
+    // Drain the observations and wake a waiting simulation until the worker
+    // releases the simulation.
+    for (;;) {
+        const auto epoch =
+          simulation_runner_epoch.load(std::memory_order_acquire);
 
-    ed = nullptr;
+        update_simulation();
+        if (!is_simulation_owned())
+            break;
+
+        simulation_runner_epoch.wait(epoch, std::memory_order_acquire);
+    }
+}
+
+void application::update_simulations()
+{
+    editor* ed = nullptr;
     while (editors.next(ed))
-        if (ed->is_running())
-            run_for(
-              *ed,
-              static_cast<long long int>(duration * ed->synchronize_timestep));
+        ed->update_simulation();
 }
 
 editor* application::make_combo_editor_name(editor_id& current) noexcept
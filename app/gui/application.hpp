@@ -8,7 +8,10 @@
 #include <irritator/core.hpp>
 #include <irritator/external_source.hpp>
 #include <irritator/modeling.hpp>
+#include <irritator/thread.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <map>
@@ -129,6 +132,94 @@ void file_discrete_output_callback(const irt::observer&        obs,
                                    const irt::time             t,
                                    const irt::observer::status s);
 
+//! Commands sent by the graphical user interface to the worker running the
+//! simulation of an editor.
+enum class simulation_command_type
+{
+    run,
+    step,
+    pause,
+    stop,
+    speed
+};
+
+struct simulation_command
+{
+    simulation_command_type type  = simulation_command_type::pause;
+    int                     bags  = 0; // number of bags to run for step.
+    real                    begin = 0;
+    real                    end   = 10;
+    float                   speed = 1.f;
+};
+
+enum class plot_message_type
+{
+    initialize, // clear the plot.
+    truncate,   // remove the points at date x.
+    point       // add the point (x, y).
+};
+
+//! Observation sent by the worker to the @c plot_output.
+struct plot_message
+{
+    plot_output_id    id;
+    plot_message_type type = plot_message_type::point;
+    real              x    = 0;
+    real              y    = 0;
+};
+
+//! State of the simulation published by the worker after each slice.
+struct simulation_snapshot
+{
+    editor_status      st        = editor_status::editing;
+    status             sim_st    = status::success;
+    real               current   = 0;
+    real               next_time = 0;
+    i64                events    = 0;
+    sz                 scheduled = 0;
+    std::vector<u32>   indices;     // sorted indices of the watched models.
+    std::vector<model> models;      // copies of the watched models.
+    std::vector<u32>   transitions; // indices of the models of the last bag.
+};
+
+enum class runner_state
+{
+    idle,   // the graphical user interface owns the simulation.
+    queued, // a slice is in the task list or running.
+    waiting // a slower simulation waits for the next frame.
+};
+
+//! @brief Runs the simulation of an editor by slices on a worker.
+//!
+//! While the @c state is not idle, the worker owns the simulation: the
+//! graphical user interface sends commands, drains the observations, reads
+//! the snapshots and does not modify the simulation. The snapshots copy only
+//! the models of the @c watched indices published by the graphical user
+//! interface.
+struct simulation_runner
+{
+    spsc_queue<simulation_command>     commands;
+    spsc_queue<plot_message>           observations;
+    triple_buffer<simulation_snapshot> snapshots;
+    task_list*                         tasks = nullptr;
+    triple_buffer<std::vector<u32>>    watched; // sorted model indices.
+    std::atomic<runner_state>          state = runner_state::idle;
+
+    // Only used by the worker.
+    editor_status st        = editor_status::editing;
+    status        sim_st    = status::success;
+    real          begin     = 0;
+    real          end       = 10;
+    real          current   = 0;
+    i64           events    = -1; // transitions run, -1 before initialize.
+    int           remaining = 0;
+    float         speed     = 1.f;
+};
+
+//! Called by the worker when it changes the @c state of a runner or when it
+//! waits for the graphical user interface to drain the observations.
+void notify_simulation_runners() noexcept;
+
 int make_input_node_id(const irt::model_id mdl, const int port) noexcept;
 
 int make_output_node_id(const irt::model_id mdl, const int port) noexcept;
@@ -152,7 +243,8 @@ struct editor
     irt::real simulation_end       = 10;
     irt::real simulation_current   = 10;
     irt::real simulation_next_time = 0;
-    long      simulation_bag_id    = 0;
+    i64       simulation_events    = 0;
+    sz        simulation_scheduled = 0;
     int       step_by_step_bag     = 0;
 
     real simulation_during_date;
@@ -173,6 +265,25 @@ struct editor
                      editor_status::running_100_step);
     }
 
+    simulation_runner runner;
+
+    //! The simulation runs on a worker: do not modify the simulation.
+    bool is_simulation_owned() const noexcept
+    {
+        return runner.state.load(std::memory_order_acquire) !=
+               runner_state::idle;
+    }
+
+    void request_simulation(simulation_command_type type,
+                            int                     bags = 0) noexcept;
+
+    //! Apply the observations and the last snapshot published by the
+    //! worker. Call it at each frame.
+    void update_simulation() noexcept;
+
+    //! Stop the simulation and wait for the worker.
+    void stop_simulation() noexcept;
+
     bool simulation_show_value = false;
     bool stop                  = false;
 
@@ -223,9 +334,75 @@ struct editor
 
     std::vector<bool> models_make_transition;
 
-    ImVector<ImVec2> positions;
+    ImVector<ImVec2> positions; // grid space position of each model index.
     ImVector<ImVec2> displacements;
 
+    //! Approximate size of a node in the grid space.
+    static constexpr float node_extent = 250.f;
+
+    //! @brief A uniform grid over the node positions.
+    //!
+    //! The models are sorted by cell when the positions or the connections
+    //! change. Each frame, only the models of the visible cells are
+    //! submitted to ImNodes. When the visible area holds more models than
+    //! the node cache setting, the cells are drawn as proxies and the links
+    //! between the cells as bundles.
+    struct node_grid
+    {
+        struct bundle
+        {
+            int from  = 0;
+            int to    = 0;
+            int count = 0;
+        };
+
+        std::vector<int>    cell_start; // first model of each cell in nodes.
+        std::vector<int>    nodes;      // model indices sorted by cell.
+        std::vector<ImVec2> centers;    // mean position of the cell models.
+        std::vector<bundle> bundles;    // links between two cells.
+        ImVec2              origin;
+        float               cell_size = 0.f;
+        int                 columns   = 0; // 0 if the grid is not built.
+        int                 rows      = 0;
+        sz                  models    = 0; // number of models of the build.
+        bool                dirty     = true;
+
+        int column(const float x) const noexcept
+        {
+            return std::clamp(
+              static_cast<int>((x - origin.x) / cell_size), 0, columns - 1);
+        }
+
+        int row(const float y) const noexcept
+        {
+            return std::clamp(
+              static_cast<int>((y - origin.y) / cell_size), 0, rows - 1);
+        }
+
+        int cell(const ImVec2 p) const noexcept
+        {
+            return row(p.y) * columns + column(p.x);
+        }
+    } grid;
+
+    //! A connection submitted to ImNodes, the link identifier is the index.
+    struct link_entry
+    {
+        model_id src;
+        model_id dst;
+        int      src_port = 0;
+        int      dst_port = 0;
+    };
+
+    std::vector<link_entry> links;
+    std::vector<int>        visible_nodes;
+    std::vector<u32>        node_frames; // last frame the node was submitted.
+    u32                     frame           = 0;
+    bool                    simplified_view = false;
+    ImVec2                  canvas_origin;
+
+    void build_grid() noexcept;
+
     bool  use_real_time;
     bool  starting             = true;
     float synchronize_timestep = 1.f;
@@ -387,8 +564,9 @@ struct component_editor
     std::filesystem::path select_directory;
     dir_path_id           select_dir_path = undefined<dir_path_id>();
 
-    real simulation_begin;
-    real simulation_end;
+    real simulation_begin   = 0;
+    real simulation_end     = 100;
+    real simulation_current = 0;
 
     void select(tree_node_id id) noexcept;
     void open_as_main(component_id id) noexcept;
@@ -402,6 +580,7 @@ struct component_editor
 
 struct application
 {
+    task_manager                  task_mgr;
     component_editor              c_editor;
     data_array<editor, editor_id> editors;
     std::filesystem::path         home_dir;
@@ -419,9 +598,10 @@ struct application
     bool show();
     void shutdown();
 
-    // For each editor run the simulation. Use this function outside of the
-    // ImGui::Render/NewFrame to not block the graphical user interface.
-    void run_simulations();
+    // For each editor, apply the observations and the state published by the
+    // workers running the simulations. Use this function outside of the
+    // ImGui::Render/NewFrame.
+    void update_simulations();
 
     void show_plot_window();
     void show_simulation_window();
@@ -96,6 +96,19 @@ static bool can_add_this_component(component_editor&  ed,
     return true;
 }
 
+//! Patches the instances of @c compo in the simulation of the component
+//! editor instead of rebuilding the whole flattened simulation.
+static void patch_simulation(component_editor& ed, component& compo) noexcept
+{
+    if (ed.status != component_editor_status::simulating)
+        return;
+
+    const auto id = ed.mod.components.get_id(compo);
+    const auto t  = ed.simulation_current;
+    if (auto ret = update_simulation(ed.mod, ed.sim, id, t); is_bad(ret))
+        log_w.log(3, "Fail to update simulation: %s\n", status_string(ret));
+}
+
 static status add_component_to_current(component_editor& ed,
                                        component&        compo) noexcept
 {
@@ -113,10 +126,13 @@ static status add_component_to_current(component_editor& ed,
     auto  child_id = ed.mod.children.get_id(child);
     parent_compo.children.emplace_back(child_id);
 
-    auto& tree = ed.mod.tree_nodes.get(tree_id);
+    auto& tree      = ed.mod.tree_nodes.get(tree_id);
+    tree.from_child = child_id;
     tree.tree.set_id(&tree);
     tree.tree.parent_to(parent.tree);
 
+    patch_simulation(ed, parent_compo);
+
     return status::success;
 }
 
@@ -752,6 +768,8 @@ static void is_link_created(component_editor& ed, component& parent) noexcept
             auto con_id = ed.mod.connections.get_id(con);
             parent.connections.emplace_back(con_id);
             parent.status = component_status::modified;
+
+            patch_simulation(ed, parent);
         }
     }
 }
@@ -768,7 +786,11 @@ void remove_nodes(component_editor& ed,
                 if (auto* c = tree.tree.get_child(); c) {
                     do {
                         if (c->id == enum_cast<component_id>(child->id)) {
-                            c->tree.remove_from_hierarchy();
+                            // The simulation patch frees the tree_node after
+                            // the removal of its models and connections.
+                            if (ed.status !=
+                                component_editor_status::simulating)
+                                c->tree.remove_from_hierarchy();
                             c = nullptr;
                         } else {
                             c = c->tree.get_sibling();
@@ -785,6 +807,8 @@ void remove_nodes(component_editor& ed,
     ImNodes::ClearNodeSelection();
 
     parent.status = component_status::modified;
+
+    patch_simulation(ed, parent);
 }
 
 void remove_links(component_editor& ed, component& parent) noexcept
@@ -810,6 +834,8 @@ void remove_links(component_editor& ed, component& parent) noexcept
     ImNodes::ClearLinkSelection();
 
     parent.status = component_status::modified;
+
+    patch_simulation(ed, parent);
 }
 
 static void show_opened_component(component_editor& ed) noexcept
@@ -841,6 +867,8 @@ static void show_opened_component(component_editor& ed) noexcept
         ImNodes::SetNodeScreenSpacePos(pack_node(new_model), click_pos);
         child->x = click_pos.x;
         child->y = click_pos.y;
+
+        patch_simulation(ed, *compo);
     }
 
     is_link_created(ed, *compo);
@@ -931,11 +959,6 @@ void component_editor::settings_manager::show(bool* is_open) noexcept
         dir_path* dir       = nullptr;
         dir_path* to_delete = nullptr;
         while (c_ed->mod.dir_paths.next(dir)) {
-            if (to_delete) {
-                c_ed->mod.dir_paths.free(*to_delete);
-                to_delete = nullptr;
-            }
-
             ImGui::PushID(dir);
             ImGui::TableNextRow();
             ImGui::TableNextColumn();
@@ -1094,8 +1117,58 @@ static void unselect_editor_component_ref(component_editor& ed) noexcept
     ed.selected_nodes.clear();
 }
 
+//! Flattens the opened component into the simulation of the component
+//! editor. Until @c stop_simulation, the edits of the components are patched
+//! into this simulation.
+static void start_simulation(component_editor& ed) noexcept
+{
+    ed.sim.clear();
+    ed.simulation_current = ed.simulation_begin;
+
+    auto ret = build_simulation(ed.mod, ed.sim);
+    if (is_success(ret))
+        ret = ed.sim.initialize(ed.simulation_current);
+
+    if (is_bad(ret)) {
+        log_w.log(3, "Fail to build simulation: %s\n", status_string(ret));
+        ed.sim.clear();
+        return;
+    }
+
+    ed.status = component_editor_status::simulating;
+}
+
+static void stop_simulation(component_editor& ed) noexcept
+{
+    if (ed.status != component_editor_status::simulating)
+        return;
+
+    ed.sim.finalize(ed.simulation_current);
+    ed.sim.clear();
+    ed.status = component_editor_status::modeling;
+}
+
+static void step_simulation(component_editor& ed, int bags) noexcept
+{
+    if (ed.status != component_editor_status::simulating)
+        start_simulation(ed);
+
+    for (int i = 0; i != bags; ++i) {
+        if (ed.status != component_editor_status::simulating ||
+            ed.simulation_current >= ed.simulation_end)
+            break;
+
+        if (auto ret = ed.sim.run(ed.simulation_current); is_bad(ret)) {
+            log_w.log(3, "Fail to run simulation: %s\n", status_string(ret));
+            stop_simulation(ed);
+        }
+    }
+}
+
 void component_editor::unselect() noexcept
 {
+    stop_simulation(*this);
+
     mod.head = undefined<tree_node_id>();
     mod.tree_nodes.clear();
 
@@ -1157,25 +1230,26 @@ static void show_simulation(component_editor& ed) noexcept
                                 ImGuiTreeNodeFlags_CollapsingHeader)) {
         ImGui::InputReal("Begin", &ed.simulation_begin);
         ImGui::InputReal("End", &ed.simulation_end);
-        ImGui::TextFormat("Current time {:.6f}", ed.simulation_begin);
+        ImGui::TextFormat("Current time {:.6f}", ed.simulation_current);
 
-        if (ImGui::Button("[]")) {
-        }
+        if (ImGui::Button("[]"))
+            stop_simulation(ed);
         ImGui::SameLine();
         if (ImGui::Button("||")) {
         }
         ImGui::SameLine();
-        if (ImGui::Button(">")) {
-        }
+        if (ImGui::Button(">") &&
+            ed.status != component_editor_status::simulating)
+            start_simulation(ed);
         ImGui::SameLine();
-        if (ImGui::Button("+1")) {
-        }
+        if (ImGui::Button("+1"))
+            step_simulation(ed, 1);
         ImGui::SameLine();
-        if (ImGui::Button("+10")) {
-        }
+        if (ImGui::Button("+10"))
+            step_simulation(ed, 10);
         ImGui::SameLine();
-        if (ImGui::Button("+100")) {
-        }
+        if (ImGui::Button("+100"))
+            step_simulation(ed, 100);
     }
 }
 
@@ -35,6 +35,7 @@ const char* status_string(const status s) noexcept
         "simulation_not_enough_model",
         "simulation_not_enough_message",
         "simulation_not_enough_connection",
+        "simulation_not_enough_structural_change",
         "vector_init_capacity_error",
         "vector_not_enough_memory",
         "data_array_init_capacity_error",
@@ -74,6 +75,7 @@ const char* status_string(const status s) noexcept
         "io_file_format_dynamics_unknown",
         "io_file_format_dynamics_limit_reach",
         "io_file_format_dynamics_init_error",
+        "distributed_transport_error",
     };
 
     static_assert(std::size(str) == status_size());
@@ -193,7 +193,7 @@ main(int, char**)
             continue;
         }
 
-        app.run_simulations();
+        app.update_simulations();
 
         // Start the Dear ImGui frame
         ImGui_ImplDX12_NewFrame();
@@ -14,6 +14,7 @@
 #include "editor.hpp"
 #include "internal.hpp"
 
+#include <algorithm>
 #include <cinttypes>
 #include <fstream>
 #include <string>
@@ -63,7 +64,13 @@ void editor::settings_manager::compute_colors() noexcept
       ImGui::ColorConvertFloat4ToU32(gui_model_transition_color * 1.5f);
 }
 
-void editor::clear() noexcept { sim.clear(); }
+void editor::clear() noexcept
+{
+    sim.clear();
+
+    std::fill(positions.begin(), positions.end(), ImVec2{ 0.f, 0.f });
+    grid.dirty = true;
+}
 
 void editor::free_children(const ImVector<int>& nodes) noexcept
 {
@@ -76,6 +83,9 @@ void editor::free_children(const ImVector<int>& nodes) noexcept
         log_w.log(7, "delete %" PRIu64 "\n", child_id);
         sim.deallocate(child_id);
 
+        positions[get_index(child_id)] = ImVec2{ 0.f, 0.f };
+        grid.dirty                     = true;
+
         observation_dispatch(
           get_index(child_id),
           [this](auto& outs, const auto id) { outs.free(id); });
@@ -142,25 +152,21 @@ void editor::compute_grid_layout() noexcept
     const auto panning = ImNodes::EditorContextGetPanning();
     auto       new_pos = panning;
 
-    model* mdl  = nullptr;
-    int    elem = 0;
+    model* mdl = nullptr;
 
     for (int i = 0; i < column; ++i) {
-        if (!sim.models.next(mdl))
-            break;
-
-        auto mdl_id    = sim.models.get_id(mdl);
-        auto mdl_index = get_index(mdl_id);
-
         new_pos.y =
           panning.y + static_cast<float>(i) * settings.grid_layout_y_distance;
         for (int j = 0; j < line; ++j) {
+            if (!sim.models.next(mdl))
+                break;
+
+            auto mdl_id    = sim.models.get_id(mdl);
+            auto mdl_index = get_index(mdl_id);
+
             new_pos.x = panning.x +
                         static_cast<float>(j) * settings.grid_layout_x_distance;
-            ImNodes::SetNodeGridSpacePos(mdl_index, new_pos);
-            positions[elem].x = new_pos.x;
-            positions[elem].y = new_pos.y;
-            ++elem;
+            positions[mdl_index] = new_pos;
         }
     }
 
@@ -176,12 +182,10 @@ void editor::compute_grid_layout() noexcept
 
         new_pos.x =
           panning.x + static_cast<float>(j) * settings.grid_layout_x_distance;
-        ImNodes::SetNodeGridSpacePos(mdl_index, new_pos);
-        positions[elem].x = new_pos.x;
-        positions[elem].y = new_pos.y;
-        ++elem;
+        positions[mdl_index] = new_pos;
     }
 
+    grid.dirty = true;
     ImNodes::EditorContextResetPanning(positions[0]);
 }
 
@@ -223,16 +227,22 @@ void editor::compute_automatic_layout() noexcept
     float t =
       1.f - 1.f / static_cast<float>(settings.automatic_layout_iteration_limit);
 
+    // The positions and displacements are indexed by model index.
+    ImVector<int> indices;
+    indices.reserve(size);
+    for (model* mdl = nullptr; sim.models.next(mdl);)
+        indices.push_back(static_cast<int>(get_index(sim.models.get_id(mdl))));
+
     for (int iteration = 0;
          iteration < settings.automatic_layout_iteration_limit;
          ++iteration) {
         for (int i_v = 0; i_v < size; ++i_v) {
-            const int v = i_v;
+            const int v = indices[i_v];
 
             displacements[v].x = displacements[v].y = 0.f;
 
             for (int i_u = 0; i_u < size; ++i_u) {
-                const int u = i_u;
+                const int u = indices[i_u];
 
                 if (u != v) {
                     const ImVec2 delta{ positions[v].x - positions[u].x,
@@ -255,10 +265,8 @@ void editor::compute_automatic_layout() noexcept
         }
 
         auto sum = 0.f;
-        mdl      = nullptr;
         for (int i_v = 0; i_v < size; ++i_v) {
-            irt_assert(sim.models.next(mdl));
-            const int v = i_v;
+            const int v = indices[i_v];
 
             const float d2 = displacements[v].x * displacements[v].x +
                              displacements[v].y * displacements[v].y;
@@ -275,14 +283,10 @@ void editor::compute_automatic_layout() noexcept
 
             positions[v].x += displacements[v].x;
             positions[v].y += displacements[v].y;
-
-            const auto mdl_id    = sim.models.get_id(mdl);
-            const auto mdl_index = get_index(mdl_id);
-
-            ImNodes::SetNodeGridSpacePos(mdl_index, positions[v]);
         }
     }
 
+    grid.dirty = true;
     ImNodes::EditorContextResetPanning(positions[0]);
 }
 
@@ -341,6 +345,11 @@ status editor::copy(const ImVector<int>& nodes) noexcept
 
         sim.make_initialize(dst_mdl, simulation_current);
 
+        const auto& src_pos = positions[get_index(src_mdl_id)];
+        const auto  shift   = node_extent / 4.f;
+        positions[get_index(dst_mdl_id)] =
+          ImVec2{ src_pos.x + shift, src_pos.y + shift };
+
         mapping.data.emplace_back(src_mdl_id, dst_mdl_id);
     }
 
@@ -378,6 +387,9 @@ status editor::initialize(u32 id) noexcept
     irt_return_if_bad(srcs.init(50));
     sim.source_dispatch = srcs;
 
+    irt_return_if_bad(runner.commands.init(64));
+    irt_return_if_bad(runner.observations.init(1 << 16));
+
     try {
         observation_outputs.resize(sim.models.capacity());
         models_make_transition.resize(sim.models.capacity(), false);
@@ -385,6 +397,9 @@ status editor::initialize(u32 id) noexcept
         positions.resize(sim.models.capacity(), ImVec2{ 0.f, 0.f });
         displacements.resize(sim.models.capacity(), ImVec2{ 0.f, 0.f });
 
+        node_frames.resize(sim.models.capacity(), 0u);
+        visible_nodes.reserve(sim.models.capacity());
+
         observation_directory = std::filesystem::current_path();
     } catch (const std::bad_alloc& /*e*/) {
         return status::gui_not_enough_memory;
@@ -554,42 +569,277 @@ status editor::add_izhikevitch() noexcept
     return status::success;
 }
 
-static int show_connection(editor& ed, model& mdl, int connection_id)
-{
-    dispatch(
-      mdl,
-      [&ed, &mdl, &connection_id]<typename Dynamics>(Dynamics& dyn) -> void {
-          if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
-              for (int i = 0, e = length(dyn.y); i != e; ++i) {
-                  auto list = append_node(ed.sim, dyn.y[i]);
-                  auto it   = list.begin();
-                  auto et   = list.end();
-
-                  while (it != et) {
-                      if (auto* mdl_dst = ed.sim.models.try_to_get(it->model);
-                          mdl_dst) {
-                          int out = make_output_node_id(ed.sim.get_id(dyn), i);
-                          int in =
-                            make_input_node_id(it->model, it->port_index);
-                          ImNodes::Link(connection_id++, out, in);
-                          ++it;
-                      } else {
-                          it = list.erase(it);
-                      }
-                  }
-              }
-          }
-      });
-
-    return connection_id;
+//! Submit the connections between two visible models. The connections to a
+//! culled model are drawn as a line to its position.
+static void show_connection(editor&      ed,
+                            model&       mdl,
+                            ImDrawList*  draw_list,
+                            const ImVec2 offset,
+                            const ImU32  color,
+                            const bool   owned)
+{
+    dispatch(mdl, [&]<typename Dynamics>(Dynamics& dyn) -> void {
+        if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+            const auto src       = ed.sim.get_id(dyn);
+            const auto src_index = static_cast<int>(get_index(src));
+
+            for (int i = 0, e = length(dyn.y); i != e; ++i) {
+                auto list = append_node(ed.sim, dyn.y[i]);
+                auto it   = list.begin();
+                auto et   = list.end();
+
+                while (it != et) {
+                    if (auto* mdl_dst = ed.sim.models.try_to_get(it->model);
+                        mdl_dst) {
+                        const auto dst_index = get_index(it->model);
+
+                        if (ed.node_frames[dst_index] == ed.frame) {
+                            ImNodes::Link(
+                              static_cast<int>(ed.links.size()),
+                              make_output_node_id(src, i),
+                              make_input_node_id(it->model, it->port_index));
+                            ed.links.emplace_back(
+                              src, it->model, i, it->port_index);
+                        } else {
+                            const auto size =
+                              ImNodes::GetNodeDimensions(src_index);
+                            const auto& from = ed.positions[src_index];
+                            const auto& to   = ed.positions[dst_index];
+
+                            draw_list->AddLine(
+                              ImVec2{ offset.x + from.x + size.x,
+                                      offset.y + from.y + size.y / 2.f },
+                              ImVec2{ offset.x + to.x, offset.y + to.y },
+                              color);
+                        }
+
+                        ++it;
+                    } else if (owned) {
+                        ++it;
+                    } else {
+                        it = list.erase(it);
+                    }
+                }
+            }
+        }
+    });
 }
 
 void editor::show_connections() noexcept
 {
-    int connection_id = 0;
+    links.clear();
 
-    for (model* mdl = nullptr; sim.models.next(mdl);)
-        connection_id = show_connection(*this, *mdl, connection_id);
+    if (simplified_view || visible_nodes.empty())
+        return;
+
+    // Draw the lines to the culled models under the nodes.
+    auto* draw_list = ImGui::GetWindowDrawList();
+    draw_list->ChannelsSetCurrent(0);
+
+    const auto panning = ImNodes::EditorContextGetPanning();
+    const auto offset  = ImVec2{ canvas_origin.x + panning.x,
+                                canvas_origin.y + panning.y };
+    const auto color   = ImNodes::GetStyle().Colors[ImNodesCol_Link];
+    const bool owned   = is_simulation_owned();
+
+    try {
+        for (const auto mdl_index : visible_nodes)
+            if (auto* mdl = sim.models.try_to_get(static_cast<u32>(mdl_index));
+                mdl)
+                show_connection(*this, *mdl, draw_list, offset, color, owned);
+    } catch (const std::bad_alloc& /*e*/) {
+    }
+}
+
+//! Remove the connection from the output port list of the source model.
+static void remove_connection(editor& ed, const editor::link_entry& link)
+{
+    auto* mdl = ed.sim.models.try_to_get(link.src);
+    if (!mdl)
+        return;
+
+    dispatch(*mdl, [&]<typename Dynamics>(Dynamics& dyn) -> void {
+        if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+            auto list = append_node(ed.sim, dyn.y[link.src_port]);
+
+            for (auto it = list.begin(), et = list.end(); it != et; ++it) {
+                if (it->model == link.dst && it->port_index == link.dst_port) {
+                    list.erase(it);
+                    return;
+                }
+            }
+        }
+    });
+}
+
+void editor::build_grid() noexcept
+{
+    grid.dirty   = false;
+    grid.models  = sim.models.size();
+    grid.columns = 0;
+    grid.rows    = 0;
+
+    if (grid.models == 0)
+        return;
+
+    ImVec2 min{ std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::max() };
+    ImVec2 max{ std::numeric_limits<float>::lowest(),
+                std::numeric_limits<float>::lowest() };
+
+    for (model* mdl = nullptr; sim.models.next(mdl);) {
+        const auto& p = positions[get_index(sim.models.get_id(mdl))];
+        min.x         = std::min(min.x, p.x);
+        min.y         = std::min(min.y, p.y);
+        max.x         = std::max(max.x, p.x);
+        max.y         = std::max(max.y, p.y);
+    }
+
+    // At most 256 x 256 cells and at least 4 x 4 nodes per cell.
+    const float width  = max.x - min.x;
+    const float height = max.y - min.y;
+    grid.origin        = min;
+    grid.cell_size =
+      std::max(4.f * node_extent, std::max(width, height) / 256.f);
+    grid.columns = static_cast<int>(width / grid.cell_size) + 1;
+    grid.rows    = static_cast<int>(height / grid.cell_size) + 1;
+
+    const auto cells = static_cast<std::size_t>(grid.columns * grid.rows);
+
+    try {
+        grid.cell_start.assign(cells + 1u, 0);
+        grid.centers.assign(cells, ImVec2{ 0.f, 0.f });
+        grid.nodes.resize(grid.models);
+        grid.bundles.clear();
+
+        // Counting sort of the models by cell.
+        for (model* mdl = nullptr; sim.models.next(mdl);) {
+            const auto& p = positions[get_index(sim.models.get_id(mdl))];
+            const auto  c = grid.cell(p);
+
+            ++grid.cell_start[c + 1];
+            grid.centers[c].x += p.x;
+            grid.centers[c].y += p.y;
+        }
+
+        for (std::size_t c = 0; c != cells; ++c) {
+            if (const auto n = grid.cell_start[c + 1]; n > 0) {
+                grid.centers[c].x /= static_cast<float>(n);
+                grid.centers[c].y /= static_cast<float>(n);
+            }
+
+            grid.cell_start[c + 1] += grid.cell_start[c];
+        }
+
+        std::vector<int> next(grid.cell_start.begin(),
+                              grid.cell_start.end() - 1);
+
+        for (model* mdl = nullptr; sim.models.next(mdl);) {
+            const auto index = get_index(sim.models.get_id(mdl));
+            grid.nodes[next[grid.cell(positions[index])]++] =
+              static_cast<int>(index);
+        }
+
+        // Count the connections between each pair of cells.
+        std::vector<u64> keys;
+        for (model* mdl = nullptr; sim.models.next(mdl);) {
+            dispatch(*mdl, [&]<typename Dynamics>(Dynamics& dyn) -> void {
+                if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+                    const auto from =
+                      grid.cell(positions[get_index(sim.get_id(dyn))]);
+
+                    for (const auto port : dyn.y) {
+                        for (const auto& elem : get_node(sim, port)) {
+                            if (!sim.models.try_to_get(elem.model))
+                                continue;
+
+                            const auto to =
+                              grid.cell(positions[get_index(elem.model)]);
+                            if (from != to)
+                                keys.emplace_back(
+                                  static_cast<u64>(from) << 32 |
+                                  static_cast<u64>(to));
+                        }
+                    }
+                }
+            });
+        }
+
+        std::sort(keys.begin(), keys.end());
+        for (std::size_t i = 0, e = keys.size(); i != e;) {
+            std::size_t j = i + 1;
+            while (j != e && keys[j] == keys[i])
+                ++j;
+
+            grid.bundles.emplace_back(static_cast<int>(keys[i] >> 32),
+                                      static_cast<int>(keys[i] & 0xffffffff),
+                                      static_cast<int>(j - i));
+            i = j;
+        }
+    } catch (const std::bad_alloc& /*e*/) {
+        grid.columns = 0;
+        grid.rows    = 0;
+    }
+}
+
+//! Draw the models of the visible cells as a disc with the number of models
+//! and the connections between cells as a line.
+static void show_simplified_view(editor&      ed,
+                                 const ImVec2 offset,
+                                 const int    x0,
+                                 const int    y0,
+                                 const int    x1,
+                                 const int    y1) noexcept
+{
+    const auto& grid      = ed.grid;
+    auto*       draw_list = ImGui::GetWindowDrawList();
+
+    const auto is_visible = [&](const int cell) noexcept {
+        const int x = cell % grid.columns;
+        const int y = cell / grid.columns;
+        return x0 <= x && x <= x1 && y0 <= y && y <= y1;
+    };
+
+    const auto to_screen = [&](const ImVec2 p) noexcept {
+        return ImVec2{ offset.x + p.x, offset.y + p.y };
+    };
+
+    const auto link_color = ImNodes::GetStyle().Colors[ImNodesCol_Link];
+    for (const auto& bundle : grid.bundles)
+        if (is_visible(bundle.from) || is_visible(bundle.to))
+            draw_list->AddLine(
+              to_screen(grid.centers[bundle.from]),
+              to_screen(grid.centers[bundle.to]),
+              link_color,
+              1.f + std::log2(static_cast<float>(bundle.count)));
+
+    const auto model_color =
+      ImGui::ColorConvertFloat4ToU32(ed.settings.gui_model_color);
+    small_string<16> number;
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            const int  cell = y * grid.columns + x;
+            const auto n = grid.cell_start[cell + 1] - grid.cell_start[cell];
+            if (n == 0)
+                continue;
+
+            const auto center = to_screen(grid.centers[cell]);
+            const auto radius =
+              std::min(grid.cell_size / 2.f,
+                       editor::node_extent / 8.f *
+                         (1.f + std::log2(static_cast<float>(n))));
+
+            draw_list->AddCircleFilled(center, radius, model_color);
+
+            format(number, "{}", n);
+            const auto size = ImGui::CalcTextSize(number.c_str());
+            draw_list->AddText(
+              ImVec2{ center.x - size.x / 2.f, center.y - size.y / 2.f },
+              IM_COL32_WHITE,
+              number.c_str());
+        }
+    }
 }
 
 template<typename Dynamics>
@@ -877,23 +1127,23 @@ static void show_dynamics_values(simulation& sim, const queue& dyn)
 
 static void show_dynamics_values(simulation& sim, const dynamic_queue& dyn)
 {
-    if (dyn.fifo == u64(-1)) {
+    if (dyn.heap == u32(-1)) {
         ImGui::TextFormat("empty");
     } else {
-        auto list = get_dated_message(sim, dyn.fifo);
-        ImGui::TextFormat("next ta {}", list.front().data[0]);
-        ImGui::TextFormat("next value {}", list.front().data[1]);
+        const auto& top = sim.dated_message_alloc[dyn.heap].value;
+        ImGui::TextFormat("next ta {}", top.data[0]);
+        ImGui::TextFormat("next value {}", top.data[1]);
     }
 }
 
 static void show_dynamics_values(simulation& sim, const priority_queue& dyn)
 {
-    if (dyn.fifo == u64(-1)) {
+    if (dyn.heap == u32(-1)) {
         ImGui::TextFormat("empty");
     } else {
-        auto list = get_dated_message(sim, dyn.fifo);
-        ImGui::TextFormat("next ta {}", list.front().data[0]);
-        ImGui::TextFormat("next value {}", list.front().data[1]);
+        const auto& top = sim.dated_message_alloc[dyn.heap].value;
+        ImGui::TextFormat("next ta {}", top.data[0]);
+        ImGui::TextFormat("next value {}", top.data[1]);
     }
 }
 
@@ -1001,13 +1251,58 @@ static void show_dynamics_values(simulation& /*sim*/, const flow& dyn)
         ImGui::TextFormat("no data");
 }
 
+//! The queues of a snapshot reference the message lists of the simulation
+//! running in a worker: only show if they are empty.
+template<typename Dynamics>
+static void show_snapshot_values(simulation& sim, const Dynamics& dyn)
+{
+    if constexpr (std::is_same_v<Dynamics, queue>)
+        ImGui::TextUnformatted(dyn.fifo == u64(-1) ? "empty" : "not empty");
+    else if constexpr (std::is_same_v<Dynamics, dynamic_queue> ||
+                       std::is_same_v<Dynamics, priority_queue>)
+        ImGui::TextUnformatted(dyn.heap == u32(-1) ? "empty" : "not empty");
+    else
+        show_dynamics_values(sim, dyn);
+}
+
+//! The copy of the model in the last snapshot or nullptr.
+static const model* get_snapshot_model(const editor& ed,
+                                       const model&  mdl) noexcept
+{
+    const auto& snap  = ed.runner.snapshots.read_buffer();
+    const auto  index = get_index(ed.sim.models.get_id(mdl));
+    const auto  it =
+      std::lower_bound(snap.indices.begin(), snap.indices.end(), index);
+
+    if (it == snap.indices.end() || *it != index)
+        return nullptr;
+
+    const auto& copy = snap.models[static_cast<std::size_t>(
+      std::distance(snap.indices.begin(), it))];
+
+    return copy.type == mdl.type ? &copy : nullptr;
+}
+
 void editor::show_model_dynamics(model& mdl) noexcept
 {
     if (simulation_show_value && st != editor_status::editing) {
-        dispatch(mdl, [&](const auto& dyn) {
+        const bool   owned  = is_simulation_owned();
+        const model* values = owned ? get_snapshot_model(*this, mdl) : &mdl;
+
+        dispatch(mdl, [&]<typename Dynamics>(const Dynamics& dyn) {
             add_input_attribute(*this, dyn);
             ImGui::PushItemWidth(120.0f);
-            show_dynamics_values(sim, dyn);
+
+            if (values) {
+                const auto& copy =
+                  *reinterpret_cast<const Dynamics*>(&values->dyn);
+
+                if (owned)
+                    show_snapshot_values(sim, copy);
+                else
+                    show_dynamics_values(sim, copy);
+            }
+
             ImGui::PopItemWidth();
             add_output_attribute(*this, dyn);
         });
@@ -1016,7 +1311,8 @@ void editor::show_model_dynamics(model& mdl) noexcept
             add_input_attribute(*this, dyn);
             ImGui::PushItemWidth(120.0f);
 
-            if (settings.show_dynamics_inputs_in_editor)
+            if (settings.show_dynamics_inputs_in_editor &&
+                !is_simulation_owned())
                 show_dynamics_inputs(this->srcs, dyn);
             ImGui::PopItemWidth();
             add_output_attribute(*this, dyn);
@@ -1069,7 +1365,12 @@ static status make_input_tooltip(simulation&  sim,
     return status::success;
 }
 
-static void show_tooltip(editor& ed, const model& mdl, const model_id id)
+//! Show the input messages only if the graphical user interface owns the
+//! simulation.
+static void show_tooltip(editor&        ed,
+                         const model&   mdl,
+                         const model_id id,
+                         const bool     with_messages)
 {
     ed.tooltip.clear();
 
@@ -1079,15 +1380,17 @@ static void show_tooltip(editor& ed, const model& mdl, const model_id id)
                        mdl.tl,
                        mdl.tn);
 
-        auto ret = dispatch(mdl, [&]<typename Dynamics>(Dynamics& dyn) {
-            if constexpr (is_detected_v<has_input_port_t, Dynamics>)
-                return make_input_tooltip(ed.sim, dyn, ed.tooltip);
+        if (with_messages) {
+            auto ret = dispatch(mdl, [&]<typename Dynamics>(Dynamics& dyn) {
+                if constexpr (is_detected_v<has_input_port_t, Dynamics>)
+                    return make_input_tooltip(ed.sim, dyn, ed.tooltip);
 
-            return status::success;
-        });
+                return status::success;
+            });
 
-        if (is_bad(ret))
-            ed.tooltip += "error\n";
+            if (is_bad(ret))
+                ed.tooltip += "error\n";
+        }
     } else {
         fmt::format_to(std::back_inserter(ed.tooltip),
                        "Not in transition\n- last time: {}\n- next time:{}\n",
@@ -1104,11 +1407,71 @@ static void show_tooltip(editor& ed, const model& mdl, const model_id id)
 
 void editor::show_top() noexcept
 {
-    model* mdl = nullptr;
-    while (sim.models.next(mdl)) {
+    ++frame;
+    canvas_origin   = ImGui::GetWindowPos();
+    simplified_view = false;
+
+    if (grid.dirty || grid.models != sim.models.size())
+        build_grid();
+
+    // The visible area in the grid space, enlarged on the top left to keep
+    // the partially visible nodes.
+    const auto panning = ImNodes::EditorContextGetPanning();
+    const auto size    = ImGui::GetWindowSize();
+    const auto view_min =
+      ImVec2{ -panning.x - node_extent, -panning.y - node_extent };
+    const auto view_max = ImVec2{ -panning.x + size.x, -panning.y + size.y };
+
+    const auto is_visible = [&](const ImVec2 p) noexcept {
+        return view_min.x <= p.x && p.x <= view_max.x && view_min.y <= p.y &&
+               p.y <= view_max.y;
+    };
+
+    visible_nodes.clear();
+
+    if (grid.columns == 0) {
+        for (model* mdl = nullptr; sim.models.next(mdl);)
+            visible_nodes.emplace_back(
+              static_cast<int>(get_index(sim.models.get_id(mdl))));
+    } else {
+        const int x0 = grid.column(view_min.x), x1 = grid.column(view_max.x);
+        const int y0 = grid.row(view_min.y), y1 = grid.row(view_max.y);
+
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                const int cell = y * grid.columns + x;
+                for (int i = grid.cell_start[cell],
+                         e = grid.cell_start[cell + 1];
+                     i != e;
+                     ++i)
+                    if (is_visible(positions[grid.nodes[i]]))
+                        visible_nodes.emplace_back(grid.nodes[i]);
+            }
+        }
+
+        const auto limit = static_cast<std::size_t>(settings.gui_node_cache);
+        simplified_view  = visible_nodes.size() > limit;
+
+        if (simplified_view) {
+            const ImVec2 offset{ canvas_origin.x + panning.x,
+                                 canvas_origin.y + panning.y };
+
+            show_simplified_view(*this, offset, x0, y0, x1, y1);
+            return;
+        }
+    }
+
+    for (const auto index : visible_nodes) {
+        auto* mdl = sim.models.try_to_get(static_cast<u32>(index));
+        if (!mdl)
+            continue;
+
         const auto mdl_id    = sim.models.get_id(mdl);
         const auto mdl_index = get_index(mdl_id);
 
+        node_frames[mdl_index] = frame;
+        ImNodes::SetNodeGridSpacePos(index, positions[mdl_index]);
+
         if (st != editor_status::editing && models_make_transition[mdl_index]) {
 
             ImNodes::PushColorStyle(ImNodesCol_TitleBar,
@@ -1232,6 +1595,10 @@ void editor::show_editor() noexcept
         ImGui::TableNextRow();
         ImGui::TableSetColumnIndex(0);
 
+        // While a worker runs the simulation, the models and connections
+        // are read-only.
+        const bool owned = is_simulation_owned();
+
         ImNodes::BeginNodeEditor();
 
         show_top();
@@ -1245,7 +1612,7 @@ void editor::show_editor() noexcept
         const auto click_pos = ImGui::GetMousePosOnOpeningCurrentPopup();
 
         ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(8.f, 8.f));
-        if (!ImGui::IsAnyItemHovered() && open_popup)
+        if (!ImGui::IsAnyItemHovered() && open_popup && !owned)
             ImGui::OpenPopup("Context menu");
 
         if (ImGui::BeginPopup("Context menu")) {
@@ -1316,9 +1683,25 @@ void editor::show_editor() noexcept
 
         ImNodes::EndNodeEditor();
 
+        const auto panning = ImNodes::EditorContextGetPanning();
+
+        // Keep the positions of the dragged nodes.
+        if (!simplified_view) {
+            for (const auto index : visible_nodes) {
+                const auto pos = ImNodes::GetNodeGridSpacePos(index);
+                if (pos.x != positions[index].x ||
+                    pos.y != positions[index].y) {
+                    positions[index] = pos;
+                    grid.dirty       = true;
+                }
+            }
+        }
+
         if (new_model != undefined<model_id>()) {
-            const auto mdl_index = get_index(new_model);
-            ImNodes::SetNodeScreenSpacePos(mdl_index, click_pos);
+            positions[get_index(new_model)] =
+              ImVec2{ click_pos.x - canvas_origin.x - panning.x,
+                      click_pos.y - canvas_origin.y - panning.y };
+            grid.dirty = true;
         }
 
         ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(8.f, 8.f));
@@ -1328,14 +1711,18 @@ void editor::show_editor() noexcept
             auto* mdl = sim.models.try_to_get(node_id);
             if (mdl) {
                 const auto mdl_id = sim.models.get_id(mdl);
-                show_tooltip(*this, *mdl, mdl_id);
+
+                if (!owned)
+                    show_tooltip(*this, *mdl, mdl_id, true);
+                else if (auto* copy = get_snapshot_model(*this, *mdl); copy)
+                    show_tooltip(*this, *copy, mdl_id, false);
             }
         } else
             tooltip.clear();
 
         {
             int start = 0, end = 0;
-            if (ImNodes::IsLinkCreated(&start, &end)) {
+            if (ImNodes::IsLinkCreated(&start, &end) && !owned) {
                 const gport out = get_out(start);
                 const gport in  = get_in(end);
 
@@ -1346,6 +1733,8 @@ void editor::show_editor() noexcept
                         log_w.log(6,
                                   "Fail to connect these models: %s\n",
                                   status_string(status));
+
+                    grid.dirty = true;
                 }
             }
         }
@@ -1357,7 +1746,7 @@ void editor::show_editor() noexcept
         static ImVector<int> selected_nodes;
         static ImVector<int> selected_links;
 
-        if (num_selected_nodes > 0) {
+        if (num_selected_nodes > 0 && !owned) {
             selected_nodes.resize(num_selected_nodes, -1);
 
             if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyReleased('X')) {
@@ -1375,72 +1764,24 @@ void editor::show_editor() noexcept
                 num_selected_nodes = 0;
                 ImNodes::ClearNodeSelection();
             }
-        } else if (num_selected_links > 0) {
+        } else if (num_selected_links > 0 && !owned) {
             selected_links.resize(static_cast<size_t>(num_selected_links));
 
             if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyReleased('X')) {
                 std::fill_n(selected_links.begin(), selected_links.size(), -1);
                 ImNodes::GetSelectedLinks(selected_links.begin());
-                std::sort(selected_links.begin(),
-                          selected_links.end(),
-                          std::less<int>());
-
-                int link_id_to_delete = selected_links[0];
-                int current_link_id   = 0;
-                int i                 = 0;
 
                 log_w.log(
                   7, "%d connection(s) to delete\n", num_selected_links);
 
-                auto selected_links_ptr  = selected_links.Data;
-                auto selected_links_size = selected_links.Size;
-
-                model* mdl = nullptr;
-                while (sim.models.next(mdl) && link_id_to_delete != -1) {
-                    dispatch(
-                      *mdl,
-                      [this,
-                       &mdl,
-                       &i,
-                       &current_link_id,
-                       selected_links_ptr,
-                       selected_links_size,
-                       &link_id_to_delete]<typename Dynamics>(Dynamics& dyn) {
-                          if constexpr (is_detected_v<has_output_port_t,
-                                                      Dynamics>) {
-                              const int e = length(dyn.y);
-                              int       j = 0;
-
-                              while (j < e && link_id_to_delete != -1) {
-                                  auto list = append_node(sim, dyn.y[j]);
-                                  auto it   = list.begin();
-                                  auto et   = list.end();
-
-                                  while (it != et && link_id_to_delete != -1) {
-                                      if (current_link_id ==
-                                          link_id_to_delete) {
-
-                                          it = list.erase(it);
-
-                                          ++i;
-
-                                          if (i != selected_links_size)
-                                              link_id_to_delete =
-                                                selected_links_ptr[i];
-                                          else
-                                              link_id_to_delete = -1;
-                                      } else {
-                                          ++it;
-                                      }
-
-                                      ++current_link_id;
-                                  }
-
-                                  ++j;
-                              }
-                          }
-                      });
-                }
+                // Link identifiers are indices in the links table of the
+                // current frame.
+                for (const auto id : selected_links)
+                    if (id >= 0 && id < static_cast<int>(links.size()))
+                        remove_connection(*this, links[id]);
+
+                links.clear();
+                grid.dirty = true;
 
                 num_selected_links = 0;
                 selected_links.resize(0);
@@ -1453,7 +1794,7 @@ void editor::show_editor() noexcept
         if (ImGui::CollapsingHeader("Selected Models",
                                     ImGuiTreeNodeFlags_CollapsingHeader |
                                       ImGuiTreeNodeFlags_DefaultOpen) &&
-            num_selected_nodes) {
+            num_selected_nodes && !owned) {
             selected_nodes.resize(num_selected_nodes, -1);
             ImNodes::GetSelectedNodes(selected_nodes.begin());
 
@@ -1603,12 +1944,16 @@ bool editor::show_window() noexcept
         return true;
     }
 
+    // While a worker runs the simulation, the models are read-only.
+    const bool owned = is_simulation_owned();
+
     if (ImGui::BeginMenuBar()) {
         if (ImGui::BeginMenu("File")) {
-            if (ImGui::MenuItem("Open"))
+            if (ImGui::MenuItem("Open", nullptr, false, !owned))
                 show_load_file_dialog = true;
 
-            if (!path.empty() && ImGui::MenuItem("Save")) {
+            if (!path.empty() &&
+                ImGui::MenuItem("Save", nullptr, false, !owned)) {
                 log_w.log(3,
                           "Write into file %s\n",
                           (const char*)path.u8string().c_str());
@@ -1622,10 +1967,10 @@ bool editor::show_window() noexcept
                 }
             }
 
-            if (ImGui::MenuItem("Save as..."))
+            if (ImGui::MenuItem("Save as...", nullptr, false, !owned))
                 show_save_file_dialog = true;
 
-            if (ImGui::MenuItem("Close")) {
+            if (ImGui::MenuItem("Close", nullptr, false, !owned)) {
                 ImGui::EndMenu();
                 ImGui::EndMenuBar();
                 ImGui::End();
@@ -1641,7 +1986,7 @@ bool editor::show_window() noexcept
                             nullptr,
                             &settings.show_dynamics_inputs_in_editor);
             ImGui::Separator();
-            if (ImGui::MenuItem("Clear"))
+            if (ImGui::MenuItem("Clear", nullptr, false, !owned))
                 clear();
             ImGui::Separator();
             if (ImGui::MenuItem("Grid Reorder"))
@@ -1657,7 +2002,7 @@ bool editor::show_window() noexcept
 
         auto empty_fun = [this](irt::model_id /*id*/) {};
 
-        if (ImGui::BeginMenu("Examples")) {
+        if (ImGui::BeginMenu("Examples", !owned)) {
             if (ImGui::MenuItem("Insert example AQSS lotka_volterra"))
                 if (auto ret = add_lotka_volterra(); is_bad(ret))
                     log_w.log(3,
@@ -1819,14 +2164,20 @@ bool editor::show_window() noexcept
             log_w.log(
               5, "Load file from %s: ", (const char*)path.u8string().c_str());
             if (auto is = std::ifstream(path); is.is_open()) {
+                ImNodes::EditorContextSet(context);
+                const auto panning = ImNodes::EditorContextGetPanning();
+
                 reader r(is);
-                auto   ret = r(sim, srcs, [&r, this](model_id id) {
+                auto   ret = r(sim, srcs, [&](model_id id) {
                     const auto index = get_index(id);
                     const auto pos   = r.get_position(index);
 
-                    ImNodes::SetNodeEditorSpacePos(index, ImVec2(pos.x, pos.y));
+                    positions[index] =
+                      ImVec2(pos.x - panning.x, pos.y - panning.y);
                 });
 
+                grid.dirty = true;
+
                 if (is_success(ret))
                     log_w.log(5, "success\n");
                 else
@@ -1850,15 +2201,16 @@ bool editor::show_window() noexcept
                           "Write into file %s\n",
                           (const char*)path.u8string().c_str());
                 if (auto os = std::ofstream(path); os.is_open()) {
+                    ImNodes::EditorContextSet(context);
+                    const auto panning = ImNodes::EditorContextGetPanning();
+
                     writer w(os);
 
                     auto ret =
-                      w(sim, srcs, [](model_id mdl_id, float& x, float& y) {
+                      w(sim, srcs, [&](model_id mdl_id, float& x, float& y) {
                           const auto index = irt::get_index(mdl_id);
-                          const auto pos   = ImNodes::GetNodeEditorSpacePos(
-                            static_cast<int>(index));
-                          x = pos.x;
-                          y = pos.y;
+                          x = positions[index].x + panning.x;
+                          y = positions[index].y + panning.y;
                       });
 
                     if (is_success(ret))
@@ -19,6 +19,7 @@
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -28,23 +29,28 @@
 
 namespace irt {
 
+//! Called by the worker running the simulation: the graphical user interface
+//! drains the queue at each frame.
 static void
-push_data(std::vector<float>& xs,
-          std::vector<float>& ys,
-          const double x,
-          const double y) noexcept
+push_message(editor& ed, const plot_message& msg) noexcept
 {
-    if (xs.size() < xs.capacity()) {
-        xs.emplace_back(static_cast<float>(x));
-        ys.emplace_back(static_cast<float>(y));
+    while (!ed.runner.observations.push(msg)) {
+        notify_simulation_runners();
+        std::this_thread::yield();
     }
 }
 
 static void
-pop_data(std::vector<float>& xs, std::vector<float>& ys) noexcept
+push_data(editor& ed,
+          const plot_output_id id,
+          const double x,
+          const double y) noexcept
 {
-    ys.pop_back();
-    xs.pop_back();
+    push_message(ed,
+                 { id,
+                   plot_message_type::point,
+                   static_cast<real>(x),
+                   static_cast<real>(y) });
 }
 
 void
@@ -55,28 +61,26 @@ plot_output_callback(const irt::observer& obs,
                      const irt::observer::status s)
 {
     auto* plot_output = reinterpret_cast<irt::plot_output*>(obs.user_data);
+    auto& ed = *plot_output->ed;
+    const auto id = ed.plot_outs.get_id(*plot_output);
 
     if (s == irt::observer::status::initialize) {
-        plot_output->xs.clear();
-        plot_output->ys.clear();
-        plot_output->xs.reserve(4096u * 4096u);
-        plot_output->ys.reserve(4096u * 4096u);
+        push_message(ed, { id, plot_message_type::initialize });
         return;
     }
 
-    while (!plot_output->xs.empty() && plot_output->xs.back() == tl)
-        pop_data(plot_output->xs, plot_output->ys);
+    push_message(ed, { id, plot_message_type::truncate, tl });
 
     switch (type) {
     case irt::dynamics_type::qss1_integrator: {
         for (auto td = tl; td < t; td += plot_output->time_step) {
             const auto e = td - tl;
             const auto value = obs.msg[0] + obs.msg[1] * e;
-            push_data(plot_output->xs, plot_output->ys, td, value);
+            push_data(ed, id, td, value);
         }
         const auto e = t - tl;
         const auto value = obs.msg[0] + obs.msg[1] * e;
-        push_data(plot_output->xs, plot_output->ys, t, value);
+        push_data(ed, id, t, value);
     } break;
 
     case irt::dynamics_type::qss2_integrator: {
@@ -84,12 +88,12 @@ plot_output_callback(const irt::observer& obs,
             const auto e = td - tl;
             const auto value =
               obs.msg[0] + obs.msg[1] * e + (obs.msg[2] * e * e / two);
-            push_data(plot_output->xs, plot_output->ys, td, value);
+            push_data(ed, id, td, value);
         }
         const auto e = t - tl;
         const auto value =
           obs.msg[0] + obs.msg[1] * e + (obs.msg[2] * e * e / two);
-        push_data(plot_output->xs, plot_output->ys, t, value);
+        push_data(ed, id, t, value);
     } break;
 
     case irt::dynamics_type::qss3_integrator: {
@@ -98,17 +102,17 @@ plot_output_callback(const irt::observer& obs,
             const auto value = obs.msg[0] + obs.msg[1] * e +
                                (obs.msg[2] * e * e / two) +
                                (obs.msg[3] * e * e * e / three);
-            push_data(plot_output->xs, plot_output->ys, td, value);
+            push_data(ed, id, td, value);
         }
         const auto e = t - tl;
         const auto value = obs.msg[0] + obs.msg[1] * e +
                            (obs.msg[2] * e * e / two) +
                            (obs.msg[3] * e * e * e / three);
-        push_data(plot_output->xs, plot_output->ys, t, value);
+        push_data(ed, id, t, value);
     } break;
 
     default:
-        push_data(plot_output->xs, plot_output->ys, t, obs.msg[0]);
+        push_data(ed, id, t, obs.msg[0]);
         break;
     }
 }
@@ -257,61 +261,43 @@ static void
 show_simulation_run(window_logger& /*log_w*/, editor& ed)
 {
     ImGui::TextFormat("Current time {:.6f}", ed.simulation_current);
-    ImGui::TextFormat("Current bag {}", ed.simulation_bag_id);
+    ImGui::TextFormat("Events {}", ed.simulation_events);
     ImGui::TextFormat("Next time {:.6f}", ed.simulation_next_time);
-    ImGui::TextFormat("Model {}", (unsigned long)ed.sim.sched.size());
-
-    ImGui::SliderFloat("Speed",
-                       &ed.synchronize_timestep,
-                       0.00001f,
-                       1.0f,
-                       "%.6f",
-                       ImGuiSliderFlags_Logarithmic);
+    ImGui::TextFormat("Model {}", (unsigned long)ed.simulation_scheduled);
+
+    if (ImGui::SliderFloat("Speed",
+                           &ed.synchronize_timestep,
+                           0.00001f,
+                           1.0f,
+                           "%.6f",
+                           ImGuiSliderFlags_Logarithmic) &&
+        ed.is_simulation_owned())
+        ed.request_simulation(simulation_command_type::speed);
     ImGui::SameLine();
-    HelpMarker("1.0 means maximum speed to run simulation for all editors. "
+    HelpMarker("1.0 means maximum speed to run the simulation in a worker. "
                "Smaller values slow down the simulation speed.");
 
-    if (ImGui::Button("[]")) {
-        ed.sim.finalize(ed.simulation_current);
-        ed.simulation_current = ed.simulation_begin;
-        ed.simulation_bag_id = -1;
-        ed.simulation_during_date = ed.simulation_begin;
-        ed.st = editor_status::editing;
-    }
+    if (ImGui::Button("[]"))
+        ed.request_simulation(simulation_command_type::stop);
     ImGui::SameLine();
     if (ImGui::Button("||")) {
         if (ed.is_running())
-            ed.st = editor_status::running_pause;
+            ed.request_simulation(simulation_command_type::pause);
         else
-            ed.st = editor_status::running;
+            ed.request_simulation(simulation_command_type::run);
     }
     ImGui::SameLine();
-    if (ImGui::Button(">")) {
-        if (ed.st == editor_status::editing)
-            ed.simulation_bag_id = -1;
-        ed.st = editor_status::running;
-    }
+    if (ImGui::Button(">"))
+        ed.request_simulation(simulation_command_type::run);
     ImGui::SameLine();
-    if (ImGui::Button("+1")) {
-        if (ed.st == editor_status::editing)
-            ed.simulation_bag_id = -1;
-        ed.st = editor_status::running_1_step;
-        ed.step_by_step_bag = 0;
-    }
+    if (ImGui::Button("+1"))
+        ed.request_simulation(simulation_command_type::step, 1);
     ImGui::SameLine();
-    if (ImGui::Button("+10")) {
-        if (ed.st == editor_status::editing)
-            ed.simulation_bag_id = -1;
-        ed.st = editor_status::running_10_step;
-        ed.step_by_step_bag = 0;
-    }
+    if (ImGui::Button("+10"))
+        ed.request_simulation(simulation_command_type::step, 10);
     ImGui::SameLine();
-    if (ImGui::Button("+100")) {
-        if (ed.st == editor_status::editing)
-            ed.simulation_bag_id = -1;
-        ed.st = editor_status::running_100_step;
-        ed.step_by_step_bag = 0;
-    }
+    if (ImGui::Button("+100"))
+        ed.request_simulation(simulation_command_type::step, 100);
 }
 
 void
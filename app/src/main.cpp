@@ -3,14 +3,23 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 
 #include <irritator/core.hpp>
+#include <irritator/ensemble.hpp>
 #include <irritator/external_source.hpp>
+#include <irritator/file.hpp>
 #include <irritator/io.hpp>
+#include <irritator/trace.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <string>
 
 #include <fmt/format.h>
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 static inline std::string_view status_str[] = {
     "success",
@@ -22,6 +31,7 @@ static inline std::string_view status_str[] = {
     "simulation_not_enough_model",
     "simulation_not_enough_message",
     "simulation_not_enough_connection",
+    "simulation_not_enough_structural_change",
     "vector_init_capacity_error",
     "vector_not_enough_memory",
     "data_array_init_capacity_error",
@@ -61,13 +71,16 @@ static inline std::string_view status_str[] = {
     "io_file_format_dynamics_unknown",
     "io_file_format_dynamics_limit_reach",
     "io_file_format_dynamics_init_error",
+    "distributed_transport_error",
 };
 
 enum action_type
 {
     action_nothing,
+    action_ensemble,
     action_help,
     action_run,
+    action_trace,
     action_version
 };
 
@@ -79,7 +92,24 @@ enum status_type
     status_bad_begin_time_argument,
     status_bad_duration_time_argument,
     status_bad_models_argument,
-    status_bad_messages_argument
+    status_bad_messages_argument,
+    status_missing_ensemble_arguments,
+    status_bad_replicates_argument,
+    status_bad_threads_argument,
+    status_bad_seed_argument,
+    status_missing_trace_arguments,
+    status_unknown_option,
+    status_bad_observe_argument,
+    status_bad_output_argument,
+    status_bad_format_argument,
+    status_bad_progress_argument,
+    status_bad_checkpoint_argument
+};
+
+enum class output_format
+{
+    csv,
+    binary
 };
 
 struct main_action
@@ -98,8 +128,10 @@ struct main_action
     bool operator==(const std::string_view other) const noexcept;
 };
 
-main_action actions[] = { { action_help, "h", "help", 0 },
+main_action actions[] = { { action_ensemble, "e", "ensemble", 7 },
+                          { action_help, "h", "help", 0 },
                           { action_run, "r", "run", 2 },
+                          { action_trace, "t", "trace", 5 },
                           { action_version, "v", "version", 0 } };
 
 static inline std::string_view main_status_str[] = {
@@ -109,39 +141,70 @@ static inline std::string_view main_status_str[] = {
     "bad begin time argument",
     "bad duration time argument",
     "status bad models argument",
-    "status bad messages argument"
+    "status bad messages argument",
+    "missing ensemble arguments",
+    "bad replicates argument",
+    "bad threads argument",
+    "bad seed argument",
+    "missing trace arguments",
+    "unknown option",
+    "bad observe argument",
+    "bad output argument",
+    "bad format argument",
+    "bad progress argument",
+    "bad checkpoint argument"
 };
 
-//! Show help message in console.
-void show_help() noexcept;
-
-//! Show current version in console.
-void show_version() noexcept;
-
-//! Run simulation from simulation file.
-void run_simulation(irt::real   begin,
-                    irt::real   duration,
-                    int         models,
-                    int         messages,
-                    const char* file_name) noexcept;
-
 struct main_parameters
 {
-    irt::real   begin    = irt::zero;
-    irt::real   duration = irt::one;
-    int         models   = 2048;
-    int         messages = 4096;
-    status_type status   = status_success;
-    action_type action   = action_nothing;
-    int         files    = 0;
+    irt::real     begin      = irt::zero;
+    irt::real     duration   = irt::one;
+    int           models     = 0; //!< 0: computed from the file.
+    int           messages   = 0; //!< 0: computed from the file.
+    int           replicates = 1;
+    int           threads    = 1;
+    irt::u64      seed       = 5489u;
+    double        progress   = 0; //!< seconds between reports, 0: none.
+    const char*   trace_file = nullptr;
+    const char*   observe    = nullptr; //!< "all" or a list of model ids.
+    const char*   output     = nullptr; //!< `{}' is the input file stem.
+    const char*   checkpoint = nullptr; //!< `{}' is the input file stem.
+    const char*   restore    = nullptr; //!< `{}' is the input file stem.
+    double        checkpoint_period = 0; //!< seconds, 0: at the end only.
+    output_format format     = output_format::csv;
+    status_type   status     = status_success;
+    action_type   action     = action_nothing;
+
+    irt::vector<const char*> files;
 
     main_parameters() = default;
 
     static bool parse_real(const char* param, irt::real& out) noexcept;
     static bool parse_integer(const char* param, int& out) noexcept;
+    static bool parse_unsigned(const char* param, irt::u64& out) noexcept;
+    bool        parse_option(std::string_view option) noexcept;
     bool        parse(int argc, char* argv[]) noexcept;
 };
 
+//! Show help message in console.
+void show_help() noexcept;
+
+//! Show current version in console.
+void show_version() noexcept;
+
+//! Run the simulation files, in parallel if @c params.threads is greater
+//! than one.
+void run_simulations(const main_parameters& params) noexcept;
+
+//! Run simulation from simulation file. If @c params.trace_file is defined,
+//! write the Chrome trace of the run steps into this file.
+void run_simulation(const main_parameters& params,
+                    const char*            file_name) noexcept;
+
+//! Run replicates of the simulation file and print the final values.
+void run_ensemble(const main_parameters& params,
+                  const char*            file_name) noexcept;
+
 int main(int argc, char* argv[])
 {
     main_parameters params;
@@ -157,16 +220,17 @@ int main(int argc, char* argv[])
     switch (params.action) {
     case action_nothing:
         break;
+    case action_ensemble:
+        for (const auto* file : params.files)
+            run_ensemble(params, file);
+        fmt::print("\n\n");
+        break;
     case action_help:
         show_help();
         break;
     case action_run:
-        for (; params.files < argc; ++params.files)
-            run_simulation(params.begin,
-                           params.duration,
-                           params.models,
-                           params.messages,
-                           argv[params.files]);
+    case action_trace:
+        run_simulations(params);
         fmt::print("\n\n");
         break;
     case action_version:
@@ -211,7 +275,9 @@ bool main_parameters::parse_real(const char* param, irt::real& out) noexcept
 bool main_parameters::parse_integer(const char* param, int& out) noexcept
 {
     int result = 0;
-    if (auto read = std::sscanf(param, "%d", &result); read) {
+    int length = 0;
+    if (auto read = std::sscanf(param, "%d%n", &result, &length);
+        read == 1 && param[length] == '\0') {
         out = result;
         return true;
     }
@@ -219,6 +285,107 @@ bool main_parameters::parse_integer(const char* param, int& out) noexcept
     return false;
 }
 
+bool main_parameters::parse_unsigned(const char* param, irt::u64& out) noexcept
+{
+    unsigned long long result = 0;
+    int                length = 0;
+    if (auto read = std::sscanf(param, "%llu%n", &result, &length);
+        read == 1 && param[length] == '\0') {
+        out = static_cast<irt::u64>(result);
+        return true;
+    }
+
+    return false;
+}
+
+//! Check the `all' or `id[,id...]' list of the @c --observe option.
+static bool is_observe_list(std::string_view list) noexcept
+{
+    if (list == "all")
+        return true;
+
+    if (list.empty() || list.front() == ',' || list.back() == ',' ||
+        list.find(",,") != std::string_view::npos)
+        return false;
+
+    return list.find_first_not_of("0123456789,") == std::string_view::npos;
+}
+
+bool main_parameters::parse_option(std::string_view option) noexcept
+{
+    const auto equal = option.find('=');
+    const auto name  = option.substr(2, equal - 2);
+    const auto value = equal == std::string_view::npos
+                         ? std::string_view{}
+                         : option.substr(equal + 1);
+
+    // The value is the end of the argument: it is null terminated.
+    const char* str = value.data();
+
+    if (name == "models") {
+        if (!parse_integer(str, models) || models <= 0) {
+            status = status_bad_models_argument;
+            return false;
+        }
+    } else if (name == "messages") {
+        if (!parse_integer(str, messages) || messages <= 0) {
+            status = status_bad_messages_argument;
+            return false;
+        }
+    } else if (name == "threads") {
+        if (!parse_integer(str, threads) || threads <= 0) {
+            status = status_bad_threads_argument;
+            return false;
+        }
+    } else if (name == "observe") {
+        if (!is_observe_list(value)) {
+            status = status_bad_observe_argument;
+            return false;
+        }
+        observe = str;
+    } else if (name == "output") {
+        if (value.empty()) {
+            status = status_bad_output_argument;
+            return false;
+        }
+        output = str;
+    } else if (name == "format") {
+        if (value == "csv") {
+            format = output_format::csv;
+        } else if (value == "binary") {
+            format = output_format::binary;
+        } else {
+            status = status_bad_format_argument;
+            return false;
+        }
+    } else if (name == "progress") {
+        irt::real seconds = 0;
+        if (!parse_real(str, seconds) || seconds <= 0) {
+            status = status_bad_progress_argument;
+            return false;
+        }
+        progress = static_cast<double>(seconds);
+    } else if (name == "checkpoint" || name == "restore") {
+        if (value.empty()) {
+            status = status_bad_checkpoint_argument;
+            return false;
+        }
+        (name == "checkpoint" ? checkpoint : restore) = str;
+    } else if (name == "checkpoint-period") {
+        irt::real seconds = 0;
+        if (!parse_real(str, seconds) || seconds <= 0) {
+            status = status_bad_checkpoint_argument;
+            return false;
+        }
+        checkpoint_period = static_cast<double>(seconds);
+    } else {
+        status = status_unknown_option;
+        return false;
+    }
+
+    return true;
+}
+
 bool main_parameters::parse(int argc, char* argv[]) noexcept
 {
     if (argc <= 1)
@@ -237,41 +404,122 @@ bool main_parameters::parse(int argc, char* argv[]) noexcept
     if (it->argument == 0)
         return true;
 
-    if (it->type == action_run) {
-        if (5 < argc) {
-            if (!parse_real(argv[2], begin)) {
-                status = status_bad_begin_time_argument;
-                return false;
-            }
+    // The `--name=value' options are accepted anywhere after the action and
+    // override the positional arguments.
+    irt::vector<const char*> args(argc);
+    irt::vector<const char*> options(argc);
+    for (int i = 2; i < argc; ++i) {
+        if (std::string_view(argv[i]).starts_with("--"))
+            options.emplace_back(argv[i]);
+        else
+            args.emplace_back(argv[i]);
+    }
 
-            if (!parse_real(argv[3], duration)) {
-                status = status_bad_duration_time_argument;
+    if (args.ssize() < 2) {
+        status = status_missing_run_arguments;
+        return false;
+    }
+
+    if (!parse_real(args[0], begin)) {
+        status = status_bad_begin_time_argument;
+        return false;
+    }
+
+    if (!parse_real(args[1], duration)) {
+        status = status_bad_duration_time_argument;
+        return false;
+    }
+
+    // Count the integers after the duration to detect the optional
+    // models and messages arguments.
+    int next     = 2;
+    int integers = 0;
+    for (int value; next + integers < args.ssize() && integers < 5 &&
+                    parse_integer(args[next + integers], value);)
+        ++integers;
+
+    const bool with_capacity =
+      it->type == action_ensemble ? integers == 5 : integers >= 2;
+
+    if (with_capacity) {
+        if (!parse_integer(args[next], models) || models <= 0) {
+            status = status_bad_models_argument;
+            return false;
+        }
+
+        if (!parse_integer(args[next + 1], messages) || messages <= 0) {
+            status = status_bad_messages_argument;
+            return false;
+        }
+
+        next += 2;
+    }
+
+    if (it->type == action_trace) {
+        if (next < args.ssize()) {
+            trace_file = args[next++];
+        } else {
+            status = status_missing_trace_arguments;
+            return false;
+        }
+    }
+
+    if (it->type == action_ensemble) {
+        if (next + 2 < args.ssize()) {
+            if (!parse_integer(args[next], replicates) || replicates <= 0) {
+                status = status_bad_replicates_argument;
                 return false;
             }
 
-            if (!parse_integer(argv[4], models) || models < 0) {
-                status = status_bad_models_argument;
+            if (!parse_integer(args[next + 1], threads) || threads <= 0) {
+                status = status_bad_threads_argument;
                 return false;
             }
 
-            if (!parse_integer(argv[5], messages) || messages < 0) {
-                status = status_bad_messages_argument;
+            if (!parse_unsigned(args[next + 2], seed)) {
+                status = status_bad_seed_argument;
                 return false;
             }
         } else {
-            status = status_missing_run_arguments;
+            status = status_missing_ensemble_arguments;
             return false;
         }
+
+        next += 3;
+    }
+
+    files.reserve(args.ssize() - next);
+    for (; next < args.ssize(); ++next)
+        files.emplace_back(args[next]);
+
+    for (const auto* option : options)
+        if (!parse_option(option))
+            return false;
+
+    // Without the `{}' of the file stem, all the files write the same
+    // observations or checkpoint file.
+    const auto shared = [this](const char* name) noexcept {
+        return name && files.ssize() > 1 &&
+               std::string_view(name).find("{}") == std::string_view::npos;
+    };
+
+    if (observe && shared(output)) {
+        status = status_bad_output_argument;
+        return false;
+    }
+
+    if (shared(checkpoint) || shared(restore)) {
+        status = status_bad_checkpoint_argument;
+        return false;
     }
 
-    files = 6;
     return true;
 }
 
 void show_help() noexcept
 {
     fmt::print(
-      "irritator-cli action-name action-argument [files...]\n"
+      "irritator-cli action-name action-argument [options] [files...]\n"
       "\n\n"
       "help        This help message\n"
       "version     Version of irritator-cli\n"
@@ -281,8 +529,40 @@ void show_help() noexcept
       "	Need parameters:\n"
       "	- [real] The begin date of the begin date of the simulation\n"
       "	- [real] The duration of the simulation\n"
+      "	Optional parameters (computed from the files otherwise):\n"
       " - [integer] The number of models to pre-allocate\n"
       " - [integer] The number of messages to pre-allocate\n"
+      "ensemble    Run replicates of simulation files\n"
+      "	Need the run parameters and:\n"
+      " - [integer] The number of replicates\n"
+      " - [integer] The number of threads\n"
+      " - [integer] The seed of the random sources\n"
+      "	Print the final value of each model over the replicates as\n"
+      "	csv: model,count,mean,stddev,min,max\n"
+      "trace       Run simulation files and write a trace of the steps\n"
+      "	Need the run parameters and:\n"
+      " - [string] The Chrome trace_event JSON output file\n"
+      "\n"
+      "Options of run and trace:\n"
+      " --models=N         The number of models to pre-allocate\n"
+      " --messages=N       The number of messages to pre-allocate\n"
+      " --threads=N        Run the files in parallel on N threads\n"
+      " --observe=all|ID,.. Write the observations of the models (the\n"
+      "                    identifiers of the file)\n"
+      " --output=PATH      The observation file, `{{}}' is replaced by the\n"
+      "                    stem of the simulation file (default `{{}}.csv'\n"
+      "                    or `{{}}.bin')\n"
+      " --format=csv|binary csv lines `model,t,value' or the `irtobs01'\n"
+      "                    magic followed by native endian records\n"
+      "                    (u32 model, f64 t, f64 value)\n"
+      " --progress=SECONDS Print the simulated time, the events per second\n"
+      "                    and the estimated remaining time on stderr\n"
+      " --checkpoint=PATH  Write the state of the simulation at the end\n"
+      "                    (`{{}}' is replaced by the stem of the file)\n"
+      " --checkpoint-period=SECONDS Write the checkpoint periodically\n"
+      " --restore=PATH     Continue the simulation from a checkpoint of\n"
+      "                    the same file. The observations are appended:\n"
+      "                    those after the checkpoint are written again\n"
       "\n\n");
 }
 
@@ -295,65 +575,542 @@ void show_version() noexcept
                VERSION_TWEAK);
 }
 
-void run_simulation(irt::real   begin,
-                    irt::real   duration,
-                    int         models,
-                    int         messages,
-                    const char* file_name) noexcept
+#ifdef IRRITATOR_ENABLE_STATS
+static void print_stats(const irt::simulation& sim) noexcept
 {
-    fmt::print("Run simulation from `{}' to `{}' for file {}\n",
-               begin,
-               duration,
-               file_name);
+    const auto& st = sim.stats;
 
-    irt::simulation      sim;
-    irt::external_source srcs;
+    fmt::print("\nmodel,transitions,lambdas,messages_sent,messages_received,"
+               "messages_merged,inserts,updates,pops,cycles,"
+               "cycles_per_transition\n");
 
-    if (irt::is_bad(sim.init(static_cast<unsigned>(models),
-                             static_cast<unsigned>(messages)))) {
-        fmt::print(stderr, "Fail to allocate {} models\n", models);
+    for (irt::sz i = 0; i != irt::dynamics_type_size(); ++i) {
+        const auto& c = st.types[i];
+        if (!c.transitions && !c.inserts)
+            continue;
+
+        fmt::print("{},{},{},{},{},{},{},{},{},{},{:.1f}\n",
+                   irt::dynamics_type_names[i],
+                   c.transitions,
+                   c.lambdas,
+                   c.messages_sent,
+                   c.messages_received,
+                   c.messages_merged,
+                   c.inserts,
+                   c.updates,
+                   c.pops,
+                   c.cycles,
+                   c.transitions ? static_cast<double>(c.cycles) /
+                                     static_cast<double>(c.transitions)
+                                 : 0.0);
+    }
+
+    fmt::print("\nbag_size,bags\n");
+    for (int i = 0; i != irt::simulation_stats::bag_histogram_size; ++i)
+        if (st.bags[i])
+            fmt::print("{},{}\n", irt::i64{ 1 } << i, st.bags[i]);
+
+    fmt::print("\nallocator,peak\n"
+               "message,{}\nnode,{}\nrecord,{}\ndated_message,{}\n",
+               st.message_peak,
+               st.node_peak,
+               st.record_peak,
+               st.dated_message_peak);
+}
+#endif
+
+//! @brief Buffer the observations and write them into a file by large
+//! blocks.
+//!
+//! The observer callbacks only copy the values into the buffer: the
+//! formatting of the csv lines is the only cost in the simulation loop.
+class observation_sink
+{
+public:
+    static constexpr int buffer_size = 1 << 20;
+    static constexpr int line_size   = 128;
+
+    observation_sink() noexcept = default;
+    observation_sink(const observation_sink&) = delete;
+    observation_sink& operator=(const observation_sink&) = delete;
+
+    ~observation_sink() noexcept { close(); }
+
+    //! Open the file, @c keep appends to the observations of a previous run.
+    bool open(const char* file_name, output_format format, bool keep) noexcept
+    {
+        m_buffer.resize(buffer_size);
+        if (m_buffer.ssize() != buffer_size)
+            return false;
+
+        std::error_code ec;
+        const bool empty = !keep || !std::filesystem::exists(file_name, ec) ||
+                           std::filesystem::file_size(file_name, ec) == 0;
+
+        m_file   = std::fopen(file_name, keep ? "ab" : "wb");
+        m_format = format;
+        m_size   = 0;
+        m_error  = m_file == nullptr;
+
+        if (m_file && empty) {
+            if (format == output_format::csv)
+                append("model,t,value\n", 14);
+            else
+                append("irtobs01", 8);
+        }
+
+        return m_file != nullptr;
+    }
+
+    void write(irt::u32 model, irt::time t, irt::real value) noexcept
+    {
+        if (m_size + line_size > buffer_size)
+            flush();
+
+        if (m_format == output_format::csv) {
+            const auto ret = fmt::format_to_n(m_buffer.data() + m_size,
+                                              line_size,
+                                              "{},{},{}\n",
+                                              model,
+                                              t,
+                                              value);
+            m_size += static_cast<int>(ret.size);
+        } else {
+            const double values[2] = { static_cast<double>(t),
+                                       static_cast<double>(value) };
+            append(&model, sizeof(model));
+            append(values, sizeof(values));
+        }
+    }
+
+    //! Write the buffer into the file.
+    void flush() noexcept
+    {
+        if (!m_file)
+            return;
+
+        if (m_size > 0 && std::fwrite(m_buffer.data(),
+                                      1,
+                                      static_cast<size_t>(m_size),
+                                      m_file) != static_cast<size_t>(m_size))
+            m_error = true;
+
+        m_size = 0;
+        if (std::fflush(m_file) != 0)
+            m_error = true;
+    }
+
+    //! Write the buffer and close the file. Returns false if a write fails.
+    bool close() noexcept
+    {
+        if (m_file) {
+            flush();
+            m_error = std::fclose(m_file) != 0 || m_error;
+            m_file  = nullptr;
+        }
+
+        return !m_error;
+    }
+
+private:
+    void append(const void* data, int size) noexcept
+    {
+        std::memcpy(m_buffer.data() + m_size, data, static_cast<size_t>(size));
+        m_size += size;
+    }
+
+    irt::vector<char> m_buffer;
+    std::FILE*        m_file   = nullptr;
+    int               m_size   = 0;
+    output_format     m_format = output_format::csv;
+    bool              m_error  = false;
+};
+
+//! The @c observer::user_data of the observed models.
+struct observed_model
+{
+    observation_sink* sink;
+    irt::u32          id; //!< The model identifier in the simulation file.
+};
+
+static void observation_sink_callback(const irt::observer& obs,
+                                      const irt::dynamics_type /*type*/,
+                                      const irt::time /*tl*/,
+                                      const irt::time             t,
+                                      const irt::observer::status s) noexcept
+{
+    if (s == irt::observer::status::initialize)
         return;
+
+    auto* observed = reinterpret_cast<observed_model*>(obs.user_data);
+    observed->sink->write(observed->id, t, obs.msg.data[0]);
+}
+
+//! Replace the `{}' of @c pattern by the stem of the simulation file.
+static std::string make_file_name(const char* pattern,
+                                  const char* file_name) noexcept
+{
+    std::string name = pattern;
+
+    if (auto pos = name.find("{}"); pos != std::string::npos)
+        name.replace(
+          pos, 2, std::filesystem::path(file_name).stem().string());
+
+    return name;
+}
+
+//! Write the checkpoint into a temporary file renamed at the end: a job
+//! preempted during the write keeps the previous checkpoint.
+static bool write_checkpoint(const std::string&          path,
+                             const irt::simulation&      sim,
+                             irt::external_source&       srcs,
+                             irt::time                   t) noexcept
+{
+    const auto temp = path + ".tmp";
+
+    {
+        irt::file f(temp.c_str(), irt::open_mode::write);
+        if (!f.is_open() || irt::is_bad(srcs.checkpoint(f)) ||
+            irt::is_bad(sim.checkpoint(f, t)) || !f.flush())
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+
+    return !ec;
+}
+
+//! Observe the models of the @c params.observe list. The file identifiers
+//! are mapped to the simulation models with the @c reader.
+static bool observe_models(const main_parameters&        params,
+                           const char*                   file_name,
+                           const irt::reader&            reader,
+                           irt::simulation&              sim,
+                           observation_sink&             sink,
+                           irt::vector<observed_model>& observed) noexcept
+{
+    const auto observe_model = [&](int id) noexcept -> bool {
+        const auto mdl_id = reader.get_model(id);
+        auto*      mdl    = sim.models.try_to_get(mdl_id);
+
+        if (!mdl) {
+            fmt::print(stderr, "Unknown model {} in `{}'\n", id, file_name);
+            return false;
+        }
+
+        if (!sim.observers.can_alloc(1))
+            return false;
+
+        auto& obs_data = observed.emplace_back(
+          observed_model{ &sink, static_cast<irt::u32>(id) });
+        auto& obs =
+          sim.observers.alloc("out", observation_sink_callback, &obs_data);
+        sim.observe(*mdl, obs);
+
+        return true;
+    };
+
+    const std::string_view list = params.observe;
+    observed.reserve(list == "all" ? reader.model_count()
+                                   : static_cast<int>(std::count(
+                                       list.begin(), list.end(), ',')) +
+                                       1);
+
+    if (list == "all") {
+        for (int id = 0, e = reader.model_count(); id != e; ++id)
+            if (!observe_model(id))
+                return false;
+
+        return true;
+    }
+
+    for (const char* str = params.observe; *str;) {
+        char* end = nullptr;
+        const auto id = static_cast<int>(std::strtol(str, &end, 10));
+
+        if (!observe_model(id))
+            return false;
+
+        str = *end == ',' ? end + 1 : end;
+    }
+
+    return true;
+}
+
+//! Print the simulated time, the events per second and the estimated
+//! remaining time on stderr every @c params.progress seconds.
+class progress_reporter
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    progress_reporter(const main_parameters& params,
+                      const char*            file_name) noexcept
+      : m_file_name(file_name)
+      , m_begin(params.begin)
+      , m_end(params.begin + params.duration)
+      , m_period(params.progress)
+      , m_start(clock::now())
+      , m_last(m_start)
+    {}
+
+    //! Count the transitions of a @c run_until call and check the clock.
+    void update(irt::time t, irt::i64 transitions) noexcept
+    {
+        m_events += transitions;
+
+        if (m_period <= 0)
+            return;
+
+        const auto now     = clock::now();
+        const auto elapsed = std::chrono::duration<double>(now - m_last);
+        if (elapsed.count() < m_period)
+            return;
+
+        const auto total = std::chrono::duration<double>(now - m_start);
+        const auto done  = static_cast<double>((t - m_begin) / (m_end - m_begin));
+        const auto eta   = irt::time_domain<irt::time>::is_infinity(t) ? 0.0
+                           : done > 0 ? total.count() * (1.0 - done) / done
+                                      : 0.0;
+
+        fmt::print(stderr,
+                   "{}: t={} ({:.1f}%) {:.0f} events/s ETA {:.0f}s\n",
+                   m_file_name,
+                   t,
+                   std::min(done, 1.0) * 100.0,
+                   static_cast<double>(m_events - m_last_events) /
+                     elapsed.count(),
+                   eta);
+
+        m_last        = now;
+        m_last_events = m_events;
     }
 
+private:
+    const char*       m_file_name;
+    irt::time         m_begin;
+    irt::time         m_end;
+    double            m_period;
+    clock::time_point m_start;
+    clock::time_point m_last;
+    irt::i64          m_events      = 0;
+    irt::i64          m_last_events = 0;
+};
+
+//! Read the simulation file into @c sim. Without the @c params.models and
+//! @c params.messages capacities, the simulation is allocated from the
+//! number of models of the file header.
+static bool read_simulation(const main_parameters& params,
+                            const char*            file_name,
+                            std::ifstream&         ifs,
+                            irt::reader&           reader,
+                            irt::simulation&       sim,
+                            irt::external_source&  srcs,
+                            int&                   models,
+                            int&                   messages) noexcept
+{
     if (irt::is_bad(srcs.init(64u))) {
         fmt::print(stderr, "Fail to allocate 64 external sources\n");
-        return;
+        return false;
     }
 
-    std::ifstream ifs(file_name);
-    if (ifs.bad()) {
+    if (!ifs.is_open()) {
         fmt::print(stderr, "Fail to open file `{}'\n", file_name);
-        return;
+        return false;
     }
 
-    irt::reader reader(ifs);
-    if (auto ret = reader(sim, srcs); irt::is_bad(ret)) {
+    if (auto ret = reader.read_header(srcs); irt::is_bad(ret)) {
         fmt::print(stderr,
                    "Fail to read file `{}' ({})\n",
                    file_name,
                    status_str[irt::ordinal(ret)]);
+        return false;
+    }
+
+    // Place for the models and the observers, and for the emitting output
+    // ports of the models with several outputs.
+    models   = params.models ? params.models : reader.model_count() * 4 + 64;
+    messages = params.messages ? params.messages : models * 8;
+
+    if (irt::is_bad(sim.init(static_cast<unsigned>(models),
+                             static_cast<unsigned>(messages)))) {
+        fmt::print(stderr, "Fail to allocate {} models\n", models);
+        return false;
+    }
+
+    if (auto ret = reader.read_models(sim); irt::is_bad(ret)) {
+        fmt::print(stderr,
+                   "Fail to read file `{}' ({})\n",
+                   file_name,
+                   status_str[irt::ordinal(ret)]);
+        return false;
+    }
+
+    return true;
+}
+
+void run_simulations(const main_parameters& params) noexcept
+{
+    if (params.threads <= 1 || params.files.ssize() <= 1) {
+        for (const auto* file : params.files)
+            run_simulation(params, file);
+
+        return;
+    }
+
+    irt::task_manager_parameters init{ .thread_number = params.threads - 1,
+                                       .simple_task_list_number = 1,
+                                       .multi_task_list_number  = 0 };
+
+    irt::task_manager tm;
+    if (auto ret = tm.init(init); irt::is_bad(ret)) {
+        fmt::print(stderr, "Fail to start {} threads\n", params.threads);
         return;
     }
 
+    for (auto& w : tm.workers)
+        w.task_lists.emplace_back(&tm.task_lists[0]);
+    tm.start();
+
+    irt::parallel_for(tm.task_lists[0],
+                      0,
+                      params.files.ssize(),
+                      1,
+                      [&params](irt::i32 first, irt::i32 last) noexcept {
+                          for (; first != last; ++first)
+                              run_simulation(params, params.files[first]);
+                      });
+
+    tm.finalize();
+}
+
+void run_simulation(const main_parameters& params,
+                    const char*            file_name) noexcept
+{
+    irt::simulation      sim;
+    irt::external_source srcs;
+    std::ifstream        ifs(file_name);
+    irt::reader          reader(ifs);
+    int                  models   = 0;
+    int                  messages = 0;
+
+    if (!read_simulation(
+          params, file_name, ifs, reader, sim, srcs, models, messages))
+        return;
+
+    fmt::print("Run simulation from `{}' to `{}' for file {} ({} models, {} "
+               "messages)\n",
+               params.begin,
+               params.duration,
+               file_name,
+               models,
+               messages);
+
+    observation_sink            sink;
+    irt::vector<observed_model> observed;
+
+    if (params.observe) {
+        const auto output = make_file_name(
+          params.output                                ? params.output
+          : params.format == output_format::csv ? "{}.csv"
+                                                : "{}.bin",
+          file_name);
+
+        if (!sink.open(output.c_str(), params.format, params.restore)) {
+            fmt::print(stderr, "Fail to open output file `{}'\n", output);
+            return;
+        }
+
+        if (!observe_models(params, file_name, reader, sim, sink, observed)) {
+            fmt::print(stderr, "Fail to observe models of `{}'\n", file_name);
+            return;
+        }
+    }
+
     irt::status ret;
-    irt::time   t   = begin;
-    irt::time   end = begin + duration;
+    irt::time   t   = params.begin;
+    irt::time   end = params.begin + params.duration;
+
+    irt_stats(sim.stats.measure_cycles = true);
+
+    irt::tracer tr;
+    if (params.trace_file) {
+        if (auto ret = tr.init(1, 1 << 22); irt::is_bad(ret)) {
+            fmt::print(stderr, "Fail to allocate the trace buffer\n");
+            return;
+        }
+
+        tr.attach(sim);
+    }
+
+    progress_reporter progress(params, file_name);
+
+    if (params.restore) {
+        const auto path = make_file_name(params.restore, file_name);
+
+        irt::file f(path.c_str(), irt::open_mode::read);
+        if (!f.is_open()) {
+            fmt::print(stderr, "Fail to open checkpoint `{}'\n", path);
+            return;
+        }
 
-    if (ret = sim.initialize(t); is_bad(ret)) {
+        if (ret = srcs.restore(f); is_success(ret))
+            ret = sim.restore(f, t);
+
+        if (is_bad(ret)) {
+            fmt::print(stderr,
+                       "Fail to restore checkpoint `{}': {}\n",
+                       path,
+                       status_str[irt::ordinal(ret)]);
+            return;
+        }
+    } else if (ret = sim.initialize(t); is_bad(ret)) {
         fmt::print(
           stderr, "Fail in simulation: {}\n", status_str[irt::ordinal(ret)]);
         return;
     }
 
-    do {
-        if (ret = sim.run(t); is_bad(ret)) {
+    const auto checkpoint =
+      params.checkpoint ? make_file_name(params.checkpoint, file_name)
+                        : std::string{};
+    auto last_checkpoint = std::chrono::steady_clock::now();
+
+    // The transitions run by each run_until call between two checks of the
+    // progress and checkpoint clocks.
+    constexpr irt::i64 events_per_call = 1 << 16;
+
+    // The observations written before a checkpoint are not written again
+    // by a restart.
+    const auto save = [&]() noexcept {
+        sink.flush();
+        if (!write_checkpoint(checkpoint, sim, srcs, t))
+            fmt::print(stderr, "Fail to write checkpoint `{}'\n", checkpoint);
+    };
+
+    while (t < end) {
+        irt::i64 events = events_per_call;
+        if (ret = sim.run_until(t, end, events); is_bad(ret)) {
             fmt::print(stderr,
                        "Fail in simulation: {}\n",
                        status_str[irt::ordinal(ret)]);
             break;
         }
 
-    } while (t < end);
+        progress.update(t, events_per_call - events);
+
+        if (params.checkpoint_period > 0 && !checkpoint.empty()) {
+            const auto now = std::chrono::steady_clock::now();
+            if (std::chrono::duration<double>(now - last_checkpoint).count() >=
+                params.checkpoint_period) {
+                save();
+                last_checkpoint = now;
+            }
+        }
+    }
+
+    if (is_success(ret) && !checkpoint.empty())
+        save();
 
     if (ret = sim.finalize(t); is_bad(ret)) {
         fmt::print(stderr,
@@ -361,5 +1118,96 @@ void run_simulation(irt::real   begin,
                    status_str[irt::ordinal(ret)]);
     }
 
+    irt_stats(print_stats(sim));
+
+    if (params.observe && !sink.close())
+        fmt::print(stderr, "Fail to write observations of `{}'\n", file_name);
+
+    if (params.trace_file) {
+        std::ofstream ofs(params.trace_file);
+        if (!ofs.is_open() || irt::is_bad(tr.write(ofs)))
+            fmt::print(
+              stderr, "Fail to write trace file `{}'\n", params.trace_file);
+        else if (tr.dropped())
+            fmt::print(stderr,
+                       "Trace buffer full: {} events dropped\n",
+                       tr.dropped());
+    }
+
     fmt::print("\n\n");
 }
+
+void run_ensemble(const main_parameters& params, const char* file_name) noexcept
+{
+    fmt::print(stderr,
+               "Run {} replicates from `{}' to `{}' for file {}\n",
+               params.replicates,
+               params.begin,
+               params.duration,
+               file_name);
+
+    irt::simulation      sim;
+    irt::external_source srcs;
+    std::ifstream        ifs(file_name);
+    irt::reader          reader(ifs);
+    int                  models   = 0;
+    int                  messages = 0;
+
+    if (!read_simulation(
+          params, file_name, ifs, reader, sim, srcs, models, messages))
+        return;
+
+    irt::task_manager_parameters init{ .thread_number = params.threads,
+                                       .simple_task_list_number = 1,
+                                       .multi_task_list_number  = 0 };
+
+    irt::task_manager tm;
+    if (auto ret = tm.init(init); irt::is_bad(ret)) {
+        fmt::print(stderr, "Fail to start {} threads\n", params.threads);
+        return;
+    }
+
+    for (auto& w : tm.workers)
+        w.task_lists.emplace_back(&tm.task_lists[0]);
+    tm.start();
+
+    irt::ensemble_parameters ens_params;
+    ens_params.replicates       = params.replicates;
+    ens_params.workers          = params.threads;
+    ens_params.model_capacity   = static_cast<irt::sz>(models);
+    ens_params.message_capacity = static_cast<irt::sz>(messages);
+    ens_params.seed             = params.seed;
+
+    irt::ensemble ens;
+    irt::status   ret = ens.init(ens_params);
+
+    if (irt::is_success(ret)) {
+        ens.observe_all(sim);
+        ret = ens.run(tm.task_lists[0],
+                      sim,
+                      srcs,
+                      params.begin,
+                      params.begin + params.duration,
+                      nullptr,
+                      nullptr);
+    }
+
+    tm.finalize();
+
+    if (irt::is_bad(ret))
+        fmt::print(stderr,
+                   "Fail in ensemble: {}\n",
+                   status_str[irt::ordinal(ret)]);
+
+    fmt::print("model,count,mean,stddev,min,max\n");
+    for (int i = 0, e = ens.observed.ssize(); i != e; ++i) {
+        const auto& stat = ens.statistics[i];
+        fmt::print("{},{},{},{},{},{}\n",
+                   irt::get_index(ens.observed[i]),
+                   stat.count,
+                   stat.mean,
+                   stat.stddev,
+                   stat.min,
+                   stat.max);
+    }
+}
@@ -0,0 +1,990 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_2021_BENCHMARK_HPP
+#define ORG_VLEPROJECT_IRRITATOR_2021_BENCHMARK_HPP
+
+#include <irritator/core.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+//! Helpers shared by the timing and exactitude benchmarks: the counting
+//! allocator, the LIF, Izhikevich and synapse builders for QSS1/2/3 and
+//! AQSS (integrator, quantifier) solvers, the @c .mtx reader and the
+//! machine-readable output.
+namespace bench {
+
+using irt::i64;
+using irt::real;
+using irt::sz;
+using irt::status;
+
+//! The @c Level template parameter of the builders: 1, 2 and 3 for QSS
+//! solvers, @c aqss for the integrator and quantifier solver.
+constexpr int aqss = 0;
+
+constexpr std::string_view solver_name(int level) noexcept
+{
+    return level == 1   ? "qss1"
+           : level == 2 ? "qss2"
+           : level == 3 ? "qss3"
+                        : "aqss";
+}
+
+/*****************************************************************************
+ *
+ * Memory
+ *
+ ****************************************************************************/
+
+//! Replace the irritator allocator with a counting allocator to report the
+//! peak memory of each run. Call @c install before any allocation.
+struct memory_counter
+{
+    static inline sz current = 0;
+    static inline sz peak    = 0;
+
+    static void* alloc(sz size) noexcept
+    {
+        auto* ptr = static_cast<sz*>(std::malloc(size + sizeof(sz) * 2));
+        if (!ptr)
+            return nullptr;
+
+        ptr[0] = size;
+        current += size;
+        peak = std::max(peak, current);
+
+        return ptr + 2;
+    }
+
+    static void free(void* ptr) noexcept
+    {
+        if (!ptr)
+            return;
+
+        auto* base = static_cast<sz*>(ptr) - 2;
+        current -= base[0];
+        std::free(base);
+    }
+
+    static void install() noexcept
+    {
+        irt::g_alloc_fn = alloc;
+        irt::g_free_fn  = free;
+    }
+
+    static void reset_peak() noexcept { peak = current; }
+};
+
+/*****************************************************************************
+ *
+ * Network
+ *
+ ****************************************************************************/
+
+//! An output port of a model.
+struct output
+{
+    irt::model_id model = irt::undefined<irt::model_id>();
+    int           port  = 0;
+};
+
+inline status connect(irt::simulation& sim,
+                      output           src,
+                      irt::model_id    dst,
+                      int              port) noexcept
+{
+    auto* src_mdl = sim.models.try_to_get(src.model);
+    auto* dst_mdl = sim.models.try_to_get(dst);
+    irt_return_if_fail(src_mdl && dst_mdl, status::unknown_dynamics);
+
+    return sim.connect(*src_mdl, src.port, *dst_mdl, port);
+}
+
+template<typename Src, typename Dst>
+inline status connect(irt::simulation& sim,
+                      Src&             src,
+                      int              port_src,
+                      Dst&             dst,
+                      int              port_dst) noexcept
+{
+    return sim.connect(src, port_src, dst, port_dst);
+}
+
+struct lif_parameters
+{
+    real quantum = 0.01;
+    real tau     = 10.0;
+    real Vt      = 1.0;  //!< threshold.
+    real V0      = 2.0;  //!< asymptotic potential.
+    real Vr      = 0.0;  //!< reset potential.
+};
+
+struct izhikevich_parameters
+{
+    real quantum = 0.01;
+    real a       = 0.02;
+    real b       = 0.2;
+    real c       = -65.0;
+    real d       = 8.0;
+    real I       = 10.0;
+    real vini    = 0.0;
+};
+
+//! Models of a neuron: the spike output and the observed state variables.
+struct neuron
+{
+    output        spike;
+    irt::model_id potential = irt::undefined<irt::model_id>();
+    irt::model_id recovery  = irt::undefined<irt::model_id>();
+};
+
+template<int Level>
+status make_lif(irt::simulation&      sim,
+                const lif_parameters& p,
+                neuron&               out) noexcept
+{
+    irt_return_if_fail(sim.can_alloc(6) && sim.can_connect(9),
+                       status::simulation_not_enough_model);
+
+    auto& cst         = sim.alloc<irt::constant>();
+    cst.default_value = 1.0;
+
+    auto& cst_cross         = sim.alloc<irt::constant>();
+    cst_cross.default_value = p.Vr;
+
+    if constexpr (Level == aqss) {
+        auto& sum        = sim.alloc<irt::adder_2>();
+        auto& integrator = sim.alloc<irt::integrator>();
+        auto& quantifier = sim.alloc<irt::quantifier>();
+        auto& cross      = sim.alloc<irt::cross>();
+
+        sum.default_input_coeffs[0] = -irt::one / p.tau;
+        sum.default_input_coeffs[1] = p.V0 / p.tau;
+
+        integrator.default_current_value = 0.0;
+
+        quantifier.default_adapt_state =
+          irt::quantifier::adapt_state::possible;
+        quantifier.default_zero_init_offset = true;
+        quantifier.default_step_size        = p.quantum;
+        quantifier.default_past_length      = 3;
+
+        cross.default_threshold = p.Vt;
+
+        irt_return_if_bad(connect(sim, quantifier, 0, integrator, 0));
+        irt_return_if_bad(connect(sim, sum, 0, integrator, 1));
+        irt_return_if_bad(connect(sim, cross, 0, integrator, 2));
+        irt_return_if_bad(connect(sim, cross, 0, quantifier, 0));
+        irt_return_if_bad(connect(sim, cross, 0, sum, 0));
+        irt_return_if_bad(connect(sim, integrator, 0, cross, 0));
+        irt_return_if_bad(connect(sim, integrator, 0, cross, 2));
+        irt_return_if_bad(connect(sim, cst_cross, 0, cross, 1));
+        irt_return_if_bad(connect(sim, cst, 0, sum, 1));
+
+        out.spike     = { sim.get_id(cross), 1 };
+        out.potential = sim.get_id(integrator);
+    } else {
+        auto& sum        = sim.alloc<irt::abstract_wsum<Level, 2>>();
+        auto& integrator = sim.alloc<irt::abstract_integrator<Level>>();
+        auto& cross      = sim.alloc<irt::abstract_cross<Level>>();
+
+        sum.default_input_coeffs[0] = -irt::one / p.tau;
+        sum.default_input_coeffs[1] = p.V0 / p.tau;
+
+        integrator.default_X  = 0.0;
+        integrator.default_dQ = p.quantum;
+
+        cross.default_threshold = p.Vt;
+
+        irt_return_if_bad(connect(sim, cross, 0, integrator, 1));
+        irt_return_if_bad(connect(sim, cross, 1, sum, 0));
+        irt_return_if_bad(connect(sim, integrator, 0, cross, 0));
+        irt_return_if_bad(connect(sim, integrator, 0, cross, 2));
+        irt_return_if_bad(connect(sim, cst_cross, 0, cross, 1));
+        irt_return_if_bad(connect(sim, cst, 0, sum, 1));
+        irt_return_if_bad(connect(sim, sum, 0, integrator, 0));
+
+        out.spike     = { sim.get_id(cross), 1 };
+        out.potential = sim.get_id(integrator);
+    }
+
+    return status::success;
+}
+
+template<int Level>
+status make_izhikevich(irt::simulation&             sim,
+                       const izhikevich_parameters& p,
+                       neuron&                      out) noexcept
+{
+    irt_return_if_fail(sim.can_alloc(14) && sim.can_connect(28),
+                       status::simulation_not_enough_model);
+
+    constexpr real vt = 30.0;
+
+    auto& cst          = sim.alloc<irt::constant>();
+    auto& cst2         = sim.alloc<irt::constant>();
+    auto& cst3         = sim.alloc<irt::constant>();
+    cst.default_value  = 1.0;
+    cst2.default_value = p.c;
+    cst3.default_value = p.I;
+
+    if constexpr (Level == aqss) {
+        auto& sum_a        = sim.alloc<irt::adder_2>();
+        auto& sum_b        = sim.alloc<irt::adder_2>();
+        auto& sum_c        = sim.alloc<irt::adder_4>();
+        auto& sum_d        = sim.alloc<irt::adder_2>();
+        auto& product      = sim.alloc<irt::mult_2>();
+        auto& integrator_a = sim.alloc<irt::integrator>();
+        auto& integrator_b = sim.alloc<irt::integrator>();
+        auto& quantifier_a = sim.alloc<irt::quantifier>();
+        auto& quantifier_b = sim.alloc<irt::quantifier>();
+        auto& cross        = sim.alloc<irt::cross>();
+        auto& cross2       = sim.alloc<irt::cross>();
+
+        cross.default_threshold  = vt;
+        cross2.default_threshold = vt;
+
+        integrator_a.default_current_value = p.vini;
+        integrator_b.default_current_value = 0.0;
+
+        for (auto* q : { &quantifier_a, &quantifier_b }) {
+            q->default_adapt_state = irt::quantifier::adapt_state::possible;
+            q->default_zero_init_offset = true;
+            q->default_step_size        = p.quantum;
+            q->default_past_length      = 3;
+        }
+
+        product.default_input_coeffs[0] = 1.0;
+        product.default_input_coeffs[1] = 1.0;
+        sum_a.default_input_coeffs[0]   = 1.0;
+        sum_a.default_input_coeffs[1]   = -1.0;
+        sum_b.default_input_coeffs[0]   = -p.a;
+        sum_b.default_input_coeffs[1]   = p.a * p.b;
+        sum_c.default_input_coeffs[0]   = 0.04;
+        sum_c.default_input_coeffs[1]   = 5.0;
+        sum_c.default_input_coeffs[2]   = 140.0;
+        sum_c.default_input_coeffs[3]   = 1.0;
+        sum_d.default_input_coeffs[0]   = 1.0;
+        sum_d.default_input_coeffs[1]   = p.d;
+
+        irt_return_if_bad(connect(sim, integrator_a, 0, cross, 0));
+        irt_return_if_bad(connect(sim, cst2, 0, cross, 1));
+        irt_return_if_bad(connect(sim, integrator_a, 0, cross, 2));
+        irt_return_if_bad(connect(sim, cross, 0, quantifier_a, 0));
+        irt_return_if_bad(connect(sim, cross, 0, product, 0));
+        irt_return_if_bad(connect(sim, cross, 0, product, 1));
+        irt_return_if_bad(connect(sim, product, 0, sum_c, 0));
+        irt_return_if_bad(connect(sim, cross, 0, sum_c, 1));
+        irt_return_if_bad(connect(sim, cross, 0, sum_b, 1));
+        irt_return_if_bad(connect(sim, cst, 0, sum_c, 2));
+        irt_return_if_bad(connect(sim, cst3, 0, sum_c, 3));
+        irt_return_if_bad(connect(sim, sum_c, 0, sum_a, 0));
+        irt_return_if_bad(connect(sim, cross2, 0, sum_a, 1));
+        irt_return_if_bad(connect(sim, sum_a, 0, integrator_a, 1));
+        irt_return_if_bad(connect(sim, cross, 0, integrator_a, 2));
+        irt_return_if_bad(connect(sim, quantifier_a, 0, integrator_a, 0));
+        irt_return_if_bad(connect(sim, cross2, 0, quantifier_b, 0));
+        irt_return_if_bad(connect(sim, cross2, 0, sum_b, 0));
+        irt_return_if_bad(connect(sim, quantifier_b, 0, integrator_b, 0));
+        irt_return_if_bad(connect(sim, sum_b, 0, integrator_b, 1));
+        irt_return_if_bad(connect(sim, cross2, 0, integrator_b, 2));
+        irt_return_if_bad(connect(sim, integrator_a, 0, cross2, 0));
+        irt_return_if_bad(connect(sim, integrator_b, 0, cross2, 2));
+        irt_return_if_bad(connect(sim, sum_d, 0, cross2, 1));
+        irt_return_if_bad(connect(sim, integrator_b, 0, sum_d, 0));
+        irt_return_if_bad(connect(sim, cst, 0, sum_d, 1));
+
+        out.spike     = { sim.get_id(cross), 1 };
+        out.potential = sim.get_id(integrator_a);
+        out.recovery  = sim.get_id(integrator_b);
+    } else {
+        auto& sum_a        = sim.alloc<irt::abstract_wsum<Level, 2>>();
+        auto& sum_b        = sim.alloc<irt::abstract_wsum<Level, 2>>();
+        auto& sum_c        = sim.alloc<irt::abstract_wsum<Level, 4>>();
+        auto& sum_d        = sim.alloc<irt::abstract_wsum<Level, 2>>();
+        auto& product      = sim.alloc<irt::abstract_multiplier<Level>>();
+        auto& integrator_a = sim.alloc<irt::abstract_integrator<Level>>();
+        auto& integrator_b = sim.alloc<irt::abstract_integrator<Level>>();
+        auto& cross        = sim.alloc<irt::abstract_cross<Level>>();
+        auto& cross2       = sim.alloc<irt::abstract_cross<Level>>();
+
+        cross.default_threshold  = vt;
+        cross2.default_threshold = vt;
+
+        integrator_a.default_X  = p.vini;
+        integrator_a.default_dQ = p.quantum;
+        integrator_b.default_X  = p.vini;
+        integrator_b.default_dQ = p.quantum;
+
+        sum_a.default_input_coeffs[0] = 1.0;
+        sum_a.default_input_coeffs[1] = -1.0;
+        sum_b.default_input_coeffs[0] = -p.a;
+        sum_b.default_input_coeffs[1] = p.a * p.b;
+        sum_c.default_input_coeffs[0] = 0.04;
+        sum_c.default_input_coeffs[1] = 5.0;
+        sum_c.default_input_coeffs[2] = 140.0;
+        sum_c.default_input_coeffs[3] = 1.0;
+        sum_d.default_input_coeffs[0] = 1.0;
+        sum_d.default_input_coeffs[1] = p.d;
+
+        irt_return_if_bad(connect(sim, integrator_a, 0, cross, 0));
+        irt_return_if_bad(connect(sim, cst2, 0, cross, 1));
+        irt_return_if_bad(connect(sim, integrator_a, 0, cross, 2));
+        irt_return_if_bad(connect(sim, cross, 1, product, 0));
+        irt_return_if_bad(connect(sim, cross, 1, product, 1));
+        irt_return_if_bad(connect(sim, product, 0, sum_c, 0));
+        irt_return_if_bad(connect(sim, cross, 1, sum_c, 1));
+        irt_return_if_bad(connect(sim, cross, 1, sum_b, 1));
+        irt_return_if_bad(connect(sim, cst, 0, sum_c, 2));
+        irt_return_if_bad(connect(sim, cst3, 0, sum_c, 3));
+        irt_return_if_bad(connect(sim, sum_c, 0, sum_a, 0));
+        irt_return_if_bad(connect(sim, cross2, 1, sum_a, 1));
+        irt_return_if_bad(connect(sim, sum_a, 0, integrator_a, 0));
+        irt_return_if_bad(connect(sim, cross, 0, integrator_a, 1));
+        irt_return_if_bad(connect(sim, cross2, 1, sum_b, 0));
+        irt_return_if_bad(connect(sim, sum_b, 0, integrator_b, 0));
+        irt_return_if_bad(connect(sim, cross2, 0, integrator_b, 1));
+        irt_return_if_bad(connect(sim, integrator_a, 0, cross2, 0));
+        irt_return_if_bad(connect(sim, integrator_b, 0, cross2, 2));
+        irt_return_if_bad(connect(sim, sum_d, 0, cross2, 1));
+        irt_return_if_bad(connect(sim, integrator_b, 0, sum_d, 0));
+        irt_return_if_bad(connect(sim, cst, 0, sum_d, 1));
+
+        out.spike     = { sim.get_id(cross), 1 };
+        out.potential = sim.get_id(integrator_a);
+        out.recovery  = sim.get_id(integrator_b);
+    }
+
+    return status::success;
+}
+
+//! Build a STDP synapse between the @c pre and @c post spike outputs.
+template<int Level>
+status make_synapse(irt::simulation& sim,
+                    output           pre,
+                    output           post,
+                    real             quantum) noexcept
+{
+    irt_return_if_fail(sim.can_alloc(12) && sim.can_connect(28),
+                       status::simulation_not_enough_model);
+
+    const real taupre  = 20.0;
+    const real taupost = taupre;
+    const real gamax   = 0.015;
+    const real dApre   = 0.01 * gamax;
+    const real dApost  = -0.01 * taupre / taupost * 1.05 * gamax;
+
+    auto& cst         = sim.alloc<irt::constant>();
+    auto& accumulator = sim.alloc<irt::accumulator_2>();
+    cst.default_value = 1.0;
+
+    auto make_side =
+      [&](output spike, real dA, irt::model_id& out) noexcept -> status {
+        if constexpr (Level == aqss) {
+            auto& integrator = sim.alloc<irt::integrator>();
+            auto& quantifier = sim.alloc<irt::quantifier>();
+            auto& sum        = sim.alloc<irt::adder_2>();
+            auto& mult       = sim.alloc<irt::adder_2>();
+            auto& cross      = sim.alloc<irt::cross>();
+
+            cross.default_threshold          = 1.0;
+            integrator.default_current_value = 0.0;
+            quantifier.default_adapt_state =
+              irt::quantifier::adapt_state::possible;
+            quantifier.default_zero_init_offset = true;
+            quantifier.default_step_size        = quantum;
+            quantifier.default_past_length      = 3;
+            sum.default_input_coeffs[0]         = 1.0;
+            sum.default_input_coeffs[1]         = dA;
+            mult.default_input_coeffs[0]        = -1.0 / taupre;
+            mult.default_input_coeffs[1]        = 0.0;
+
+            irt_return_if_bad(connect(sim, quantifier, 0, integrator, 0));
+            irt_return_if_bad(connect(sim, mult, 0, integrator, 1));
+            irt_return_if_bad(connect(sim, cross, 0, integrator, 2));
+            irt_return_if_bad(connect(sim, integrator, 0, cross, 2));
+            irt_return_if_bad(connect(sim, cross, 0, quantifier, 0));
+            irt_return_if_bad(connect(sim, cross, 0, mult, 0));
+            irt_return_if_bad(connect(sim, cst, 0, mult, 1));
+            irt_return_if_bad(connect(sim, integrator, 0, sum, 0));
+            irt_return_if_bad(connect(sim, cst, 0, sum, 1));
+            irt_return_if_bad(connect(sim, sum, 0, cross, 1));
+            irt_return_if_bad(connect(sim, spike, sim.get_id(cross), 0));
+
+            out = sim.get_id(cross);
+            return status::success;
+        } else {
+            auto& integrator = sim.alloc<irt::abstract_integrator<Level>>();
+            auto& sum        = sim.alloc<irt::abstract_wsum<Level, 2>>();
+            auto& mult       = sim.alloc<irt::abstract_wsum<Level, 2>>();
+            auto& cross      = sim.alloc<irt::abstract_cross<Level>>();
+
+            cross.default_threshold      = 1.0;
+            integrator.default_X         = 0.0;
+            integrator.default_dQ        = quantum;
+            sum.default_input_coeffs[0]  = 1.0;
+            sum.default_input_coeffs[1]  = dA;
+            mult.default_input_coeffs[0] = -1.0 / taupre;
+            mult.default_input_coeffs[1] = 0.0;
+
+            irt_return_if_bad(connect(sim, mult, 0, integrator, 0));
+            irt_return_if_bad(connect(sim, cross, 0, integrator, 1));
+            irt_return_if_bad(connect(sim, integrator, 0, cross, 2));
+            irt_return_if_bad(connect(sim, cross, 1, mult, 0));
+            irt_return_if_bad(connect(sim, cst, 0, mult, 1));
+            irt_return_if_bad(connect(sim, integrator, 0, sum, 0));
+            irt_return_if_bad(connect(sim, cst, 0, sum, 1));
+            irt_return_if_bad(connect(sim, sum, 0, cross, 1));
+            irt_return_if_bad(connect(sim, spike, sim.get_id(cross), 0));
+
+            out = sim.get_id(cross);
+            return status::success;
+        }
+    };
+
+    irt::model_id cross_pre, cross_post;
+    irt_return_if_bad(make_side(pre, dApre, cross_pre));
+    irt_return_if_bad(make_side(post, dApost, cross_post));
+
+    const auto acc = sim.get_id(accumulator);
+    irt_return_if_bad(connect(sim, pre, acc, 0));
+    irt_return_if_bad(connect(sim, post, acc, 1));
+    irt_return_if_bad(connect(sim, { cross_post, 0 }, acc, 2));
+    irt_return_if_bad(connect(sim, { cross_pre, 0 }, acc, 3));
+
+    return status::success;
+}
+
+/*****************************************************************************
+ *
+ * Sparse matrix
+ *
+ ****************************************************************************/
+
+//! A graph stored as a list of edges (row -> column).
+struct mtx_matrix
+{
+    int              M = 0;
+    int              N = 0;
+    std::vector<int> rows;
+    std::vector<int> columns;
+
+    int nnz() const noexcept { return static_cast<int>(rows.size()); }
+};
+
+//! Read a Matrix Market coordinate file.
+inline bool read_mtx(const std::string& file_name, mtx_matrix& m) noexcept
+{
+    try {
+        std::ifstream ifs(file_name);
+        if (!ifs)
+            return false;
+
+        std::string header;
+        std::getline(ifs, header);
+        const bool is_pattern = header.find("pattern") != std::string::npos;
+
+        while (ifs.peek() == '%')
+            ifs.ignore(4096, '\n');
+
+        int nnz = 0;
+        if (!(ifs >> m.M >> m.N >> nnz))
+            return false;
+
+        m.rows.resize(nnz);
+        m.columns.resize(nnz);
+
+        for (int i = 0; i < nnz; ++i) {
+            double value;
+            if (!(ifs >> m.rows[i] >> m.columns[i]))
+                return false;
+            if (!is_pattern && !(ifs >> value))
+                return false;
+
+            --m.rows[i]; // mtx indices start at 1.
+            --m.columns[i];
+        }
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+inline mtx_matrix make_empty(int n) noexcept
+{
+    mtx_matrix m;
+    m.M = m.N = n;
+    return m;
+}
+
+inline mtx_matrix make_fully_connected(int n)
+{
+    mtx_matrix m;
+    m.M = m.N = n;
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            m.rows.emplace_back(i);
+            m.columns.emplace_back(j);
+        }
+    }
+
+    return m;
+}
+
+inline mtx_matrix make_bipartite(int n, int p)
+{
+    mtx_matrix m;
+    m.M = m.N = n + p;
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = n; j < n + p; ++j) {
+            m.rows.emplace_back(i);
+            m.columns.emplace_back(j);
+        }
+    }
+
+    return m;
+}
+
+/*****************************************************************************
+ *
+ * Run and output
+ *
+ ****************************************************************************/
+
+struct result
+{
+    std::string_view suite;
+    std::string_view solver;
+    std::string      network;
+    int              neurons     = 0;
+    int              synapses    = 0;
+    sz               models      = 0;
+    double           duration    = 0;
+    i64              bags        = 0;
+    i64              transitions = 0;
+    double           seconds     = 0;
+    sz               peak_memory = 0;
+    status           st          = status::success;
+};
+
+//! Print the csv header of @c print_result.
+inline void print_header() noexcept
+{
+    fmt::print("suite,solver,network,neurons,synapses,models,duration,bags,"
+               "transitions,seconds,events_per_second,ns_per_transition,"
+               "peak_memory,status\n");
+}
+
+inline void print_result(const result& r) noexcept
+{
+    const auto events_per_second =
+      r.seconds > 0 ? static_cast<double>(r.transitions) / r.seconds : 0.0;
+    const auto ns_per_transition =
+      r.transitions > 0
+        ? r.seconds * 1e9 / static_cast<double>(r.transitions)
+        : 0.0;
+
+    fmt::print("{},{},{},{},{},{},{},{},{},{:.6f},{:.0f},{:.2f},{},{}\n",
+               r.suite,
+               r.solver,
+               r.network,
+               r.neurons,
+               r.synapses,
+               r.models,
+               r.duration,
+               r.bags,
+               r.transitions,
+               r.seconds,
+               events_per_second,
+               ns_per_transition,
+               r.peak_memory,
+               irt::is_success(r.st) ? "success" : "failure");
+    std::fflush(stdout);
+}
+
+//! Run the simulation from 0 to @c duration and fill the counters of @c r.
+//! The peak memory includes the allocation of the simulation.
+template<typename Simulation>
+void run(Simulation& sim, double duration, result& r) noexcept
+{
+    r.duration = duration;
+    r.models   = sim.models.size();
+
+    irt::time  t     = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    if (r.st = sim.initialize(t); irt::is_success(r.st)) {
+        do {
+            if (r.st = sim.run(t); irt::is_bad(r.st))
+                break;
+
+            ++r.bags;
+            r.transitions += sim.immediate_models.ssize();
+        } while (t < duration);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    r.seconds      = std::chrono::duration<double>(end - start).count();
+    r.peak_memory  = memory_counter::peak;
+
+    if (irt::is_success(r.st))
+        r.st = sim.finalize(t);
+}
+
+//! The archives of the AQSS integrators grow with the derivative changes
+//! received between two quanta, far beyond the ten records per model of
+//! @c simulation::init.
+constexpr sz record_capacity(sz model_capacity) noexcept
+{
+    return model_capacity * 160;
+}
+
+//! Neuron model of the @c network benchmark.
+enum class neuron_type
+{
+    lif,
+    izhikevich
+};
+
+//! Build a network of neurons with a synapse per edge of the matrix. @c rate
+//! is the time constant of LIF neurons or the upper bound of the @c a
+//! parameter of Izhikevich neurons.
+template<int Level>
+status make_network(irt::simulation&  sim,
+                    neuron_type       type,
+                    const mtx_matrix& matrix,
+                    real              quantum_synapse,
+                    real              quantum_neuron,
+                    real              spike_rate) noexcept
+{
+    // The simulation reserves the emitting output ports with the model
+    // capacity: reserve a place for each model and each connection.
+    const sz neuron_capacity = type == neuron_type::lif ? 6 + 9 : 14 + 28;
+    const sz model_capacity  = static_cast<sz>(matrix.M) * neuron_capacity +
+                              static_cast<sz>(matrix.nnz()) * (12 + 28) + 16;
+
+    irt_return_if_bad(sim.init(model_capacity, model_capacity * 4));
+    irt_return_if_bad(
+      sim.record_alloc.init(record_capacity(model_capacity)));
+
+    std::vector<neuron> neurons(matrix.M);
+    std::mt19937        gen(12345);
+
+    for (auto& n : neurons) {
+        if (type == neuron_type::lif) {
+            lif_parameters p;
+            p.quantum = quantum_neuron;
+            p.tau     = spike_rate;
+            irt_return_if_bad(make_lif<Level>(sim, p, n));
+        } else {
+            std::uniform_real_distribution<real> dist(spike_rate / 2,
+                                                      spike_rate);
+            izhikevich_parameters                p;
+            p.quantum = quantum_neuron;
+            p.a       = dist(gen);
+            irt_return_if_bad(make_izhikevich<Level>(sim, p, n));
+        }
+    }
+
+    for (int i = 0, e = matrix.nnz(); i != e; ++i)
+        irt_return_if_bad(make_synapse<Level>(sim,
+                                              neurons[matrix.rows[i]].spike,
+                                              neurons[matrix.columns[i]].spike,
+                                              quantum_synapse));
+
+    return status::success;
+}
+
+//! Build the network of @c make_network into a @c Simulation (a
+//! @c simulation or a @c simulation_of) and run it.
+template<int Level, typename Simulation = irt::simulation>
+result network(std::string_view  suite,
+               neuron_type       type,
+               std::string_view  name,
+               const mtx_matrix& matrix,
+               double            duration,
+               real              quantum_synapse,
+               real              quantum_neuron,
+               real              spike_rate) noexcept
+{
+    result r;
+    r.suite    = suite;
+    r.solver   = solver_name(Level);
+    r.network  = std::string(name);
+    r.neurons  = matrix.M;
+    r.synapses = matrix.nnz();
+
+    memory_counter::reset_peak();
+
+    Simulation sim;
+    if (r.st = make_network<Level>(
+          sim, type, matrix, quantum_synapse, quantum_neuron, spike_rate);
+        irt::is_bad(r.st))
+        return r;
+
+    run(sim, duration, r);
+
+    return r;
+}
+
+//! The graphs of the timing suites: synthetic graphs or Matrix Market
+//! files.
+struct instance
+{
+    const char* name;
+    const char* file; //!< nullptr for synthetic graphs.
+    real        rate;
+};
+
+inline const instance instances[] = {
+    { "empty_1000", nullptr, 0.02 },
+    { "fully_connected_10", nullptr, 0.002 },
+    { "bipartite_10_10", nullptr, 0.002 },
+    { "chesapeake", "chesapeake.mtx", 0.002 },
+    { "celegansneural", "celegansneural.mtx", 0.002 },
+    { "west0655", "west0655.mtx", 0.002 },
+    { "jpwh_991", "jpwh_991.mtx", 0.002 },
+};
+
+//! Build the synthetic graph or read the file of @c elem in @c directory.
+inline bool read_instance(const instance&    elem,
+                          const std::string& directory,
+                          mtx_matrix&        m)
+{
+    if (elem.file == nullptr) {
+        const std::string_view name = elem.name;
+        m = name == "empty_1000"           ? make_empty(1000)
+            : name == "fully_connected_10" ? make_fully_connected(10)
+                                           : make_bipartite(10, 10);
+    } else if (!read_mtx(directory + '/' + elem.file, m)) {
+        fmt::print(stderr,
+                   "skip {}: {}/{} not found\n",
+                   elem.name,
+                   directory,
+                   elem.file);
+        return false;
+    }
+
+    return true;
+}
+
+/*****************************************************************************
+ *
+ * Suites
+ *
+ ****************************************************************************/
+
+//! Write the observations of a model into a csv file.
+struct file_output
+{
+    std::FILE*  os = nullptr;
+    std::string filename;
+
+    file_output(std::string name) noexcept
+      : filename(std::move(name))
+    {
+        os = std::fopen(filename.c_str(), "w");
+    }
+
+    ~file_output() noexcept
+    {
+        if (os)
+            std::fclose(os);
+    }
+};
+
+inline void file_output_callback(const irt::observer& obs,
+                                 const irt::dynamics_type /*type*/,
+                                 const irt::time /*tl*/,
+                                 const irt::time             t,
+                                 const irt::observer::status s) noexcept
+{
+    auto* fo = reinterpret_cast<file_output*>(obs.user_data);
+    if (!fo->os)
+        return;
+
+    if (s == irt::observer::status::initialize)
+        fmt::print(fo->os, "t,{}\n", obs.name.c_str());
+    else
+        fmt::print(fo->os, "{},{}\n", t, obs.msg.data[0]);
+}
+
+//! Run a neuron alone and write the potential (and the recovery variable
+//! for Izhikevich neuron) into @c name_a.csv and @c name_b.csv.
+template<int Level, typename Parameters>
+result exactitude(std::string_view  name,
+                  const Parameters& p,
+                  double            duration) noexcept
+{
+    result r;
+    r.suite   = "exactitude";
+    r.solver  = solver_name(Level);
+    r.network = std::string(name);
+    r.neurons = 1;
+
+    memory_counter::reset_peak();
+
+    irt::simulation sim;
+    if (r.st = sim.init(256, 32768); irt::is_bad(r.st))
+        return r;
+
+    if (r.st = sim.record_alloc.init(record_capacity(256)); irt::is_bad(r.st))
+        return r;
+
+    neuron n;
+    if constexpr (std::is_same_v<Parameters, lif_parameters>)
+        r.st = make_lif<Level>(sim, p, n);
+    else
+        r.st = make_izhikevich<Level>(sim, p, n);
+
+    if (irt::is_bad(r.st))
+        return r;
+
+    file_output fo_a(fmt::format("{}_{}_a.csv", r.solver, name));
+    file_output fo_b(fmt::format("{}_{}_b.csv", r.solver, name));
+
+    auto& obs_a = sim.observers.alloc("A", file_output_callback, &fo_a);
+    sim.observe(sim.models.get(n.potential), obs_a);
+
+    if (auto* mdl = sim.models.try_to_get(n.recovery); mdl) {
+        auto& obs_b = sim.observers.alloc("B", file_output_callback, &fo_b);
+        sim.observe(*mdl, obs_b);
+    }
+
+    run(sim, duration, r);
+
+    return r;
+}
+
+//! Run the LIF and the Izhikevich presets of Izhikevich (2003).
+//!
+//! Usage: benchmark_exactitude_<solver> [duration] [quantum]
+template<int Level>
+int exactitude_main(int argc, char* argv[]) noexcept
+{
+    memory_counter::install();
+
+    const double duration = argc > 1 ? std::atof(argv[1]) : 1000.0;
+    const real   quantum  = argc > 2 ? std::atof(argv[2]) : 1e-2;
+
+    struct preset
+    {
+        const char* name;
+        real        a, b, c, d, I, vini;
+    };
+
+    static const preset presets[] = {
+        { "izhikevich_RS", 0.02, 0.2, -65.0, 8.0, 10.0, 0.0 },
+        { "izhikevich_IB", 0.02, 0.2, -55.0, 4.0, 10.0, 0.0 },
+        { "izhikevich_CH", 0.02, 0.2, -50.0, 2.0, 10.0, 0.0 },
+        { "izhikevich_FS", 0.1, 0.2, -65.0, 2.0, 10.0, 0.0 },
+        { "izhikevich_TC", 0.02, 0.25, -65.0, 0.05, 10.0, -87.0 },
+        { "izhikevich_RZ", 0.1, 0.26, -65.0, 2.0, 10.0, -63.0 },
+        { "izhikevich_LTS", 0.02, 0.25, -65.0, 2.0, 10.0, -63.0 },
+        { "izhikevich_P", 0.2, 2.0, -56.0, -16.0, -99.0, 0.0 },
+    };
+
+    int failures = 0;
+    print_header();
+
+    lif_parameters lif;
+    lif.quantum = quantum;
+    lif.tau     = 10.0;
+    lif.Vt      = 10.0;
+    lif.V0      = 20.0;
+    lif.Vr      = 0.0;
+
+    const auto r = exactitude<Level>("lif", lif, duration);
+    failures += irt::is_bad(r.st);
+    print_result(r);
+
+    for (const auto& elem : presets) {
+        izhikevich_parameters p;
+        p.quantum = quantum;
+        p.a       = elem.a;
+        p.b       = elem.b;
+        p.c       = elem.c;
+        p.d       = elem.d;
+        p.I       = elem.I;
+        p.vini    = elem.vini;
+
+        const auto r = exactitude<Level>(elem.name, p, duration);
+        failures += irt::is_bad(r.st);
+        print_result(r);
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//! Run the LIF and Izhikevich networks on synthetic graphs and on the
+//! Matrix Market files found in @c directory.
+//!
+//! Usage: benchmark_timing_<solver> [duration] [mtx-directory]
+template<int Level>
+int timing_main(int argc, char* argv[]) noexcept
+{
+    memory_counter::install();
+
+    const double      duration  = argc > 1 ? std::atof(argv[1]) : 500.0;
+    const std::string directory = argc > 2 ? argv[2] : EXAMPLES_DIR;
+
+    constexpr real quantum_synapse = 1e-5;
+    constexpr real quantum_neuron  = 0.1;
+
+    int failures = 0;
+    print_header();
+
+    for (const auto& elem : instances) {
+        mtx_matrix m;
+
+        try {
+            if (!read_instance(elem, directory, m))
+                continue;
+        } catch (...) {
+            return EXIT_FAILURE;
+        }
+
+        const auto lif = network<Level>("timing",
+                                        neuron_type::lif,
+                                        fmt::format("lif_{}", elem.name),
+                                        m,
+                                        duration,
+                                        quantum_synapse,
+                                        quantum_neuron,
+                                        10.0);
+        failures += irt::is_bad(lif.st);
+        print_result(lif);
+
+        const auto izh = network<Level>("timing",
+                                        neuron_type::izhikevich,
+                                        fmt::format("izhikevich_{}", elem.name),
+                                        m,
+                                        duration,
+                                        quantum_synapse,
+                                        quantum_neuron,
+                                        elem.rate);
+        failures += irt::is_bad(izh.st);
+        print_result(izh);
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // namespace bench
+
+#endif
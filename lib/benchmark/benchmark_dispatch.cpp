@@ -0,0 +1,67 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmark.hpp"
+
+//! The five dynamics of the LIF networks.
+template<int Level>
+using lif_simulation = irt::simulation_of<irt::constant,
+                                          irt::accumulator_2,
+                                          irt::abstract_wsum<Level, 2>,
+                                          irt::abstract_integrator<Level>,
+                                          irt::abstract_cross<Level>>;
+
+//! Run the LIF networks of the timing benchmarks with a @c simulation (the
+//! @c generic suite) and with a @c simulation_of restricted to the dynamics
+//! of the networks (the @c specialized suite).
+//!
+//! Usage: benchmark_dispatch [duration] [mtx-directory]
+template<int Level>
+int run_networks(double duration, const std::string& directory) noexcept
+{
+    using namespace bench;
+
+    int failures = 0;
+
+    for (const auto& elem : instances) {
+        mtx_matrix m;
+
+        try {
+            if (!read_instance(elem, directory, m))
+                continue;
+        } catch (...) {
+            return failures + 1;
+        }
+
+        const auto name = fmt::format("lif_{}", elem.name);
+
+        const auto generic = network<Level>(
+          "generic", neuron_type::lif, name, m, duration, 1e-5, 0.1, 10.0);
+        failures += irt::is_bad(generic.st);
+        print_result(generic);
+
+        const auto specialized = network<Level, lif_simulation<Level>>(
+          "specialized", neuron_type::lif, name, m, duration, 1e-5, 0.1, 10.0);
+        failures += irt::is_bad(specialized.st);
+        print_result(specialized);
+    }
+
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    bench::memory_counter::install();
+
+    const double      duration  = argc > 1 ? std::atof(argv[1]) : 500.0;
+    const std::string directory = argc > 2 ? argv[2] : EXAMPLES_DIR;
+
+    bench::print_header();
+
+    const int failures = run_networks<1>(duration, directory) +
+                         run_networks<2>(duration, directory) +
+                         run_networks<3>(duration, directory);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmark.hpp"
+
+#include <irritator/partition.hpp>
+
+//! Partition the LIF networks of the timing benchmarks: a warm-up run
+//! weights the connections, then each network is split into 2, 4, 8 and 16
+//! parts. With a @c metis-directory, the weighted graphs are written into
+//! @c name.graph files to compare with @c gpmetis.
+//!
+//! Usage: benchmark_partition [warm-up] [mtx-directory] [metis-directory]
+//!
+//! Each point prints a csv line. The cut ratio is the cut over the total
+//! edge weight, the imbalance is the heaviest part over the average part.
+int main(int argc, char* argv[])
+{
+    using namespace bench;
+
+    const double      warm_up   = argc > 1 ? std::atof(argv[1]) : 10.0;
+    const std::string directory = argc > 2 ? argv[2] : EXAMPLES_DIR;
+    const std::string metis     = argc > 3 ? argv[3] : "";
+
+    int failures = 0;
+    fmt::print("network,models,edges,parts,cut,cut_ratio,imbalance,seconds,"
+               "status\n");
+
+    for (const auto& elem : instances) {
+        mtx_matrix m;
+
+        try {
+            if (!read_instance(elem, directory, m))
+                continue;
+        } catch (...) {
+            return EXIT_FAILURE;
+        }
+
+        irt::simulation  sim;
+        irt::partitioner part;
+
+        auto st =
+          make_network<1>(sim, neuron_type::lif, m, 1e-5, 0.1, 10.0);
+        if (irt::is_success(st))
+            st = part.warm_up(sim, 0, warm_up);
+        if (irt::is_success(st))
+            st = part.build(sim);
+
+        if (irt::is_bad(st)) {
+            fmt::print(stderr,
+                       "{}: failure ({})\n",
+                       elem.name,
+                       static_cast<int>(st));
+            ++failures;
+            continue;
+        }
+
+        if (!metis.empty()) {
+            std::ofstream ofs(fmt::format("{}/{}.graph", metis, elem.name));
+            failures += irt::is_bad(part.write_metis(ofs));
+        }
+
+        i64 edges = 0;
+        for (const auto w : part.graph.edge_weights)
+            edges += w;
+        edges /= 2;
+
+        for (const irt::i32 k : { 2, 4, 8, 16 }) {
+            const auto start = std::chrono::steady_clock::now();
+            st               = part.partition({ .parts = k });
+            const auto end   = std::chrono::steady_clock::now();
+
+            const auto heaviest = *std::max_element(part.part_weights.begin(),
+                                                    part.part_weights.end());
+            const auto average =
+              static_cast<double>(part.graph.total_weight()) / k;
+
+            fmt::print("{},{},{},{},{},{:.4f},{:.3f},{:.6f},{}\n",
+                       elem.name,
+                       part.graph.vertices(),
+                       part.graph.edges(),
+                       k,
+                       part.cut,
+                       edges ? static_cast<double>(part.cut) / edges : 0.0,
+                       average > 0 ? heaviest / average : 0.0,
+                       std::chrono::duration<double>(end - start).count(),
+                       irt::is_success(st) ? "success" : "failure");
+            failures += irt::is_bad(st);
+        }
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
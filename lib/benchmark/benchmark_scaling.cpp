@@ -0,0 +1,342 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include "benchmark.hpp"
+
+#include <irritator/examples.hpp>
+
+#include <charconv>
+
+//! Synthetic scaling benchmark: replicate an example of examples.hpp (a
+//! cell) to reach the number of models, connect each cell to @c fanout
+//! counters and run the simulation. The @c jitter perturbs the quantum of
+//! the integrators of each cell to spread the events: with 0 all cells are
+//! synchronized and the bags are large, with 1 the bags are small.
+//!
+//! Usage: benchmark_scaling [--models=1000,10000] [--fanout=1,10]
+//!                          [--qss=1,2,3] [--jitter=0,1]
+//!                          [--cell=lotka_volterra|lif|izhikevich|van_der_pol]
+//!                          [--duration=10]
+//!
+//! Each point prints a csv line. The scheduler operations are the pop and
+//! the reintegration of each transition plus the update of each message
+//! receiver.
+
+namespace bench {
+
+enum class cell_type
+{
+    lotka_volterra,
+    lif,
+    izhikevich,
+    van_der_pol
+};
+
+struct scaling_point
+{
+    cell_type cell     = cell_type::lotka_volterra;
+    int       level    = 1;
+    sz        models   = 1000;
+    int       fanout   = 1;
+    real      jitter   = 0;
+    double    duration = 10;
+};
+
+struct scaling_result
+{
+    sz     models      = 0;
+    sz     cells       = 0;
+    int    fanout      = 0;
+    i64    bags        = 0;
+    i64    max_bag     = 0;
+    i64    transitions = 0;
+    i64    deliveries  = 0;
+    double seconds     = 0;
+    sz     peak_memory = 0;
+    status st          = status::success;
+};
+
+constexpr std::string_view cell_name(cell_type cell) noexcept
+{
+    return cell == cell_type::lotka_volterra ? "lotka_volterra"
+           : cell == cell_type::lif          ? "lif"
+           : cell == cell_type::izhikevich   ? "izhikevich"
+                                             : "van_der_pol";
+}
+
+//! Models and connections of the cells of examples.hpp.
+constexpr sz cell_models(cell_type cell) noexcept
+{
+    return cell == cell_type::izhikevich ? 12 : 5;
+}
+
+constexpr sz cell_connections(cell_type cell) noexcept
+{
+    return cell == cell_type::izhikevich ? 22 : 9;
+}
+
+template<int Level, typename F>
+status make_cell(irt::simulation& sim, cell_type cell, F f) noexcept
+{
+    switch (cell) {
+    case cell_type::lotka_volterra:
+        return irt::example_qss_lotka_volterra<Level>(sim, f);
+    case cell_type::lif:
+        return irt::example_qss_lif<Level>(sim, f);
+    case cell_type::izhikevich:
+        return irt::example_qss_izhikevich<Level>(sim, f);
+    case cell_type::van_der_pol:
+        return irt::example_qss_van_der_pol<Level>(sim, f);
+    }
+
+    irt_unreachable();
+}
+
+template<int Level>
+scaling_result run_point(const scaling_point& p) noexcept
+{
+    scaling_result r;
+
+    // A cell and its counter.
+    const sz per_cell = cell_models(p.cell) + 1;
+    r.cells           = std::max(p.models / per_cell, sz{ 1 });
+    r.fanout          = static_cast<int>(
+      std::min(static_cast<sz>(std::max(p.fanout, 1)), r.cells));
+    r.models = r.cells * per_cell;
+
+    const sz connections =
+      r.cells * (cell_connections(p.cell) + static_cast<sz>(r.fanout));
+
+    memory_counter::reset_peak();
+
+    // The simulation reserves the emitting output ports with the model
+    // capacity: reserve a place for each model and each connection.
+    irt::simulation sim;
+    if (r.st = sim.init(r.models + connections, connections + 16);
+        irt::is_bad(r.st))
+        return r;
+
+    std::vector<irt::model_id> sources, counters;
+    std::mt19937_64            gen(12345);
+    std::uniform_real_distribution<real> dist(-p.jitter / 2, p.jitter / 2);
+
+    try {
+        sources.reserve(r.cells);
+        counters.reserve(r.cells);
+    } catch (...) {
+        r.st = status::vector_not_enough_memory;
+        return r;
+    }
+
+    for (sz i = 0; i != r.cells; ++i) {
+        const real    factor = 1 + dist(gen);
+        irt::model_id source = irt::undefined<irt::model_id>();
+
+        r.st = make_cell<Level>(sim, p.cell, [&](irt::model_id id) noexcept {
+            irt::dispatch(
+              sim.models.get(id), [&]<typename Dynamics>(Dynamics& dyn) {
+                  if constexpr (requires { dyn.default_dQ; }) {
+                      dyn.default_dQ *= factor;
+                      if (irt::is_undefined(source))
+                          source = id;
+                  }
+              });
+        });
+
+        if (irt::is_bad(r.st))
+            return r;
+
+        sources.emplace_back(source);
+        counters.emplace_back(sim.get_id(sim.alloc<irt::counter>()));
+    }
+
+    // Connect the first integrator of each cell to @c fanout counters spread
+    // over the cells.
+    const sz stride = r.cells / static_cast<sz>(r.fanout);
+    for (sz i = 0; i != r.cells; ++i) {
+        for (sz j = 0; j != static_cast<sz>(r.fanout); ++j) {
+            const auto dst = counters[(i + j * stride) % r.cells];
+            if (r.st = connect(sim, { sources[i], 0 }, dst, 0);
+                irt::is_bad(r.st))
+                return r;
+        }
+    }
+
+    irt::time  t     = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    if (r.st = sim.initialize(t); irt::is_success(r.st)) {
+        do {
+            if (r.st = sim.run(t); irt::is_bad(r.st))
+                break;
+
+            const auto bag = sim.immediate_models.ssize();
+            ++r.bags;
+            r.max_bag = std::max(r.max_bag, static_cast<i64>(bag));
+            r.transitions += bag;
+            r.deliveries += sim.emitting_output_ports.ssize();
+        } while (t < p.duration);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    r.seconds      = std::chrono::duration<double>(end - start).count();
+    r.peak_memory  = memory_counter::peak;
+
+    if (irt::is_success(r.st))
+        r.st = sim.finalize(t);
+
+    return r;
+}
+
+inline void print_scaling_header() noexcept
+{
+    fmt::print("cell,solver,models,cells,fanout,jitter,duration,bags,mean_bag,"
+               "max_bag,transitions,deliveries,scheduler_ops,seconds,"
+               "transitions_per_second,scheduler_ops_per_second,"
+               "deliveries_per_second,peak_memory,status\n");
+}
+
+inline void print_scaling(const scaling_point&  p,
+                          const scaling_result& r) noexcept
+{
+    const i64  ops = 2 * r.transitions + r.deliveries;
+    const auto per_second = [&r](i64 value) noexcept {
+        return r.seconds > 0 ? static_cast<double>(value) / r.seconds : 0.0;
+    };
+
+    fmt::print("{},{},{},{},{},{},{},{},{:.2f},{},{},{},{},"
+               "{:.6f},{:.0f},{:.0f},{:.0f},{},{}\n",
+               cell_name(p.cell),
+               solver_name(p.level),
+               r.models,
+               r.cells,
+               r.fanout,
+               p.jitter,
+               p.duration,
+               r.bags,
+               r.bags ? static_cast<double>(r.transitions) / r.bags : 0.0,
+               r.max_bag,
+               r.transitions,
+               r.deliveries,
+               ops,
+               r.seconds,
+               per_second(r.transitions),
+               per_second(ops),
+               per_second(r.deliveries),
+               r.peak_memory,
+               irt::is_success(r.st) ? "success" : "failure");
+    std::fflush(stdout);
+}
+
+//! Parse the comma separated list of the @c --name=values option.
+template<typename T>
+bool parse_list(std::string_view  arg,
+                std::string_view  name,
+                std::vector<T>&   out)
+{
+    if (!arg.starts_with("--") || arg.substr(2, name.size()) != name ||
+        arg.size() <= name.size() + 3 || arg[name.size() + 2] != '=')
+        return false;
+
+    out.clear();
+    arg.remove_prefix(name.size() + 3);
+
+    while (!arg.empty()) {
+        const auto comma = arg.find(',');
+        const auto token = arg.substr(0, comma);
+
+        if constexpr (std::is_floating_point_v<T>) {
+            const auto str = std::string(token);
+            out.emplace_back(static_cast<T>(std::atof(str.c_str())));
+        } else {
+            T value{};
+            std::from_chars(token.data(), token.data() + token.size(), value);
+            out.emplace_back(value);
+        }
+
+        arg = comma == std::string_view::npos ? std::string_view{}
+                                              : arg.substr(comma + 1);
+    }
+
+    return true;
+}
+
+} // namespace bench
+
+int main(int argc, char* argv[])
+{
+    using namespace bench;
+
+    memory_counter::install();
+
+    try {
+        std::vector<sz>     models   = { 1000, 10000, 100000 };
+        std::vector<int>    fanouts  = { 1, 10, 100 };
+        std::vector<int>    levels   = { 1, 2, 3 };
+        std::vector<double> jitters  = { 0.0, 1.0 };
+        std::vector<double> duration = { 10.0 };
+        cell_type           cell     = cell_type::lotka_volterra;
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+
+            if (parse_list(arg, "models", models) ||
+                parse_list(arg, "fanout", fanouts) ||
+                parse_list(arg, "qss", levels) ||
+                parse_list(arg, "jitter", jitters) ||
+                parse_list(arg, "duration", duration))
+                continue;
+
+            if (arg == "--cell=lotka_volterra")
+                cell = cell_type::lotka_volterra;
+            else if (arg == "--cell=lif")
+                cell = cell_type::lif;
+            else if (arg == "--cell=izhikevich")
+                cell = cell_type::izhikevich;
+            else if (arg == "--cell=van_der_pol")
+                cell = cell_type::van_der_pol;
+            else {
+                fmt::print(stderr, "Unknown option {}\n", arg);
+                return EXIT_FAILURE;
+            }
+        }
+
+        for (const auto level : levels) {
+            if (level < 1 || level > 3) {
+                fmt::print(stderr, "Bad QSS level {}\n", level);
+                return EXIT_FAILURE;
+            }
+        }
+
+        int failures = 0;
+        print_scaling_header();
+
+        for (const auto level : levels) {
+            for (const auto mdl : models) {
+                for (const auto fanout : fanouts) {
+                    for (const auto jitter : jitters) {
+                        scaling_point p;
+                        p.cell     = cell;
+                        p.level    = level;
+                        p.models   = mdl;
+                        p.fanout   = fanout;
+                        p.jitter   = static_cast<real>(jitter);
+                        p.duration = duration.empty() ? 10.0 : duration[0];
+
+                        const auto r = level == 1   ? run_point<1>(p)
+                                       : level == 2 ? run_point<2>(p)
+                                                    : run_point<3>(p);
+
+                        failures += irt::is_bad(r.st);
+                        print_scaling(p, r);
+                    }
+                }
+            }
+        }
+
+        return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+    } catch (...) {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,221 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/core.hpp>
+#include <irritator/thread.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+static std::atomic<int> benchmark_counter;
+
+static void function_benchmark(void* /*param*/) noexcept
+{
+    benchmark_counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+//! Stores the run date then counts the task: the date is written when the
+//! counter is seen.
+static void function_latency(void* param) noexcept
+{
+    auto* end = reinterpret_cast<std::chrono::steady_clock::time_point*>(param);
+    *end      = std::chrono::steady_clock::now();
+    benchmark_counter.fetch_add(1, std::memory_order_release);
+}
+
+//! The former task_manager design used as baseline by the benchmark: each
+//! worker polls the task list under a spin lock, even if the list is empty.
+struct spin_polling_manager
+{
+    irt::ring_buffer<irt::task, 256> tasks;
+    irt::spin_lock                   spin;
+    std::vector<std::jthread>        threads;
+    std::atomic<bool>                is_terminating = false;
+
+    void start(int thread_number)
+    {
+        for (int i = 0; i < thread_number; ++i)
+            threads.emplace_back([this]() {
+                for (;;) {
+                    irt::task t;
+                    {
+                        irt::scoped_spin_lock lock(spin);
+                        if (!tasks.empty())
+                            t = tasks.dequeue();
+                    }
+
+                    if (t.function)
+                        t.function(t.parameter);
+                    else if (is_terminating)
+                        return;
+                }
+            });
+    }
+
+    void add(irt::task_function function, void* parameter) noexcept
+    {
+        for (;;) {
+            {
+                irt::scoped_spin_lock lock(spin);
+                if (!tasks.full()) {
+                    tasks.emplace_enqueue(function, parameter);
+                    return;
+                }
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    void finalize() noexcept
+    {
+        is_terminating = true;
+        for (auto& t : threads)
+            t.join();
+    }
+};
+
+struct benchmark_result
+{
+    double throughput; // tasks per second
+    double latency;    // mean time between add and run in microseconds
+    double idle_cpu;   // process cpu time per wall time when idle
+    bool   success;    // all the tasks were run
+};
+
+template<typename Manager, typename Add, typename Wait>
+static benchmark_result run_task_benchmark(Manager& manager,
+                                           Add      add,
+                                           Wait     wait,
+                                           int      task_number,
+                                           int      latency_number)
+{
+    using clock = std::chrono::steady_clock;
+
+    benchmark_result ret{};
+
+    {
+        const auto cpu_start  = std::clock();
+        const auto wall_start = clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        const auto cpu_end  = std::clock();
+        const auto wall_end = clock::now();
+
+        const auto cpu = static_cast<double>(cpu_end - cpu_start) /
+                         static_cast<double>(CLOCKS_PER_SEC);
+        ret.idle_cpu =
+          cpu / std::chrono::duration<double>(wall_end - wall_start).count();
+    }
+
+    {
+        benchmark_counter = 0;
+        const auto start  = clock::now();
+        for (int i = 0; i < task_number; ++i)
+            add(manager, &function_benchmark, nullptr);
+        wait(manager, task_number);
+        const auto end = clock::now();
+
+        ret.success = benchmark_counter.load() == task_number;
+        ret.throughput =
+          task_number / std::chrono::duration<double>(end - start).count();
+    }
+
+    {
+        double sum = 0.0;
+        for (int i = 0; i < latency_number; ++i) {
+            benchmark_counter = 0;
+            clock::time_point end;
+            const auto        start = clock::now();
+            add(manager, &function_latency, &end);
+            wait(manager, 1);
+
+            ret.success = ret.success && benchmark_counter.load() == 1;
+            sum +=
+              std::chrono::duration<double, std::micro>(end - start).count();
+        }
+
+        ret.latency = sum / latency_number;
+    }
+
+    return ret;
+}
+
+//! Compare the throughput, the latency and the idle cpu usage of the
+//! work-stealing @c task_manager with the former spin-polling design.
+//!
+//! Usage: benchmark_task_manager [threads] [tasks] [latency-tasks]
+int main(int argc, char* argv[])
+{
+    const int thread_number  = argc > 1 ? std::atoi(argv[1]) : 4;
+    const int task_number    = argc > 2 ? std::atoi(argv[2]) : 20000;
+    const int latency_number = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    benchmark_result sleeping{}, polling{};
+
+    {
+        irt::task_manager_parameters init{ .thread_number = thread_number,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        if (irt::is_bad(tm.init(init)))
+            return EXIT_FAILURE;
+
+        for (auto& w : tm.workers)
+            w.task_lists.emplace_back(&tm.task_lists[0]);
+
+        tm.start();
+        sleeping = run_task_benchmark(
+          tm,
+          [](irt::task_manager& m, irt::task_function f, void* p) {
+              m.task_lists[0].add(f, p);
+          },
+          [](irt::task_manager& m, int /*number*/) {
+              m.task_lists[0].wait();
+          },
+          task_number,
+          latency_number);
+        tm.finalize();
+    }
+
+    {
+        spin_polling_manager spm;
+        spm.start(thread_number);
+        polling = run_task_benchmark(
+          spm,
+          [](spin_polling_manager& m, irt::task_function f, void* p) {
+              m.add(f, p);
+          },
+          [](spin_polling_manager& /*m*/, int number) {
+              // Acquires the date stored by the latency task.
+              while (benchmark_counter.load(std::memory_order_acquire) !=
+                     number)
+                  std::this_thread::yield();
+          },
+          task_number,
+          latency_number);
+        spm.finalize();
+    }
+
+    fmt::print("task manager: {:>12} {:>16} {:>14}\n",
+               "tasks/s",
+               "latency (us)",
+               "idle cpu");
+    fmt::print("work-stealing {:>12.0f} {:>16.2f} {:>14.2f}\n",
+               sleeping.throughput,
+               sleeping.latency,
+               sleeping.idle_cpu);
+    fmt::print("spin-polling  {:>12.0f} {:>16.2f} {:>14.2f}\n",
+               polling.throughput,
+               polling.latency,
+               polling.idle_cpu);
+
+    return sleeping.success && polling.success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
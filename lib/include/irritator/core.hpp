@@ -37,7 +37,7 @@
 
 namespace irt {
 
-static inline bool is_fatal_breakpoint = true;
+inline bool is_fatal_breakpoint = true;
 
 }
 
@@ -118,6 +118,24 @@ static inline bool is_fatal_breakpoint = true;
 #define irt_unreachable()
 #endif
 
+//! Statistics of the simulation hot path (@c simulation::stats) are compiled
+//! only when @c IRRITATOR_ENABLE_STATS is defined. Otherwise the @c irt_stats
+//! expressions disappear.
+#ifdef IRRITATOR_ENABLE_STATS
+#define irt_stats(expr__) expr__
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define irt_stats_cycles() __rdtsc()
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define irt_stats_cycles() __rdtsc()
+#else
+#define irt_stats_cycles() static_cast<irt::u64>(0)
+#endif
+#else
+#define irt_stats(expr__)
+#endif
+
 namespace irt {
 
 using i8  = int8_t;
@@ -329,6 +347,7 @@ enum class status
     simulation_not_enough_model,
     simulation_not_enough_message,
     simulation_not_enough_connection,
+    simulation_not_enough_structural_change,
     vector_init_capacity_error,
     vector_not_enough_memory,
     data_array_init_capacity_error,
@@ -368,12 +387,13 @@ enum class status
     io_file_format_dynamics_unknown,
     io_file_format_dynamics_limit_reach,
     io_file_format_dynamics_init_error,
+    distributed_transport_error,
     filter_threshold_condition_not_satisfied
 };
 
 constexpr i8 status_last() noexcept
 {
-    return static_cast<i8>(status::io_file_format_dynamics_init_error);
+    return static_cast<i8>(status::distributed_transport_error);
 }
 
 constexpr sz status_size() noexcept
@@ -800,9 +820,44 @@ struct fixed_real_array
 };
 
 using message             = fixed_real_array<3>;
-using dated_message       = fixed_real_array<4>;
+using dated_message       = fixed_real_array<5>; // date, message, sequence.
 using observation_message = fixed_real_array<4>;
 
+/*****************************************************************************
+ *
+ * Checkpoint
+ *
+ ****************************************************************************/
+
+//! @brief Write the bytes of @c value into @c f (an @c irt::file or an
+//! @c irt::memory).
+//!
+//! Checkpoints use the native layout: restore them with the same build.
+template<typename File, typename T>
+bool write_raw(File& f, const T& value) noexcept
+{
+    return f.write(&value, static_cast<i64>(sizeof(T)));
+}
+
+template<typename File, typename T>
+bool write_raw(File& f, const T* values, sz number) noexcept
+{
+    return number == 0 ||
+           f.write(values, static_cast<i64>(sizeof(T) * number));
+}
+
+template<typename File, typename T>
+bool read_raw(File& f, T& value) noexcept
+{
+    return f.read(&value, static_cast<i64>(sizeof(T)));
+}
+
+template<typename File, typename T>
+bool read_raw(File& f, T* values, sz number) noexcept
+{
+    return number == 0 || f.read(values, static_cast<i64>(sizeof(T) * number));
+}
+
 /*****************************************************************************
  *
  * Flat list
@@ -827,6 +882,7 @@ private:
     sz     size{ 0 };            // number of active elements allocated
     sz     max_size{ 0 }; // number of elements allocated (with free_head)
     sz     capacity{ 0 }; // capacity of the allocator
+    block* owned{ nullptr }; // the own blocks while sharing (see share).
 
 public:
     block_allocator() = default;
@@ -836,6 +892,8 @@ public:
 
     ~block_allocator() noexcept
     {
+        stop_sharing();
+
         if (blocks)
             g_free_fn(blocks);
     }
@@ -845,6 +903,8 @@ public:
         if (new_capacity == 0)
             return status::block_allocator_bad_capacity;
 
+        stop_sharing();
+
         if (new_capacity != capacity) {
             if (blocks)
                 g_free_fn(blocks);
@@ -865,6 +925,8 @@ public:
 
     void reset() noexcept
     {
+        stop_sharing();
+
         if (capacity > 0) {
             size      = 0;
             max_size  = 0;
@@ -874,6 +936,8 @@ public:
 
     T* alloc() noexcept
     {
+        irt_assert(!owned);
+
         block* new_block = nullptr;
 
         if (free_head != nullptr) {
@@ -897,6 +961,8 @@ public:
 
     u32 alloc_index() noexcept
     {
+        irt_assert(!owned);
+
         block* new_block = nullptr;
 
         if (free_head != nullptr) {
@@ -920,6 +986,7 @@ public:
     void free(T* n) noexcept
     {
         irt_assert(n);
+        irt_assert(!owned);
 
         block* ptr = reinterpret_cast<block*>(n);
 
@@ -940,6 +1007,116 @@ public:
         free(to_free);
     }
 
+    //! Number of active elements allocated.
+    sz used() const noexcept { return size; }
+
+    //! @brief Copy the blocks and the free list of @c other.
+    //!
+    //! The copies keep the indices of @c other. The capacity must be large
+    //! enough for the allocated blocks of @c other.
+    bool can_copy(const block_allocator& other) const noexcept
+    {
+        return other.max_size <= capacity;
+    }
+
+    status copy(const block_allocator& other) noexcept
+    {
+        stop_sharing();
+
+        if (other.max_size > capacity)
+            return status::block_allocator_not_enough_memory;
+
+        copy_blocks(other.blocks, other.max_size, other.free_head);
+        size = other.size;
+
+        return status::success;
+    }
+
+    //! @brief Read the blocks of @c other until the next write.
+    //!
+    //! The allocator does not copy the blocks: @c other must outlive the
+    //! sharing and must not change. @c unshare copies the blocks before a
+    //! write, @c alloc and @c free must not be used while sharing.
+    status share(const block_allocator& other) noexcept
+    {
+        stop_sharing();
+
+        if (other.max_size > capacity)
+            return status::block_allocator_not_enough_memory;
+
+        owned     = blocks;
+        blocks    = other.blocks;
+        free_head = other.free_head;
+        size      = other.size;
+        max_size  = other.max_size;
+
+        return status::success;
+    }
+
+    bool is_shared() const noexcept { return owned != nullptr; }
+
+    //! Copy the shared blocks into the own blocks.
+    void unshare() noexcept
+    {
+        if (!owned)
+            return;
+
+        const auto* shared = blocks;
+        blocks             = owned;
+        owned              = nullptr;
+
+        copy_blocks(shared, max_size, free_head);
+    }
+
+    //! Write the allocated blocks and the free list into @c f.
+    template<typename File>
+    bool checkpoint(File& f) const noexcept
+    {
+        u64 free_number = 0;
+        for (const block* b = free_head; b; b = b->next)
+            ++free_number;
+
+        const u64 header[3] = { size, max_size, free_number };
+        if (!write_raw(f, header) || !write_raw(f, blocks, max_size))
+            return false;
+
+        for (const block* b = free_head; b; b = b->next)
+            if (!write_raw(f, static_cast<u32>(b - blocks)))
+                return false;
+
+        return true;
+    }
+
+    //! Read the blocks and the free list written by @c checkpoint. The
+    //! capacity must be large enough.
+    template<typename File>
+    bool restore(File& f) noexcept
+    {
+        stop_sharing();
+
+        u64 header[3];
+        if (!read_raw(f, header) || header[1] > capacity ||
+            header[2] > header[1] || !read_raw(f, blocks, header[1]))
+            return false;
+
+        size      = static_cast<sz>(header[0]);
+        max_size  = static_cast<sz>(header[1]);
+        free_head = nullptr;
+
+        block** last = &free_head;
+        for (u64 i = 0; i != header[2]; ++i) {
+            u32 index;
+            if (!read_raw(f, index) || index >= max_size)
+                return false;
+
+            *last = &blocks[index];
+            last  = &blocks[index].next;
+        }
+        *last = nullptr;
+
+        return true;
+    }
+
     bool can_alloc(size_t number) const noexcept
     {
         return number + size < capacity;
@@ -954,6 +1131,40 @@ public:
     {
         return *reinterpret_cast<T*>(&(blocks[index]));
     }
+
+private:
+    //! Forget the shared blocks and use the own blocks again.
+    void stop_sharing() noexcept
+    {
+        if (owned) {
+            blocks    = owned;
+            owned     = nullptr;
+            free_head = nullptr;
+            size      = 0;
+            max_size  = 0;
+        }
+    }
+
+    //! Copy the @c number first blocks of @c src and rebuild the free list
+    //! of @c src_free_head in the own blocks.
+    void copy_blocks(const block* src,
+                     sz           number,
+                     const block* src_free_head) noexcept
+    {
+        if (number > 0)
+            std::memcpy(
+              static_cast<void*>(blocks), src, number * sizeof(block));
+
+        max_size  = number;
+        free_head = nullptr;
+
+        block** last = &free_head;
+        for (const block* b = src_free_head; b; b = b->next) {
+            *last = &blocks[b - src];
+            last  = &blocks[b - src].next;
+        }
+        *last = nullptr;
+    }
 };
 
 template<typename T>
@@ -1430,6 +1641,150 @@ public:
     }
 };
 
+/*****************************************************************************
+ *
+ * Heap view
+ *
+ ****************************************************************************/
+
+//! @brief A skew heap of the nodes of a @c block_allocator ordered by the
+//! first element of the values (the date of a @c dated_message) then by the
+//! last element (the insertion sequence): the values of the same date leave
+//! in insertion order.
+//!
+//! The @c prev and @c next fields of the nodes are the left and right
+//! children and the root index is stored by the user. Insertion and removal
+//! of the top cost amortized O(log n).
+template<typename T>
+class heap_view
+{
+public:
+    using node_type       = list_view_node<T>;
+    using allocator_type  = block_allocator<node_type>;
+    using value_type      = T;
+    using reference       = T&;
+    using const_reference = const T&;
+
+    static constexpr u32 none = static_cast<u32>(-1);
+
+private:
+    allocator_type& m_allocator;
+    u32&            m_root;
+
+    bool less(u32 a, u32 b) const noexcept
+    {
+        constexpr auto last = std::extent_v<decltype(T::data)> - 1u;
+        const auto&    lhs  = m_allocator[a].value;
+        const auto&    rhs  = m_allocator[b].value;
+
+        return lhs[0] < rhs[0] || (lhs[0] == rhs[0] && lhs[last] < rhs[last]);
+    }
+
+    //! Top-down merge: walk the right paths and swap the children of each
+    //! visited node.
+    u32 merge(u32 a, u32 b) noexcept
+    {
+        if (a == none)
+            return b;
+        if (b == none)
+            return a;
+
+        if (less(b, a))
+            std::swap(a, b);
+
+        const u32 root   = a;
+        u32       parent = a;
+
+        for (;;) {
+            const u32 right           = m_allocator[parent].next;
+            m_allocator[parent].next = m_allocator[parent].prev;
+
+            if (right == none) {
+                m_allocator[parent].prev = b;
+                break;
+            }
+
+            a = right;
+            if (less(b, a))
+                std::swap(a, b);
+
+            m_allocator[parent].prev = a;
+            parent                   = a;
+        }
+
+        return root;
+    }
+
+public:
+    heap_view(allocator_type& allocator, u32& root) noexcept
+      : m_allocator(allocator)
+      , m_root(root)
+    {}
+
+    ~heap_view() noexcept = default;
+
+    //! Free the nodes in O(n) with right rotations instead of a stack.
+    void clear() noexcept
+    {
+        u32 id = m_root;
+
+        while (id != none) {
+            const u32 left = m_allocator[id].prev;
+
+            if (left == none) {
+                const u32 to_delete = id;
+                id                  = m_allocator[id].next;
+                m_allocator.free(to_delete);
+            } else {
+                m_allocator[id].prev   = m_allocator[left].next;
+                m_allocator[left].next = id;
+                id                     = left;
+            }
+        }
+
+        m_root = none;
+    }
+
+    bool empty() const noexcept { return m_root == none; }
+
+    reference top() noexcept
+    {
+        irt_assert(!empty());
+
+        return m_allocator[m_root].value;
+    }
+
+    const_reference top() const noexcept
+    {
+        irt_assert(!empty());
+
+        return m_allocator[m_root].value;
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args) noexcept
+    {
+        irt_assert(m_allocator.can_alloc());
+
+        const u32 new_node = m_allocator.alloc_index();
+        new (&m_allocator[new_node].value) T{ std::forward<Args>(args)... };
+        m_allocator[new_node].prev = none;
+        m_allocator[new_node].next = none;
+
+        m_root = merge(m_root, new_node);
+    }
+
+    void pop() noexcept
+    {
+        irt_assert(!empty());
+
+        const u32 to_delete = m_root;
+        m_root              = merge(m_allocator[to_delete].prev,
+                       m_allocator[to_delete].next);
+        m_allocator.free(to_delete);
+    }
+};
+
 /*****************************************************************************
  *
  * data-array
@@ -1487,6 +1842,7 @@ constexpr u32 make_next_key(u32 key) noexcept
 //!
 //! A container to handle everything from trivial, pod or object.
 //! - linear memory/iteration
+//! - iteration proportional to the number of valid items
 //! - O(1) alloc/free
 //! - stable indices
 //! - weak references
@@ -1511,6 +1867,8 @@ private:
     };
 
     item* m_items     = nullptr; // items array.
+    u32*  m_dense     = nullptr; // indices of the valid items.
+    u32*  m_positions = nullptr; // position of the valid items in m_dense.
     u32   m_max_size  = 0;       // number of valid item in array.
     u32   m_max_used  = 0;       // highest index ever allocated in array.
     u32   m_capacity  = 0;       // capacity of the array.
@@ -1531,6 +1889,9 @@ public:
 
         if (m_items)
             g_free_fn(m_items);
+
+        if (m_dense)
+            g_free_fn(m_dense);
     }
 
     //! @brief Initialize the underlying byffer of T.
@@ -1547,6 +1908,15 @@ public:
         if (!m_items)
             return status::data_array_not_enough_memory;
 
+        if (m_dense)
+            g_free_fn(m_dense);
+
+        m_dense = static_cast<u32*>(g_alloc_fn(capacity * 2u * sizeof(u32)));
+        if (!m_dense)
+            return status::data_array_not_enough_memory;
+
+        m_positions = m_dense + capacity;
+
         m_max_size  = 0;
         m_max_used  = 0;
         m_capacity  = static_cast<u32>(capacity);
@@ -1562,11 +1932,9 @@ public:
     void clear() noexcept
     {
         if constexpr (!std::is_trivial_v<T>) {
-            for (u32 i = 0; i != m_max_used; ++i) {
-                if (is_valid(m_items[i].id)) {
-                    m_items[i].item.~T();
-                    m_items[i].id = static_cast<identifier_type>(0);
-                }
+            for (u32 i = 0; i != m_max_size; ++i) {
+                m_items[m_dense[i]].item.~T();
+                m_items[m_dense[i]].id = static_cast<identifier_type>(0);
             }
         }
 
@@ -1609,6 +1977,8 @@ public:
         m_items[new_index].id = make_id<Identifier>(m_next_key, new_index);
         m_next_key            = make_next_key<Identifier>(m_next_key);
 
+        m_dense[m_max_size]    = new_index;
+        m_positions[new_index] = m_max_size;
         ++m_max_size;
 
         return m_items[new_index].item;
@@ -1645,6 +2015,8 @@ public:
         m_items[new_index].id = make_id<Identifier>(m_next_key, new_index);
         m_next_key            = make_next_key<Identifier>(m_next_key);
 
+        m_dense[m_max_size]    = new_index;
+        m_positions[new_index] = m_max_size;
         ++m_max_size;
 
         return { true, &m_items[new_index].item };
@@ -1669,7 +2041,7 @@ public:
         m_items[index].id = static_cast<Identifier>(m_free_head);
         m_free_head       = index;
 
-        --m_max_size;
+        remove_dense(index);
     }
 
     //! @brief Free the element pointer by @c id.
@@ -1689,7 +2061,7 @@ public:
         m_items[index].id = static_cast<Identifier>(m_free_head);
         m_free_head       = index;
 
-        --m_max_size;
+        remove_dense(index);
     }
 
     //! @brief Accessor to the id part of the item
@@ -1759,6 +2131,11 @@ public:
     }
 
     //! @brief Return next valid item.
+    //!
+    //! Walk the dense index of the valid items: the loop is proportional to
+    //! @c size() and not to @c max_used(). The order is the allocation order
+    //! until a @c free moves the last item into the hole, see @c sort.
+    //!
     //! @code
     //! data_array<int> d;
     //! ...
@@ -1768,37 +2145,83 @@ public:
     //! }
     //! @endcode
     //!
-    //! Loop item where @c id & 0xffffffff00000000 != 0 (i.e. items not on
-    //! free list).
+    //! The item @c t can be freed before the call: @c next resumes at its
+    //! old position, filled by the last item, and no item is skipped.
+    //!
+    //! @code
+    //! int* value = nullptr;
+    //! while (d.next(value))
+    //!     if (*value < 0)
+    //!         d.free(*value);
+    //! @endcode
     //!
     //! @return true if the paramter @c t is valid false otherwise.
     bool next(T*& t) const noexcept
     {
-        u32 index;
+        u32 position = 0;
 
         if (t) {
-            auto id = get_id(*t);
-            index   = get_index(id);
-            ++index;
-
-            for (; index < m_max_used; ++index) {
-                if (is_valid(m_items[index].id)) {
-                    t = &m_items[index].item;
-                    return true;
-                }
-            }
-        } else {
-            for (index = 0; index < m_max_used; ++index) {
-                if (is_valid(m_items[index].id)) {
-                    t = &m_items[index].item;
-                    return true;
-                }
-            }
+            const auto* ptr   = reinterpret_cast<const item*>(t);
+            const auto  index = static_cast<u32>(ptr - m_items);
+            irt_assert(index < m_max_used);
+
+            position = is_valid(ptr->id) ? m_positions[index] + 1u
+                                         : m_positions[index];
+        }
+
+        if (position < m_max_size) {
+            t = &m_items[m_dense[position]].item;
+            return true;
         }
 
         return false;
     }
 
+    //! @brief Sort the dense index by index in the array.
+    //!
+    //! After this call @c next walks the items in the memory order until the
+    //! next @c free.
+    void sort() noexcept
+    {
+        std::sort(m_dense, m_dense + m_max_size);
+
+        for (u32 i = 0; i != m_max_size; ++i)
+            m_positions[m_dense[i]] = i;
+    }
+
+    //! @brief Copy the items, the identifiers and the free list of @c other.
+    //!
+    //! The copies keep the identifiers of @c other. A @c memcpy of the used
+    //! part of the arrays: the capacity must be greater than or equal to
+    //! @c other.max_used().
+    status copy(const data_array& other) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "data_array::copy needs a trivially copyable type");
+
+        if (other.m_max_used > m_capacity)
+            return status::data_array_not_enough_memory;
+
+        clear();
+
+        if (other.m_max_used > 0) {
+            std::memcpy(static_cast<void*>(m_items),
+                        other.m_items,
+                        other.m_max_used * sizeof(item));
+            std::memcpy(
+              m_dense, other.m_dense, other.m_max_size * sizeof(u32));
+            std::memcpy(
+              m_positions, other.m_positions, other.m_max_used * sizeof(u32));
+        }
+
+        m_max_size  = other.m_max_size;
+        m_max_used  = other.m_max_used;
+        m_next_key  = other.m_next_key;
+        m_free_head = other.m_free_head;
+
+        return status::success;
+    }
+
     constexpr bool full() const noexcept
     {
         return m_free_head == none && m_max_used == m_capacity;
@@ -1831,6 +2254,19 @@ public:
     {
         return m_free_head == none;
     }
+
+private:
+    //! Move the last valid item of the dense index into the hole. The
+    //! position of the freed @c index is kept for @c next.
+    void remove_dense(const u32 index) noexcept
+    {
+        const auto position = m_positions[index];
+        const auto last     = m_dense[m_max_size - 1u];
+
+        m_dense[position] = last;
+        m_positions[last] = position;
+        --m_max_size;
+    }
 };
 
 struct record
@@ -2025,6 +2461,75 @@ public:
 
     size_t full() const noexcept { return m_size == capacity; }
 
+    //! Index of @c elem in the nodes or @c -1 if @c elem is null.
+    u32 index(const node* elem) const noexcept
+    {
+        return elem ? static_cast<u32>(elem - nodes) : static_cast<u32>(-1);
+    }
+
+    handle get(u32 index) const noexcept
+    {
+        return index == static_cast<u32>(-1) ? nullptr : &nodes[index];
+    }
+
+    //! Write the nodes into @c f: the links are written as indices.
+    template<typename File>
+    bool checkpoint(File& f) const noexcept
+    {
+        const u64 header[4] = { m_size, max_size, index(root), index(free_list) };
+        if (!write_raw(f, header))
+            return false;
+
+        for (size_t i = 0; i != max_size; ++i) {
+            const u32 links[3] = { index(nodes[i].prev),
+                                   index(nodes[i].next),
+                                   index(nodes[i].child) };
+
+            if (!write_raw(f, nodes[i].tn) || !write_raw(f, nodes[i].id) ||
+                !write_raw(f, links))
+                return false;
+        }
+
+        return true;
+    }
+
+    //! Read the nodes written by @c checkpoint. The capacity must be large
+    //! enough.
+    template<typename File>
+    bool restore(File& f) noexcept
+    {
+        u64 header[4];
+        if (!read_raw(f, header) || header[1] > capacity)
+            return false;
+
+        const auto valid = [&header](u32 index) noexcept {
+            return index == static_cast<u32>(-1) || index < header[1];
+        };
+
+        for (size_t i = 0; i != header[1]; ++i) {
+            u32 links[3];
+            if (!read_raw(f, nodes[i].tn) || !read_raw(f, nodes[i].id) ||
+                !read_raw(f, links) || !valid(links[0]) || !valid(links[1]) ||
+                !valid(links[2]))
+                return false;
+
+            nodes[i].prev  = get(links[0]);
+            nodes[i].next  = get(links[1]);
+            nodes[i].child = get(links[2]);
+        }
+
+        if (!valid(static_cast<u32>(header[2])) ||
+            !valid(static_cast<u32>(header[3])))
+            return false;
+
+        m_size    = static_cast<size_t>(header[0]);
+        max_size  = static_cast<size_t>(header[1]);
+        root      = get(static_cast<u32>(header[2]));
+        free_list = get(static_cast<u32>(header[3]));
+
+        return true;
+    }
+
     bool empty() const noexcept { return root == nullptr; }
 
     handle top() const noexcept { return root; }
@@ -2135,7 +2640,8 @@ struct source
     {
         initialize, // Use to initialize the buffer at simulation init step.
         update,     // Use to update the buffer when all values are read.
-        finalize    // Use to clear the buffer at simulation finalize step.
+        finalize,   // Use to clear the buffer at simulation finalize step.
+        locate      // Use to get the beginning of the buffers (checkpoint).
     };
 
     double* buffer = nullptr;
@@ -2291,6 +2797,24 @@ struct observer
     void*               user_data = nullptr;
 };
 
+//! @brief Phases of @c simulation::run reported to @c simulation::trace_fn.
+//!
+//! @c start before the scheduler pop, @c popped when the bag is known,
+//! @c transitions after the transitions of the bag and @c deliveries after
+//! the delivery of the output messages.
+enum class run_phase
+{
+    start,
+    popped,
+    transitions,
+    deliveries
+};
+
+using run_trace_fn = void (*)(void*           user_data,
+                              const run_phase phase,
+                              const time      t,
+                              const i32       bag) noexcept;
+
 struct node
 {
     node() = default;
@@ -2304,13 +2828,53 @@ struct node
     i8       port_index = 0;
 };
 
-struct output_message
+//! @brief Identifier of the destination @c index outside of the simulation.
+//!
+//! A remote identifier has a null key so no model matches it. The
+//! @c send_message function keeps the remote nodes and pushes their
+//! messages into @c simulation::emitting_output_ports where an engine (see
+//! @c timewarp) forwards them. @c simulation::run_bag ignores them.
+constexpr model_id make_remote_id(const u32 index) noexcept
 {
-    message  msg;
-    model_id model;
+    return make_id<model_id>(0u, index + 1u);
+}
+
+constexpr bool is_remote(const model_id id) noexcept
+{
+    return get_key(id) == 0u && get_index(id) > 0u;
+}
+
+constexpr u32 get_remote_index(const model_id id) noexcept
+{
+    return get_index(id) - 1u;
+}
+
+struct output_message
+{
+    message  msg;
+    model_id model;
     i8       port;
 };
 
+enum class structural_change_type : i8
+{
+    clone,
+    deallocate,
+    connect,
+    disconnect
+};
+
+//! @brief A change of the structure of the simulation requested during a
+//! @c simulation::run and applied at the end of the bag.
+struct structural_change
+{
+    model_id               src;
+    model_id               dst;
+    structural_change_type type;
+    i8                     port_src;
+    i8                     port_dst;
+};
+
 using output_port = u64;
 using input_port  = u64;
 
@@ -2324,6 +2888,12 @@ bool can_alloc_node(const simulation& sim, int alloc_number) noexcept;
 bool can_alloc_dated_message(const simulation& sim, int alloc_number) noexcept;
 
 list_view<message> append_message(simulation& sim, input_port& port) noexcept;
+
+template<typename Dynamics>
+status push_message(simulation&    sim,
+                    Dynamics&      dyn,
+                    int            port,
+                    const message& msg) noexcept;
 list_view_const<message> get_message(const simulation& sim,
                                      const input_port  port) noexcept;
 
@@ -2339,6 +2909,8 @@ list_view<dated_message>       append_dated_message(simulation& sim,
                                                     u64&        id) noexcept;
 list_view_const<dated_message> get_dated_message(const simulation& sim,
                                                  const u64         id) noexcept;
+heap_view<dated_message>       append_dated_message_heap(simulation& sim,
+                                                         u32& id) noexcept;
 
 status send_message(simulation&  sim,
                     output_port& p,
@@ -2405,6 +2977,21 @@ using has_input_port_t = decltype(&T::x);
 template<typename T>
 using has_output_port_t = decltype(&T::y);
 
+//! How the messages received by the input ports of a dynamics during one
+//! bag are kept: all of them, only the first or only the last one. A
+//! dynamics declares a @c static @c constexpr @c input_policy member when
+//! its transition reads a single message per port, the other messages are
+//! then dropped at delivery without allocation.
+enum class port_policy : u8
+{
+    all,
+    first,
+    last
+};
+
+template<typename T>
+using input_policy_t = decltype(T::input_policy);
+
 struct integrator
 {
     input_port  x[3];
@@ -2670,6 +3257,9 @@ struct abstract_integrator;
 template<>
 struct abstract_integrator<1>
 {
+    //! The transition reads the first message of each port.
+    static constexpr port_policy input_policy = port_policy::first;
+
     input_port  x[2];
     output_port y[1];
     real        default_X  = zero;
@@ -2790,6 +3380,9 @@ struct abstract_integrator<1>
 template<>
 struct abstract_integrator<2>
 {
+    //! The transition reads the first message of each port.
+    static constexpr port_policy input_policy = port_policy::first;
+
     input_port  x[2];
     output_port y[1];
     real        default_X  = zero;
@@ -2949,6 +3542,9 @@ struct abstract_integrator<2>
 template<>
 struct abstract_integrator<3>
 {
+    //! The transition reads the first message of each port.
+    static constexpr port_policy input_policy = port_policy::first;
+
     input_port  x[2];
     output_port y[1];
     real        default_X  = zero;
@@ -3297,6 +3893,9 @@ struct abstract_power
 {
     static_assert(1 <= QssLevel && QssLevel <= 3, "Only for Qss1, 2 and 3");
 
+    //! The transition reads the first message of each port.
+    static constexpr port_policy input_policy = port_policy::first;
+
     input_port  x[1];
     output_port y[1];
     time        sigma;
@@ -3392,6 +3991,9 @@ struct abstract_square
 {
     static_assert(1 <= QssLevel && QssLevel <= 3, "Only for Qss1, 2 and 3");
 
+    //! The transition reads the first message of each port.
+    static constexpr port_policy input_policy = port_policy::first;
+
     input_port  x[1];
     output_port y[1];
     time        sigma;
@@ -3481,6 +4083,9 @@ struct abstract_sum
     static_assert(1 <= QssLevel && QssLevel <= 3, "Only for Qss1, 2 and 3");
     static_assert(PortNumber > 1, "sum model need at least two input port");
 
+    //! The transition reads the last message of each port.
+    static constexpr port_policy input_policy = port_policy::last;
+
     input_port  x[PortNumber];
     output_port y[1];
     time        sigma;
@@ -3638,6 +4243,9 @@ struct abstract_wsum
     static_assert(1 <= QssLevel && QssLevel <= 3, "Only for Qss1, 2 and 3");
     static_assert(PortNumber > 1, "sum model need at least two input port");
 
+    //! The transition reads the last message of each port.
+    static constexpr port_policy input_policy = port_policy::last;
+
     input_port  x[PortNumber];
     output_port y[1];
     time        sigma;
@@ -3800,6 +4408,9 @@ struct abstract_multiplier
 {
     static_assert(1 <= QssLevel && QssLevel <= 3, "Only for Qss1, 2 and 3");
 
+    //! The transition reads the last message of each port.
+    static constexpr port_policy input_policy = port_policy::last;
+
     input_port  x[2];
     output_port y[1];
     time        sigma;
@@ -4262,6 +4873,9 @@ struct adder
 {
     static_assert(PortNumber > 1, "adder model need at least two input port");
 
+    //! The transition reads the last message of each port.
+    static constexpr port_policy input_policy = port_policy::last;
+
     input_port  x[PortNumber];
     output_port y[1];
     time        sigma;
@@ -4355,6 +4969,9 @@ struct mult
 {
     static_assert(PortNumber > 1, "mult model need at least two input port");
 
+    //! The transition reads the last message of each port.
+    static constexpr port_policy input_policy = port_policy::last;
+
     input_port  x[PortNumber];
     output_port y[1];
     time        sigma;
@@ -4750,6 +5367,9 @@ struct flow
 template<size_t PortNumber>
 struct accumulator
 {
+    //! The transition reads the first message of each port.
+    static constexpr port_policy input_policy = port_policy::first;
+
     input_port x[2 * PortNumber];
     time       sigma;
     real       number;
@@ -4800,6 +5420,9 @@ struct accumulator
 
 struct cross
 {
+    //! The transition reads the last message of each port.
+    static constexpr port_policy input_policy = port_policy::last;
+
     input_port  x[4];
     output_port y[2];
     time        sigma;
@@ -4917,6 +5540,9 @@ struct abstract_cross
 {
     static_assert(1 <= QssLevel && QssLevel <= 3, "Only for Qss1, 2 and 3");
 
+    //! The transition reads the last message of each port.
+    static constexpr port_policy input_policy = port_policy::last;
+
     input_port  x[4];
     output_port y[3];
     time        sigma;
@@ -5345,7 +5971,8 @@ struct dynamic_queue
     input_port  x[1];
     output_port y[1];
     time        sigma;
-    u64         fifo = static_cast<u64>(-1);
+    u32         heap     = static_cast<u32>(-1);
+    u32         sequence = 0; // insertion order of the messages of a date.
 
     source default_source_ta;
     bool   stop_on_error = false;
@@ -5354,15 +5981,17 @@ struct dynamic_queue
 
     dynamic_queue(const dynamic_queue& other) noexcept
       : sigma(other.sigma)
-      , fifo(static_cast<u64>(-1))
+      , heap(static_cast<u32>(-1))
+      , sequence(0)
       , default_source_ta(other.default_source_ta)
       , stop_on_error(other.stop_on_error)
     {}
 
     status initialize(simulation& sim) noexcept
     {
-        sigma = time_domain<time>::infinity;
-        fifo  = static_cast<u64>(-1);
+        sigma    = time_domain<time>::infinity;
+        heap     = static_cast<u32>(-1);
+        sequence = 0;
 
         if (stop_on_error)
             irt_return_if_bad(initialize_source(sim, default_source_ta));
@@ -5374,7 +6003,7 @@ struct dynamic_queue
 
     status finalize(simulation& sim) noexcept
     {
-        append_dated_message(sim, fifo).clear();
+        append_dated_message_heap(sim, heap).clear();
         irt_return_if_bad(finalize_source(sim, default_source_ta));
 
         return status::success;
@@ -5382,9 +6011,7 @@ struct dynamic_queue
 
     status transition(simulation& sim, time t, time /*e*/, time /*r*/) noexcept
     {
-        auto list = append_dated_message(sim, fifo);
-        while (!list.empty() && list.front().data[0] <= t)
-            list.pop_front();
+        auto queue = append_dated_message_heap(sim, heap);
 
         auto span = get_message(sim, x[0]);
         for (const auto& msg : span) {
@@ -5394,17 +6021,23 @@ struct dynamic_queue
             double ta;
             if (stop_on_error) {
                 irt_return_if_bad(update_source(sim, default_source_ta, ta));
-                list.emplace_back(
-                  t + static_cast<real>(ta), msg[0], msg[1], msg[2]);
+                queue.emplace(t + static_cast<real>(ta),
+                              msg[0],
+                              msg[1],
+                              msg[2],
+                              static_cast<real>(sequence++));
             } else {
                 if (is_success(update_source(sim, default_source_ta, ta)))
-                    list.emplace_back(
-                      t + static_cast<real>(ta), msg[0], msg[1], msg[2]);
+                    queue.emplace(t + static_cast<real>(ta),
+                                  msg[0],
+                                  msg[1],
+                                  msg[2],
+                                  static_cast<real>(sequence++));
             }
         }
 
-        if (!list.empty()) {
-            sigma = list.front().data[0] - t;
+        if (!queue.empty()) {
+            sigma = queue.top()[0] - t;
             sigma = sigma <= time_domain<time>::zero ? time_domain<time>::zero
                                                      : sigma;
         } else {
@@ -5414,19 +6047,23 @@ struct dynamic_queue
         return status::success;
     }
 
+    //! Send and remove the messages of the earliest release date.
     status lambda(simulation& sim) noexcept
     {
-        if (fifo == static_cast<u64>(-1))
+        auto queue = append_dated_message_heap(sim, heap);
+        if (queue.empty())
             return status::success;
 
-        auto       list = append_dated_message(sim, fifo);
-        auto       it   = list.begin();
-        auto       end  = list.end();
-        const auto t    = it->data[0];
+        const auto t = queue.top()[0];
+        while (!queue.empty() && queue.top()[0] <= t) {
+            const auto& msg = queue.top();
+            irt_return_if_bad(send_message(sim, y[0], msg[1], msg[2], msg[3]));
+            queue.pop();
+        }
 
-        for (; it != end && it->data[0] <= t; ++it)
-            irt_return_if_bad(
-              send_message(sim, y[0], it->data[1], it->data[2], it->data[3]));
+        // Restart the sequence to keep it exact in a real.
+        if (queue.empty())
+            sequence = 0;
 
         return status::success;
     }
@@ -5437,7 +6074,8 @@ struct priority_queue
     input_port  x[1];
     output_port y[1];
     time        sigma;
-    u64         fifo       = static_cast<u64>(-1);
+    u32         heap       = static_cast<u32>(-1);
+    u32         sequence   = 0; // insertion order of the messages of a date.
     real        default_ta = 1.0;
 
     source default_source_ta;
@@ -5447,7 +6085,8 @@ struct priority_queue
 
     priority_queue(const priority_queue& other) noexcept
       : sigma(other.sigma)
-      , fifo(static_cast<u64>(-1))
+      , heap(static_cast<u32>(-1))
+      , sequence(0)
       , default_ta(other.default_ta)
       , default_source_ta(other.default_source_ta)
       , stop_on_error(other.stop_on_error)
@@ -5461,21 +6100,9 @@ private:
         if (!can_alloc_dated_message(sim, 1))
             irt_bad_return(status::model_priority_queue_source_is_null);
 
-        auto list = append_dated_message(sim, fifo);
-        if (list.empty() || list.begin()->data[0] > t) {
-            list.emplace_front(irt::real(t), msg[0], msg[1], msg[2]);
-        } else {
-            auto it  = list.begin();
-            auto end = list.end();
-            ++it;
-
-            for (; it != end; ++it) {
-                if (it->data[0] > t) {
-                    list.emplace(it, irt::real(t), msg[0], msg[1], msg[2]);
-                    return status::success;
-                }
-            }
-        }
+        const auto seq = static_cast<real>(sequence++);
+        append_dated_message_heap(sim, heap).emplace(
+          irt::real(t), msg[0], msg[1], msg[2], seq);
 
         return status::success;
     }
@@ -5488,15 +6115,16 @@ public:
         else
             (void)initialize_source(sim, default_source_ta);
 
-        sigma = time_domain<time>::infinity;
-        fifo  = static_cast<u64>(-1);
+        sigma    = time_domain<time>::infinity;
+        heap     = static_cast<u32>(-1);
+        sequence = 0;
 
         return status::success;
     }
 
     status finalize(simulation& sim) noexcept
     {
-        append_dated_message(sim, fifo).clear();
+        append_dated_message_heap(sim, heap).clear();
         irt_return_if_bad(finalize_source(sim, default_source_ta));
 
         return status::success;
@@ -5504,10 +6132,6 @@ public:
 
     status transition(simulation& sim, time t, time /*e*/, time /*r*/) noexcept
     {
-        auto list = append_dated_message(sim, fifo);
-        while (!list.empty() && list.front().data[0] <= t)
-            list.pop_front();
-
         auto span = get_message(sim, x[0]);
         for (const auto& msg : span) {
             double value;
@@ -5529,8 +6153,8 @@ public:
             }
         }
 
-        if (!list.empty()) {
-            sigma = list.front()[0] - t;
+        if (auto queue = append_dated_message_heap(sim, heap); !queue.empty()) {
+            sigma = queue.top()[0] - t;
             sigma = sigma <= time_domain<time>::zero ? time_domain<time>::zero
                                                      : sigma;
         } else {
@@ -5542,17 +6166,20 @@ public:
 
     status lambda(simulation& sim) noexcept
     {
-        if (fifo == static_cast<u64>(-1))
+        auto queue = append_dated_message_heap(sim, heap);
+        if (queue.empty())
             return status::success;
 
-        auto       list = get_dated_message(sim, fifo);
-        auto       it   = list.begin();
-        auto       end  = list.end();
-        const auto t    = it->data[0];
+        const auto t = queue.top()[0];
+        while (!queue.empty() && queue.top()[0] <= t) {
+            const auto& msg = queue.top();
+            irt_return_if_bad(send_message(sim, y[0], msg[1], msg[2], msg[3]));
+            queue.pop();
+        }
 
-        for (; it != end && it->data[0] <= t; ++it)
-            irt_return_if_bad(
-              send_message(sim, y[0], it->data[1], it->data[2], it->data[3]));
+        // Restart the sequence to keep it exact in a real.
+        if (queue.empty())
+            sequence = 0;
 
         return status::success;
     }
@@ -6112,6 +6739,26 @@ public:
     bool empty() const noexcept { return m_heap.empty(); }
 
     size_t size() const noexcept { return m_heap.size(); }
+
+    //! Index of the scheduller node of @c mdl (see @c checkpoint).
+    u32 index(const model& mdl) const noexcept
+    {
+        return m_heap.index(mdl.handle);
+    }
+
+    heap::handle get(u32 index) const noexcept { return m_heap.get(index); }
+
+    template<typename File>
+    bool checkpoint(File& f) const noexcept
+    {
+        return m_heap.checkpoint(f);
+    }
+
+    template<typename File>
+    bool restore(File& f) noexcept
+    {
+        return m_heap.restore(f);
+    }
 };
 
 /*****************************************************************************
@@ -6261,6 +6908,154 @@ constexpr model& get_model(Dynamics& d) noexcept
     return *(model*)((char*)__mptr - offsetof(model, dyn));
 }
 
+//! @brief Call @c f with the dynamics of @c mdl, one of the @c Dynamics.
+//!
+//! A smaller switch than @c dispatch: the compiler inlines the few cases or
+//! builds a small jump table. The type of the model must be one of the
+//! @c Dynamics (see @c is_dynamics_among).
+template<typename Dynamics,
+         typename... Others,
+         typename Model,
+         typename Function>
+constexpr decltype(auto) dispatch_among(Model& mdl, Function&& f) noexcept
+{
+    using type = std::
+      conditional_t<std::is_const_v<Model>, const Dynamics, Dynamics>;
+
+    if constexpr (sizeof...(Others) > 0) {
+        if (mdl.type != dynamics_typeof<Dynamics>())
+            return dispatch_among<Others...>(mdl, std::forward<Function>(f));
+    } else {
+        irt_assert(mdl.type == dynamics_typeof<Dynamics>());
+    }
+
+    return f(*reinterpret_cast<type*>(&mdl.dyn));
+}
+
+template<typename... Dynamics>
+constexpr bool is_dynamics_among(dynamics_type type) noexcept
+{
+    return ((type == dynamics_typeof<Dynamics>()) || ...);
+}
+
+//! The dispatcher of the @c simulation run functions: all the dynamics.
+struct any_dynamics
+{
+    static constexpr bool accepts(dynamics_type /*type*/) noexcept
+    {
+        return true;
+    }
+
+    template<typename Model, typename Function>
+    constexpr decltype(auto) operator()(Model& mdl, Function&& f) const noexcept
+    {
+        return dispatch(mdl, std::forward<Function>(f));
+    }
+};
+
+//! The dispatcher of the @c simulation run functions restricted to the
+//! @c Dynamics.
+template<typename... Dynamics>
+struct dynamics_among
+{
+    static_assert(sizeof...(Dynamics) > 0, "dynamics_among needs a type");
+
+    static constexpr bool accepts(dynamics_type type) noexcept
+    {
+        return is_dynamics_among<Dynamics...>(type);
+    }
+
+    template<typename Model, typename Function>
+    constexpr decltype(auto) operator()(Model& mdl, Function&& f) const noexcept
+    {
+        return dispatch_among<Dynamics...>(mdl, std::forward<Function>(f));
+    }
+};
+
+//! Call @c f on each @c source of the dynamics.
+template<typename Dynamics, typename Function>
+constexpr void for_each_source(Dynamics& dyn, Function&& f) noexcept
+{
+    using type = std::remove_const_t<Dynamics>;
+
+    if constexpr (std::is_same_v<type, generator>) {
+        f(dyn.default_source_ta);
+        f(dyn.default_source_value);
+    } else if constexpr (std::is_same_v<type, dynamic_queue> ||
+                         std::is_same_v<type, priority_queue>) {
+        f(dyn.default_source_ta);
+    }
+}
+
+#ifdef IRRITATOR_ENABLE_STATS
+//! @brief Counters of the simulation hot path.
+//!
+//! Filled only if @c IRRITATOR_ENABLE_STATS is defined. The scheduler updates
+//! merge the reintegration of the transitioned models and the update of the
+//! models receiving messages.
+struct simulation_stats
+{
+    struct counters
+    {
+        i64 transitions       = 0;
+        i64 lambdas           = 0;
+        i64 messages_sent     = 0;
+        i64 messages_received = 0;
+        i64 messages_merged   = 0; //!< Dropped by the @c port_policy.
+        i64 inserts           = 0;
+        i64 updates           = 0;
+        i64 pops              = 0;
+        u64 cycles            = 0; //!< TSC cycles in @c make_transition.
+    };
+
+    //! The bucket @c i counts the bags of size in [2^i, 2^(i+1)[.
+    static constexpr int bag_histogram_size = 32;
+
+    counters types[dynamics_type_size()];
+    i64      bags[bag_histogram_size];
+
+    sz message_peak       = 0;
+    sz node_peak          = 0;
+    sz record_peak        = 0;
+    sz dated_message_peak = 0;
+
+    //! Read the time stamp counter around each @c make_transition.
+    bool measure_cycles = false;
+
+    void clear() noexcept
+    {
+        std::fill_n(types, dynamics_type_size(), counters{});
+        std::fill_n(bags, bag_histogram_size, i64{ 0 });
+
+        message_peak       = 0;
+        node_peak          = 0;
+        record_peak        = 0;
+        dated_message_peak = 0;
+    }
+
+    void add_bag(i64 size) noexcept
+    {
+        int bucket = 0;
+        while (size > 1 && bucket + 1 < bag_histogram_size) {
+            size >>= 1;
+            ++bucket;
+        }
+
+        ++bags[bucket];
+    }
+
+    counters& operator[](dynamics_type type) noexcept
+    {
+        return types[static_cast<i32>(type)];
+    }
+
+    const counters& operator[](dynamics_type type) const noexcept
+    {
+        return types[static_cast<i32>(type)];
+    }
+};
+#endif
+
 struct simulation
 {
     block_allocator<list_view_node<message>>       message_alloc;
@@ -6269,11 +7064,22 @@ struct simulation
     block_allocator<list_view_node<dated_message>> dated_message_alloc;
     vector<output_message>                         emitting_output_ports;
     vector<model_id>                               immediate_models;
+    vector<structural_change>                      structural_changes;
     data_array<model, model_id>                    models;
     data_array<observer, observer_id>              observers;
 
     scheduller sched;
 
+#ifdef IRRITATOR_ENABLE_STATS
+    simulation_stats stats;
+#endif
+
+    //! @brief Optional callback called at each phase of @c run.
+    //!
+    //! See the @c tracer class for an implementation.
+    run_trace_fn trace_fn        = nullptr;
+    void*        trace_user_data = nullptr;
+
     //! @brief Use initialize, generate or finalize data from a source.
     //!
     //! See the @c external_source class for an implementation.
@@ -6302,6 +7108,7 @@ public:
 
         emitting_output_ports.reserve(static_cast<i32>(model_capacity));
         immediate_models.reserve(static_cast<i32>(model_capacity));
+        structural_changes.reserve(static_cast<i32>(model_capacity));
 
         return status::success;
     }
@@ -6324,6 +7131,7 @@ public:
 
         emitting_output_ports.clear();
         immediate_models.clear();
+        structural_changes.clear();
     }
 
     //! @brief cleanup simulation and destroy all models and connections
@@ -6337,6 +7145,49 @@ public:
         observers.clear();
     }
 
+    //! @brief Copy the models and the connections of @c src in one pass.
+    //!
+    //! The models keep their identifiers and their connections: a @c memcpy
+    //! of the models and of the connection storage without @c dispatch nor
+    //! allocation. The capacities of this simulation must be large enough.
+    //! The observers are not copied and the sources keep the identifiers of
+    //! @c src. Call @c initialize before @c run.
+    //!
+    //! With @c copy_on_write, the connections are read from @c src until
+    //! the first connection change of this simulation (see
+    //! @c block_allocator::share): the copies differing by parameters only
+    //! share the connections of their template, which must outlive them
+    //! and keep its connections.
+    bool can_copy(const simulation& src) const noexcept
+    {
+        return src.models.max_used() <= models.capacity() &&
+               node_alloc.can_copy(src.node_alloc);
+    }
+
+    status copy(const simulation& src, bool copy_on_write = false) noexcept
+    {
+        irt_return_if_fail(src.models.max_used() <= models.capacity(),
+                           status::simulation_not_enough_model);
+
+        clean();
+        observers.clear();
+
+        if (copy_on_write)
+            irt_return_if_bad(node_alloc.share(src.node_alloc));
+        else
+            irt_return_if_bad(node_alloc.copy(src.node_alloc));
+
+        irt_return_if_bad(models.copy(src.models));
+
+        model* mdl = nullptr;
+        while (models.next(mdl)) {
+            mdl->handle = nullptr;
+            mdl->obs_id = static_cast<observer_id>(0);
+        }
+
+        return status::success;
+    }
+
     //! @brief This function allocates dynamics and models.
     template<typename Dynamics>
     Dynamics& alloc() noexcept
@@ -6417,6 +7268,13 @@ public:
         obs.model  = models.get_id(mdl);
     }
 
+    //! @brief Free the model @c id, its observer and its messages without
+    //! finalizing it (see @c request_deallocate).
+    //!
+    //! The output ports of the other models keep their connections to @c id:
+    //! a new model in the same slot gets another identifier and
+    //! @c send_message removes these connections lazily (except with a shared
+    //! node allocator).
     status deallocate(model_id id)
     {
         auto* mdl = models.try_to_get(id);
@@ -6495,13 +7353,74 @@ public:
         return global_disconnect(*this, src, port_src, get_id(dst), port_dst);
     }
 
+    //! @brief The model built by the last clone request of the current bag.
+    //!
+    //! Use it as the identifier of the new model in the next requests of the
+    //! same bag, for example to connect it.
+    static constexpr model_id cloned_model = static_cast<model_id>(-1);
+
+    //! @brief Clone the model @c id at the end of the current bag and
+    //! initialize the new model at the date of the bag.
+    //!
+    //! The requests (clone, deallocate, connect and disconnect) can be used
+    //! from the @c transition functions: they are queued and applied in
+    //! order after the delivery of the messages. The requests which
+    //! reference a deleted model are ignored.
+    status request_clone(model_id id) noexcept
+    {
+        return request(structural_change_type::clone, id, id, 0, 0);
+    }
+
+    //! @brief Finalize and deallocate the model @c id at the end of the
+    //! current bag.
+    status request_deallocate(model_id id) noexcept
+    {
+        return request(structural_change_type::deallocate, id, id, 0, 0);
+    }
+
+    status request_connect(model_id src,
+                           int      port_src,
+                           model_id dst,
+                           int      port_dst) noexcept
+    {
+        return request(
+          structural_change_type::connect, src, dst, port_src, port_dst);
+    }
+
+    status request_disconnect(model_id src,
+                              int      port_src,
+                              model_id dst,
+                              int      port_dst) noexcept
+    {
+        return request(
+          structural_change_type::disconnect, src, dst, port_src, port_dst);
+    }
+
     status initialize(time t) noexcept
+    {
+        return initialize(t, any_dynamics{});
+    }
+
+    //! @brief Initialize the models with the @c Dispatcher of the run
+    //! functions (see @c simulation_of).
+    //!
+    //! Fails with @c unknown_dynamics if the dispatcher does not accept the
+    //! type of a model.
+    template<typename Dispatcher>
+    status initialize(time t, Dispatcher d) noexcept
     {
         clean();
+        irt_stats(stats.clear());
+
+        // Walk the models in memory order whatever the edition history.
+        models.sort();
+        observers.sort();
 
         irt::model* mdl = nullptr;
-        while (models.next(mdl))
-            irt_return_if_bad(make_initialize(*mdl, t));
+        while (models.next(mdl)) {
+            irt_return_if_fail(d.accepts(mdl->type), status::unknown_dynamics);
+            irt_return_if_bad(make_initialize(*mdl, t, d));
+        }
 
         irt::observer* obs = nullptr;
         while (observers.next(obs)) {
@@ -6515,7 +7434,10 @@ public:
         return status::success;
     }
 
-    status run(time& t) noexcept
+    status run(time& t) noexcept { return run(t, any_dynamics{}); }
+
+    template<typename Dispatcher>
+    status run(time& t, Dispatcher d) noexcept
     {
         if (sched.empty()) {
             t = time_domain<time>::infinity;
@@ -6525,13 +7447,72 @@ public:
         if (t = sched.tn(); time_domain<time>::is_infinity(t))
             return status::success;
 
+        return run_bag(t, d);
+    }
+
+    //! @brief Run the bags of date lower than @c end while @c events is
+    //! positive.
+    //!
+    //! Each bag decrements @c events by its number of transitions. On
+    //! return, @c t is the date of the last bag or the date of the next
+    //! bag (infinity if none) if it is not lower than @c end: continue
+    //! while @c t is lower than @c end.
+    status run_until(time& t, const time end, i64& events) noexcept
+    {
+        return run_until(t, end, events, any_dynamics{});
+    }
+
+    template<typename Dispatcher>
+    status run_until(time&      t,
+                     const time end,
+                     i64&       events,
+                     Dispatcher d) noexcept
+    {
+        while (events > 0) {
+            t = sched.empty() ? time_domain<time>::infinity : sched.tn();
+            if (!(t < end))
+                break;
+
+            irt_return_if_bad(run_bag(t, d));
+            events -= immediate_models.ssize();
+        }
+
+        return status::success;
+    }
+
+    //! Run the bag of date @c t, the date of the top of the scheduller.
+    status run_bag(const time t) noexcept
+    {
+        return run_bag(t, any_dynamics{});
+    }
+
+    template<typename Dispatcher>
+    status run_bag(const time t, Dispatcher d) noexcept
+    {
+        if (trace_fn)
+            trace_fn(trace_user_data, run_phase::start, t, 0);
+
         immediate_models.clear();
         sched.pop(immediate_models);
+        irt_stats(stats.add_bag(immediate_models.ssize()));
+
+        if (trace_fn)
+            trace_fn(
+              trace_user_data, run_phase::popped, t, immediate_models.ssize());
 
         emitting_output_ports.clear();
-        for (const auto id : immediate_models)
-            if (auto* mdl = models.try_to_get(id); mdl)
-                irt_return_if_bad(make_transition(*mdl, t));
+        for (const auto id : immediate_models) {
+            if (auto* mdl = models.try_to_get(id); mdl) {
+                irt_stats(++stats[mdl->type].pops);
+                irt_return_if_bad(make_transition(*mdl, t, d));
+            }
+        }
+
+        if (trace_fn)
+            trace_fn(trace_user_data,
+                     run_phase::transitions,
+                     t,
+                     immediate_models.ssize());
 
         for (int i = 0, e = length(emitting_output_ports); i != e; ++i) {
             auto* mdl = models.try_to_get(emitting_output_ports[i].model);
@@ -6539,22 +7520,38 @@ public:
                 continue;
 
             sched.update(*mdl, t);
-
-            irt_return_if_fail(can_alloc_message(*this, 1),
-                               status::simulation_not_enough_message);
+            irt_stats(++stats[mdl->type].updates);
+            irt_stats(++stats[mdl->type].messages_received);
 
             auto  port = emitting_output_ports[i].port;
             auto& msg  = emitting_output_ports[i].msg;
 
-            dispatch(
-              *mdl, [this, port, &msg]<typename Dynamics>(Dynamics& dyn) {
-                  if constexpr (is_detected_v<has_input_port_t, Dynamics>) {
-                      auto list = append_message(*this, dyn.x[port]);
-                      list.push_back(msg);
-                  }
-              });
+            irt_return_if_bad(
+              d(*mdl, [this, port, &msg]<typename Dynamics>(Dynamics& dyn) {
+                  if constexpr (is_detected_v<has_input_port_t, Dynamics>)
+                      return push_message(*this, dyn, port, msg);
+                  else
+                      return status::success;
+              }));
         }
 
+        if (!structural_changes.empty())
+            irt_return_if_bad(apply_structural_changes(t));
+
+        if (trace_fn)
+            trace_fn(trace_user_data,
+                     run_phase::deliveries,
+                     t,
+                     immediate_models.ssize());
+
+#ifdef IRRITATOR_ENABLE_STATS
+        stats.message_peak = std::max(stats.message_peak, message_alloc.used());
+        stats.node_peak    = std::max(stats.node_peak, node_alloc.used());
+        stats.record_peak  = std::max(stats.record_peak, record_alloc.used());
+        stats.dated_message_peak =
+          std::max(stats.dated_message_peak, dated_message_alloc.used());
+#endif
+
         return status::success;
     }
 
@@ -6574,13 +7571,20 @@ public:
         mdl.handle = nullptr;
 
         sched.insert(mdl, models.get_id(mdl), mdl.tn);
+        irt_stats(++stats[mdl.type].inserts);
 
         return status::success;
     }
 
     status make_initialize(model& mdl, time t) noexcept
     {
-        return dispatch(mdl, [this, &mdl, t]<typename Dynamics>(Dynamics& dyn) {
+        return make_initialize(mdl, t, any_dynamics{});
+    }
+
+    template<typename Dispatcher>
+    status make_initialize(model& mdl, time t, Dispatcher d) noexcept
+    {
+        return d(mdl, [this, &mdl, t]<typename Dynamics>(Dynamics& dyn) {
             return this->make_initialize(mdl, dyn, t);
         });
     }
@@ -6600,9 +7604,15 @@ public:
         }
 
         if (mdl.tn == mdl.handle->tn) {
-            if constexpr (is_detected_v<lambda_function_t, Dynamics>)
-                if constexpr (is_detected_v<has_output_port_t, Dynamics>)
+            if constexpr (is_detected_v<lambda_function_t, Dynamics>) {
+                if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+                    irt_stats(const auto sent = emitting_output_ports.ssize());
                     irt_return_if_bad(dyn.lambda(*this));
+                    irt_stats(++stats[mdl.type].lambdas);
+                    irt_stats(stats[mdl.type].messages_sent +=
+                              emitting_output_ports.ssize() - sent);
+                }
+            }
         }
 
         if constexpr (is_detected_v<transition_function_t, Dynamics>)
@@ -6621,13 +7631,33 @@ public:
             mdl.tn = std::nextafter(t, t + irt::one);
 
         sched.reintegrate(mdl, mdl.tn);
+        irt_stats(++stats[mdl.type].transitions);
+        irt_stats(++stats[mdl.type].updates);
 
         return status::success;
     }
 
     status make_transition(model& mdl, time t) noexcept
     {
-        return dispatch(mdl, [this, &mdl, t]<typename Dynamics>(Dynamics& dyn) {
+        return make_transition(mdl, t, any_dynamics{});
+    }
+
+    template<typename Dispatcher>
+    status make_transition(model& mdl, time t, Dispatcher d) noexcept
+    {
+#ifdef IRRITATOR_ENABLE_STATS
+        if (stats.measure_cycles) {
+            const u64  begin = irt_stats_cycles();
+            const auto ret =
+              d(mdl, [this, &mdl, t]<typename Dynamics>(Dynamics& dyn) {
+                  return this->make_transition(mdl, dyn, t);
+              });
+            stats[mdl.type].cycles += irt_stats_cycles() - begin;
+            return ret;
+        }
+#endif
+
+        return d(mdl, [this, &mdl, t]<typename Dynamics>(Dynamics& dyn) {
             return this->make_transition(mdl, dyn, t);
         });
     }
@@ -6662,7 +7692,10 @@ public:
      *
      * This function must be call at the end of the simulation.
      */
-    status finalize(time t) noexcept
+    status finalize(time t) noexcept { return finalize(t, any_dynamics{}); }
+
+    template<typename Dispatcher>
+    status finalize(time t, Dispatcher d) noexcept
     {
         model* mdl = nullptr;
         while (models.next(mdl)) {
@@ -6670,8 +7703,8 @@ public:
             if (is_defined(mdl->obs_id))
                 obs = observers.try_to_get(mdl->obs_id);
 
-            auto ret = dispatch(
-              *mdl, [this, mdl, obs, t]<typename Dynamics>(Dynamics& dyn) {
+            auto ret =
+              d(*mdl, [this, mdl, obs, t]<typename Dynamics>(Dynamics& dyn) {
                   return this->make_finalize(*mdl, dyn, obs, t);
               });
 
@@ -6680,6 +7713,323 @@ public:
 
         return status::success;
     }
+
+    //! @brief Write the state of the simulation between two @c run into
+    //! @c f (an @c irt::file or an @c irt::memory).
+    //!
+    //! Writes the date @c t of the last @c run, the messages, records and
+    //! dated messages allocators, the scheduller and the dynamics of the
+    //! models. The parameters, the connections and the observers are not
+    //! rebuilt by @c restore: it needs a simulation built from the same
+    //! models, for example read from the same file. The external sources
+    //! are written by @c external_source::checkpoint.
+    template<typename File>
+    status checkpoint(File& f, time t) const noexcept
+    {
+        const u32 layout[2] = { sizeof(model), sizeof(real) };
+
+        irt_return_if_fail(write_raw(f, checkpoint_magic) &&
+                             write_raw(f, layout) && write_raw(f, t) &&
+                             message_alloc.checkpoint(f) &&
+                             node_alloc.checkpoint(f) &&
+                             record_alloc.checkpoint(f) &&
+                             dated_message_alloc.checkpoint(f) &&
+                             sched.checkpoint(f) &&
+                             write_raw(f, static_cast<u64>(models.size())),
+                           status::io_file_format_error);
+
+        model* mdl = nullptr;
+        while (models.next(mdl)) {
+            irt_return_if_fail(write_raw(f, ordinal(models.get_id(*mdl))) &&
+                                 write_raw(f, mdl->type) &&
+                                 write_raw(f, mdl->tl) &&
+                                 write_raw(f, mdl->tn) &&
+                                 write_raw(f, sched.index(*mdl)),
+                               status::io_file_format_error);
+
+            irt_return_if_bad(
+              dispatch(*mdl, [this, &f]<typename Dynamics>(Dynamics& dyn) {
+                  return this->checkpoint_dynamics(f, dyn);
+              }));
+        }
+
+        return status::success;
+    }
+
+    //! @brief Read the state written by @c checkpoint and the date @c t of
+    //! the last @c run. Use it instead of @c initialize then continue with
+    //! @c run.
+    //!
+    //! Restore the external sources with @c external_source::restore
+    //! first. The capacities must be large enough for the checkpoint.
+    template<typename File>
+    status restore(File& f, time& t) noexcept
+    {
+        char magic[sizeof(checkpoint_magic)];
+        u32  layout[2];
+
+        irt_return_if_fail(read_raw(f, magic) && read_raw(f, layout) &&
+                             std::equal(std::begin(magic),
+                                        std::end(magic),
+                                        std::begin(checkpoint_magic)) &&
+                             layout[0] == sizeof(model) &&
+                             layout[1] == sizeof(real) && read_raw(f, t),
+                           status::io_file_format_error);
+
+        irt_return_if_fail(message_alloc.restore(f) && node_alloc.restore(f) &&
+                             record_alloc.restore(f) &&
+                             dated_message_alloc.restore(f),
+                           status::block_allocator_not_enough_memory);
+
+        irt_return_if_fail(sched.restore(f),
+                           status::head_allocator_not_enough_memory);
+
+        u64 number;
+        irt_return_if_fail(read_raw(f, number) && number == models.size(),
+                           status::io_file_format_model_number_error);
+
+        for (u64 i = 0; i != number; ++i) {
+            u64           id;
+            dynamics_type type;
+            real          tl, tn;
+            u32           handle;
+
+            irt_return_if_fail(read_raw(f, id) && read_raw(f, type) &&
+                                 read_raw(f, tl) && read_raw(f, tn) &&
+                                 read_raw(f, handle),
+                               status::io_file_format_error);
+
+            auto* mdl = models.try_to_get(enum_cast<model_id>(id));
+            irt_return_if_fail(mdl && mdl->type == type,
+                               status::io_file_format_model_unknown);
+
+            irt_return_if_bad(
+              dispatch(*mdl, [this, &f]<typename Dynamics>(Dynamics& dyn) {
+                  return this->restore_dynamics(f, dyn);
+              }));
+
+            mdl->tl     = tl;
+            mdl->tn     = tn;
+            mdl->handle = sched.get(handle);
+        }
+
+        emitting_output_ports.clear();
+        immediate_models.clear();
+
+        return status::success;
+    }
+
+private:
+    //! Queue a structural change applied at the end of the current bag.
+    status request(structural_change_type type,
+                   model_id               src,
+                   model_id               dst,
+                   int                    port_src,
+                   int                    port_dst) noexcept
+    {
+        irt_return_if_fail(!structural_changes.full(),
+                           status::simulation_not_enough_structural_change);
+
+        structural_changes.emplace_back(src,
+                                        dst,
+                                        type,
+                                        static_cast<i8>(port_src),
+                                        static_cast<i8>(port_dst));
+
+        return status::success;
+    }
+
+    //! Apply the queued structural changes in order: the changes which
+    //! reference a deleted model are ignored.
+    status apply_structural_changes(time t) noexcept
+    {
+        auto cloned  = undefined<model_id>();
+        auto resolve = [&cloned](model_id id) noexcept {
+            return id == cloned_model ? cloned : id;
+        };
+
+        status ret = status::success;
+        for (const auto& change : structural_changes) {
+            auto* src = models.try_to_get(resolve(change.src));
+            auto* dst = models.try_to_get(resolve(change.dst));
+            if (!src || !dst)
+                continue;
+
+            switch (change.type) {
+            case structural_change_type::clone:
+                if (!models.can_alloc(1)) {
+                    ret = status::simulation_not_enough_model;
+                } else {
+                    auto& mdl = clone(*src);
+                    cloned    = models.get_id(mdl);
+                    ret       = make_initialize(mdl, t);
+                }
+                break;
+
+            case structural_change_type::deallocate:
+                ret = dispatch(*src, [this, src, t]<typename Dynamics>(
+                                       Dynamics& dyn) {
+                    return this->make_finalize(
+                      *src, dyn, observers.try_to_get(src->obs_id), t);
+                });
+
+                if (is_success(ret))
+                    ret = deallocate(models.get_id(*src));
+                break;
+
+            case structural_change_type::connect:
+                ret = connect(*src, change.port_src, *dst, change.port_dst);
+                break;
+
+            case structural_change_type::disconnect:
+                ret = disconnect(*src, change.port_src, *dst, change.port_dst);
+                break;
+            }
+
+            if (is_bad(ret))
+                break;
+        }
+
+        structural_changes.clear();
+
+        return ret;
+    }
+
+    static constexpr char checkpoint_magic[8] = { 'i', 'r', 't', 's',
+                                                  'i', 'm', '0', '2' };
+
+    //! Offset of the buffer of @c src in the buffers of its external source
+    //! or -1 if the source is not initialized.
+    status source_offset(const source& src, i64& offset) const noexcept
+    {
+        offset = -1;
+        if (!src.buffer)
+            return status::success;
+
+        source base = src;
+        irt_return_if_bad(source_dispatch(base, source::operation_type::locate));
+        irt_return_if_fail(base.buffer, status::source_unknown);
+
+        offset = src.buffer - base.buffer;
+
+        return status::success;
+    }
+
+    template<typename File, typename Dynamics>
+    status checkpoint_dynamics(File& f, const Dynamics& dyn) const noexcept
+    {
+        irt_return_if_fail(write_raw(f, dyn), status::io_file_format_error);
+
+        status ret = status::success;
+        for_each_source(dyn, [this, &f, &ret](const source& src) noexcept {
+            i64 offset = -1;
+            if (is_success(ret) && is_success(ret = source_offset(src, offset)))
+                if (!write_raw(f, offset))
+                    ret = status::io_file_format_error;
+        });
+
+        return ret;
+    }
+
+    template<typename File, typename Dynamics>
+    status restore_dynamics(File& f, Dynamics& dyn) noexcept
+    {
+        alignas(Dynamics) std::byte bytes[sizeof(Dynamics)];
+        irt_return_if_fail(read_raw(f, bytes, sizeof(Dynamics)),
+                           status::io_file_format_error);
+
+        auto* saved = reinterpret_cast<Dynamics*>(bytes);
+
+        // The pointers are parameters of the models: keep the current ones.
+        if constexpr (std::is_same_v<Dynamics, time_func>) {
+            saved->f         = saved->f ? dyn.default_f : nullptr;
+            saved->default_f = dyn.default_f;
+        } else if constexpr (std::is_same_v<Dynamics, flow>) {
+            saved->default_data   = dyn.default_data;
+            saved->default_sigmas = dyn.default_sigmas;
+        }
+
+        status ret = status::success;
+        for_each_source(*saved, [this, &f, &ret](source& src) noexcept {
+            i64 offset = -1;
+            if (is_bad(ret))
+                return;
+
+            if (!read_raw(f, offset)) {
+                ret = status::io_file_format_error;
+                return;
+            }
+
+            src.buffer = nullptr;
+            if (offset >= 0) {
+                source base = src;
+                ret = source_dispatch(base, source::operation_type::locate);
+                if (is_success(ret) && !base.buffer)
+                    ret = status::source_unknown;
+                else if (is_success(ret))
+                    src.buffer = base.buffer + offset;
+            }
+        });
+
+        irt_return_if_bad(ret);
+        std::memcpy(static_cast<void*>(&dyn), bytes, sizeof(Dynamics));
+
+        return status::success;
+    }
+};
+
+//! @brief A @c simulation of the models of the @c Dynamics types only.
+//!
+//! The run functions dispatch the models among the @c Dynamics: a switch
+//! of a few cases inlined in the kernel loop instead of the switch over all
+//! the dynamics. The models, the connections and the other functions are
+//! those of @c simulation: the @c reader, the @c writer and the other
+//! engines accept a @c simulation_of. @c initialize fails with
+//! @c unknown_dynamics if a model is not one of the @c Dynamics.
+//!
+//!     simulation_of<constant, qss1_wsum_2, qss1_integrator> sim;
+template<typename... Dynamics>
+struct simulation_of : public simulation
+{
+    using dispatcher = dynamics_among<Dynamics...>;
+
+    template<typename Type>
+    Type& alloc() noexcept
+    {
+        static_assert(is_dynamics_among<Dynamics...>(dynamics_typeof<Type>()),
+                      "the type is not one of the simulation dynamics");
+
+        return simulation::alloc<Type>();
+    }
+
+    model& alloc(dynamics_type type) noexcept
+    {
+        irt_assert(dispatcher::accepts(type));
+
+        return simulation::alloc(type);
+    }
+
+    status initialize(time t) noexcept
+    {
+        return simulation::initialize(t, dispatcher{});
+    }
+
+    status run(time& t) noexcept { return simulation::run(t, dispatcher{}); }
+
+    status run_until(time& t, const time end, i64& events) noexcept
+    {
+        return simulation::run_until(t, end, events, dispatcher{});
+    }
+
+    status run_bag(const time t) noexcept
+    {
+        return simulation::run_bag(t, dispatcher{});
+    }
+
+    status finalize(time t) noexcept
+    {
+        return simulation::finalize(t, dispatcher{});
+    }
 };
 
 inline status initialize_source(simulation& sim, source& src) noexcept
@@ -6715,14 +8065,45 @@ inline list_view<message> append_message(simulation& sim,
     return list_view<message>(sim.message_alloc, port);
 }
 
+//! Deliver @c msg to the input port @c port of @c dyn according to the
+//! @c port_policy of the dynamics.
+template<typename Dynamics>
+inline status push_message(simulation&    sim,
+                           Dynamics&      dyn,
+                           int            port,
+                           const message& msg) noexcept
+{
+    auto list = append_message(sim, dyn.x[port]);
+
+    if constexpr (is_detected_v<input_policy_t, Dynamics>) {
+        if (Dynamics::input_policy != port_policy::all && !list.empty()) {
+            if (Dynamics::input_policy == port_policy::last)
+                list.back() = msg;
+
+            irt_stats(++sim.stats[dynamics_typeof<Dynamics>()].messages_merged);
+            return status::success;
+        }
+    }
+
+    irt_return_if_fail(can_alloc_message(sim, 1),
+                       status::simulation_not_enough_message);
+
+    list.push_back(msg);
+    return status::success;
+}
+
 inline list_view_const<message> get_message(const simulation& sim,
                                             const input_port  port) noexcept
 {
     return list_view_const<message>(sim.message_alloc, port);
 }
 
+//! The connections of @c port to modify: a simulation sharing the
+//! connections of another one copies them first.
 inline list_view<node> append_node(simulation& sim, output_port& port) noexcept
 {
+    sim.node_alloc.unshare();
+
     return list_view<node>(sim.node_alloc, port);
 }
 
@@ -6766,20 +8147,31 @@ inline list_view_const<dated_message> get_dated_message(const simulation& sim,
     return list_view_const<dated_message>(sim.dated_message_alloc, id);
 }
 
+inline heap_view<dated_message> append_dated_message_heap(simulation& sim,
+                                                          u32& id) noexcept
+{
+    return heap_view<dated_message>(sim.dated_message_alloc, id);
+}
+
 inline status send_message(simulation&  sim,
                            output_port& p,
                            real         r1,
                            real         r2,
                            real         r3) noexcept
 {
-    auto list = append_node(sim, p);
+    // The connections to deleted models are removed, unless they are shared
+    // with another simulation.
+    auto list = list_view<node>(sim.node_alloc, p);
     auto it   = list.begin();
     auto end  = list.end();
 
     while (it != end) {
         auto* mdl = sim.models.try_to_get(it->model);
-        if (!mdl) {
-            it = list.erase(it);
+        if (!mdl && !is_remote(it->model)) {
+            if (sim.node_alloc.is_shared())
+                ++it;
+            else
+                it = list.erase(it);
         } else {
             irt_return_if_fail(sim.emitting_output_ports.can_alloc(1),
                                status::simulation_not_enough_message);
@@ -0,0 +1,596 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_2021_DISTRIBUTED_HPP
+#define ORG_VLEPROJECT_IRRITATOR_2021_DISTRIBUTED_HPP
+
+#include <irritator/core.hpp>
+#include <irritator/ext.hpp>
+#include <irritator/external_source.hpp>
+#include <irritator/io.hpp>
+#include <irritator/timewarp.hpp>
+
+#include <algorithm>
+#include <istream>
+#include <new>
+#include <vector>
+
+namespace irt {
+
+struct distributed_parameters;
+struct distributed_packet;
+struct distributed_transport;
+class unix_socket_transport;
+class distributed;
+
+struct distributed_parameters
+{
+    i32 rank             = 0;
+    i32 processes        = 1;
+    sz  message_capacity = 4096;
+};
+
+enum class distributed_packet_type : i8
+{
+    message,
+    null
+};
+
+//! @brief A message for a model of another process or a null message.
+//!
+//! A null message closes the messages of a round. It carries the earliest
+//! bag of the sender or of the messages it sent in the round (@c date), the
+//! earliest message of its boundary models at their scheduled date
+//! (@c output) and the smallest delay between an input and an output of
+//! these models (@c lookahead).
+struct distributed_packet
+{
+    message                 msg;
+    timewarp_time           date;
+    timewarp_time           output;
+    time                    lookahead = time_domain<time>::infinity;
+    model_id                model     = undefined<model_id>();
+    i8                      port      = 0;
+    distributed_packet_type type      = distributed_packet_type::message;
+};
+
+using distributed_send_fn    = status (*)(void*       user_data,
+                                       i32         to,
+                                       const void* data,
+                                       sz          size) noexcept;
+using distributed_flush_fn   = status (*)(void* user_data) noexcept;
+using distributed_receive_fn = status (*)(void* user_data,
+                                          i32   from,
+                                          void* data,
+                                          sz    size) noexcept;
+
+//! @brief The reliable and ordered channels between the processes.
+//!
+//! @c send queues bytes for a process, @c flush blocks until the queued
+//! bytes are sent and @c receive until the bytes of a process are read.
+//! Both must keep reading and writing all the channels: two processes may
+//! wait for each other.
+struct distributed_transport
+{
+    void*                  user_data = nullptr;
+    distributed_send_fn    send      = nullptr;
+    distributed_flush_fn   flush     = nullptr;
+    distributed_receive_fn receive   = nullptr;
+};
+
+//! @brief A @c distributed_transport over the Unix domain sockets of one
+//! machine.
+//!
+//! The process @c rank listens on the socket file `prefix.rank`, connects
+//! to the processes of lower rank and accepts the processes of higher rank.
+//! Not available on Windows.
+class unix_socket_transport
+{
+public:
+    static constexpr i32 max_processes = 256;
+
+    unix_socket_transport() noexcept = default;
+    ~unix_socket_transport() noexcept;
+
+    unix_socket_transport(const unix_socket_transport&) = delete;
+    unix_socket_transport& operator=(const unix_socket_transport&) = delete;
+
+    //! Connect the @c processes processes, waiting at most @c timeout
+    //! milliseconds for the others.
+    status open(i32         rank,
+                i32         processes,
+                const char* prefix,
+                int         timeout = 10000) noexcept;
+
+    void close() noexcept;
+
+    distributed_transport get() noexcept;
+
+    status send(i32 to, const void* data, sz size) noexcept;
+    status flush() noexcept;
+    status receive(i32 from, void* data, sz size) noexcept;
+
+private:
+    struct peer
+    {
+        int             fd = -1;
+        std::vector<u8> out;
+        std::vector<u8> in;
+        sz              out_pos = 0;
+        sz              in_pos  = 0;
+        bool            closed  = false; //!< the other process closed.
+    };
+
+    std::vector<peer> peers;
+    i32               rank = 0;
+
+    status pump() noexcept;
+};
+
+//! @brief The smallest delay between an input of the model and its next
+//! output, the outputs already scheduled excepted.
+//!
+//! Infinity for the models without input port, the delay of a @c queue and
+//! zero for the other models.
+inline time lookahead(const model& mdl) noexcept
+{
+    return dispatch(
+      mdl, []<typename Dynamics>(const Dynamics& dyn) noexcept -> time {
+          if constexpr (!is_detected_v<has_input_port_t, Dynamics>)
+              return time_domain<time>::infinity;
+          else if constexpr (std::is_same_v<Dynamics, queue>)
+              return dyn.default_ta;
+          else
+              return time_domain<time>::zero;
+      });
+}
+
+//! @brief Conservative simulation of a partition of the models in each
+//! process of a distributed run.
+//!
+//! Every process loads the whole simulation (the model identifiers are the
+//! same in all processes) and keeps the models of its part, the connections
+//! to the other parts become remote nodes (see @c make_remote_id). The
+//! processes run in rounds: each process runs its bags before its horizon,
+//! sends the messages of its boundary models then a null message to every
+//! process. From the null messages, each process computes the earliest bag
+//! of all processes (@c gvt) and its next horizon: the earliest message the
+//! other processes may send, from the scheduled dates of their boundary
+//! models and from the @c lookahead of these models after the @c gvt.
+//!
+//! The results are those of the timewarp engine: the messages sent by a bag
+//! are received by the next bag of the same date. Observers are not
+//! supported.
+//!
+//!     unix_socket_transport sockets;
+//!     sockets.open(rank, 4, "/tmp/irritator");
+//!     distributed d;
+//!     d.init({ .rank = rank, .processes = 4 }, sockets.get());
+//!     d.load(ifs, whole, srcs);
+//!     d.run(0, 100);
+class distributed
+{
+public:
+    simulation                sim;    //!< the models of this process.
+    table<model_id, model_id> models; //!< template model to process model.
+    table<model_id, i32>      partition;
+    vector<timewarp_link>     links;
+    vector<model_id>          boundaries; //!< models with remote nodes.
+    vector<i32>               senders;    //!< processes sending messages.
+    vector<timewarp_message>  pending;    //!< by decreasing date.
+    vector<distributed_packet> nulls;     //!< last null message by process.
+
+    distributed_parameters parameters;
+    distributed_transport  transport;
+
+    timewarp_time lvt;     //!< the last bag.
+    timewarp_time gvt;     //!< the earliest bag of all processes.
+    timewarp_time horizon; //!< the earliest message of the other processes.
+    time          boundary_lookahead = time_domain<time>::infinity;
+
+    i64 bags     = 0;
+    i64 rounds   = 0;
+    i64 messages = 0; //!< messages sent to the other processes.
+
+    status init(const distributed_parameters& params,
+                const distributed_transport&  channels) noexcept;
+
+    //! Place the template model @c id in the process @c process. The models
+    //! without place are split in contiguous blocks.
+    void assign(model_id id, i32 process) noexcept;
+
+    //! Copy the models of this process from the template simulation and
+    //! connect them.
+    status build(const simulation& whole) noexcept;
+
+    //! Read the simulation file with a @c reader into @c whole, initialized
+    //! by the caller, then @c build.
+    status load(std::istream&    is,
+                simulation&      whole,
+                external_source& srcs) noexcept;
+
+    //! Run the processes from @c begin until the @c gvt reaches @c end.
+    status run(time begin, time end) noexcept;
+
+    status finalize(time t) noexcept;
+
+    //! Get the process model copied from the template model @c id or
+    //! nullptr if another process owns it.
+    model* get(model_id id) noexcept;
+
+    //! The date of the next bag: the next model or pending message.
+    timewarp_time next_time() const noexcept;
+
+private:
+    timewarp_time sent; //!< the earliest message sent in the round.
+
+    status run_bag(timewarp_time date) noexcept;
+    status exchange() noexcept;
+
+    timewarp_time output_time() const noexcept;
+};
+
+/*****************************************************************************
+ *
+ * Implementation
+ *
+ ****************************************************************************/
+
+inline status distributed::init(const distributed_parameters& params,
+                                const distributed_transport&  channels) noexcept
+{
+    irt_return_if_fail(params.processes > 0 && 0 <= params.rank &&
+                         params.rank < params.processes,
+                       status::vector_init_capacity_error);
+
+    irt_return_if_fail(params.processes == 1 ||
+                         (channels.send && channels.flush && channels.receive),
+                       status::distributed_transport_error);
+
+    parameters = params;
+    transport  = channels;
+    partition.data.clear();
+
+    return status::success;
+}
+
+inline void distributed::assign(model_id id, i32 process) noexcept
+{
+    irt_assert(0 <= process && process < parameters.processes);
+
+    partition.set(id, process);
+}
+
+inline status distributed::build(const simulation& whole) noexcept
+{
+    table<model_id, i32> owners;
+    owners.data.reserve(std::max(static_cast<i32>(whole.models.size()), 1));
+    partition.sort();
+
+    const auto number = static_cast<i64>(whole.models.size());
+    i64        index  = 0;
+    i32        owned  = 0;
+
+    model* mdl = nullptr;
+    while (whole.models.next(mdl)) {
+        const auto  id      = whole.models.get_id(*mdl);
+        const auto* place   = partition.get(id);
+        const auto  process = place ? *place
+                                    : static_cast<i32>(
+                                       index * parameters.processes / number);
+
+        owners.data.emplace_back(id, process);
+        owned += process == parameters.rank;
+        ++index;
+    }
+
+    owners.sort();
+
+    sim.clear();
+    irt_return_if_bad(sim.init(static_cast<sz>(std::max(owned, 1)),
+                               parameters.message_capacity));
+
+    models.data.clear();
+    models.data.reserve(std::max(owned, 1));
+
+    for (const auto& elem : owners.data) {
+        if (elem.value == parameters.rank) {
+            auto& new_mdl = sim.clone(whole.models.get(elem.id));
+            models.data.emplace_back(elem.id, sim.models.get_id(new_mdl));
+        }
+    }
+
+    models.sort();
+    links.clear();
+    boundaries.clear();
+    senders.clear();
+    boundary_lookahead = time_domain<time>::infinity;
+
+    // The connections between two other processes are ignored, those from
+    // another process tell who sends messages to this process.
+    vector<u8> sending(parameters.processes, parameters.processes);
+    std::fill(sending.begin(), sending.end(), u8{ 0 });
+    i32 connections = 0;
+
+    for (const auto& elem : owners.data) {
+        const auto& src      = whole.models.get(elem.id);
+        auto*       new_src  = get(elem.id);
+        bool        boundary = false;
+
+        irt_return_if_bad(dispatch(
+          src, [&]<typename Dynamics>(const Dynamics& dyn) noexcept -> status {
+              if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+                  for (int i = 0, e = length(dyn.y); i != e; ++i) {
+                      for (const auto& cnt : get_node(whole, dyn.y[i])) {
+                          const auto* owner = owners.get(cnt.model);
+                          if (!owner)
+                              continue;
+
+                          if (elem.value != parameters.rank) {
+                              if (*owner == parameters.rank)
+                                  sending[elem.value] = 1;
+                              continue;
+                          }
+
+                          irt_return_if_fail(
+                            sim.can_connect(1),
+                            status::simulation_not_enough_connection);
+                          ++connections;
+
+                          if (*owner == parameters.rank) {
+                              auto& dst =
+                                sim.models.get(*models.get(cnt.model));
+                              irt_return_if_bad(sim.connect(
+                                *new_src, i, dst, cnt.port_index));
+                          } else {
+                              const auto link = links.ssize();
+                              links.emplace_back(
+                                timewarp_link{ cnt.model, *owner });
+                              irt_return_if_bad(
+                                global_connect(sim,
+                                               *new_src,
+                                               i,
+                                               make_remote_id(link),
+                                               cnt.port_index));
+                              boundary = true;
+                          }
+                      }
+                  }
+              }
+
+              return status::success;
+          }));
+
+        if (boundary) {
+            boundaries.emplace_back(sim.models.get_id(*new_src));
+            boundary_lookahead =
+              std::min(boundary_lookahead, lookahead(*new_src));
+        }
+    }
+
+    for (i32 i = 0; i != parameters.processes; ++i)
+        if (sending[i])
+            senders.emplace_back(i);
+
+    // A bag emits at most one message per connection.
+    sim.emitting_output_ports.reserve(std::max(connections, 1));
+
+    return status::success;
+}
+
+inline status distributed::load(std::istream&    is,
+                                simulation&      whole,
+                                external_source& srcs) noexcept
+{
+    reader r(is);
+    irt_return_if_bad(r(whole, srcs));
+
+    return build(whole);
+}
+
+inline model* distributed::get(model_id id) noexcept
+{
+    if (auto* new_id = models.get(id); new_id)
+        return sim.models.try_to_get(*new_id);
+
+    return nullptr;
+}
+
+inline timewarp_time distributed::next_time() const noexcept
+{
+    timewarp_time next{ time_domain<time>::infinity, 0 };
+
+    if (!sim.sched.empty()) {
+        next.t     = sim.sched.tn();
+        next.depth = next.t == lvt.t ? lvt.depth + 1 : 0;
+    }
+
+    if (!pending.empty() && pending.back().date < next)
+        next = pending.back().date;
+
+    return next;
+}
+
+//! The earliest message of the boundary models at their scheduled date: a
+//! model scheduled at the next bag emits for the following bag.
+inline timewarp_time distributed::output_time() const noexcept
+{
+    const auto     next = next_time();
+    timewarp_time output{ time_domain<time>::infinity, 0 };
+
+    for (const auto id : boundaries) {
+        const auto tn = sim.models.get(id).tn;
+        const auto date =
+          tn == next.t ? timewarp_time{ tn, next.depth + 1 }
+                       : timewarp_time{ tn, 1 };
+
+        if (date < output)
+            output = date;
+    }
+
+    return output;
+}
+
+inline status distributed::run_bag(timewarp_time date) noexcept
+{
+    while (!pending.empty() && pending.back().date == date) {
+        const auto& m = pending.back();
+
+        if (auto* mdl = sim.models.try_to_get(m.model); mdl) {
+            irt_return_if_bad(
+              dispatch(*mdl, [this, &m]<typename Dynamics>(Dynamics& dyn) {
+                  if constexpr (is_detected_v<has_input_port_t, Dynamics>)
+                      return push_message(sim, dyn, m.port, m.msg);
+                  else
+                      return status::success;
+              }));
+
+            sim.sched.update(*mdl, date.t);
+        }
+
+        pending.pop_back();
+    }
+
+    if (!sim.sched.empty() && sim.sched.tn() == date.t)
+        irt_return_if_bad(sim.run_bag(date.t));
+
+    lvt = date;
+    ++bags;
+
+    for (const auto& out : sim.emitting_output_ports) {
+        if (!is_remote(out.model))
+            continue;
+
+        const auto& link = links[static_cast<i32>(get_remote_index(out.model))];
+
+        distributed_packet p{};
+        p.msg   = out.msg;
+        p.date  = { date.t, date.depth + 1 };
+        p.model = link.model;
+        p.port  = out.port;
+        p.type  = distributed_packet_type::message;
+
+        irt_return_if_bad(
+          transport.send(transport.user_data, link.process, &p, sizeof(p)));
+
+        if (p.date < sent)
+            sent = p.date;
+        ++messages;
+    }
+
+    return status::success;
+}
+
+inline status distributed::exchange() noexcept
+{
+    const auto next = next_time();
+
+    distributed_packet own{};
+    own.date      = sent < next ? sent : next;
+    own.output    = output_time();
+    own.lookahead = boundary_lookahead;
+    own.type      = distributed_packet_type::null;
+
+    sent = { time_domain<time>::infinity, 0 };
+
+    for (i32 i = 0; i != parameters.processes; ++i)
+        if (i != parameters.rank)
+            irt_return_if_bad(
+              transport.send(transport.user_data, i, &own, sizeof(own)));
+
+    if (parameters.processes > 1)
+        irt_return_if_bad(transport.flush(transport.user_data));
+
+    nulls[parameters.rank] = own;
+
+    // The channels are ordered: the messages of a round precede its null
+    // message.
+    for (i32 i = 0; i != parameters.processes; ++i) {
+        if (i == parameters.rank)
+            continue;
+
+        for (;;) {
+            distributed_packet p;
+            irt_return_if_bad(
+              transport.receive(transport.user_data, i, &p, sizeof(p)));
+
+            if (p.type == distributed_packet_type::null) {
+                nulls[i] = p;
+                break;
+            }
+
+            const auto* id = models.get(p.model);
+            irt_return_if_fail(id, status::distributed_transport_error);
+
+            timewarp_message m;
+            m.msg   = p.msg;
+            m.date  = p.date;
+            m.model = *id;
+            m.port  = p.port;
+            insert_pending(pending, m, false);
+        }
+    }
+
+    // Nothing happens before the gvt: a boundary model emits at its
+    // scheduled date or after an input received from the gvt.
+    gvt = nulls[0].date;
+    for (const auto& null : nulls)
+        if (null.date < gvt)
+            gvt = null.date;
+
+    horizon = { time_domain<time>::infinity, 0 };
+    for (const auto i : senders) {
+        const auto& null  = nulls[i];
+        auto        input = timewarp_time{ gvt.t, gvt.depth + 2 };
+
+        if (time_domain<time>::is_infinity(null.lookahead))
+            input = { time_domain<time>::infinity, 0 };
+        else if (gvt.t + null.lookahead > gvt.t)
+            input = { gvt.t + null.lookahead, 1 };
+
+        if (null.output < horizon)
+            horizon = null.output;
+        if (input < horizon)
+            horizon = input;
+    }
+
+    ++rounds;
+
+    return status::success;
+}
+
+inline status distributed::run(time begin, time end) noexcept
+{
+    pending.clear();
+    nulls.resize(parameters.processes);
+    lvt      = timewarp_time{};
+    sent     = { time_domain<time>::infinity, 0 };
+    bags     = 0;
+    rounds   = 0;
+    messages = 0;
+
+    irt_return_if_bad(sim.initialize(begin));
+
+    for (;;) {
+        irt_return_if_bad(exchange());
+
+        if (!(gvt.t < end))
+            break;
+
+        for (auto date = next_time(); date < horizon && date.t < end;
+             date      = next_time())
+            irt_return_if_bad(run_bag(date));
+    }
+
+    return status::success;
+}
+
+inline status distributed::finalize(time t) noexcept
+{
+    return sim.finalize(t);
+}
+
+} // namespace irt
+
+#endif
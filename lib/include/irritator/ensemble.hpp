@@ -0,0 +1,633 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_2021_ENSEMBLE_HPP
+#define ORG_VLEPROJECT_IRRITATOR_2021_ENSEMBLE_HPP
+
+#include <irritator/core.hpp>
+#include <irritator/ext.hpp>
+#include <irritator/external_source.hpp>
+#include <irritator/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace irt {
+
+struct ensemble_parameters;
+struct ensemble_replicate;
+struct ensemble_statistics;
+class ensemble;
+
+enum class ensemble_replicate_id : u64;
+
+//! Mapping between the external sources of a template and of a copy.
+struct source_mapping
+{
+    table<u64, u64> constant;
+    table<u64, u64> binary_file;
+    table<u64, u64> text_file;
+    table<u64, u64> random;
+
+    void clear() noexcept;
+    void sort() noexcept;
+    void remap(source& src) const noexcept;
+
+    //! Each source keeps its identifier.
+    bool is_identity() const noexcept;
+};
+
+//! Copy all the external sources from @c src into @c dst after freeing the
+//! sources of @c dst. The random sources are reseeded from @c seed.
+status copy(const external_source& src,
+            external_source&       dst,
+            u64                    seed,
+            source_mapping&        mapping) noexcept;
+
+//! Copy all models and connections from @c src into the empty @c dst with
+//! @c simulation::copy, or @c simulation::clone if the capacities of @c dst
+//! are too small. @c mapping stores the @c dst model identifier of each
+//! @c src model and @c sources remaps the sources of the models. With
+//! @c copy_on_write, @c dst shares the connections of @c src.
+status copy(const simulation&          src,
+            simulation&                dst,
+            const source_mapping&      sources,
+            table<model_id, model_id>& mapping,
+            bool                       copy_on_write = false) noexcept;
+
+//! Derive the seed of the replicate @c index from the ensemble seed.
+constexpr u64 ensemble_seed(u64 seed, i32 index) noexcept;
+
+using ensemble_setup_function = status (*)(ensemble_replicate& replicate,
+                                           void* parameter) noexcept;
+
+struct ensemble_parameters
+{
+    i32 replicates       = 1;
+    i32 workers          = 1; //!< simulations in memory, the thread number.
+    sz  model_capacity   = 0; //!< 0 to use the template model capacity.
+    sz  message_capacity = 4096;
+    u64 seed             = std::mt19937_64::default_seed;
+
+    //! The replicates share the connections of the template until they
+    //! change one: the template must outlive the replicates.
+    bool copy_on_write = false;
+};
+
+//! @brief The simulation and the external sources of a worker, rebuilt
+//! from the template for each replicate @c index the worker runs.
+struct ensemble_replicate
+{
+    simulation                sim;
+    external_source           srcs;
+    source_mapping            sources;
+    table<model_id, model_id> models; //!< template model to replicate model.
+    u64                       seed  = 0;
+    i32                       index = 0;
+
+    //! Get the replicate model copied from the template model @c id.
+    model* get(model_id id) noexcept;
+};
+
+struct ensemble_statistics
+{
+    real mean   = zero;
+    real stddev = zero;
+    real min    = zero;
+    real max    = zero;
+    i32  count  = 0;
+};
+
+//! @brief Run many copies of the same simulation on a @c task_list.
+//!
+//! Each of the @c parameters.workers ranges of the @c parallel_for owns one
+//! @c ensemble_replicate: for each replicate of the range, it copies the
+//! template simulation and its external sources, calls the setup function,
+//! runs the simulation and keeps only the final values of the observed
+//! models. The memory grows with the number of workers, not with the number
+//! of replicates. The values are aggregated into the @c statistics vector.
+//!
+//!     ensemble ens;
+//!     ens.init({ .replicates = 1000, .workers = 4, .seed = 42 });
+//!     ens.observe(sim.get_id(integrator));
+//!     ens.run(tm.task_lists[0], sim, srcs, 0, 100, nullptr, nullptr);
+class ensemble
+{
+public:
+    data_array<ensemble_replicate, ensemble_replicate_id> workers;
+    vector<model_id>                                      observed;
+    vector<real>   values; //!< @c observed.ssize() values per replicate.
+    vector<status> results; //!< status of each replicate.
+    vector<ensemble_statistics> statistics;
+    ensemble_parameters         parameters;
+
+    status init(const ensemble_parameters& params) noexcept;
+
+    //! Observe the final value of the template model @c id.
+    void observe(model_id id) noexcept;
+
+    //! Observe all the template models with an observation function.
+    void observe_all(const simulation& sim) noexcept;
+
+    //! Build and run all replicates from @c begin to @c end then aggregate
+    //! the observed values. @c setup is called on each replicate before its
+    //! run, from the workers: it must be thread-safe. Returns the first
+    //! replicate error, @c results stores the status of each replicate.
+    status run(task_list&              list,
+               const simulation&       sim,
+               const external_source&  srcs,
+               time                    begin,
+               time                    end,
+               ensemble_setup_function setup,
+               void*                   parameter) noexcept;
+
+    //! The final value of the observed model @c i of the replicate @c index.
+    real value(i32 index, i32 i) const noexcept;
+
+    //! Compute the statistics of the observed values of the successful
+    //! replicates.
+    void aggregate() noexcept;
+
+private:
+    status build(ensemble_replicate&     rep,
+                 const simulation&       sim,
+                 const external_source&  srcs,
+                 ensemble_setup_function setup,
+                 void*                   parameter) noexcept;
+
+    status run(ensemble_replicate& rep, time begin, time end) noexcept;
+
+    status first_error() const noexcept;
+};
+
+/*****************************************************************************
+ *
+ * Implementation
+ *
+ ****************************************************************************/
+
+inline void source_mapping::clear() noexcept
+{
+    constant.data.clear();
+    binary_file.data.clear();
+    text_file.data.clear();
+    random.data.clear();
+}
+
+inline void source_mapping::sort() noexcept
+{
+    constant.sort();
+    binary_file.sort();
+    text_file.sort();
+    random.sort();
+}
+
+inline void source_mapping::remap(source& src) const noexcept
+{
+    external_source_type type;
+    if (!external_source_type_cast(src.type, &type))
+        return;
+
+    const u64* id = nullptr;
+    switch (type) {
+    case external_source_type::binary_file:
+        id = binary_file.get(src.id);
+        break;
+    case external_source_type::constant:
+        id = constant.get(src.id);
+        break;
+    case external_source_type::random:
+        id = random.get(src.id);
+        break;
+    case external_source_type::text_file:
+        id = text_file.get(src.id);
+        break;
+    }
+
+    if (id)
+        src.id = *id;
+}
+
+inline bool source_mapping::is_identity() const noexcept
+{
+    const auto same = [](const table<u64, u64>& t) noexcept {
+        return std::all_of(t.data.begin(), t.data.end(), [](const auto& e) {
+            return e.id == e.value;
+        });
+    };
+
+    return same(constant) && same(binary_file) && same(text_file) &&
+           same(random);
+}
+
+constexpr u64 ensemble_seed(u64 seed, i32 index) noexcept
+{
+    // splitmix64 to spread consecutive indices over the seed space.
+    u64 z = seed + static_cast<u64>(index + 1) * 0x9e3779b97f4a7c15ull;
+    z     = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z     = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+    return z ^ (z >> 31);
+}
+
+inline status copy(const external_source& src,
+                   external_source&       dst,
+                   u64                    seed,
+                   source_mapping&        mapping) noexcept
+{
+    mapping.clear();
+    dst.block_size   = src.block_size;
+    dst.block_number = src.block_number;
+
+    const auto capacity = std::max({ src.constant_sources.capacity(),
+                                     src.binary_file_sources.capacity(),
+                                     src.text_file_sources.capacity(),
+                                     src.random_sources.capacity(),
+                                     1u });
+
+    // The sources of a worker are reused from one replicate to the next.
+    if (dst.constant_sources.capacity() < capacity)
+        irt_return_if_bad(dst.init(capacity));
+    else
+        dst.clear();
+
+    {
+        constant_source* elem = nullptr;
+        while (src.constant_sources.next(elem)) {
+            auto& copied = dst.constant_sources.alloc();
+            irt_return_if_bad(copied.init(dst.block_size));
+
+            try {
+                copied.buffer = elem->buffer;
+            } catch (const std::bad_alloc& /*e*/) {
+                return status::io_not_enough_memory;
+            }
+
+            copied.name = elem->name.sv();
+            mapping.constant.data.emplace_back(
+              ordinal(src.constant_sources.get_id(*elem)),
+              ordinal(dst.constant_sources.get_id(copied)));
+        }
+    }
+
+    {
+        binary_file_source* elem = nullptr;
+        while (src.binary_file_sources.next(elem)) {
+            auto& copied = dst.binary_file_sources.alloc();
+            irt_return_if_bad(copied.init(dst.block_size, dst.block_number));
+
+            copied.name      = elem->name.sv();
+            copied.file_path = elem->file_path;
+            mapping.binary_file.data.emplace_back(
+              ordinal(src.binary_file_sources.get_id(*elem)),
+              ordinal(dst.binary_file_sources.get_id(copied)));
+        }
+    }
+
+    {
+        text_file_source* elem = nullptr;
+        while (src.text_file_sources.next(elem)) {
+            auto& copied = dst.text_file_sources.alloc();
+            irt_return_if_bad(copied.init(dst.block_size, dst.block_number));
+
+            copied.name      = elem->name.sv();
+            copied.file_path = elem->file_path;
+            mapping.text_file.data.emplace_back(
+              ordinal(src.text_file_sources.get_id(*elem)),
+              ordinal(dst.text_file_sources.get_id(copied)));
+        }
+    }
+
+    {
+        random_source* elem = nullptr;
+        i32            i    = 0;
+        while (src.random_sources.next(elem)) {
+            auto& copied = dst.random_sources.alloc();
+            irt_return_if_bad(copied.init(dst.block_size, dst.block_number));
+
+            copied.name         = elem->name.sv();
+            copied.distribution = elem->distribution;
+            copied.a            = elem->a;
+            copied.b            = elem->b;
+            copied.p            = elem->p;
+            copied.mean         = elem->mean;
+            copied.lambda       = elem->lambda;
+            copied.alpha        = elem->alpha;
+            copied.beta         = elem->beta;
+            copied.stddev       = elem->stddev;
+            copied.m            = elem->m;
+            copied.s            = elem->s;
+            copied.n            = elem->n;
+            copied.a32          = elem->a32;
+            copied.b32          = elem->b32;
+            copied.t32          = elem->t32;
+            copied.k32          = elem->k32;
+            copied.seed         = ensemble_seed(seed, i++);
+
+            mapping.random.data.emplace_back(
+              ordinal(src.random_sources.get_id(*elem)),
+              ordinal(dst.random_sources.get_id(copied)));
+        }
+    }
+
+    mapping.sort();
+
+    return status::success;
+}
+
+inline status copy(const simulation&          src,
+                   simulation&                dst,
+                   const source_mapping&      sources,
+                   table<model_id, model_id>& mapping,
+                   bool                       copy_on_write) noexcept
+{
+    irt_return_if_fail(dst.models.can_alloc(src.models.size()),
+                       status::simulation_not_enough_model);
+
+    mapping.data.clear();
+    mapping.data.reserve(static_cast<i32>(src.models.size()));
+
+    model* mdl = nullptr;
+
+    if (dst.can_copy(src)) {
+        irt_return_if_bad(dst.copy(src, copy_on_write));
+
+        while (dst.models.next(mdl)) {
+            const auto id = dst.models.get_id(*mdl);
+            mapping.data.emplace_back(id, id);
+        }
+
+        mapping.sort();
+
+        // Only the models with sources need a dispatch.
+        if (sources.is_identity())
+            return status::success;
+
+        mdl = nullptr;
+        while (dst.models.next(mdl)) {
+            if (mdl->type == dynamics_type::generator ||
+                mdl->type == dynamics_type::dynamic_queue ||
+                mdl->type == dynamics_type::priority_queue)
+                dispatch(*mdl, [&sources]<typename Dynamics>(Dynamics& dyn) {
+                    for_each_source(dyn, [&sources](source& src) noexcept {
+                        sources.remap(src);
+                    });
+                });
+        }
+
+        return status::success;
+    }
+
+    while (src.models.next(mdl)) {
+        auto& new_mdl = dst.clone(*mdl);
+
+        dispatch(new_mdl, [&sources]<typename Dynamics>(Dynamics& dyn) {
+            if constexpr (std::is_same_v<Dynamics, generator>) {
+                sources.remap(dyn.default_source_ta);
+                sources.remap(dyn.default_source_value);
+            }
+
+            if constexpr (std::is_same_v<Dynamics, dynamic_queue> ||
+                          std::is_same_v<Dynamics, priority_queue>)
+                sources.remap(dyn.default_source_ta);
+        });
+
+        mapping.data.emplace_back(src.models.get_id(*mdl),
+                                  dst.models.get_id(new_mdl));
+    }
+
+    mapping.sort();
+
+    mdl = nullptr;
+    while (src.models.next(mdl)) {
+        auto* new_mdl = mapping.get(src.models.get_id(*mdl));
+        irt_assert(new_mdl);
+
+        auto& new_src = dst.models.get(*new_mdl);
+
+        irt_return_if_bad(dispatch(
+          *mdl,
+          [&]<typename Dynamics>(const Dynamics& dyn) noexcept -> status {
+              if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+                  for (int i = 0, e = length(dyn.y); i != e; ++i) {
+                      for (const auto& elem : get_node(src, dyn.y[i])) {
+                          auto* dst_id = mapping.get(elem.model);
+                          if (!dst_id)
+                              continue;
+
+                          auto& new_dst = dst.models.get(*dst_id);
+                          irt_return_if_fail(
+                            dst.can_connect(1),
+                            status::simulation_not_enough_connection);
+                          irt_return_if_bad(dst.connect(
+                            new_src, i, new_dst, elem.port_index));
+                      }
+                  }
+              }
+
+              return status::success;
+          }));
+    }
+
+    return status::success;
+}
+
+inline model* ensemble_replicate::get(model_id id) noexcept
+{
+    if (auto* new_id = models.get(id); new_id)
+        return sim.models.try_to_get(*new_id);
+
+    return nullptr;
+}
+
+inline status ensemble::init(const ensemble_parameters& params) noexcept
+{
+    irt_return_if_fail(params.replicates > 0 && params.workers > 0,
+                       status::vector_init_capacity_error);
+
+    parameters         = params;
+    parameters.workers = std::min(params.workers, params.replicates);
+    irt_return_if_bad(workers.init(parameters.workers));
+
+    for (i32 i = 0; i != parameters.workers; ++i)
+        workers.alloc();
+
+    observed.clear();
+    values.clear();
+    results.clear();
+    statistics.clear();
+
+    return status::success;
+}
+
+inline real ensemble::value(i32 index, i32 i) const noexcept
+{
+    irt_assert(0 <= i && i < observed.ssize());
+
+    return values[index * observed.ssize() + i];
+}
+
+inline void ensemble::observe(model_id id) noexcept
+{
+    if (observed.find(id) == observed.ssize())
+        observed.emplace_back(id);
+}
+
+inline void ensemble::observe_all(const simulation& sim) noexcept
+{
+    observed.reserve(static_cast<i32>(sim.models.size()));
+
+    model* mdl = nullptr;
+    while (sim.models.next(mdl)) {
+        const auto has_observation =
+          dispatch(*mdl, []<typename Dynamics>(const Dynamics&) noexcept {
+              return is_detected_v<observation_function_t, Dynamics>;
+          });
+
+        if (has_observation)
+            observe(sim.models.get_id(*mdl));
+    }
+}
+
+inline status ensemble::build(ensemble_replicate&     rep,
+                              const simulation&       sim,
+                              const external_source&  srcs,
+                              ensemble_setup_function setup,
+                              void*                   parameter) noexcept
+{
+    const auto model_capacity = parameters.model_capacity
+                                  ? parameters.model_capacity
+                                  : static_cast<sz>(sim.models.capacity());
+
+    // The first replicate of the worker allocates the simulation, the next
+    // ones reuse it.
+    rep.sim.source_dispatch = rep.srcs;
+    if (rep.sim.models.capacity() == 0)
+        irt_return_if_bad(
+          rep.sim.init(model_capacity, parameters.message_capacity));
+    else
+        rep.sim.clear();
+
+    irt_return_if_bad(copy(srcs, rep.srcs, rep.seed, rep.sources));
+    irt_return_if_bad(copy(
+      sim, rep.sim, rep.sources, rep.models, parameters.copy_on_write));
+
+    if (setup)
+        irt_return_if_bad(setup(rep, parameter));
+
+    return status::success;
+}
+
+inline status ensemble::run(ensemble_replicate& rep,
+                            time                begin,
+                            time                end) noexcept
+{
+    auto t = begin;
+    irt_return_if_bad(rep.sim.initialize(t));
+
+    auto events = std::numeric_limits<i64>::max();
+    irt_return_if_bad(rep.sim.run_until(t, end, events));
+
+    const auto first = rep.index * observed.ssize();
+    for (i32 i = 0, e = observed.ssize(); i != e; ++i) {
+        values[first + i] = zero;
+
+        if (auto* mdl = rep.get(observed[i]); mdl) {
+            const auto elapsed = end - mdl->tl;
+
+            values[first + i] = dispatch(
+              *mdl, [elapsed]<typename Dynamics>(const Dynamics& dyn) noexcept {
+                  if constexpr (is_detected_v<observation_function_t,
+                                              Dynamics>)
+                      return dyn.observation(elapsed)[0];
+                  else
+                      return zero;
+              });
+        }
+    }
+
+    return rep.sim.finalize(end);
+}
+
+inline status ensemble::run(task_list&              list,
+                            const simulation&       sim,
+                            const external_source&  srcs,
+                            time                    begin,
+                            time                    end,
+                            ensemble_setup_function setup,
+                            void*                   parameter) noexcept
+{
+    values.resize(parameters.replicates * observed.ssize());
+    results.resize(parameters.replicates);
+
+    // One range per worker, the worker w runs the replicates w, w + workers,
+    // w + 2 * workers, etc.
+    const auto number = parameters.workers;
+    parallel_for(list, 0, number, 1, [&](i32 first, i32 last) {
+        for (i32 w = first; w < last; ++w) {
+            auto* rep = workers.try_to_get(static_cast<u32>(w));
+            irt_assert(rep);
+
+            for (i32 i = w; i < parameters.replicates; i += number) {
+                rep->index = i;
+                rep->seed  = ensemble_seed(parameters.seed, i);
+
+                results[i] = build(*rep, sim, srcs, setup, parameter);
+                if (is_success(results[i]))
+                    results[i] = run(*rep, begin, end);
+            }
+        }
+    });
+
+    aggregate();
+
+    return first_error();
+}
+
+inline void ensemble::aggregate() noexcept
+{
+    statistics.clear();
+    statistics.resize(observed.ssize());
+
+    for (i32 i = 0, e = observed.ssize(); i != e; ++i) {
+        auto& stat = statistics[i];
+        real  m2   = zero;
+
+        for (i32 r = 0, end = results.ssize(); r != end; ++r) {
+            if (is_bad(results[r]))
+                continue;
+
+            const auto value = values[r * observed.ssize() + i];
+            if (stat.count == 0) {
+                stat.min = value;
+                stat.max = value;
+            } else {
+                stat.min = std::min(stat.min, value);
+                stat.max = std::max(stat.max, value);
+            }
+
+            ++stat.count;
+            const auto delta = value - stat.mean;
+            stat.mean += delta / static_cast<real>(stat.count);
+            m2 += delta * (value - stat.mean);
+        }
+
+        stat.stddev =
+          stat.count > 1 ? std::sqrt(m2 / static_cast<real>(stat.count - 1))
+                         : zero;
+    }
+}
+
+inline status ensemble::first_error() const noexcept
+{
+    for (const auto st : results)
+        if (is_bad(st))
+            return st;
+
+    return status::success;
+}
+
+} // namespace irt
+
+#endif
@@ -12,6 +12,8 @@
 #include <iomanip>
 #include <map>
 #include <random>
+#include <sstream>
+#include <string>
 #include <vector>
 
 namespace irt {
@@ -65,7 +67,8 @@ struct block_vector_base
             if (buffer)
                 g_free_fn(buffer);
 
-            buffer = static_cast<double*>(g_alloc_fn(capacity_ * block_size_));
+            buffer = static_cast<double*>(
+              g_alloc_fn(capacity_ * block_size_ * sizeof(double)));
             if (buffer == nullptr)
                 return status::block_allocator_not_enough_memory;
         }
@@ -93,8 +96,8 @@ struct block_vector_base
 
         if constexpr (P == block_vector_policy::reuse_free_list) {
             if (free_head != static_cast<sz>(-1)) {
-                new_block = free_head;
-                free_head = static_cast<sz>(buffer[free_head * block_size]);
+                new_block = free_head * block_size;
+                free_head = static_cast<sz>(buffer[new_block]);
             } else {
                 new_block = max_size * block_size;
                 ++max_size;
@@ -108,10 +111,39 @@ struct block_vector_base
         return &buffer[new_block];
     }
 
+    //! Write the allocation state and the values of the blocks.
+    template<typename File>
+    bool checkpoint(File& f) const noexcept
+    {
+        const u64 header[5] = { size, max_size, capacity, block_size, free_head };
+
+        return write_raw(f, header) &&
+               write_raw(f, buffer, capacity * block_size);
+    }
+
+    //! Read the blocks written by @c checkpoint. The block size must be the
+    //! same and the capacity large enough.
+    template<typename File>
+    bool restore(File& f) noexcept
+    {
+        u64 header[5];
+        if (!read_raw(f, header) || header[2] > capacity ||
+            header[3] != block_size ||
+            !read_raw(f, buffer, header[2] * header[3]))
+            return false;
+
+        size      = static_cast<sz>(header[0]);
+        max_size  = static_cast<sz>(header[1]);
+        capacity  = static_cast<sz>(header[2]);
+        free_head = static_cast<sz>(header[4]);
+
+        return true;
+    }
+
     void free([[maybe_unused]] double* block) noexcept
     {
         if constexpr (P == block_vector_policy::reuse_free_list) {
-            auto ptr_diff = buffer - block;
+            auto ptr_diff = block - buffer;
             auto block_index = ptr_diff / block_size;
 
             block[0] = static_cast<double>(free_head);
@@ -231,12 +263,93 @@ struct constant_source
             return update(src);
         case source::operation_type::finalize:
             return finalize(src);
+        case source::operation_type::locate:
+            src.buffer = buffer.data();
+            return status::success;
         }
 
         irt_unreachable();
     }
 };
 
+//! Write the position of the stream or -1 if the stream is closed.
+template<typename File>
+bool checkpoint_stream(File& f, std::ifstream& ifs) noexcept
+{
+    i64 position = -1;
+    if (ifs.is_open())
+        position = ifs.good() ? static_cast<i64>(ifs.tellg()) : -2;
+
+    return write_raw(f, position);
+}
+
+//! Reopen the stream at the position written by @c checkpoint_stream (-2
+//! for the end of the file).
+template<typename File>
+bool restore_stream(File& f,
+                    std::ifstream& ifs,
+                    const std::filesystem::path& file_path) noexcept
+{
+    i64 position;
+    if (!read_raw(f, position))
+        return false;
+
+    if (position == -1) {
+        if (ifs.is_open())
+            ifs.close();
+
+        return true;
+    }
+
+    if (!ifs.is_open())
+        ifs.open(file_path);
+
+    ifs.clear();
+    if (position >= 0)
+        ifs.seekg(position);
+    else
+        ifs.seekg(0, std::ios_base::end);
+
+    return ifs.is_open() && ifs.good();
+}
+
+//! Write the state of the random number generator.
+template<typename File>
+bool checkpoint_generator(File& f, const std::mt19937_64& gen) noexcept
+{
+    try {
+        std::ostringstream os;
+        os << gen;
+        const auto str = os.str();
+
+        return write_raw(f, static_cast<u64>(str.size())) &&
+               write_raw(f, str.data(), str.size());
+    } catch (...) {
+        return false;
+    }
+}
+
+template<typename File>
+bool restore_generator(File& f, std::mt19937_64& gen) noexcept
+{
+    try {
+        u64 size;
+        if (!read_raw(f, size))
+            return false;
+
+        std::string str(static_cast<sz>(size), '\0');
+        if (!read_raw(f, str.data(), str.size()))
+            return false;
+
+        std::istringstream is(str);
+        is >> gen;
+
+        return !is.fail();
+    } catch (...) {
+        return false;
+    }
+}
+
 struct binary_file_source
 {
     small_string<23> name;
@@ -304,19 +417,35 @@ struct binary_file_source
             return update(src);
         case source::operation_type::finalize:
             return finalize(src);
+        case source::operation_type::locate:
+            src.buffer = buffer.buffer;
+            return status::success;
         }
 
         irt_unreachable();
     }
 
+    template<typename File>
+    bool checkpoint(File& f) noexcept
+    {
+        return buffer.checkpoint(f) && checkpoint_stream(f, ifs);
+    }
+
+    template<typename File>
+    bool restore(File& f) noexcept
+    {
+        return buffer.restore(f) && restore_stream(f, ifs, file_path);
+    }
+
 private:
     status fill_buffer() noexcept
     {
         ifs.read(reinterpret_cast<char*>(buffer.buffer),
-                 buffer.capacity * buffer.block_size);
+                 buffer.capacity * buffer.block_size * sizeof(double));
         const auto read = ifs.gcount();
 
-        buffer.capacity = static_cast<sz>(read) / buffer.block_size;
+        buffer.capacity =
+          static_cast<sz>(read) / (buffer.block_size * sizeof(double));
         if (buffer.capacity == 0)
             return status::source_empty;
 
@@ -389,11 +518,26 @@ struct text_file_source
             return update(src);
         case source::operation_type::finalize:
             return finalize(src);
+        case source::operation_type::locate:
+            src.buffer = buffer.buffer;
+            return status::success;
         }
 
         irt_unreachable();
     }
 
+    template<typename File>
+    bool checkpoint(File& f) noexcept
+    {
+        return buffer.checkpoint(f) && checkpoint_stream(f, ifs);
+    }
+
+    template<typename File>
+    bool restore(File& f) noexcept
+    {
+        return buffer.restore(f) && restore_stream(f, ifs, file_path);
+    }
+
 private:
     status fill_buffer() noexcept
     {
@@ -420,6 +564,10 @@ struct random_source
     double a, b, p, mean, lambda, alpha, beta, stddev, m, s, n;
     int a32, b32, t32, k32;
 
+    //! Seed used to restart the generator at simulation initialization.
+    u64 seed = std::mt19937_64::default_seed;
+    std::mt19937_64 gen;
+
     template<typename RandomGenerator, typename Distribution>
     void generate(RandomGenerator& gen,
                   Distribution dist,
@@ -525,8 +673,8 @@ struct random_source
             src.index = 0;
         }
 
-        std::mt19937_64 gen;
         generate(gen, src.buffer, src.size);
+        src.index = 0;
 
         return status::success;
     }
@@ -545,15 +693,31 @@ struct random_source
     {
         switch (op) {
         case source::operation_type::initialize:
+            gen.seed(seed);
             return update(src);
         case source::operation_type::update:
             return update(src);
         case source::operation_type::finalize:
             return finalize(src);
+        case source::operation_type::locate:
+            src.buffer = buffer.buffer;
+            return status::success;
         }
 
         irt_unreachable();
     }
+
+    template<typename File>
+    bool checkpoint(File& f) noexcept
+    {
+        return buffer.checkpoint(f) && checkpoint_generator(f, gen);
+    }
+
+    template<typename File>
+    bool restore(File& f) noexcept
+    {
+        return buffer.restore(f) && restore_generator(f, gen);
+    }
 };
 
 enum class constant_source_id : u64;
@@ -585,6 +749,15 @@ struct external_source
         return status::success;
     }
 
+    //! Free all the sources and keep the capacities.
+    void clear() noexcept
+    {
+        constant_sources.clear();
+        binary_file_sources.clear();
+        text_file_sources.clear();
+        random_sources.clear();
+    }
+
     status operator()(source& src, const source::operation_type op) noexcept
     {
         external_source_type type;
@@ -623,6 +796,75 @@ struct external_source
 
         irt_unreachable();
     }
+
+    //! @brief Write the state of the sources: the positions in the files,
+    //! the states of the random generators and the values of the buffers.
+    //!
+    //! Use with @c simulation::checkpoint.
+    template<typename File>
+    status checkpoint(File& f) noexcept
+    {
+        irt_return_if_fail(checkpoint_generator(f, generator),
+                           status::io_file_format_error);
+
+        irt_return_if_bad(checkpoint_sources(f, binary_file_sources));
+        irt_return_if_bad(checkpoint_sources(f, text_file_sources));
+
+        return checkpoint_sources(f, random_sources);
+    }
+
+    //! @brief Read the state written by @c checkpoint into the same
+    //! sources, before @c simulation::restore.
+    template<typename File>
+    status restore(File& f) noexcept
+    {
+        irt_return_if_fail(restore_generator(f, generator),
+                           status::io_file_format_error);
+
+        irt_return_if_bad(restore_sources(f, binary_file_sources));
+        irt_return_if_bad(restore_sources(f, text_file_sources));
+
+        return restore_sources(f, random_sources);
+    }
+
+private:
+    template<typename File, typename T, typename Identifier>
+    static status checkpoint_sources(File& f,
+                                     data_array<T, Identifier>& sources) noexcept
+    {
+        irt_return_if_fail(write_raw(f, static_cast<u64>(sources.size())),
+                           status::io_file_format_error);
+
+        T* src = nullptr;
+        while (sources.next(src))
+            irt_return_if_fail(write_raw(f, ordinal(sources.get_id(*src))) &&
+                                 src->checkpoint(f),
+                               status::io_file_format_error);
+
+        return status::success;
+    }
+
+    template<typename File, typename T, typename Identifier>
+    static status restore_sources(File& f,
+                                  data_array<T, Identifier>& sources) noexcept
+    {
+        u64 number;
+        irt_return_if_fail(read_raw(f, number) && number == sources.size(),
+                           status::io_file_format_source_number_error);
+
+        for (u64 i = 0; i != number; ++i) {
+            u64 id;
+            irt_return_if_fail(read_raw(f, id),
+                               status::io_file_format_error);
+
+            auto* src = sources.try_to_get(enum_cast<Identifier>(id));
+            irt_return_if_fail(src, status::source_unknown);
+            irt_return_if_fail(src->restore(f),
+                               status::io_file_format_error);
+        }
+
+        return status::success;
+    }
 };
 
 enum class random_file_type
@@ -7,8 +7,112 @@
 
 #include <irritator/core.hpp>
 
+#include <bit>
+#include <span>
+
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
 namespace irt {
 
+namespace detail {
+
+//! Reverse the bytes of an integer or a floating point @c value.
+template<typename T>
+inline T byteswap(T value) noexcept
+{
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else {
+        using U = std::conditional_t<
+          sizeof(T) == 2,
+          u16,
+          std::conditional_t<sizeof(T) == 4, u32, u64>>;
+        static_assert(sizeof(U) == sizeof(T));
+
+        auto bits = std::bit_cast<U>(value);
+#if defined(__GNUC__) || defined(__clang__)
+        if constexpr (sizeof(T) == 2)
+            bits = __builtin_bswap16(bits);
+        else if constexpr (sizeof(T) == 4)
+            bits = __builtin_bswap32(bits);
+        else
+            bits = __builtin_bswap64(bits);
+#elif defined(_MSC_VER)
+        if constexpr (sizeof(T) == 2)
+            bits = _byteswap_ushort(bits);
+        else if constexpr (sizeof(T) == 4)
+            bits = _byteswap_ulong(bits);
+        else
+            bits = _byteswap_uint64(bits);
+#endif
+        return std::bit_cast<T>(bits);
+    }
+}
+
+//! Reverse the bytes of each element of the array. A simple loop the
+//! compiler vectorizes.
+template<typename T>
+inline void byteswap(T* values, sz number) noexcept
+{
+    for (sz i = 0; i != number; ++i)
+        values[i] = byteswap(values[i]);
+}
+
+//! Read an array of little endian integers or floating points.
+template<typename File, typename T, std::size_t N>
+bool read_array(File& f, std::span<T, N> values) noexcept
+{
+    static_assert(std::is_arithmetic_v<T> && !std::is_const_v<T>);
+
+    if (values.empty())
+        return true;
+
+    if (!f.read(static_cast<void*>(values.data()),
+                static_cast<i64>(values.size_bytes())))
+        return false;
+
+    if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1)
+        byteswap(values.data(), values.size());
+
+    return true;
+}
+
+//! Write an array of integers or floating points in little endian.
+template<typename File, typename T, std::size_t N>
+bool write_array(File& f, std::span<T, N> values) noexcept
+{
+    using value_type = std::remove_const_t<T>;
+    static_assert(std::is_arithmetic_v<value_type>);
+
+    if (values.empty())
+        return true;
+
+    if constexpr (std::endian::native == std::endian::big &&
+                  sizeof(value_type) > 1) {
+        constexpr sz chunk = 256;
+        value_type   temp[chunk];
+
+        for (sz i = 0; i < values.size(); i += chunk) {
+            const auto n = std::min(chunk, values.size() - i);
+            std::copy_n(values.data() + i, n, temp);
+            byteswap(temp, n);
+
+            if (!f.write(static_cast<const void*>(temp),
+                         static_cast<i64>(n * sizeof(value_type))))
+                return false;
+        }
+
+        return true;
+    } else {
+        return f.write(static_cast<const void*>(values.data()),
+                       static_cast<i64>(values.size_bytes()));
+    }
+}
+
+} // namespace detail
+
 enum class seek_origin
 {
     current,
@@ -20,12 +124,20 @@ enum class open_mode
 {
     read,
     write,
-    append
+    append,
+    map //!< Read-only memory mapped file, see @c file::view.
 };
 
+//! @brief A binary file in little endian.
+//!
+//! The @c read and @c write modes use an internal buffer of @c
+//! buffer_size bytes to combine the small reads and writes. The @c map
+//! mode maps the file into memory and provides zero-copy views.
 class file
 {
 public:
+    static constexpr i32 buffer_size = 64 * 1024;
+
     file(const char* filename, const open_mode mode) noexcept;
     ~file() noexcept;
 
@@ -38,10 +150,13 @@ public:
 
     i64  length() const noexcept;
     i64  tell() const noexcept;
-    void flush() const noexcept;
     i64  seek(i64 offset, seek_origin origin) noexcept;
     void rewind() noexcept;
 
+    //! Write the internal buffer into the file.
+    //! @return false if the write fails.
+    bool flush() noexcept;
+
     bool read(u8& value) noexcept;
     bool read(u16& value) noexcept;
     bool read(u32& value) noexcept;
@@ -60,6 +175,20 @@ public:
     bool write(const i32 value) noexcept;
     bool write(const i64 value) noexcept;
 
+    //! Read an array of integers or floating points with one copy.
+    template<typename T, std::size_t N>
+    bool read(std::span<T, N> values) noexcept
+    {
+        return detail::read_array(*this, values);
+    }
+
+    //! Write an array of integers or floating points with one copy.
+    template<typename T, std::size_t N>
+    bool write(std::span<T, N> values) noexcept
+    {
+        return detail::write_array(*this, values);
+    }
+
     //! Low level read function.
     //! @param buffer A pointer to buffer (must be not null)
     //! @param length The length of the buffer to read (must be greater than
@@ -75,11 +204,37 @@ public:
     //! @return false if failure, true otherwise.
     bool write(const void* buffer, i64 length) noexcept;
 
+    //! The @c length next bytes of a @c map file without copy. Moves the
+    //! position after the bytes.
+    //! @return An empty span if the file is not mapped or too short.
+    std::span<const u8> view(i64 length) noexcept;
+
+    //! All the bytes of a @c map file.
+    std::span<const u8> mapped() const noexcept;
+
 private:
+    //! Write the pending bytes of the write buffer or drop the read-ahead
+    //! bytes of the read buffer.
+    bool flush_cache() noexcept;
+    void close() noexcept;
+
     void*     file_handle = nullptr;
     open_mode mode        = open_mode::read;
+
+    vector<u8> cache;         // write-combining or read-ahead buffer
+    i32        cache_pos = 0; // next byte to read or write in the cache
+    i32        cache_end = 0; // number of bytes read into the cache
+
+    const u8* map_data = nullptr;
+    i64       map_size = 0;
+    i64       map_pos  = 0;
 };
 
+//! @brief A growable binary buffer with the interface of @c file.
+//!
+//! The first @c length bytes of the constructor are the content of the
+//! buffer. Writes after the end grow the buffer (the @c data capacity
+//! doubles), reads after the end fail.
 class memory
 {
 public:
@@ -91,14 +246,30 @@ public:
     memory(memory&& other) noexcept;
     memory& operator=(memory&& other) noexcept;
 
+    //! false if the allocation of the buffer fails.
     bool is_open() const noexcept;
 
     i64  length() const noexcept;
     i64  tell() const noexcept;
-    void flush() const noexcept;
+    bool flush() noexcept;
     i64  seek(i64 offset, seek_origin origin) noexcept;
     void rewind() noexcept;
 
+    //! Allocate at least @c capacity bytes. The content is kept.
+    bool reserve(i64 capacity) noexcept;
+
+    //! Release the memory after the content.
+    void shrink_to_fit() noexcept;
+
+    //! The content of the buffer without copy.
+    std::span<u8>       bytes() noexcept;
+    std::span<const u8> bytes() const noexcept;
+
+    //! The @c length next bytes without copy. Moves the position after the
+    //! bytes.
+    //! @return An empty span if the buffer is too short.
+    std::span<const u8> view(i64 length) noexcept;
+
     bool read(u8& value) noexcept;
     bool read(u16& value) noexcept;
     bool read(u32& value) noexcept;
@@ -117,6 +288,20 @@ public:
     bool write(const i32 value) noexcept;
     bool write(const i64 value) noexcept;
 
+    //! Read an array of integers or floating points with one copy.
+    template<typename T, std::size_t N>
+    bool read(std::span<T, N> values) noexcept
+    {
+        return detail::read_array(*this, values);
+    }
+
+    //! Write an array of integers or floating points with one copy.
+    template<typename T, std::size_t N>
+    bool write(std::span<T, N> values) noexcept
+    {
+        return detail::write_array(*this, values);
+    }
+
     //! Low level read function.
     //! @param buffer A pointer to buffer (must be not null)
     //! @param length The length of the buffer to read (must be greater than
@@ -132,8 +317,144 @@ public:
     //! @return false if failure, true otherwise.
     bool write(const void* buffer, i64 length) noexcept;
 
-    vector<u8> data;
-    i64        pos = 0;
+    vector<u8> data;     // the storage: @c data.size() equals the capacity
+    i64        pos  = 0; // next byte to read or write
+    i64        used = 0; // number of bytes of the content
+};
+
+enum class serialize_mode
+{
+    read,
+    write
+};
+
+/**
+ * @brief Read or write values over a @c file or a @c memory with the same
+ * description.
+ *
+ * Integers, floating points and enumerations are stored in little endian,
+ * the arithmetic arrays (@c std::span, C arrays and @c vector) with one
+ * copy. A @c vector is prefixed by its size. Other types provide a @c
+ * serialize function found by ADL and used in both modes:
+ *
+ * @code
+ * template<typename Serializer>
+ * bool serialize(Serializer& s, position& p) noexcept { return s(p.x, p.y); }
+ * @endcode
+ *
+ * The remaining trivially copyable types are stored with their native
+ * layout.
+ */
+template<typename File, serialize_mode Mode>
+class serializer
+{
+public:
+    static constexpr bool is_reading = Mode == serialize_mode::read;
+
+    explicit serializer(File& f) noexcept
+      : m_file(f)
+    {}
+
+    //! Process each argument in order.
+    //! @return false at the first failure.
+    template<typename... Args>
+    bool operator()(Args&... args) noexcept
+    {
+        return (process(args) && ...);
+    }
+
+    File& file() noexcept { return m_file; }
+
+private:
+    template<typename T>
+    struct is_vector : std::false_type
+    {};
+
+    template<typename T>
+    struct is_vector<vector<T>> : std::true_type
+    {};
+
+    template<typename T>
+    struct is_span : std::false_type
+    {};
+
+    template<typename T, std::size_t N>
+    struct is_span<std::span<T, N>> : std::true_type
+    {};
+
+    template<typename T, std::size_t N>
+    bool process_array(std::span<T, N> values) noexcept
+    {
+        using value_type = std::remove_const_t<T>;
+
+        if constexpr (std::is_arithmetic_v<value_type>) {
+            if constexpr (is_reading)
+                return detail::read_array(m_file, values);
+            else
+                return detail::write_array(m_file, values);
+        } else {
+            for (auto& value : values)
+                if (!process(value))
+                    return false;
+
+            return true;
+        }
+    }
+
+    template<typename T>
+    bool process(T& value) noexcept
+    {
+        using value_type = std::remove_const_t<T>;
+        static_assert(!is_reading || !std::is_const_v<T>,
+                      "serializer can not read into a constant");
+
+        if constexpr (std::is_arithmetic_v<value_type>) {
+            return process_array(std::span<T, 1>(&value, 1));
+        } else if constexpr (std::is_enum_v<value_type>) {
+            auto underlying = static_cast<std::underlying_type_t<T>>(value);
+            if (!process(underlying))
+                return false;
+
+            if constexpr (is_reading)
+                value = static_cast<T>(underlying);
+
+            return true;
+        } else if constexpr (std::is_array_v<value_type>) {
+            return process_array(std::span(value));
+        } else if constexpr (is_span<value_type>::value) {
+            return process_array(value);
+        } else if constexpr (is_vector<value_type>::value) {
+            i32 size = value.ssize();
+            if (!process(size) || size < 0)
+                return false;
+
+            if constexpr (is_reading) {
+                value.clear();
+                if (size == 0)
+                    return true;
+
+                value.resize(size);
+                if (value.ssize() != size || !value.data())
+                    return false;
+            }
+
+            return process_array(std::span(value.data(), value.size()));
+        } else if constexpr (requires { serialize(*this, value); }) {
+            return serialize(*this, value);
+        } else {
+            static_assert(std::is_trivially_copyable_v<value_type>,
+                          "provide a serialize function for this type");
+
+            if constexpr (is_reading)
+                return m_file.read(static_cast<void*>(&value),
+                                   static_cast<i64>(sizeof(T)));
+            else
+                return m_file.write(static_cast<const void*>(&value),
+                                    static_cast<i64>(sizeof(T)));
+        }
+    }
+
+    File& m_file;
 };
 
 } // irt
@@ -458,6 +458,49 @@ protected:
     }
 };
 
+//! @brief A component file decoded by @c reader without a @c modeling.
+//!
+//! The decoding only writes into this structure so the component files can
+//! be decoded in parallel. The children, ports and connections are
+//! allocated into the @c modeling later, in a single thread.
+struct component_file_data
+{
+    struct child_data
+    {
+        model       mdl;  // the dynamics if @c is_component is false
+        std::string hint; // "file" or "cpp" if @c is_component is true
+        std::string name; // the component file or type name
+        float       x            = 0.f;
+        float       y            = 0.f;
+        int         id           = 0;
+        bool        is_component = false;
+    };
+
+    struct port_data
+    {
+        int child;
+        i8  index;
+    };
+
+    struct connection_data
+    {
+        int src;
+        int dst;
+        i8  index_src;
+        i8  index_dst;
+    };
+
+    std::vector<child_data>      children;
+    std::vector<port_data>       x;
+    std::vector<port_data>       y;
+    std::vector<connection_data> connections;
+
+    // The external sources are allocated into an @c external_source: a file
+    // with sources is not decoded and must be read with the @c modeling
+    // reader.
+    bool has_sources = false;
+};
+
 class reader
 {
 private:
@@ -520,10 +563,27 @@ public:
     }
 
     status operator()(simulation& sim, external_source& srcs) noexcept
+    {
+        irt_return_if_bad(read_header(srcs));
+
+        return read_models(sim);
+    }
+
+    //! @brief Read the sources and the number of models of a simulation
+    //! file.
+    //!
+    //! Use @c model_count to allocate the simulation before reading the
+    //! models and the connections with @c read_models.
+    status read_header(external_source& srcs) noexcept
     {
         irt_return_if_bad(do_read_data_source(srcs));
 
-        irt_return_if_bad(do_read_model_number());
+        return do_read_model_number();
+    }
+
+    //! @brief Read the models and the connections after @c read_header.
+    status read_models(simulation& sim) noexcept
+    {
         for (int i = 0; i != model_number; ++i, ++model_error) {
             int id;
             irt_return_if_bad(do_read_model(sim, &id));
@@ -534,6 +594,18 @@ public:
         return status::success;
     }
 
+    //! Number of models read by @c read_header.
+    int model_count() const noexcept { return model_number; }
+
+    //! The simulation model of the model @c id of the file or an undefined
+    //! identifier.
+    model_id get_model(int id) const noexcept
+    {
+        const auto* ptr = map.get(id);
+
+        return ptr ? *ptr : undefined<model_id>();
+    }
+
     status operator()(simulation&                        sim,
                       external_source&                   srcs,
                       function_ref<void(const model_id)> f) noexcept
@@ -575,6 +647,43 @@ public:
         return status::success;
     }
 
+    //! @brief Decode a component file into @c data.
+    //!
+    //! Neither the @c modeling nor the @c external_source are accessed so
+    //! different readers can decode in parallel.
+    status operator()(component_file_data& data) noexcept
+    {
+        for (int i = 0; i != 4; ++i) {
+            sz number;
+            irt_return_if_fail((is >> number),
+                               status::io_file_format_source_number_error);
+
+            if (number > 0u) {
+                data.has_sources = true;
+                return status::success;
+            }
+        }
+
+        irt_return_if_bad(do_read_model_number());
+
+        try {
+            data.children.reserve(model_number);
+            for (int i = 0; i != model_number; ++i, ++model_error) {
+                int id = 0;
+                irt_return_if_bad(do_read_model_pre(&id));
+                irt_return_if_bad(do_read_dynamics(data, id, temp_1));
+            }
+
+            irt_return_if_bad(do_read_ports(data.y));
+            irt_return_if_bad(do_read_ports(data.x));
+            irt_return_if_bad(do_read_connections(data));
+        } catch (const std::bad_alloc& /*e*/) {
+            irt_bad_return(status::io_not_enough_memory);
+        }
+
+        return status::success;
+    }
+
 private:
     status do_read_binary_file_source(external_source& srcs) noexcept
     {
@@ -930,6 +1039,64 @@ private:
         return status::success;
     }
 
+    status do_read_ports(std::vector<component_file_data::port_data>& ports)
+    {
+        int nb = 0;
+
+        irt_return_if_fail((is >> nb), status::io_file_format_model_error);
+        irt_return_if_fail(nb >= 0, status::io_file_format_model_error);
+
+        for (int i = 0; i < nb; ++i) {
+            int child_index, port_index;
+
+            irt_return_if_fail((is >> child_index >> port_index),
+                               status::io_file_format_model_error);
+            irt_return_if_fail(0 <= child_index && child_index < model_number,
+                               status::io_file_format_model_error);
+            irt_return_if_fail(0 <= port_index && port_index < INT8_MAX,
+                               status::io_file_format_model_error);
+
+            ports.emplace_back(component_file_data::port_data{
+              child_index, static_cast<i8>(port_index) });
+        }
+
+        return status::success;
+    }
+
+    status do_read_connections(component_file_data& data)
+    {
+        while (is) {
+            int mdl_src_id, port_src_index, mdl_dst_id, port_dst_index;
+
+            if (!(is >> mdl_src_id >> port_src_index >> mdl_dst_id >>
+                  port_dst_index)) {
+                if (is.eof())
+                    break;
+
+                irt_bad_return(status::io_file_format_error);
+            }
+
+            irt_return_if_fail(0 <= mdl_src_id && mdl_src_id < model_number,
+                               status::io_file_format_model_error);
+            irt_return_if_fail(0 <= mdl_dst_id && mdl_dst_id < model_number,
+                               status::io_file_format_model_error);
+            irt_return_if_fail(0 <= port_src_index && port_src_index < INT8_MAX,
+                               status::io_file_format_model_unknown);
+            irt_return_if_fail(0 <= port_dst_index && port_dst_index < INT8_MAX,
+                               status::io_file_format_model_unknown);
+
+            data.connections.emplace_back(component_file_data::connection_data{
+              mdl_src_id,
+              mdl_dst_id,
+              static_cast<i8>(port_src_index),
+              static_cast<i8>(port_dst_index) });
+
+            ++connection_error;
+        }
+
+        return status::success;
+    }
+
     status do_read_connections(modeling& mod, component& compo) noexcept
     {
         while (is) {
@@ -1198,6 +1365,42 @@ private:
         return status::success;
     }
 
+    status do_read_dynamics(component_file_data& data,
+                            int                  id,
+                            const char*          dynamics_name)
+    {
+        auto& child = data.children.emplace_back();
+        child.id    = id;
+        child.x     = positions[id].x;
+        child.y     = positions[id].y;
+
+        if (std::strcmp(dynamics_name, "component") == 0) {
+            child.is_component = true;
+
+            irt_return_if_fail((is >> child.hint >> std::quoted(child.name)),
+                               status::io_file_format_error);
+        } else {
+            dynamics_type type;
+            irt_return_if_fail(convert(dynamics_name, &type),
+                               status::io_file_format_dynamics_unknown);
+
+            init_model(child.mdl, type);
+
+            auto ret = dispatch(
+              child.mdl, [this]<typename Dynamics>(Dynamics& dyn) -> status {
+                  irt_return_if_fail(
+                    this->read(dyn),
+                    status::io_file_format_dynamics_init_error);
+
+                  return status::success;
+              });
+
+            irt_return_if_bad(ret);
+        }
+
+        return status::success;
+    }
+
     bool read(qss1_integrator& dyn) noexcept
     {
         real& x1 = *(const_cast<real*>(&dyn.default_X));
@@ -1673,7 +1876,8 @@ struct writer
                                   os << std::distance(map.begin(), it_out)
                                      << ' ' << i << ' '
                                      << std::distance(map.begin(), it_in) << ' '
-                                     << cnt.port_index << '\n';
+                                     << static_cast<int>(cnt.port_index)
+                                     << '\n';
                               }
                           }
 
@@ -2250,7 +2454,8 @@ public:
 
                                   os << irt::get_key(src_id) << " -> "
                                      << irt::get_key(cnt.model) << " [label=\""
-                                     << i << " - " << cnt.port_index
+                                     << i << " - "
+                                     << static_cast<int>(cnt.port_index)
                                      << "\"];\n";
                               }
                           }
@@ -33,6 +33,9 @@ struct component;
 // struct component_ref;
 struct modeling;
 struct description;
+struct tree_node;
+
+class task_manager;
 
 status add_cpp_component_ref(const char* buffer,
                              modeling&   mod,
@@ -41,7 +44,25 @@ status add_file_component_ref(const char* buffer,
                               modeling&   mod,
                               component&  parent) noexcept;
 
-status build_simulation(const modeling& mod, simulation& sim) noexcept;
+//! Flattens the component hierarchy rooted at @c mod.head into @c sim. For
+//! each @c tree_node, the @c tree_node::sim table stores the mapping between
+//! the @c modeling model_id and the @c simulation model_id.
+status build_simulation(modeling& mod, simulation& sim) noexcept;
+
+//! Patches a simulation built with @c build_simulation after the component
+//! @c id was modified. Only the instances of @c id (the tree_node and its
+//! children) are deallocated, rebuilt and reconnected. The rebuilt models
+//! are initialized and scheduled at @c t. The other models of the
+//! simulation are untouched.
+status update_simulation(modeling&    mod,
+                         simulation&  sim,
+                         component_id id,
+                         time         t) noexcept;
+
+//! Finalizes at @c t and deallocates from @c sim all models built for
+//! @c node and its children and removes the connections recorded by the
+//! ancestors of @c node from the other models to them.
+status unbuild_simulation(simulation& sim, tree_node& node, time t) noexcept;
 
 enum class description_status
 {
@@ -140,7 +161,7 @@ enum class component_type
 
 enum class component_status
 {
-    unread,
+    unread, // registered from the component index cache, see modeling::load
     read_only,
     modified,
     unmodified,
@@ -181,6 +202,13 @@ struct file_path
 {
     small_string<256> path;
     dir_path_id       parent{ 0 };
+
+    // Component index cache: last write time and hash of the file content
+    // when the component was read. Unchanged files are not read again. Zero
+    // if the file was never read successfully. The cache is saved into the
+    // .irritator-index file of each directory by fill_components.
+    u64 last_write_time = 0;
+    u64 hash            = 0;
 };
 
 struct modeling_initializer
@@ -204,17 +232,29 @@ struct modeling_initializer
     u64 random_generator_seed;
 };
 
+//! A connection between two simulation models built for a connection of a
+//! component.
+struct sim_connection
+{
+    model_id src;
+    model_id dst;
+    i8       port_src;
+    i8       port_dst;
+};
+
 struct tree_node
 {
     tree_node(component_id id_) noexcept;
 
     component_id         id;
+    child_id             from_child = undefined<child_id>();
     hierarchy<tree_node> tree;
 
     table<model_id, model_id> parameters;
     vector<model_id>          observables;
 
     table<model_id, model_id> sim;
+    vector<sim_connection>    sim_connections; // built from the connections.
 };
 
 // static void refresh_component(void *param) noexcept
@@ -243,14 +283,27 @@ struct modeling
     irt::external_source srcs;
     tree_node_id         head;
 
+    //! Runs the directory scans and the file reads and parsing of
+    //! @c fill_components. If null, the jobs run in the calling thread.
+    task_manager* task_mgr = nullptr;
+
     status init(const modeling_initializer& params) noexcept;
 
     component_id search_component(const char* name, const char* hint) noexcept;
 
     status fill_internal_components() noexcept;
+    //! Loads the new or modified component files of the directories. Files
+    //! unchanged since the .irritator-index cache of their directory are
+    //! registered as @c component_status::unread and read by @c load.
+    //! Components of deleted files are freed if never read or become memory
+    //! components.
     status fill_components() noexcept;
     status fill_components(dir_path& path) noexcept;
 
+    //! Reads the file of an @c component_status::unread component. Called
+    //! by @c make_tree_from and @c copy, does nothing for other components.
+    status load(component& c) noexcept;
+
     void free(component& c) noexcept;
     void free(component& parent, child& c) noexcept;
     void free(component& parent, connection& c) noexcept;
@@ -306,11 +359,8 @@ inline tree_node::tree_node(component_id id_) noexcept
   : id(id_)
 {}
 
-inline child& modeling::alloc(component& parent, dynamics_type type) noexcept
+inline void init_model(model& mdl, dynamics_type type) noexcept
 {
-    irt_assert(!models.full());
-
-    auto& mdl  = models.alloc();
     mdl.type   = type;
     mdl.handle = nullptr;
 
@@ -325,6 +375,14 @@ inline child& modeling::alloc(component& parent, dynamics_type type) noexcept
             for (int i = 0, e = length(dyn.y); i != e; ++i)
                 dyn.y[i] = static_cast<u64>(-1);
     });
+}
+
+inline child& modeling::alloc(component& parent, dynamics_type type) noexcept
+{
+    irt_assert(!models.full());
+
+    auto& mdl = models.alloc();
+    init_model(mdl, type);
 
     auto  mdl_id = models.get_id(mdl);
     auto& child  = children.alloc(mdl_id);
@@ -0,0 +1,632 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_2021_PARTITION_HPP
+#define ORG_VLEPROJECT_IRRITATOR_2021_PARTITION_HPP
+
+#include <irritator/core.hpp>
+#include <irritator/timewarp.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <ostream>
+#include <vector>
+
+namespace irt {
+
+struct partition_parameters;
+struct partition_graph;
+struct partition_level;
+class partitioner;
+
+struct partition_parameters
+{
+    i32  parts     = 2;
+    real imbalance = 0.03; //!< part weight allowed above the average weight.
+    i32  passes    = 8;    //!< refinement passes per level.
+    i32  coarsest  = 32;   //!< vertices per part of the coarsest graph.
+};
+
+//! @brief An undirected weighted graph in compressed sparse row format.
+//!
+//! The neighbors of the vertex @c v are stored in @c adjacency from
+//! @c offsets[v] to @c offsets[v + 1] (excluded). Each edge is stored in
+//! both directions with the same weight.
+struct partition_graph
+{
+    vector<i32> offsets;
+    vector<i32> adjacency;
+    vector<i64> edge_weights;
+    vector<i64> vertex_weights;
+
+    i32 vertices() const noexcept { return vertex_weights.ssize(); }
+    i32 edges() const noexcept { return adjacency.ssize() / 2; }
+
+    i64  total_weight() const noexcept;
+    void clear() noexcept;
+};
+
+//! A coarse graph and the coarse vertex of each vertex of the finer graph.
+struct partition_level
+{
+    partition_graph graph;
+    vector<i32>     map;
+    vector<i32>     parts;
+};
+
+//! @brief Split the connection graph of a simulation into balanced parts
+//! with a small edge cut.
+//!
+//! The vertices are the models, the edges the connections of the output
+//! ports weighted by the messages they carry. A model emits only during its
+//! internal transitions: an edge weights one plus the transitions of its
+//! source model and a vertex one plus its transitions, counted by
+//! @c warm_up or filled by the caller in @c transitions.
+//!
+//! @c partition is a multilevel heuristic: the graph is coarsened with heavy
+//! edge matchings, the coarsest graph is cut along a breadth first
+//! traversal, then the parts are projected back level by level and refined
+//! with greedy moves of the boundary vertices.
+//!
+//!     partitioner part;
+//!     part.warm_up(sim, 0, 10);
+//!     part.build(sim);
+//!     part.partition({ .parts = 8 });
+//!     part.assign(tw);
+class partitioner
+{
+public:
+    vector<model_id> models;      //!< vertex to model.
+    vector<i64>      transitions; //!< by model index.
+    partition_graph  graph;
+    vector<i32>      parts; //!< vertex to part.
+    vector<i64>      part_weights;
+    i64              cut = 0;
+
+    //! Run the simulation from @c begin to @c end and count the transitions
+    //! of each model. The simulation must be initialized again before its
+    //! actual run.
+    status warm_up(simulation& sim, time begin, time end) noexcept;
+
+    //! Build the weighted graph of the models and connections of @c sim.
+    status build(const simulation& sim) noexcept;
+
+    //! Split the graph into @c params.parts parts. Fills @c parts,
+    //! @c part_weights and @c cut.
+    status partition(const partition_parameters& params) noexcept;
+
+    //! The vertex of the model @c id or -1.
+    i32 find(model_id id) const noexcept;
+
+    //! Place each model in the process of its part.
+    void assign(timewarp& tw) const noexcept;
+
+    //! Write the graph in the METIS graph file format with vertex and edge
+    //! weights (the @c gpmetis input).
+    status write_metis(std::ostream& os) const noexcept;
+
+    //! Write the part of each vertex, one per line (the @c gpmetis output).
+    status write_parts(std::ostream& os) const noexcept;
+
+private:
+    std::vector<partition_level> levels;
+    vector<i32>                  vertex; //!< model index to vertex.
+    vector<i32>                  order;
+    vector<i32>                  match;
+    vector<i64>                  connectivity;
+    vector<i64>                  external;
+    vector<i32>                  touched;
+
+    void coarsen(const partition_graph& g,
+                 partition_level&       level,
+                 i64                    limit) noexcept;
+    void split(const partition_graph& g, vector<i32>& p, i32 k) noexcept;
+    void refine(const partition_graph& g,
+                vector<i32>&           p,
+                i32                    k,
+                i64                    limit,
+                i32                    passes) noexcept;
+};
+
+/*****************************************************************************
+ *
+ * Implementation
+ *
+ ****************************************************************************/
+
+inline i64 partition_graph::total_weight() const noexcept
+{
+    i64 total = 0;
+    for (const auto w : vertex_weights)
+        total += w;
+
+    return total;
+}
+
+inline void partition_graph::clear() noexcept
+{
+    offsets.clear();
+    adjacency.clear();
+    edge_weights.clear();
+    vertex_weights.clear();
+}
+
+inline status partitioner::warm_up(simulation& sim,
+                                   time        begin,
+                                   time        end) noexcept
+{
+    transitions.resize(static_cast<i32>(sim.models.capacity()));
+
+    time t = begin;
+    irt_return_if_bad(sim.initialize(t));
+
+    for (;;) {
+        t = sim.sched.empty() ? time_domain<time>::infinity : sim.sched.tn();
+        if (!(t < end))
+            break;
+
+        irt_return_if_bad(sim.run_bag(t));
+
+        for (const auto id : sim.immediate_models)
+            if (const auto index = static_cast<i32>(get_index(id));
+                index < transitions.ssize())
+                ++transitions[index];
+    }
+
+    return status::success;
+}
+
+inline status partitioner::build(const simulation& sim) noexcept
+{
+    struct arc
+    {
+        i32 from;
+        i32 to;
+        i64 weight;
+    };
+
+    const auto traffic = [this](const model_id id) noexcept -> i64 {
+        const auto index = static_cast<i32>(get_index(id));
+        return index < transitions.ssize() ? transitions[index] : 0;
+    };
+
+    models.clear();
+    graph.clear();
+    vertex.resize(static_cast<i32>(sim.models.capacity()));
+    std::fill(vertex.begin(), vertex.end(), -1);
+
+    model* mdl = nullptr;
+    while (sim.models.next(mdl)) {
+        const auto id = sim.models.get_id(*mdl);
+        vertex[static_cast<i32>(get_index(id))] = models.ssize();
+        models.emplace_back(id);
+        graph.vertex_weights.emplace_back(1 + traffic(id));
+    }
+
+    std::vector<arc> arcs;
+
+    try {
+        for (i32 u = 0, e = models.ssize(); u != e; ++u) {
+            const auto& src    = sim.models.get(models[u]);
+            const auto  weight = 1 + traffic(models[u]);
+
+            dispatch(src, [&]<typename Dynamics>(const Dynamics& dyn) {
+                if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+                    for (const auto port : dyn.y) {
+                        for (const auto& elem : get_node(sim, port)) {
+                            if (!sim.models.try_to_get(elem.model))
+                                continue;
+
+                            const auto v =
+                              vertex[static_cast<i32>(get_index(elem.model))];
+                            if (v == u)
+                                continue;
+
+                            arcs.emplace_back(arc{ u, v, weight });
+                            arcs.emplace_back(arc{ v, u, weight });
+                        }
+                    }
+                }
+            });
+        }
+    } catch (const std::bad_alloc& /*e*/) {
+        return status::vector_not_enough_memory;
+    }
+
+    std::sort(arcs.begin(), arcs.end(), [](const arc& a, const arc& b) {
+        return a.from < b.from || (a.from == b.from && a.to < b.to);
+    });
+
+    // Merge the parallel connections and the two directions of an edge.
+    graph.offsets.resize(models.ssize() + 1);
+
+    for (sz i = 0, e = arcs.size(); i != e; ++i) {
+        if (i > 0 && arcs[i].from == arcs[i - 1].from &&
+            arcs[i].to == arcs[i - 1].to) {
+            graph.edge_weights.back() += arcs[i].weight;
+        } else {
+            ++graph.offsets[arcs[i].from + 1];
+            graph.adjacency.emplace_back(arcs[i].to);
+            graph.edge_weights.emplace_back(arcs[i].weight);
+        }
+    }
+
+    for (i32 v = 0, e = models.ssize(); v != e; ++v)
+        graph.offsets[v + 1] += graph.offsets[v];
+
+    return status::success;
+}
+
+inline void partitioner::coarsen(const partition_graph& g,
+                                 partition_level&       level,
+                                 i64                    limit) noexcept
+{
+    const auto  n = g.vertices();
+    const auto& w = g.vertex_weights;
+
+    // Match the vertices of small degree first: they have fewer choices.
+    order.resize(n);
+    for (i32 v = 0; v != n; ++v)
+        order[v] = v;
+
+    std::sort(order.begin(), order.end(), [&g](i32 a, i32 b) {
+        const auto da = g.offsets[a + 1] - g.offsets[a];
+        const auto db = g.offsets[b + 1] - g.offsets[b];
+        return da < db || (da == db && a < b);
+    });
+
+    level.map.resize(n);
+    std::fill(level.map.begin(), level.map.end(), -1);
+    match.resize(n);
+
+    i32 coarse = 0;
+    for (const auto u : order) {
+        if (level.map[u] >= 0)
+            continue;
+
+        i32 best        = u;
+        i64 best_weight = 0;
+
+        for (i32 e = g.offsets[u]; e != g.offsets[u + 1]; ++e) {
+            const auto v = g.adjacency[e];
+            if (level.map[v] < 0 && w[u] + w[v] <= limit &&
+                g.edge_weights[e] > best_weight) {
+                best        = v;
+                best_weight = g.edge_weights[e];
+            }
+        }
+
+        level.map[u] = level.map[best] = coarse;
+        match[u]                      = best;
+        order[coarse]                 = u;
+        ++coarse;
+    }
+
+    // The position of each coarse neighbor in the adjacency of the current
+    // coarse vertex to merge the edges.
+    auto& c = level.graph;
+    c.clear();
+    c.offsets.resize(coarse + 1);
+    c.vertex_weights.resize(coarse);
+    touched.resize(coarse);
+    std::fill(touched.begin(), touched.end(), -1);
+
+    for (i32 cv = 0; cv != coarse; ++cv) {
+        const i32 members[2] = { order[cv], match[order[cv]] };
+        const i32 first      = c.adjacency.ssize();
+
+        for (i32 m = 0; m != (members[0] == members[1] ? 1 : 2); ++m) {
+            const auto u = members[m];
+            c.vertex_weights[cv] += w[u];
+
+            for (i32 e = g.offsets[u]; e != g.offsets[u + 1]; ++e) {
+                const auto to = level.map[g.adjacency[e]];
+                if (to == cv)
+                    continue;
+
+                if (touched[to] < first) {
+                    touched[to] = c.adjacency.ssize();
+                    c.adjacency.emplace_back(to);
+                    c.edge_weights.emplace_back(g.edge_weights[e]);
+                } else {
+                    c.edge_weights[touched[to]] += g.edge_weights[e];
+                }
+            }
+        }
+
+        c.offsets[cv + 1] = c.adjacency.ssize();
+    }
+}
+
+inline void partitioner::split(const partition_graph& g,
+                               vector<i32>&           p,
+                               i32                    k) noexcept
+{
+    const auto n     = g.vertices();
+    const auto total = g.total_weight();
+
+    p.resize(n);
+    std::fill(p.begin(), p.end(), -1);
+
+    // The breadth first order gives the seeds: each part starts next to the
+    // previous parts.
+    order.clear();
+    for (i32 start = 0; start != n; ++start) {
+        if (p[start] >= 0)
+            continue;
+
+        p[start] = 0;
+        order.emplace_back(start);
+
+        for (i32 head = order.ssize() - 1; head != order.ssize(); ++head) {
+            const auto u = order[head];
+            for (i32 e = g.offsets[u]; e != g.offsets[u + 1]; ++e) {
+                if (p[g.adjacency[e]] < 0) {
+                    p[g.adjacency[e]] = 0;
+                    order.emplace_back(g.adjacency[e]);
+                }
+            }
+        }
+    }
+
+    // Grow each part from a seed with the vertex of greatest gain: the
+    // weight of its edges to the part minus its edges to the free vertices.
+    std::fill(p.begin(), p.end(), -1);
+    connectivity.resize(n);
+    external.resize(n);
+    for (i32 v = 0; v != n; ++v)
+        for (i32 e = g.offsets[v]; e != g.offsets[v + 1]; ++e)
+            external[v] += g.edge_weights[e];
+
+    i32 seed = 0;
+    i64 sum  = 0;
+
+    for (i32 part = 0; part != k; ++part) {
+        touched.clear();
+
+        while (part + 1 == k || sum * k < (part + 1) * total) {
+            i32 best = -1;
+            for (i32 i = 0; i != touched.ssize(); ++i) {
+                const auto v = touched[i];
+                if (best < 0 || connectivity[v] - external[v] >
+                                  connectivity[best] - external[best])
+                    best = v;
+            }
+
+            if (best < 0) {
+                while (seed != n && p[order[seed]] >= 0)
+                    ++seed;
+                if (seed == n)
+                    break;
+
+                best = order[seed];
+            }
+
+            p[best] = part;
+            sum += g.vertex_weights[best];
+
+            const auto it = std::find(touched.begin(), touched.end(), best);
+            if (it != touched.end())
+                touched.swap_pop_back(static_cast<i32>(it - touched.begin()));
+
+            for (i32 e = g.offsets[best]; e != g.offsets[best + 1]; ++e) {
+                const auto v = g.adjacency[e];
+                if (p[v] >= 0)
+                    continue;
+
+                if (connectivity[v] == 0)
+                    touched.emplace_back(v);
+                connectivity[v] += g.edge_weights[e];
+                external[v] -= g.edge_weights[e];
+            }
+        }
+
+        for (const auto v : touched)
+            connectivity[v] = 0;
+    }
+
+    touched.clear();
+}
+
+inline void partitioner::refine(const partition_graph& g,
+                                vector<i32>&           p,
+                                i32                    k,
+                                i64                    limit,
+                                i32                    passes) noexcept
+{
+    const auto n = g.vertices();
+
+    part_weights.resize(k);
+    for (i32 v = 0; v != n; ++v)
+        part_weights[p[v]] += g.vertex_weights[v];
+
+    connectivity.resize(k);
+    touched.clear();
+
+    for (i32 pass = 0; pass != passes; ++pass) {
+        i32 moves = 0;
+
+        for (i32 u = 0; u != n; ++u) {
+            const auto from   = p[u];
+            const auto weight = g.vertex_weights[u];
+
+            for (i32 e = g.offsets[u]; e != g.offsets[u + 1]; ++e) {
+                const auto q = p[g.adjacency[e]];
+                if (connectivity[q] == 0)
+                    touched.emplace_back(q);
+                connectivity[q] += g.edge_weights[e];
+            }
+
+            i32 best      = -1;
+            i64 best_gain = std::numeric_limits<i64>::min();
+
+            for (const auto q : touched) {
+                if (q == from || part_weights[q] + weight > limit)
+                    continue;
+
+                const auto gain = connectivity[q] - connectivity[from];
+                if (gain > best_gain ||
+                    (best >= 0 && gain == best_gain &&
+                     part_weights[q] < part_weights[best])) {
+                    best      = q;
+                    best_gain = gain;
+                }
+            }
+
+            const bool overweight = part_weights[from] > limit;
+            if (overweight && best < 0) {
+                const auto lightest =
+                  std::min_element(part_weights.begin(), part_weights.end()) -
+                  part_weights.begin();
+
+                if (part_weights[lightest] + weight <= limit)
+                    best = static_cast<i32>(lightest);
+            }
+
+            // A move without gain must improve the balance to terminate.
+            if (best >= 0 &&
+                (overweight || best_gain > 0 ||
+                 (best_gain == 0 &&
+                  part_weights[best] + weight < part_weights[from]))) {
+                p[u] = best;
+                part_weights[from] -= weight;
+                part_weights[best] += weight;
+                ++moves;
+            }
+
+            for (const auto q : touched)
+                connectivity[q] = 0;
+            touched.clear();
+        }
+
+        if (moves == 0)
+            break;
+    }
+}
+
+inline status partitioner::partition(
+  const partition_parameters& params) noexcept
+{
+    irt_return_if_fail(params.parts > 0 && params.passes >= 0 &&
+                         params.coarsest > 0 && params.imbalance >= 0,
+                       status::vector_init_capacity_error);
+
+    const auto k     = params.parts;
+    const auto total = graph.total_weight();
+
+    // A coarse vertex weights at most 1.5 times the average vertex of the
+    // coarsest graph.
+    const auto limit = std::max<i64>(
+      1, 3 * total / (2 * static_cast<i64>(k) * params.coarsest));
+
+    const auto graph_at = [this](sz depth) noexcept -> partition_graph& {
+        return depth ? levels[depth - 1].graph : graph;
+    };
+
+    // Coarsen while the matchings shrink the graph.
+    sz depth = 0;
+    while (graph_at(depth).vertices() > k * params.coarsest) {
+        try {
+            if (depth == levels.size())
+                levels.emplace_back();
+        } catch (const std::bad_alloc& /*e*/) {
+            return status::vector_not_enough_memory;
+        }
+
+        const auto& fine = graph_at(depth);
+        coarsen(fine, levels[depth], limit);
+        if (levels[depth].graph.vertices() * 10 > fine.vertices() * 9)
+            break;
+
+        ++depth;
+    }
+
+    const auto max_weight = [&](const partition_graph& fine) noexcept {
+        const auto heaviest =
+          fine.vertices() ? *std::max_element(fine.vertex_weights.begin(),
+                                              fine.vertex_weights.end())
+                          : 0;
+        const auto average = (total + k - 1) / k;
+
+        return std::max(static_cast<i64>(static_cast<real>(total) *
+                                         (1 + params.imbalance) / k),
+                        average + heaviest);
+    };
+
+    const auto& coarsest = graph_at(depth);
+    auto&       p        = depth ? levels[depth - 1].parts : parts;
+    split(coarsest, p, k);
+    refine(coarsest, p, k, max_weight(coarsest), params.passes);
+
+    for (; depth > 0; --depth) {
+        const auto& coarse = levels[depth - 1];
+        const auto& fine   = graph_at(depth - 1);
+        auto&       fp     = depth > 1 ? levels[depth - 2].parts : parts;
+
+        fp.resize(fine.vertices());
+        for (i32 v = 0, e = fine.vertices(); v != e; ++v)
+            fp[v] = coarse.parts[coarse.map[v]];
+
+        refine(fine, fp, k, max_weight(fine), params.passes);
+    }
+
+    part_weights.resize(k);
+    for (i32 v = 0, e = graph.vertices(); v != e; ++v)
+        part_weights[parts[v]] += graph.vertex_weights[v];
+
+    cut = 0;
+    for (i32 v = 0, e = graph.vertices(); v != e; ++v)
+        for (i32 i = graph.offsets[v]; i != graph.offsets[v + 1]; ++i)
+            if (v < graph.adjacency[i] && parts[v] != parts[graph.adjacency[i]])
+                cut += graph.edge_weights[i];
+
+    return status::success;
+}
+
+inline i32 partitioner::find(model_id id) const noexcept
+{
+    const auto index = static_cast<i32>(get_index(id));
+    if (index >= vertex.ssize() || vertex[index] < 0)
+        return -1;
+
+    return models[vertex[index]] == id ? vertex[index] : -1;
+}
+
+inline void partitioner::assign(timewarp& tw) const noexcept
+{
+    irt_assert(parts.ssize() == models.ssize());
+
+    for (i32 v = 0, e = models.ssize(); v != e; ++v)
+        tw.assign(models[v], parts[v]);
+}
+
+inline status partitioner::write_metis(std::ostream& os) const noexcept
+{
+    os << "% irritator models: vertex and edge weights\n"
+       << graph.vertices() << ' ' << graph.edges() << " 011\n";
+
+    for (i32 v = 0, e = graph.vertices(); v != e; ++v) {
+        os << graph.vertex_weights[v];
+
+        for (i32 i = graph.offsets[v]; i != graph.offsets[v + 1]; ++i)
+            os << ' ' << graph.adjacency[i] + 1 << ' ' << graph.edge_weights[i];
+
+        os << '\n';
+    }
+
+    return os.good() ? status::success : status::io_file_format_error;
+}
+
+inline status partitioner::write_parts(std::ostream& os) const noexcept
+{
+    for (const auto part : parts)
+        os << part << '\n';
+
+    return os.good() ? status::success : status::io_file_format_error;
+}
+
+} // namespace irt
+
+#endif
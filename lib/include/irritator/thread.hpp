@@ -10,9 +10,14 @@
 
 #include <atomic>
 #include <barrier>
+#include <chrono>
 #include <latch>
 #include <thread>
 
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
 namespace irt {
 
 class spin_lock;
@@ -23,6 +28,14 @@ struct worker;
 struct task;
 struct task_list;
 class task_manager;
+class task_counter;
+class task_graph;
+
+template<typename T>
+class spsc_queue;
+
+template<typename T>
+class triple_buffer;
 
 class spin_lock
 {
@@ -59,17 +72,63 @@ using task_function = void (*)(void*) noexcept;
 struct task
 {
     constexpr task() noexcept = default;
-    constexpr task(task_function function_, void* parameter_) noexcept;
+    constexpr task(task_function function_,
+                   void*         parameter_,
+                   task_list*    list_    = nullptr,
+                   task_counter* counter_ = nullptr) noexcept;
 
     task_function function  = nullptr;
     void*         parameter = nullptr;
+    task_list*    list      = nullptr; //!< Owner list notified at task end.
+    task_counter* counter   = nullptr; //!< Counter decremented at task end.
 };
 
-//! @brief Simple task list access by only one thread
+//! @brief A fixed size Chase-Lev work-stealing deque.
+//!
+//! The owner thread pushes and pops tasks at the bottom, other workers steal
+//! tasks at the top. Slots are atomics so a concurrent steal of a slot being
+//! overwritten is never a data race: the compare-exchange on @c top rejects
+//! the stolen copy.
+template<i32 Size>
+class work_stealing_deque
+{
+    static_assert(Size > 0 && (Size & (Size - 1)) == 0,
+                  "Size must be a power of two");
+
+    struct slot
+    {
+        std::atomic<task_function> function  = nullptr;
+        std::atomic<void*>         parameter = nullptr;
+        std::atomic<task_list*>    list      = nullptr;
+        std::atomic<task_counter*> counter   = nullptr;
+    };
+
+    slot buffer[Size];
+
+    alignas(64) std::atomic<i64> top    = 0;
+    alignas(64) std::atomic<i64> bottom = 0;
+
+    void store(i64 index, const task& t) noexcept;
+    task load(i64 index) const noexcept;
+
+public:
+    work_stealing_deque() noexcept = default;
+
+    bool push(const task& t) noexcept; // owner only
+    bool pop(task& t) noexcept;        // owner only
+    bool steal(task& t) noexcept;      // any thread
+
+    bool empty() const noexcept;
+    bool full() const noexcept;
+};
+
+//! @brief Simple task list fed by any thread and consumed by the workers.
 struct task_list
 {
     ring_buffer<task, 256> tasks;
     spin_lock              spin;
+    task_manager*          manager = nullptr; // to wake up sleeping workers.
+    std::atomic<i32>       pending = 0;       // tasks added but not finished.
 
     i32 task_number = 0;   // number of task since task_list constructor
     i8  priority    = 127; // task_list priority (-127 better than 127).
@@ -77,9 +136,24 @@ struct task_list
     task_list() noexcept = default;
 
     void add(task_function function, void* parameter) noexcept;
+
+    //! Add a task which decrements @c counter when finished.
+    void add(task_function function,
+             void*         parameter,
+             task_counter& counter) noexcept;
+
+    //! Wait until all the tasks added to this list are finished.
     void wait() noexcept;
+
+private:
+    void push(const task& t) noexcept;
 };
 
+//! @brief A worker thread.
+//!
+//! The worker runs tasks from its own deque, refills the deque from its
+//! task lists, steals from the deques of the other workers and finally
+//! sleeps on the @c task_manager epoch when no work is available.
 struct worker
 {
     void start() noexcept;
@@ -93,10 +167,44 @@ struct worker
     void run() noexcept;
     void join() noexcept;
 
-    std::jthread         thread;
-    vector<task_list*>   task_lists;
-    ring_buffer<task, 8> tasks;
-    bool                 is_terminating = false;
+    //! Get a task from the worker deque, its task lists or another worker.
+    bool try_get(task& t) noexcept;
+
+    //! Run the task and notify its task list and its counter.
+    static void execute(task& t) noexcept;
+
+    std::jthread              thread;
+    vector<task_list*>        task_lists;
+    work_stealing_deque<256>  tasks;
+    task_manager*             manager        = nullptr;
+    i32                       index          = 0;
+    std::atomic<bool>         is_terminating = false;
+
+private:
+    bool refill() noexcept;
+    bool try_steal(task& t) noexcept;
+    bool is_lists_empty() noexcept;
+};
+
+//! The worker running in the current thread or nullptr.
+inline thread_local worker* this_worker = nullptr;
+
+//! Incremented each time a @c task_counter reaches zero. The threads waiting
+//! for a counter sleep on this word since the owner of a counter may destroy
+//! it as soon as it reaches zero.
+inline std::atomic<u32> task_counter_epoch = 0;
+
+//! @brief Exponential backoff of a thread waiting for other threads.
+//!
+//! @c pause spins with a growing number of cpu pauses, then yields and
+//! finally sleeps a few microseconds. Call @c reset after progress.
+class backoff
+{
+    i32 m_step = 0;
+
+public:
+    void pause() noexcept;
+    void reset() noexcept { m_step = 0; }
 };
 
 struct task_manager_parameters
@@ -112,6 +220,9 @@ public:
     vector<worker>    workers;
     vector<task_list> task_lists;
 
+    std::atomic<u32> epoch    = 0; // incremented when new tasks are available
+    std::atomic<i32> sleeping = 0; // number of workers waiting on epoch
+
     task_manager() noexcept = default;
 
     task_manager(task_manager&& params)      = delete;
@@ -124,6 +235,195 @@ public:
     // creating task lists and spawning workers
     status start() noexcept;
     void   finalize() noexcept;
+
+    //! Wake up the sleeping workers.
+    void notify() noexcept;
+};
+
+//! @brief A counter of unfinished tasks with an optional continuation.
+//!
+//! Tasks added with @c task_list::add(function, parameter, counter)
+//! decrement the counter at the end of their execution. When the counter
+//! reaches zero, the continuation task (if any) is added to its task list
+//! and the waiting threads are woken up. Use it for fork-join:
+//!
+//!     task_counter counter;
+//!     for (auto& elem : elems)
+//!         list.add(&function, &elem, counter);
+//!     counter.wait();
+class task_counter
+{
+    std::atomic<i32> m_count = 0;
+    task_list*       m_list  = nullptr;
+    task             m_continuation;
+
+public:
+    task_counter() noexcept = default;
+
+    task_counter(const task_counter&) = delete;
+    task_counter& operator=(const task_counter&) = delete;
+
+    //! Set the task added to @c list when the counter reaches zero. Must be
+    //! called before the first task is added.
+    void then(task_list& list, task_function function, void* parameter) noexcept;
+
+    void increment(i32 number = 1) noexcept;
+    void decrement() noexcept;
+
+    bool is_done() const noexcept;
+
+    //! Wait until the counter reaches zero. Called from a worker, the
+    //! worker runs other tasks while waiting.
+    void wait() noexcept;
+};
+
+using range_function = void (*)(i32 first, i32 last, void* parameter) noexcept;
+
+//! Split [@c begin, @c end[ into ranges of @c grain indices, run
+//! @c function on each range in @c list and wait for the end of all ranges.
+//! The calling thread runs the last range.
+void parallel_for(task_list&     list,
+                  i32            begin,
+                  i32            end,
+                  i32            grain,
+                  range_function function,
+                  void*          parameter) noexcept;
+
+//! Call @c f(first, last) for each range, see the function pointer version.
+template<typename Function>
+void parallel_for(task_list& list,
+                  i32        begin,
+                  i32        end,
+                  i32        grain,
+                  Function&& f) noexcept;
+
+//! @brief A directed acyclic graph of dependent tasks.
+//!
+//! Nodes are added with @c add, dependencies with @c precede. @c submit adds
+//! the nodes without predecessor to the task list, each finished node adds
+//! its successors with no more unfinished predecessor. For example, 64 tasks
+//! followed by a reduction:
+//!
+//!     task_graph graph;
+//!     graph.init(65);
+//!     auto reduce = graph.add(&reduce_function, &data);
+//!     for (int i = 0; i < 64; ++i)
+//!         graph.precede(graph.add(&map_function, &data[i]), reduce);
+//!     graph.submit(list);
+//!     graph.wait();
+class task_graph
+{
+public:
+    using node_id = i32;
+
+private:
+    struct node
+    {
+        task_function    function  = nullptr;
+        void*            parameter = nullptr;
+        task_graph*      graph     = nullptr;
+        vector<node_id>  successors;
+        i32              predecessor_number = 0;
+        std::atomic<i32> remaining          = 0;
+
+        node() noexcept = default;
+        node(const node& other) noexcept;
+        node& operator=(const node& other) noexcept;
+    };
+
+    vector<node> m_nodes;
+    task_list*   m_list = nullptr;
+    task_counter m_counter;
+
+    static void run_node(void* parameter) noexcept;
+
+public:
+    task_graph() noexcept = default;
+
+    task_graph(const task_graph&) = delete;
+    task_graph& operator=(const task_graph&) = delete;
+
+    status init(i32 capacity) noexcept;
+    void   clear() noexcept;
+
+    bool can_add(i32 number = 1) const noexcept;
+
+    //! Add a node. Use @c can_add before using this function.
+    node_id add(task_function function, void* parameter) noexcept;
+
+    //! The node @c after waits the end of the node @c before.
+    void precede(node_id before, node_id after) noexcept;
+
+    //! Add the root nodes into @c list. The graph can be submitted again
+    //! after @c wait.
+    void submit(task_list& list) noexcept;
+    void wait() noexcept;
+};
+
+//! @brief A bounded single-producer single-consumer lock-free queue.
+//!
+//! One thread pushes, another thread pops: use it to stream values between
+//! two threads without lock (for example from a simulation running in a
+//! worker to the graphical user interface). The values are copied with
+//! their bytes.
+template<typename T>
+class spsc_queue
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    vector<T> m_buffer;
+    u32       m_mask = 0;
+
+    alignas(64) std::atomic<u32> m_head = 0; // next value to pop
+    alignas(64) std::atomic<u32> m_tail = 0; // next value to push
+
+public:
+    spsc_queue() noexcept = default;
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    //! Allocate the buffer. The @c capacity is rounded up to a power of two.
+    //! Must be called before the threads use the queue.
+    status init(i32 capacity) noexcept;
+
+    bool push(const T& value) noexcept; // producer only
+    bool pop(T& value) noexcept;        // consumer only
+
+    bool empty() const noexcept;
+    i32  capacity() const noexcept;
+};
+
+//! @brief Exchange the last value written by a thread with a reader thread
+//! without lock.
+//!
+//! The writer fills the @c write_buffer then calls @c publish, the reader
+//! calls @c update then reads the @c read_buffer. The third buffer makes
+//! the two sides independent: the writer never waits for the reader and
+//! overwrites the published values not yet read.
+template<typename T>
+class triple_buffer
+{
+    static constexpr u8 fresh = 4u; // the middle buffer was published
+
+    T               m_buffers[3];
+    u8              m_write  = 0;
+    u8              m_read   = 1;
+    std::atomic<u8> m_middle = 2;
+
+public:
+    triple_buffer() noexcept = default;
+
+    triple_buffer(const triple_buffer&) = delete;
+    triple_buffer& operator=(const triple_buffer&) = delete;
+
+    T&   write_buffer() noexcept; // writer only
+    void publish() noexcept;      // writer only
+
+    //! Take the last published buffer if any.
+    //! @return true if the @c read_buffer changes.
+    bool     update() noexcept;            // reader only
+    const T& read_buffer() const noexcept; // reader only
 };
 
 /*****************************************************************************
@@ -132,6 +432,103 @@ public:
  *
  ****************************************************************************/
 
+template<typename T>
+inline status spsc_queue<T>::init(i32 capacity) noexcept
+{
+    irt_return_if_fail(capacity > 0 && capacity <= (1 << 30),
+                       status::vector_init_capacity_error);
+
+    i32 size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    m_buffer = vector<T>(size, size);
+    irt_return_if_fail(m_buffer.data() != nullptr,
+                       status::vector_not_enough_memory);
+
+    m_mask = static_cast<u32>(size - 1);
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+
+    return status::success;
+}
+
+template<typename T>
+inline bool spsc_queue<T>::push(const T& value) noexcept
+{
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    const auto head = m_head.load(std::memory_order_acquire);
+
+    if (tail - head == static_cast<u32>(m_buffer.ssize()))
+        return false;
+
+    m_buffer[static_cast<i32>(tail & m_mask)] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+template<typename T>
+inline bool spsc_queue<T>::pop(T& value) noexcept
+{
+    const auto head = m_head.load(std::memory_order_relaxed);
+    const auto tail = m_tail.load(std::memory_order_acquire);
+
+    if (head == tail)
+        return false;
+
+    value = m_buffer[static_cast<i32>(head & m_mask)];
+    m_head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+template<typename T>
+inline bool spsc_queue<T>::empty() const noexcept
+{
+    return m_head.load(std::memory_order_acquire) ==
+           m_tail.load(std::memory_order_acquire);
+}
+
+template<typename T>
+inline i32 spsc_queue<T>::capacity() const noexcept
+{
+    return m_buffer.ssize();
+}
+
+template<typename T>
+inline T& triple_buffer<T>::write_buffer() noexcept
+{
+    return m_buffers[m_write];
+}
+
+template<typename T>
+inline void triple_buffer<T>::publish() noexcept
+{
+    const auto old = m_middle.exchange(static_cast<u8>(m_write | fresh),
+                                       std::memory_order_acq_rel);
+
+    m_write = static_cast<u8>(old & ~fresh);
+}
+
+template<typename T>
+inline bool triple_buffer<T>::update() noexcept
+{
+    if (!(m_middle.load(std::memory_order_relaxed) & fresh))
+        return false;
+
+    const auto old = m_middle.exchange(m_read, std::memory_order_acq_rel);
+    m_read         = static_cast<u8>(old & ~fresh);
+
+    return true;
+}
+
+template<typename T>
+inline const T& triple_buffer<T>::read_buffer() const noexcept
+{
+    return m_buffers[m_read];
+}
+
 inline status task_manager::init(task_manager_parameters& params) noexcept
 {
     irt_return_if_fail(params.thread_number > 0, status::gui_not_enough_memory);
@@ -141,6 +538,14 @@ inline status task_manager::init(task_manager_parameters& params) noexcept
     workers.resize(params.thread_number);
     task_lists.resize(params.simple_task_list_number);
 
+    for (i32 i = 0, e = workers.ssize(); i != e; ++i) {
+        workers[i].manager = this;
+        workers[i].index   = i;
+    }
+
+    for (auto& lst : task_lists)
+        lst.manager = this;
+
     return status::success;
 }
 
@@ -164,6 +569,34 @@ inline void task_manager::finalize() noexcept
     workers.clear();
 }
 
+inline void task_manager::notify() noexcept
+{
+    epoch.fetch_add(1u);
+
+    if (sleeping.load() > 0)
+        epoch.notify_all();
+}
+
+inline void backoff::pause() noexcept
+{
+    if (m_step < 6) {
+        for (i32 i = 0, e = 1 << m_step; i != e; ++i) {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+            _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+            __builtin_ia32_pause();
+#endif
+        }
+    } else if (m_step < 10) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        return;
+    }
+
+    ++m_step;
+}
+
 inline spin_lock::spin_lock() noexcept { flag.clear(); }
 
 inline bool spin_lock::try_lock() noexcept
@@ -191,39 +624,158 @@ inline scoped_spin_lock::scoped_spin_lock(spin_lock& spin_) noexcept
 
 inline scoped_spin_lock::~scoped_spin_lock() noexcept { spin.unlock(); }
 
-constexpr task::task(task_function function_, void* parameter_) noexcept
+constexpr task::task(task_function function_,
+                     void*         parameter_,
+                     task_list*    list_,
+                     task_counter* counter_) noexcept
   : function(function_)
   , parameter(parameter_)
+  , list(list_)
+  , counter(counter_)
 {}
 
-inline void task_list::add(task_function function, void* parameter) noexcept
+template<i32 Size>
+inline void work_stealing_deque<Size>::store(i64 index, const task& t) noexcept
+{
+    auto& s = buffer[index & (Size - 1)];
+    s.function.store(t.function, std::memory_order_relaxed);
+    s.parameter.store(t.parameter, std::memory_order_relaxed);
+    s.list.store(t.list, std::memory_order_relaxed);
+    s.counter.store(t.counter, std::memory_order_relaxed);
+}
+
+template<i32 Size>
+inline task work_stealing_deque<Size>::load(i64 index) const noexcept
+{
+    const auto& s = buffer[index & (Size - 1)];
+    return task(s.function.load(std::memory_order_relaxed),
+                s.parameter.load(std::memory_order_relaxed),
+                s.list.load(std::memory_order_relaxed),
+                s.counter.load(std::memory_order_relaxed));
+}
+
+template<i32 Size>
+inline bool work_stealing_deque<Size>::push(const task& t) noexcept
 {
+    const auto b = bottom.load(std::memory_order_relaxed);
+    const auto f = top.load(std::memory_order_acquire);
+
+    if (b - f >= Size)
+        return false;
+
+    store(b, t);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+template<i32 Size>
+inline bool work_stealing_deque<Size>::pop(task& t) noexcept
+{
+    const auto b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto f = top.load(std::memory_order_relaxed);
+
+    if (f > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    t = load(b);
+    if (f == b) {
+        // Last task: race against the stealers.
+        const bool success = top.compare_exchange_strong(
+          f, f + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return success;
+    }
+
+    return true;
+}
+
+template<i32 Size>
+inline bool work_stealing_deque<Size>::steal(task& t) noexcept
+{
+    auto f = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto b = bottom.load(std::memory_order_acquire);
+
+    if (f >= b)
+        return false;
+
+    t = load(f);
+
+    return top.compare_exchange_strong(
+      f, f + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+template<i32 Size>
+inline bool work_stealing_deque<Size>::empty() const noexcept
+{
+    return bottom.load(std::memory_order_relaxed) <=
+           top.load(std::memory_order_relaxed);
+}
+
+template<i32 Size>
+inline bool work_stealing_deque<Size>::full() const noexcept
+{
+    return bottom.load(std::memory_order_relaxed) -
+             top.load(std::memory_order_relaxed) >=
+           Size;
+}
+
+inline void task_list::push(const task& t) noexcept
+{
+    pending.fetch_add(1, std::memory_order_relaxed);
+
     for (;;) {
         {
             scoped_spin_lock lock(spin);
             if (!tasks.full()) {
-                tasks.emplace_enqueue(function, parameter);
+                tasks.enqueue(t);
                 ++task_number;
-                return;
+                break;
             }
         }
 
+        // A worker adding into a full list runs the task itself to avoid
+        // waiting for the other workers, themselves maybe blocked here.
+        if (this_worker) {
+            task copy = t;
+            worker::execute(copy);
+            return;
+        }
+
         std::this_thread::yield();
     }
+
+    if (manager)
+        manager->notify();
+}
+
+inline void task_list::add(task_function function, void* parameter) noexcept
+{
+    push(task(function, parameter, this));
+}
+
+inline void task_list::add(task_function function,
+                           void*         parameter,
+                           task_counter& counter) noexcept
+{
+    counter.increment();
+    push(task(function, parameter, this, &counter));
 }
 
 inline void task_list::wait() noexcept
 {
     for (;;) {
-        {
-            scoped_spin_lock lock(spin);
-            if (tasks.empty()) {
-                tasks.clear();
-                return;
-            }
-        }
+        const auto n = pending.load(std::memory_order_acquire);
+        if (n == 0)
+            return;
 
-        std::this_thread::yield();
+        pending.wait(n, std::memory_order_acquire);
     }
 }
 
@@ -232,10 +784,92 @@ inline void worker::start() noexcept
     thread = std::jthread{ &worker::run, this };
 }
 
-inline void worker::terminate() noexcept { is_terminating = true; }
+inline void worker::terminate() noexcept
+{
+    is_terminating = true;
+
+    if (manager) {
+        manager->epoch.fetch_add(1u);
+        manager->epoch.notify_all();
+    }
+}
+
+inline bool worker::refill() noexcept
+{
+    constexpr i32 batch = 16;
+    i32           moved = 0;
+
+    for (auto& lst : task_lists) {
+        scoped_spin_lock lock(lst->spin);
+
+        while (moved < batch && !tasks.full() && !lst->tasks.empty()) {
+            tasks.push(lst->tasks.dequeue());
+            ++moved;
+        }
+
+        if (moved == batch)
+            break;
+    }
+
+    // Others workers can steal the surplus.
+    if (moved > 1 && manager)
+        manager->notify();
+
+    return moved > 0;
+}
+
+inline bool worker::try_steal(task& t) noexcept
+{
+    if (!manager)
+        return false;
+
+    const auto n = manager->workers.ssize();
+    for (i32 i = 1; i < n; ++i) {
+        auto& victim = manager->workers[(index + i) % n];
+        if (victim.tasks.steal(t))
+            return true;
+    }
+
+    return false;
+}
+
+inline bool worker::try_get(task& t) noexcept
+{
+    if (tasks.pop(t))
+        return true;
+
+    if (refill() && tasks.pop(t))
+        return true;
+
+    return try_steal(t);
+}
+
+inline bool worker::is_lists_empty() noexcept
+{
+    for (auto& lst : task_lists) {
+        scoped_spin_lock lock(lst->spin);
+        if (!lst->tasks.empty())
+            return false;
+    }
+
+    return true;
+}
+
+inline void worker::execute(task& t) noexcept
+{
+    t.function(t.parameter);
+
+    if (t.counter)
+        t.counter->decrement();
+
+    if (t.list && t.list->pending.fetch_sub(1) == 1)
+        t.list->pending.notify_all();
+}
 
 inline void worker::run() noexcept
 {
+    this_worker = this;
+
     std::sort(task_lists.begin(),
               task_lists.end(),
               [](const task_list* left, const task_list* right) -> bool {
@@ -243,38 +877,239 @@ inline void worker::run() noexcept
               });
 
     for (;;) {
-        while (!tasks.empty()) {
-            auto task = tasks.dequeue();
-            task.function(task.parameter);
+        const auto current_epoch = manager ? manager->epoch.load() : 0u;
+
+        if (task t; try_get(t)) {
+            execute(t);
+            continue;
         }
 
-        for (auto& lst : task_lists) {
-            scoped_spin_lock lock(lst->spin);
-            if (lst->tasks.empty())
-                continue;
+        if (is_terminating && tasks.empty() && is_lists_empty())
+            return;
 
-            while (!tasks.full() && !lst->tasks.empty())
-                tasks.enqueue(lst->tasks.dequeue());
+        if (manager) {
+            manager->sleeping.fetch_add(1);
+            manager->epoch.wait(current_epoch);
+            manager->sleeping.fetch_sub(1);
+        } else {
+            std::this_thread::yield();
         }
+    }
+}
 
-        if (tasks.empty() && is_terminating) {
-            bool all_empty = true;
+inline void worker::join() noexcept { thread.join(); }
 
-            for (auto& lst : task_lists) {
-                scoped_spin_lock lock(lst->spin);
-                if (!lst->tasks.empty()) {
-                    all_empty = false;
-                    break;
-                }
-            }
+inline void task_counter::then(task_list&    list,
+                               task_function function,
+                               void*         parameter) noexcept
+{
+    m_list         = &list;
+    m_continuation = task(function, parameter);
+}
+
+inline void task_counter::increment(i32 number) noexcept
+{
+    m_count.fetch_add(number);
+}
+
+inline void task_counter::decrement() noexcept
+{
+    // Copy the continuation first and never touch the counter after the
+    // last decrement: a waiting thread may destroy the counter as soon as it
+    // reaches zero.
+    auto* list         = m_list;
+    auto  continuation = m_continuation;
+
+    if (m_count.fetch_sub(1) == 1) {
+        if (list && continuation.function)
+            list->add(continuation.function, continuation.parameter);
+
+        task_counter_epoch.fetch_add(1u);
+        task_counter_epoch.notify_all();
+    }
+}
+
+inline bool task_counter::is_done() const noexcept
+{
+    return m_count.load() == 0;
+}
 
-            if (all_empty)
+inline void task_counter::wait() noexcept
+{
+    if (this_worker) {
+        backoff b;
+        while (!is_done()) {
+            if (task t; this_worker->try_get(t)) {
+                worker::execute(t);
+                b.reset();
+            } else {
+                b.pause();
+            }
+        }
+    } else {
+        // Read the epoch before the counter: the last decrement increments
+        // the epoch after the counter reaches zero.
+        for (;;) {
+            const auto epoch = task_counter_epoch.load();
+            if (is_done())
                 return;
+
+            task_counter_epoch.wait(epoch);
         }
     }
 }
 
-inline void worker::join() noexcept { thread.join(); }
+inline void parallel_for(task_list&     list,
+                         i32            begin,
+                         i32            end,
+                         i32            grain,
+                         range_function function,
+                         void*          parameter) noexcept
+{
+    struct range
+    {
+        i32            first;
+        i32            last;
+        range_function function;
+        void*          parameter;
+    };
+
+    if (begin >= end)
+        return;
+
+    if (grain <= 0)
+        grain = 1;
+
+    const i32     number = (end - begin + grain - 1) / grain;
+    vector<range> ranges(number);
+    task_counter  counter;
+
+    for (i32 i = begin; i < end; i += grain)
+        ranges.emplace_back(range{ i, std::min(i + grain, end), function, parameter });
+
+    for (i32 i = 0; i + 1 < number; ++i)
+        list.add(
+          [](void* param) noexcept {
+              auto* r = reinterpret_cast<range*>(param);
+              r->function(r->first, r->last, r->parameter);
+          },
+          &ranges[i],
+          counter);
+
+    auto& last = ranges.back();
+    last.function(last.first, last.last, last.parameter);
+
+    counter.wait();
+}
+
+template<typename Function>
+inline void parallel_for(task_list& list,
+                         i32        begin,
+                         i32        end,
+                         i32        grain,
+                         Function&& f) noexcept
+{
+    using function_type = std::remove_reference_t<Function>;
+
+    parallel_for(
+      list,
+      begin,
+      end,
+      grain,
+      [](i32 first, i32 last, void* parameter) noexcept {
+          (*reinterpret_cast<function_type*>(parameter))(first, last);
+      },
+      const_cast<void*>(reinterpret_cast<const void*>(&f)));
+}
+
+inline task_graph::node::node(const node& other) noexcept
+  : function(other.function)
+  , parameter(other.parameter)
+  , graph(other.graph)
+  , successors(other.successors)
+  , predecessor_number(other.predecessor_number)
+  , remaining(other.remaining.load())
+{}
+
+inline task_graph::node& task_graph::node::operator=(
+  const node& other) noexcept
+{
+    function           = other.function;
+    parameter          = other.parameter;
+    graph              = other.graph;
+    successors         = other.successors;
+    predecessor_number = other.predecessor_number;
+    remaining          = other.remaining.load();
+
+    return *this;
+}
+
+inline status task_graph::init(i32 capacity) noexcept
+{
+    irt_return_if_fail(capacity > 0, status::vector_init_capacity_error);
+
+    m_nodes.clear();
+    m_nodes.reserve(capacity);
+
+    return status::success;
+}
+
+inline void task_graph::clear() noexcept { m_nodes.clear(); }
+
+inline bool task_graph::can_add(i32 number) const noexcept
+{
+    return m_nodes.can_alloc(number);
+}
+
+inline task_graph::node_id task_graph::add(task_function function,
+                                           void*         parameter) noexcept
+{
+    irt_assert(can_add(1));
+
+    auto& n     = m_nodes.emplace_back();
+    n.function  = function;
+    n.parameter = parameter;
+    n.graph     = this;
+
+    return m_nodes.ssize() - 1;
+}
+
+inline void task_graph::precede(node_id before, node_id after) noexcept
+{
+    irt_assert(0 <= before && before < m_nodes.ssize());
+    irt_assert(0 <= after && after < m_nodes.ssize());
+
+    m_nodes[before].successors.emplace_back(after);
+    ++m_nodes[after].predecessor_number;
+}
+
+inline void task_graph::run_node(void* parameter) noexcept
+{
+    auto* n     = reinterpret_cast<node*>(parameter);
+    auto* graph = n->graph;
+
+    n->function(n->parameter);
+
+    for (auto id : n->successors) {
+        auto& succ = graph->m_nodes[id];
+        if (succ.remaining.fetch_sub(1) == 1)
+            graph->m_list->add(&run_node, &succ, graph->m_counter);
+    }
+}
+
+inline void task_graph::submit(task_list& list) noexcept
+{
+    m_list = &list;
+
+    for (auto& n : m_nodes)
+        n.remaining = n.predecessor_number;
+
+    for (auto& n : m_nodes)
+        if (n.predecessor_number == 0)
+            list.add(&run_node, &n, m_counter);
+}
+
+inline void task_graph::wait() noexcept { m_counter.wait(); }
 
 } // namespace irt
 
@@ -0,0 +1,769 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_2021_TIMEWARP_HPP
+#define ORG_VLEPROJECT_IRRITATOR_2021_TIMEWARP_HPP
+
+#include <irritator/core.hpp>
+#include <irritator/ext.hpp>
+#include <irritator/file.hpp>
+#include <irritator/thread.hpp>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace irt {
+
+struct timewarp_parameters;
+struct timewarp_time;
+struct timewarp_message;
+struct timewarp_link;
+struct timewarp_state;
+struct timewarp_process;
+class timewarp;
+
+enum class timewarp_process_id : u64;
+
+struct timewarp_parameters
+{
+    i32 processes        = 1;
+    i32 bags_per_round   = 64; //!< optimistic bags of a process per round.
+    i32 state_period     = 8;  //!< bags between two saved states.
+    sz  message_capacity = 4096;
+};
+
+//! @brief The date of a bag and its index among the bags of this date.
+//!
+//! The messages of the bag (t, depth) are received by the bag (t, depth + 1)
+//! as in a sequential @c simulation::run.
+struct timewarp_time
+{
+    time t     = time_domain<time>::negative_infinity;
+    i32  depth = 0;
+};
+
+constexpr bool operator<(const timewarp_time& a,
+                         const timewarp_time& b) noexcept
+{
+    return a.t < b.t || (a.t == b.t && a.depth < b.depth);
+}
+
+constexpr bool operator==(const timewarp_time& a,
+                          const timewarp_time& b) noexcept
+{
+    return a.t == b.t && a.depth == b.depth;
+}
+
+//! The bag which sends the messages of date @c date.
+constexpr timewarp_time sending_bag(const timewarp_time& date) noexcept
+{
+    return { date.t, date.depth - 1 };
+}
+
+//! @brief A message between two processes or its anti-message.
+struct timewarp_message
+{
+    message       msg;
+    timewarp_time date;
+    u64           id      = 0; //!< sender process and sequence number.
+    model_id      model   = undefined<model_id>(); //!< receiver model.
+    i32           process = 0;                     //!< receiver process.
+    i8            port    = 0;
+    bool          anti    = false;
+};
+
+//! The receiver of a remote node (see @c make_remote_id).
+struct timewarp_link
+{
+    model_id model   = undefined<model_id>();
+    i32      process = 0;
+};
+
+//! A checkpoint of a process taken after the bag @c lvt.
+struct timewarp_state
+{
+    memory        mem{ 0, open_mode::write };
+    timewarp_time lvt;
+};
+
+//! @brief A logical process: a part of the models in its own simulation.
+//!
+//! The connections to the models of other processes are remote nodes, the
+//! index of the remote identifier is the index of the link.
+struct timewarp_process
+{
+    simulation                sim;
+    table<model_id, model_id> models; //!< template model to process model.
+    vector<model_id>          owned;  //!< template models of the process.
+    vector<timewarp_link>     links;
+
+    vector<timewarp_message> pending;   //!< by decreasing date.
+    vector<timewarp_message> processed; //!< by increasing date.
+    vector<timewarp_message> sent;      //!< by increasing date.
+    vector<timewarp_message> cancelled; //!< sent by a rolled back bag.
+    vector<timewarp_message> inbox;
+    vector<timewarp_message> outbox;
+
+    //! Saved states by increasing date in [0, saved[, reused buffers after.
+    std::vector<timewarp_state> states;
+    i32                         saved   = 0;
+    i32                         unsaved = 0; //!< bags since the last save.
+
+    timewarp_time lvt; //!< local virtual time: the last bag.
+    u64           sequence  = 0;
+    i64           bags      = 0; //!< including the rolled back bags.
+    i64           rollbacks = 0;
+    i32           index     = 0;
+    status        st        = status::success;
+
+    //! The date of the next bag: the next model or pending message.
+    timewarp_time next_time() const noexcept;
+
+    //! Get the process model copied from the template model @c id.
+    model* get(model_id id) noexcept;
+};
+
+//! @brief Optimistic parallel simulation of a partition of the models.
+//!
+//! @c build splits the models of the template simulation into logical
+//! processes, each process owns a simulation of its models and runs its
+//! bags without waiting for the other processes. A message received in the
+//! past of a process (a straggler) restores the last saved state before its
+//! date and cancels the messages sent since with anti-messages. A message
+//! sent again with the same content during the re-execution is not
+//! cancelled (lazy cancellation).
+//!
+//! The processes run in rounds on a @c task_list: each process runs up to
+//! @c bags_per_round bags, then the messages are exchanged until no process
+//! rolls back. The global virtual time @c gvt, the earliest next bag of the
+//! processes, can not be rolled back: the states and messages before it are
+//! freed.
+//!
+//! Observers are not supported. The models must not use external sources
+//! or structural changes which are not rolled back.
+//!
+//!     timewarp tw;
+//!     tw.init({ .processes = 8 });
+//!     tw.build(tm.task_lists[0], sim);
+//!     tw.run(tm.task_lists[0], 0, 100);
+class timewarp
+{
+public:
+    data_array<timewarp_process, timewarp_process_id> processes;
+    table<model_id, i32>                              partition;
+    table<model_id, i32>                              owners;
+    timewarp_parameters                               parameters;
+    timewarp_time                                     gvt;
+
+    //! Get the process @c index in [0, parameters.processes[.
+    timewarp_process& get(i32 index) noexcept;
+
+    //! Get the process model copied from the template model @c id.
+    model* get(model_id id) noexcept;
+
+    status init(const timewarp_parameters& params) noexcept;
+
+    //! Place the template model @c id in the process @c process. The models
+    //! without place are split in contiguous blocks.
+    void assign(model_id id, i32 process) noexcept;
+
+    //! Copy the models of each process and connect them. Processes are built
+    //! in parallel.
+    status build(task_list& list, const simulation& sim) noexcept;
+
+    //! Run all processes from @c begin until the global virtual time reaches
+    //! @c end. Returns the first process error.
+    status run(task_list& list, time begin, time end) noexcept;
+
+    //! Finalize the simulation of each process.
+    status finalize(time t) noexcept;
+
+    i64 rollbacks() const noexcept;
+
+private:
+    status clone(timewarp_process& p, const simulation& sim) noexcept;
+    status connect(timewarp_process& p, const simulation& sim) noexcept;
+
+    void   run(timewarp_process& p, time end) noexcept;
+    status run_bag(timewarp_process& p, timewarp_time date) noexcept;
+    status save(timewarp_process& p) noexcept;
+    status rollback(timewarp_process& p, timewarp_time date) noexcept;
+    void   receive(timewarp_process& p) noexcept;
+    void   flush(timewarp_process& p, timewarp_time date) noexcept;
+    void   collect(timewarp_process& p, timewarp_time date) noexcept;
+
+    bool route() noexcept;
+
+    status first_error() const noexcept;
+};
+
+/*****************************************************************************
+ *
+ * Implementation
+ *
+ ****************************************************************************/
+
+inline timewarp_time timewarp_process::next_time() const noexcept
+{
+    timewarp_time next{ time_domain<time>::infinity, 0 };
+
+    if (!sim.sched.empty()) {
+        next.t     = sim.sched.tn();
+        next.depth = next.t == lvt.t ? lvt.depth + 1 : 0;
+    }
+
+    if (!pending.empty() && pending.back().date < next)
+        next = pending.back().date;
+
+    return next;
+}
+
+inline model* timewarp_process::get(model_id id) noexcept
+{
+    if (auto* new_id = models.get(id); new_id)
+        return sim.models.try_to_get(*new_id);
+
+    return nullptr;
+}
+
+//! Insert @c m into the messages sorted by decreasing date, before the
+//! messages of the same date in the pop order if @c first is true.
+inline void insert_pending(vector<timewarp_message>& pending,
+                           const timewarp_message&   m,
+                           bool                      first) noexcept
+{
+    const auto later = [](const timewarp_message& a,
+                          const timewarp_message& b) noexcept {
+        return b.date < a.date;
+    };
+
+    const auto it = first ? std::upper_bound(
+                              pending.begin(), pending.end(), m, later)
+                          : std::lower_bound(
+                              pending.begin(), pending.end(), m, later);
+    const auto index = static_cast<i32>(it - pending.begin());
+
+    pending.emplace_back(m);
+    std::rotate(pending.begin() + index, pending.end() - 1, pending.end());
+}
+
+inline bool same_message(const timewarp_message& a,
+                         const timewarp_message& b) noexcept
+{
+    return a.date == b.date && a.process == b.process &&
+           a.model == b.model && a.port == b.port &&
+           std::equal(std::begin(a.msg.data),
+                      std::end(a.msg.data),
+                      std::begin(b.msg.data));
+}
+
+inline timewarp_process& timewarp::get(i32 index) noexcept
+{
+    auto* p = processes.try_to_get(static_cast<u32>(index));
+    irt_assert(p);
+
+    return *p;
+}
+
+inline model* timewarp::get(model_id id) noexcept
+{
+    if (auto* process = owners.get(id); process)
+        return get(*process).get(id);
+
+    return nullptr;
+}
+
+inline status timewarp::init(const timewarp_parameters& params) noexcept
+{
+    irt_return_if_fail(params.processes > 0 && params.bags_per_round > 0 &&
+                         params.state_period > 0,
+                       status::vector_init_capacity_error);
+
+    parameters = params;
+    irt_return_if_bad(processes.init(params.processes));
+
+    for (i32 i = 0; i != params.processes; ++i) {
+        auto& p = processes.alloc();
+        p.index = i;
+    }
+
+    partition.data.clear();
+    owners.data.clear();
+
+    return status::success;
+}
+
+inline void timewarp::assign(model_id id, i32 process) noexcept
+{
+    irt_assert(0 <= process && process < parameters.processes);
+
+    partition.set(id, process);
+}
+
+inline status timewarp::clone(timewarp_process& p,
+                              const simulation& sim) noexcept
+{
+    const auto capacity = static_cast<sz>(std::max(p.owned.ssize(), 1));
+
+    p.sim.clear();
+    irt_return_if_bad(p.sim.init(capacity, parameters.message_capacity));
+
+    p.models.data.clear();
+    p.models.data.reserve(std::max(p.owned.ssize(), 1));
+    p.links.clear();
+
+    for (const auto id : p.owned) {
+        auto& new_mdl = p.sim.clone(sim.models.get(id));
+        p.models.data.emplace_back(id, p.sim.models.get_id(new_mdl));
+    }
+
+    p.models.sort();
+
+    return status::success;
+}
+
+inline status timewarp::connect(timewarp_process& p,
+                                const simulation& sim) noexcept
+{
+    i32 connections = 0;
+
+    for (const auto id : p.owned) {
+        const auto& mdl     = sim.models.get(id);
+        auto&       new_src = p.sim.models.get(*p.models.get(id));
+
+        irt_return_if_bad(dispatch(
+          mdl, [&]<typename Dynamics>(const Dynamics& dyn) noexcept -> status {
+              if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+                  for (int i = 0, e = length(dyn.y); i != e; ++i) {
+                      for (const auto& elem : get_node(sim, dyn.y[i])) {
+                          auto* owner = owners.get(elem.model);
+                          if (!owner)
+                              continue;
+
+                          irt_return_if_fail(
+                            p.sim.can_connect(1),
+                            status::simulation_not_enough_connection);
+
+                          ++connections;
+                          auto& dst = get(*owner);
+                          auto* dst_id = dst.models.get(elem.model);
+                          irt_assert(dst_id);
+
+                          if (*owner == p.index) {
+                              auto& new_dst = p.sim.models.get(*dst_id);
+                              irt_return_if_bad(p.sim.connect(
+                                new_src, i, new_dst, elem.port_index));
+                          } else {
+                              const auto link = p.links.ssize();
+                              p.links.emplace_back(
+                                timewarp_link{ *dst_id, *owner });
+                              irt_return_if_bad(
+                                global_connect(p.sim,
+                                               new_src,
+                                               i,
+                                               make_remote_id(link),
+                                               elem.port_index));
+                          }
+                      }
+                  }
+              }
+
+              return status::success;
+          }));
+    }
+
+    // A bag emits at most one message per connection.
+    p.sim.emitting_output_ports.reserve(std::max(connections, 1));
+
+    return status::success;
+}
+
+inline status timewarp::build(task_list& list, const simulation& sim) noexcept
+{
+    partition.sort();
+    owners.data.clear();
+    owners.data.reserve(std::max(static_cast<i32>(sim.models.size()), 1));
+
+    timewarp_process* p = nullptr;
+    while (processes.next(p))
+        p->owned.clear();
+
+    const auto number = static_cast<i64>(sim.models.size());
+    i64        index  = 0;
+
+    model* mdl = nullptr;
+    while (sim.models.next(mdl)) {
+        const auto  id     = sim.models.get_id(*mdl);
+        const auto* place  = partition.get(id);
+        const auto process = place ? *place
+                                   : static_cast<i32>(
+                                       index * parameters.processes / number);
+
+        owners.data.emplace_back(id, process);
+        get(process).owned.emplace_back(id);
+        ++index;
+    }
+
+    owners.sort();
+
+    // The connections need the model identifiers of all the processes.
+    parallel_for(list, 0, parameters.processes, 1, [&](i32 first, i32 last) {
+        for (i32 i = first; i < last; ++i)
+            get(i).st = clone(get(i), sim);
+    });
+
+    irt_return_if_bad(first_error());
+
+    parallel_for(list, 0, parameters.processes, 1, [&](i32 first, i32 last) {
+        for (i32 i = first; i < last; ++i)
+            get(i).st = connect(get(i), sim);
+    });
+
+    return first_error();
+}
+
+inline status timewarp::save(timewarp_process& p) noexcept
+{
+    if (p.saved == static_cast<i32>(p.states.size())) {
+        try {
+            p.states.emplace_back();
+        } catch (const std::bad_alloc& /*e*/) {
+            return status::vector_not_enough_memory;
+        }
+    }
+
+    auto& state = p.states[static_cast<sz>(p.saved)];
+    state.mem.rewind();
+    irt_return_if_bad(p.sim.checkpoint(state.mem, p.lvt.t));
+
+    state.lvt = p.lvt;
+    ++p.saved;
+    p.unsaved = 0;
+
+    return status::success;
+}
+
+inline status timewarp::rollback(timewarp_process& p,
+                                 timewarp_time     date) noexcept
+{
+    irt_assert(p.saved > 0);
+
+    // The last state older than @c date.
+    i32 i = p.saved - 1;
+    while (i > 0 && !(p.states[static_cast<sz>(i)].lvt < date))
+        --i;
+
+    auto& state = p.states[static_cast<sz>(i)];
+    time  t;
+    state.mem.rewind();
+    irt_return_if_bad(p.sim.restore(state.mem, t));
+
+    p.lvt     = state.lvt;
+    p.saved   = i + 1;
+    p.unsaved = 0;
+    ++p.rollbacks;
+
+    while (!p.processed.empty() && state.lvt < p.processed.back().date) {
+        insert_pending(p.pending, p.processed.back(), true);
+        p.processed.pop_back();
+    }
+
+    // Sent by a rolled back bag: cancelled if the re-execution does not
+    // send them again.
+    while (!p.sent.empty() && state.lvt < sending_bag(p.sent.back().date)) {
+        p.cancelled.emplace_back(p.sent.back());
+        p.sent.pop_back();
+    }
+
+    return status::success;
+}
+
+inline void timewarp::flush(timewarp_process& p, timewarp_time date) noexcept
+{
+    for (i32 i = p.cancelled.ssize() - 1; i >= 0; --i) {
+        if (date < p.cancelled[i].date)
+            continue;
+
+        auto& anti = p.outbox.emplace_back(p.cancelled[i]);
+        anti.anti  = true;
+        p.cancelled.swap_pop_back(i);
+    }
+}
+
+inline status timewarp::run_bag(timewarp_process& p,
+                                timewarp_time     date) noexcept
+{
+    flush(p, date);
+
+    if (p.saved == 0 || p.unsaved >= parameters.state_period)
+        irt_return_if_bad(save(p));
+
+    while (!p.pending.empty() && p.pending.back().date == date) {
+        const auto& m = p.pending.back();
+
+        if (auto* mdl = p.sim.models.try_to_get(m.model); mdl) {
+            irt_return_if_bad(
+              dispatch(*mdl, [&p, &m]<typename Dynamics>(Dynamics& dyn) {
+                  if constexpr (is_detected_v<has_input_port_t, Dynamics>)
+                      return push_message(p.sim, dyn, m.port, m.msg);
+                  else
+                      return status::success;
+              }));
+
+            p.sim.sched.update(*mdl, date.t);
+        }
+
+        p.processed.emplace_back(m);
+        p.pending.pop_back();
+    }
+
+    if (!p.sim.sched.empty() && p.sim.sched.tn() == date.t)
+        irt_return_if_bad(p.sim.run_bag(date.t));
+
+    p.lvt = date;
+    ++p.bags;
+    ++p.unsaved;
+
+    for (const auto& out : p.sim.emitting_output_ports) {
+        if (!is_remote(out.model))
+            continue;
+
+        const auto  index = static_cast<i32>(get_remote_index(out.model));
+        const auto& link  = p.links[index];
+
+        timewarp_message m;
+        m.msg     = out.msg;
+        m.date    = { date.t, date.depth + 1 };
+        m.model   = link.model;
+        m.process = link.process;
+        m.port    = out.port;
+
+        const auto it = std::find_if(
+          p.cancelled.begin(),
+          p.cancelled.end(),
+          [&m](const auto& old) noexcept { return same_message(old, m); });
+
+        if (it != p.cancelled.end()) {
+            p.sent.emplace_back(*it);
+            p.cancelled.swap_pop_back(
+              static_cast<i32>(it - p.cancelled.begin()));
+        } else {
+            m.id = (static_cast<u64>(p.index) << 40) | ++p.sequence;
+            p.sent.emplace_back(m);
+            p.outbox.emplace_back(m);
+        }
+    }
+
+    return status::success;
+}
+
+inline void timewarp::run(timewarp_process& p, time end) noexcept
+{
+    for (i32 i = 0; i != parameters.bags_per_round; ++i) {
+        const auto date = p.next_time();
+        if (!(date.t < end))
+            break;
+
+        if (p.st = run_bag(p, date); is_bad(p.st))
+            return;
+
+        // The first bag of the process of the global virtual time is never
+        // rolled back: save it to progress at each round.
+        if (i == 0 && p.unsaved > 0)
+            if (p.st = save(p); is_bad(p.st))
+                return;
+    }
+
+    flush(p, p.next_time());
+}
+
+inline void timewarp::receive(timewarp_process& p) noexcept
+{
+    const auto same_id = [](const u64 id) noexcept {
+        return [id](const timewarp_message& m) noexcept { return m.id == id; };
+    };
+
+    for (const auto& m : p.inbox) {
+        if (is_bad(p.st))
+            break;
+
+        if (!m.anti) {
+            if (!(p.lvt < m.date))
+                p.st = rollback(p, m.date);
+
+            insert_pending(p.pending, m, false);
+            continue;
+        }
+
+        auto it =
+          std::find_if(p.pending.begin(), p.pending.end(), same_id(m.id));
+
+        if (it == p.pending.end()) {
+            const auto done = std::find_if(
+              p.processed.begin(), p.processed.end(), same_id(m.id));
+            if (done == p.processed.end())
+                continue;
+
+            if (p.st = rollback(p, done->date); is_bad(p.st))
+                break;
+
+            it = std::find_if(
+              p.pending.begin(), p.pending.end(), same_id(m.id));
+        }
+
+        if (it != p.pending.end())
+            p.pending.erase(it);
+    }
+
+    p.inbox.clear();
+    flush(p, p.next_time());
+}
+
+inline void timewarp::collect(timewarp_process& p, timewarp_time date) noexcept
+{
+    // Keep the last state before @c date, the first rollback target.
+    i32 keep = 0;
+    while (keep + 1 < p.saved &&
+           p.states[static_cast<sz>(keep + 1)].lvt < date)
+        ++keep;
+
+    if (keep == 0)
+        return;
+
+    std::rotate(p.states.begin(),
+                p.states.begin() + keep,
+                p.states.begin() + p.saved);
+    p.saved -= keep;
+
+    const auto oldest = p.states.front().lvt;
+
+    const auto processed = std::find_if(
+      p.processed.begin(), p.processed.end(), [&oldest](const auto& m) {
+          return oldest < m.date;
+      });
+    if (processed != p.processed.begin())
+        p.processed.erase(p.processed.begin(), processed);
+
+    const auto sent =
+      std::find_if(p.sent.begin(), p.sent.end(), [&oldest](const auto& m) {
+          return oldest < sending_bag(m.date);
+      });
+    if (sent != p.sent.begin())
+        p.sent.erase(p.sent.begin(), sent);
+}
+
+inline bool timewarp::route() noexcept
+{
+    bool routed = false;
+
+    timewarp_process* p = nullptr;
+    while (processes.next(p)) {
+        for (const auto& m : p->outbox)
+            get(m.process).inbox.emplace_back(m);
+
+        routed = routed || !p->outbox.empty();
+        p->outbox.clear();
+    }
+
+    return routed;
+}
+
+inline status timewarp::run(task_list& list, time begin, time end) noexcept
+{
+    parallel_for(list, 0, parameters.processes, 1, [&](i32 first, i32 last) {
+        for (i32 i = first; i < last; ++i) {
+            auto& p = get(i);
+
+            p.pending.clear();
+            p.processed.clear();
+            p.sent.clear();
+            p.cancelled.clear();
+            p.inbox.clear();
+            p.outbox.clear();
+            p.saved     = 0;
+            p.unsaved   = 0;
+            p.lvt       = timewarp_time{};
+            p.sequence  = 0;
+            p.bags      = 0;
+            p.rollbacks = 0;
+            p.st        = p.sim.initialize(begin);
+        }
+    });
+
+    irt_return_if_bad(first_error());
+
+    for (;;) {
+        parallel_for(
+          list, 0, parameters.processes, 1, [&](i32 first, i32 last) {
+              for (i32 i = first; i < last; ++i)
+                  run(get(i), end);
+          });
+
+        irt_return_if_bad(first_error());
+
+        // Exchange the messages until no process rolls back.
+        while (route()) {
+            parallel_for(
+              list, 0, parameters.processes, 1, [&](i32 first, i32 last) {
+                  for (i32 i = first; i < last; ++i)
+                      receive(get(i));
+              });
+
+            irt_return_if_bad(first_error());
+        }
+
+        gvt = timewarp_time{ time_domain<time>::infinity, 0 };
+
+        timewarp_process* p = nullptr;
+        while (processes.next(p))
+            if (const auto next = p->next_time(); next < gvt)
+                gvt = next;
+
+        if (!(gvt.t < end))
+            break;
+
+        parallel_for(
+          list, 0, parameters.processes, 1, [&](i32 first, i32 last) {
+              for (i32 i = first; i < last; ++i)
+                  collect(get(i), gvt);
+          });
+    }
+
+    return status::success;
+}
+
+inline status timewarp::finalize(time t) noexcept
+{
+    timewarp_process* p = nullptr;
+    while (processes.next(p))
+        irt_return_if_bad(p->sim.finalize(t));
+
+    return status::success;
+}
+
+inline i64 timewarp::rollbacks() const noexcept
+{
+    i64 ret = 0;
+
+    timewarp_process* p = nullptr;
+    while (processes.next(p))
+        ret += p->rollbacks;
+
+    return ret;
+}
+
+inline status timewarp::first_error() const noexcept
+{
+    timewarp_process* p = nullptr;
+    while (processes.next(p))
+        if (is_bad(p->st))
+            return p->st;
+
+    return status::success;
+}
+
+} // namespace irt
+
+#endif
@@ -0,0 +1,275 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_2021_TRACE_HPP
+#define ORG_VLEPROJECT_IRRITATOR_2021_TRACE_HPP
+
+#include <irritator/core.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+namespace irt {
+
+//! @brief A complete event (a span) of the trace.
+struct trace_event
+{
+    const char* name     = nullptr;
+    u64         begin    = 0; //!< nanoseconds since the @c tracer::init.
+    u64         duration = 0; //!< nanoseconds.
+    time        t        = 0; //!< simulated time.
+    i32         bag      = 0; //!< bag size or -1 if undefined.
+};
+
+//! @brief The events recorded by a thread.
+//!
+//! Only the owner thread writes the buffer: no lock is required. When the
+//! buffer is full, new events are dropped and counted.
+struct trace_buffer
+{
+    vector<trace_event> events;
+    i64                 dropped = 0;
+    i32                 tid     = 0;
+
+    //! Timestamps of the current @c simulation::run phases.
+    u64 stamps[3] = {};
+
+    void push(const char* name, u64 begin, u64 end, time t, i32 bag) noexcept
+    {
+        if (events.full()) {
+            ++dropped;
+        } else {
+            events.emplace_back(name, begin, end - begin, t, bag);
+        }
+    }
+};
+
+//! Thread local cache of the buffer of the last used tracer.
+struct trace_local_cache
+{
+    u64           id     = 0;
+    trace_buffer* buffer = nullptr;
+};
+
+inline thread_local trace_local_cache trace_local;
+inline std::atomic<u64>               trace_next_id{ 1 };
+
+/**
+ * @brief Records the @c simulation::run phases and user spans into per
+ * thread buffers and writes them into a Chrome trace_event JSON file (also
+ * read by Perfetto).
+ *
+ * Each thread which records an event takes the next free buffer. A thread
+ * records into one tracer at a time. Write the file when the recording
+ * threads are stopped.
+ */
+class tracer
+{
+public:
+    tracer() noexcept = default;
+    tracer(const tracer&) = delete;
+    tracer& operator=(const tracer&) = delete;
+
+    //! Allocate @c threads buffers of @c events_per_thread events.
+    status init(i32 threads, i32 events_per_thread) noexcept
+    {
+        irt_return_if_fail(threads > 0 && events_per_thread > 0,
+                           status::vector_init_capacity_error);
+
+        m_buffers.clear();
+        m_buffers.resize(threads);
+        irt_return_if_fail(m_buffers.ssize() == threads,
+                           status::vector_not_enough_memory);
+
+        for (i32 i = 0; i != threads; ++i) {
+            m_buffers[i].events.reserve(events_per_thread);
+            irt_return_if_fail(m_buffers[i].events.capacity() ==
+                                 static_cast<sz>(events_per_thread),
+                               status::vector_not_enough_memory);
+            m_buffers[i].tid = i + 1;
+        }
+
+        m_used.store(0, std::memory_order_relaxed);
+        m_id     = trace_next_id.fetch_add(1, std::memory_order_relaxed);
+        m_origin = std::chrono::steady_clock::now();
+
+        return status::success;
+    }
+
+    //! Nanoseconds since @c init.
+    u64 now() const noexcept
+    {
+        return static_cast<u64>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_origin)
+            .count());
+    }
+
+    //! The buffer of the calling thread or nullptr if all the buffers are
+    //! used by other threads.
+    trace_buffer* local() noexcept
+    {
+        if (trace_local.id == m_id)
+            return trace_local.buffer;
+
+        const auto slot = m_used.fetch_add(1, std::memory_order_relaxed);
+
+        trace_local.id     = m_id;
+        trace_local.buffer = slot < m_buffers.ssize() ? &m_buffers[slot]
+                                                      : nullptr;
+
+        return trace_local.buffer;
+    }
+
+    //! Record a span from @c begin to @c end (see @c now) in the calling
+    //! thread buffer.
+    void record(const char* name,
+                u64         begin,
+                u64         end,
+                time        t   = 0,
+                i32         bag = -1) noexcept
+    {
+        if (auto* buffer = local(); buffer)
+            buffer->push(name, begin, end, t, bag);
+    }
+
+    //! Record the phases of each @c run of the simulation.
+    void attach(simulation& sim) noexcept
+    {
+        sim.trace_fn        = &tracer::on_run;
+        sim.trace_user_data = this;
+    }
+
+    void detach(simulation& sim) noexcept
+    {
+        sim.trace_fn        = nullptr;
+        sim.trace_user_data = nullptr;
+    }
+
+    i64 dropped() const noexcept
+    {
+        i64 ret = 0;
+        for (const auto& buffer : m_buffers)
+            ret += buffer.dropped;
+
+        return ret;
+    }
+
+    const vector<trace_buffer>& buffers() const noexcept { return m_buffers; }
+
+    //! Write the Chrome trace_event JSON file.
+    status write(std::ostream& os) const noexcept;
+
+private:
+    static void on_run(void*           user_data,
+                       const run_phase phase,
+                       const time      t,
+                       const i32       bag) noexcept
+    {
+        auto* tr     = reinterpret_cast<tracer*>(user_data);
+        auto* buffer = tr->local();
+        if (!buffer)
+            return;
+
+        const auto now = tr->now();
+
+        switch (phase) {
+        case run_phase::start:
+            buffer->stamps[0] = now;
+            break;
+        case run_phase::popped:
+            buffer->stamps[1] = now;
+            break;
+        case run_phase::transitions:
+            buffer->stamps[2] = now;
+            break;
+        case run_phase::deliveries:
+            buffer->push("run", buffer->stamps[0], now, t, bag);
+            buffer->push("pop", buffer->stamps[0], buffer->stamps[1], t, bag);
+            buffer->push(
+              "transition", buffer->stamps[1], buffer->stamps[2], t, bag);
+            buffer->push("delivery", buffer->stamps[2], now, t, bag);
+            break;
+        }
+    }
+
+    vector<trace_buffer>                  m_buffers;
+    std::atomic<i32>                      m_used{ 0 };
+    u64                                   m_id = 0;
+    std::chrono::steady_clock::time_point m_origin;
+};
+
+//! @brief Record a span from the construction to the destruction.
+class trace_scope
+{
+public:
+    trace_scope(tracer& tr, const char* name) noexcept
+      : m_tracer(tr)
+      , m_name(name)
+      , m_begin(tr.now())
+    {}
+
+    ~trace_scope() noexcept { m_tracer.record(m_name, m_begin, m_tracer.now()); }
+
+private:
+    tracer&     m_tracer;
+    const char* m_name;
+    u64         m_begin;
+};
+
+inline status tracer::write(std::ostream& os) const noexcept
+{
+    // Chrome expects microseconds: write the nanoseconds as a fixed point.
+    const auto write_us = [&os](u64 ns) noexcept {
+        const char digits[] = { static_cast<char>('0' + ns % 1000 / 100),
+                                static_cast<char>('0' + ns % 100 / 10),
+                                static_cast<char>('0' + ns % 10),
+                                '\0' };
+        os << ns / 1000 << '.' << digits;
+    };
+
+    const auto precision =
+      os.precision(std::numeric_limits<time>::max_digits10);
+
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool first = true;
+    for (const auto& buffer : m_buffers) {
+        if (buffer.events.empty() && buffer.dropped == 0)
+            continue;
+
+        os << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\","
+           << "\"pid\":1,\"tid\":" << buffer.tid
+           << ",\"args\":{\"name\":\"thread " << buffer.tid
+           << "\",\"dropped\":" << buffer.dropped << "}}";
+        first = false;
+
+        for (const auto& ev : buffer.events) {
+            os << ",\n{\"name\":\"" << ev.name
+               << "\",\"cat\":\"irritator\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+               << buffer.tid << ",\"ts\":";
+            write_us(ev.begin);
+            os << ",\"dur\":";
+            write_us(ev.duration);
+            os << ",\"args\":{\"t\":";
+
+            if (time_domain<time>::is_infinity(ev.t))
+                os << "\"inf\"";
+            else
+                os << ev.t;
+
+            os << ",\"bag\":" << ev.bag << "}}";
+        }
+    }
+
+    os << "\n]}\n";
+    os.precision(precision);
+
+    return os.good() ? status::success : status::io_file_format_error;
+}
+
+} // namespace irt
+
+#endif
@@ -0,0 +1,398 @@
+// Copyright (c) 2021 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/distributed.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace irt {
+
+static status socket_send(void*       user_data,
+                          i32         to,
+                          const void* data,
+                          sz          size) noexcept
+{
+    return reinterpret_cast<unix_socket_transport*>(user_data)->send(
+      to, data, size);
+}
+
+static status socket_flush(void* user_data) noexcept
+{
+    return reinterpret_cast<unix_socket_transport*>(user_data)->flush();
+}
+
+static status socket_receive(void* user_data,
+                             i32   from,
+                             void* data,
+                             sz    size) noexcept
+{
+    return reinterpret_cast<unix_socket_transport*>(user_data)->receive(
+      from, data, size);
+}
+
+unix_socket_transport::~unix_socket_transport() noexcept
+{
+    close();
+}
+
+distributed_transport unix_socket_transport::get() noexcept
+{
+    return distributed_transport{ .user_data = this,
+                                  .send      = socket_send,
+                                  .flush     = socket_flush,
+                                  .receive   = socket_receive };
+}
+
+#if defined(_WIN32)
+
+status unix_socket_transport::open(i32 /*rank*/,
+                                   i32 /*processes*/,
+                                   const char* /*prefix*/,
+                                   int /*timeout*/) noexcept
+{
+    return status::distributed_transport_error;
+}
+
+void unix_socket_transport::close() noexcept
+{
+    peers.clear();
+}
+
+status unix_socket_transport::pump() noexcept
+{
+    return status::distributed_transport_error;
+}
+
+#else
+
+static bool make_address(sockaddr_un& addr, const std::string& path) noexcept
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(addr.sun_path))
+        return false;
+
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static bool write_all(int fd, const void* data, sz size) noexcept
+{
+    const auto* ptr = reinterpret_cast<const u8*>(data);
+
+    while (size > 0) {
+        const auto ret = ::write(fd, ptr, size);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+
+        ptr += ret;
+        size -= static_cast<sz>(ret);
+    }
+
+    return true;
+}
+
+static bool read_all(int fd, void* data, sz size) noexcept
+{
+    auto* ptr = reinterpret_cast<u8*>(data);
+
+    while (size > 0) {
+        const auto ret = ::read(fd, ptr, size);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+
+        ptr += ret;
+        size -= static_cast<sz>(ret);
+    }
+
+    return true;
+}
+
+status unix_socket_transport::open(i32         rank_,
+                                   i32         processes,
+                                   const char* prefix,
+                                   int         timeout) noexcept
+{
+    irt_return_if_fail(0 <= rank_ && rank_ < processes &&
+                         processes <= max_processes && prefix,
+                       status::distributed_transport_error);
+
+    close();
+    rank = rank_;
+
+    try {
+        peers.resize(static_cast<sz>(processes));
+    } catch (const std::bad_alloc& /*e*/) {
+        return status::io_not_enough_memory;
+    }
+
+    const auto path = [prefix](i32 index) {
+        return std::string(prefix) + '.' + std::to_string(index);
+    };
+
+    sockaddr_un addr;
+    auto*       address  = reinterpret_cast<sockaddr*>(&addr);
+    int         listener = -1;
+
+    // The processes of higher rank connect to this one.
+    if (rank + 1 < processes) {
+        const auto name = path(rank);
+        ::unlink(name.c_str());
+
+        listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 || !make_address(addr, name) ||
+            ::bind(listener, address, sizeof(addr)) < 0 ||
+            ::listen(listener, processes) < 0) {
+            if (listener >= 0)
+                ::close(listener);
+            irt_bad_return(status::distributed_transport_error);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    status     ret   = status::success;
+
+    const auto expired = [start, timeout]() noexcept {
+        return std::chrono::steady_clock::now() - start >
+               std::chrono::milliseconds(timeout);
+    };
+
+    // Wait for the processes of lower rank to listen.
+    for (i32 i = 0; i != rank && is_success(ret); ++i) {
+        int fd = -1;
+
+        for (;;) {
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || !make_address(addr, path(i))) {
+                ret = status::distributed_transport_error;
+                break;
+            }
+
+            if (::connect(fd, address, sizeof(addr)) == 0)
+                break;
+
+            ::close(fd);
+            fd = -1;
+
+            if (expired()) {
+                ret = status::distributed_transport_error;
+                break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        if (fd >= 0) {
+            peers[static_cast<sz>(i)].fd = fd;
+            if (!write_all(fd, &rank, sizeof(rank)))
+                ret = status::distributed_transport_error;
+        }
+    }
+
+    for (i32 i = rank + 1; i < processes && is_success(ret); ++i) {
+        const auto elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+        const auto remaining = std::max<i64>(timeout - elapsed, 0);
+
+        pollfd pfd{ listener, POLLIN, 0 };
+        i32    other = -1;
+        int    fd    = -1;
+        if (::poll(&pfd, 1, static_cast<int>(remaining)) <= 0 ||
+            (fd = ::accept(listener, nullptr, nullptr)) < 0 ||
+            !read_all(fd, &other, sizeof(other)) || other <= rank ||
+            other >= processes || peers[static_cast<sz>(other)].fd >= 0) {
+            if (fd >= 0)
+                ::close(fd);
+            ret = status::distributed_transport_error;
+            break;
+        }
+
+        peers[static_cast<sz>(other)].fd = fd;
+    }
+
+    if (listener >= 0) {
+        ::close(listener);
+        ::unlink(path(rank).c_str());
+    }
+
+    if (is_bad(ret)) {
+        close();
+        irt_bad_return(ret);
+    }
+
+    for (auto& p : peers)
+        if (p.fd >= 0)
+            ::fcntl(p.fd, F_SETFL, ::fcntl(p.fd, F_GETFL) | O_NONBLOCK);
+
+    return status::success;
+}
+
+void unix_socket_transport::close() noexcept
+{
+    for (auto& p : peers)
+        if (p.fd >= 0)
+            ::close(p.fd);
+
+    peers.clear();
+}
+
+//! Wait until a channel is ready, then write the queued bytes and read the
+//! available bytes of all the channels.
+status unix_socket_transport::pump() noexcept
+{
+    pollfd fds[max_processes];
+    i32    index[max_processes];
+    int    number = 0;
+
+    for (i32 i = 0, e = static_cast<i32>(peers.size()); i != e; ++i) {
+        auto& p = peers[static_cast<sz>(i)];
+        if (p.fd < 0 || p.closed)
+            continue;
+
+        fds[number].fd      = p.fd;
+        fds[number].events  = POLLIN;
+        fds[number].revents = 0;
+        if (p.out_pos < p.out.size())
+            fds[number].events |= POLLOUT;
+        index[number++] = i;
+    }
+
+    if (::poll(fds, static_cast<nfds_t>(number), -1) < 0)
+        return errno == EINTR ? status::success
+                              : status::distributed_transport_error;
+
+    u8 buffer[65536];
+
+    for (int i = 0; i != number; ++i) {
+        auto& p = peers[static_cast<sz>(index[i])];
+
+        if (fds[i].revents & POLLOUT) {
+            const auto ret = ::send(p.fd,
+                                    p.out.data() + p.out_pos,
+                                    p.out.size() - p.out_pos,
+                                    MSG_NOSIGNAL);
+            if (ret < 0 && errno != EAGAIN && errno != EINTR)
+                irt_bad_return(status::distributed_transport_error);
+
+            if (ret > 0)
+                p.out_pos += static_cast<sz>(ret);
+
+            if (p.out_pos == p.out.size()) {
+                p.out.clear();
+                p.out_pos = 0;
+            }
+        }
+
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+            // A process closes its channels when its run ends: it is an
+            // error only if the bytes of this process are still awaited.
+            const auto ret = ::read(p.fd, buffer, sizeof(buffer));
+            if (ret == 0)
+                p.closed = true;
+            else if (ret < 0 && errno != EAGAIN && errno != EINTR)
+                irt_bad_return(status::distributed_transport_error);
+
+            if (ret > 0) {
+                try {
+                    p.in.insert(p.in.end(), buffer, buffer + ret);
+                } catch (const std::bad_alloc& /*e*/) {
+                    return status::io_not_enough_memory;
+                }
+            }
+        }
+    }
+
+    return status::success;
+}
+
+#endif
+
+status unix_socket_transport::send(i32 to, const void* data, sz size) noexcept
+{
+    irt_return_if_fail(0 <= to && to < static_cast<i32>(peers.size()) &&
+                         peers[static_cast<sz>(to)].fd >= 0,
+                       status::distributed_transport_error);
+
+    auto&       p   = peers[static_cast<sz>(to)];
+    const auto* ptr = reinterpret_cast<const u8*>(data);
+
+    try {
+        p.out.insert(p.out.end(), ptr, ptr + size);
+    } catch (const std::bad_alloc& /*e*/) {
+        return status::io_not_enough_memory;
+    }
+
+    return status::success;
+}
+
+status unix_socket_transport::flush() noexcept
+{
+    for (;;) {
+        bool queued = false;
+        for (const auto& p : peers) {
+            if (p.out_pos < p.out.size()) {
+                irt_return_if_fail(!p.closed,
+                                   status::distributed_transport_error);
+                queued = true;
+            }
+        }
+
+        if (!queued)
+            return status::success;
+
+        irt_return_if_bad(pump());
+    }
+}
+
+status unix_socket_transport::receive(i32 from, void* data, sz size) noexcept
+{
+    irt_return_if_fail(0 <= from && from < static_cast<i32>(peers.size()) &&
+                         peers[static_cast<sz>(from)].fd >= 0,
+                       status::distributed_transport_error);
+
+    auto& p = peers[static_cast<sz>(from)];
+
+    while (p.in.size() - p.in_pos < size) {
+        irt_return_if_fail(!p.closed, status::distributed_transport_error);
+        irt_return_if_bad(pump());
+    }
+
+    std::memcpy(data, p.in.data() + p.in_pos, size);
+    p.in_pos += size;
+
+    // Keep the buffer small: the consumed bytes are dropped when half of
+    // the buffer is read.
+    if (p.in_pos == p.in.size()) {
+        p.in.clear();
+        p.in_pos = 0;
+    } else if (p.in_pos > p.in.size() / 2) {
+        p.in.erase(p.in.begin(), p.in.begin() + static_cast<long>(p.in_pos));
+        p.in_pos = 0;
+    }
+
+    return status::success;
+}
+
+} // namespace irt
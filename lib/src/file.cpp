@@ -8,6 +8,21 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace irt {
 
@@ -301,36 +316,144 @@ bool write_to_file(File& f, const double value) noexcept
     }
 }
 
-file::file(const char* filename, const open_mode node) noexcept
+//! Map the @c length bytes of the file into memory.
+//! @return nullptr if failure.
+static const u8* map_file(std::FILE* f, i64 length) noexcept
+{
+#if defined(_WIN32)
+    auto* handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(f)));
+    if (handle == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    auto* mapping =
+      ::CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return nullptr;
+
+    // The view keeps a reference on the mapping object.
+    auto* view = ::MapViewOfFile(
+      mapping, FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(length));
+    ::CloseHandle(mapping);
+
+    return reinterpret_cast<const u8*>(view);
+#else
+    auto* view = ::mmap(nullptr,
+                        static_cast<size_t>(length),
+                        PROT_READ,
+                        MAP_PRIVATE,
+                        ::fileno(f),
+                        0);
+
+    return view == MAP_FAILED ? nullptr : reinterpret_cast<const u8*>(view);
+#endif
+}
+
+static void unmap_file(const u8* data, i64 length) noexcept
+{
+#if defined(_WIN32)
+    (void)length;
+    ::UnmapViewOfFile(data);
+#else
+    ::munmap(const_cast<u8*>(data), static_cast<size_t>(length));
+#endif
+}
+
+file::file(const char* filename, const open_mode mode_) noexcept
+  : mode(mode_)
 {
     file_handle = to_void(std::fopen(filename,
-                                     node == open_mode::read    ? "rb"
-                                     : node == open_mode::write ? "wb"
+                                     mode == open_mode::read ||
+                                         mode == open_mode::map
+                                       ? "rb"
+                                     : mode == open_mode::write ? "wb"
                                                                 : "ab"));
+
+    if (!file_handle)
+        return;
+
+    if (mode == open_mode::map) {
+        std::fseek(to_handle(file_handle), 0, SEEK_END);
+        map_size = std::ftell(to_handle(file_handle));
+        std::rewind(to_handle(file_handle));
+
+        if (map_size > 0) {
+            map_data = map_file(to_handle(file_handle), map_size);
+            if (!map_data) {
+                map_size = 0;
+                close();
+            }
+        }
+    } else {
+        // Without memory for the buffer, reads and writes are direct.
+        cache.resize(buffer_size);
+        if (cache.ssize() != buffer_size)
+            cache.clear();
+    }
 }
 
 file::file(file&& other) noexcept
   : file_handle(other.file_handle)
+  , mode(other.mode)
+  , cache(std::move(other.cache))
+  , cache_pos(other.cache_pos)
+  , cache_end(other.cache_end)
+  , map_data(other.map_data)
+  , map_size(other.map_size)
+  , map_pos(other.map_pos)
 {
     other.file_handle = nullptr;
+    other.cache_pos   = 0;
+    other.cache_end   = 0;
+    other.map_data    = nullptr;
+    other.map_size    = 0;
+    other.map_pos     = 0;
 }
 
 file& file::operator=(file&& other) noexcept
 {
-    if (file_handle)
-        std::fclose(to_handle(file_handle));
-
-    file_handle       = other.file_handle;
-    other.file_handle = nullptr;
+    if (this != &other) {
+        close();
+
+        file_handle = other.file_handle;
+        mode        = other.mode;
+        cache       = std::move(other.cache);
+        cache_pos   = other.cache_pos;
+        cache_end   = other.cache_end;
+        map_data    = other.map_data;
+        map_size    = other.map_size;
+        map_pos     = other.map_pos;
+
+        other.file_handle = nullptr;
+        other.cache_pos   = 0;
+        other.cache_end   = 0;
+        other.map_data    = nullptr;
+        other.map_size    = 0;
+        other.map_pos     = 0;
+    }
 
     return *this;
 }
 
-file::~file() noexcept
+file::~file() noexcept { close(); }
+
+void file::close() noexcept
 {
+    if (map_data) {
+        unmap_file(map_data, map_size);
+        map_data = nullptr;
+    }
+
+    map_size = 0;
+    map_pos  = 0;
+
     if (file_handle) {
+        flush_cache();
         std::fclose(to_handle(file_handle));
+        file_handle = nullptr;
     }
+
+    cache_pos = 0;
+    cache_end = 0;
 }
 
 bool file::is_open() const noexcept { return file_handle != nullptr; }
@@ -339,12 +462,21 @@ i64 file::length() const noexcept
 {
     irt_assert(file_handle);
 
+    if (mode == open_mode::map)
+        return map_size;
+
     const auto prev = std::ftell(to_handle(file_handle));
     std::fseek(to_handle(file_handle), 0, SEEK_END);
 
     const auto size = std::ftell(to_handle(file_handle));
     std::fseek(to_handle(file_handle), prev, SEEK_SET);
 
+    // The bytes of the write buffer are not yet in the file.
+    if (mode == open_mode::append)
+        return size + cache_pos;
+    if (mode == open_mode::write)
+        return std::max(static_cast<i64>(size), prev + cache_pos);
+
     return size;
 }
 
@@ -352,24 +484,69 @@ i64 file::tell() const noexcept
 {
     irt_assert(file_handle);
 
-    return std::ftell(to_handle(file_handle));
+    switch (mode) {
+    case open_mode::map:
+        return map_pos;
+    case open_mode::read:
+        return std::ftell(to_handle(file_handle)) - (cache_end - cache_pos);
+    case open_mode::write:
+        return std::ftell(to_handle(file_handle)) + cache_pos;
+    case open_mode::append:
+        return length();
+    }
+
+    irt_unreachable();
 }
 
-void file::flush() const noexcept
+bool file::flush_cache() noexcept
+{
+    if (mode == open_mode::read || mode == open_mode::map) {
+        // Forget the read-ahead bytes: move the file position back.
+        const auto ahead = cache_end - cache_pos;
+        cache_pos = cache_end = 0;
+
+        return ahead == 0 ||
+               std::fseek(to_handle(file_handle), -ahead, SEEK_CUR) == 0;
+    }
+
+    const auto len = static_cast<size_t>(cache_pos);
+    cache_pos      = 0;
+
+    return len == 0 ||
+           std::fwrite(cache.data(), len, 1, to_handle(file_handle)) == 1;
+}
+
+bool file::flush() noexcept
 {
     irt_assert(file_handle);
 
-    std::fflush(to_handle(file_handle));
+    const bool written = flush_cache();
+
+    return std::fflush(to_handle(file_handle)) == 0 && written;
 }
 
 i64 file::seek(i64 offset, seek_origin origin) noexcept
 {
     irt_assert(file_handle);
 
+    if (mode == open_mode::map) {
+        const auto pos = origin == seek_origin::current ? map_pos + offset
+                         : origin == seek_origin::end   ? map_size + offset
+                                                        : offset;
+        if (pos < 0 || pos > map_size)
+            return -1;
+
+        map_pos = pos;
+        return 0;
+    }
+
+    if (!flush_cache())
+        return -1;
+
     const auto offset_good = static_cast<long int>(offset);
     const auto origin_good = origin == seek_origin::current ? SEEK_CUR
                              : origin == seek_origin::end   ? SEEK_END
-                                                            : SEEK_CUR;
+                                                            : SEEK_SET;
 
     return std::fseek(to_handle(file_handle), offset_good, origin_good);
 }
@@ -378,6 +555,12 @@ void file::rewind() noexcept
 {
     irt_assert(file_handle);
 
+    map_pos = 0;
+    if (mode == open_mode::read)
+        cache_pos = cache_end = 0;
+    else
+        flush_cache();
+
     std::rewind(to_handle(file_handle));
 }
 
@@ -443,9 +626,59 @@ bool file::read(void* buffer, i64 length) noexcept
     irt_assert(buffer);
     irt_assert(length > 0);
 
-    const auto len     = static_cast<size_t>(length);
-    const auto written = std::fread(buffer, len, 1, to_handle(file_handle));
-    return written == 1;
+    if (mode == open_mode::map) {
+        if (length > map_size - map_pos)
+            return false;
+
+        std::memcpy(buffer, map_data + map_pos, static_cast<size_t>(length));
+        map_pos += length;
+        return true;
+    }
+
+    if (mode != open_mode::read)
+        return false;
+
+    auto*      out       = reinterpret_cast<u8*>(buffer);
+    const auto available = static_cast<i64>(cache_end - cache_pos);
+
+    if (length <= available) {
+        std::memcpy(
+          out, cache.data() + cache_pos, static_cast<size_t>(length));
+        cache_pos += static_cast<i32>(length);
+        return true;
+    }
+
+    if (available > 0) {
+        std::memcpy(
+          out, cache.data() + cache_pos, static_cast<size_t>(available));
+        out += available;
+        length -= available;
+    }
+
+    cache_pos = cache_end = 0;
+
+    // Large reads bypass the buffer.
+    if (length >= cache.ssize()) {
+        const auto len = static_cast<size_t>(length);
+        return std::fread(out, len, 1, to_handle(file_handle)) == 1;
+    }
+
+    const auto read = std::fread(cache.data(),
+                                 1,
+                                 static_cast<size_t>(cache.ssize()),
+                                 to_handle(file_handle));
+
+    cache_end = static_cast<i32>(read);
+
+    if (static_cast<i64>(read) < length) {
+        cache_pos = cache_end;
+        return false;
+    }
+
+    std::memcpy(out, cache.data(), static_cast<size_t>(length));
+    cache_pos = static_cast<i32>(length);
+
+    return true;
 }
 
 bool file::write(const void* buffer, i64 length) noexcept
@@ -454,74 +687,183 @@ bool file::write(const void* buffer, i64 length) noexcept
     irt_assert(buffer);
     irt_assert(length > 0);
 
-    const auto len     = static_cast<size_t>(length);
-    const auto written = std::fwrite(buffer, len, 1, to_handle(file_handle));
-    return written == 1;
+    if (mode == open_mode::read || mode == open_mode::map)
+        return false;
+
+    if (length <= cache.ssize() - cache_pos) {
+        std::memcpy(
+          cache.data() + cache_pos, buffer, static_cast<size_t>(length));
+        cache_pos += static_cast<i32>(length);
+        return true;
+    }
+
+    if (!flush_cache())
+        return false;
+
+    // Large writes bypass the buffer.
+    if (length >= cache.ssize()) {
+        const auto len = static_cast<size_t>(length);
+        return std::fwrite(buffer, len, 1, to_handle(file_handle)) == 1;
+    }
+
+    std::memcpy(cache.data(), buffer, static_cast<size_t>(length));
+    cache_pos = static_cast<i32>(length);
+
+    return true;
+}
+
+std::span<const u8> file::view(i64 length) noexcept
+{
+    if (!map_data || length <= 0 || length > map_size - map_pos)
+        return {};
+
+    const auto* first = map_data + map_pos;
+    map_pos += length;
+
+    return { first, static_cast<size_t>(length) };
+}
+
+std::span<const u8> file::mapped() const noexcept
+{
+    if (!map_data)
+        return {};
+
+    return { map_data, static_cast<size_t>(map_size) };
 }
 
 memory::memory(const i64 length, const open_mode /*mode*/) noexcept
   : data(static_cast<i32>(length), static_cast<i32>(length))
   , pos(0)
+  , used(data.data() ? length : 0)
 {}
 
 memory::memory(memory&& other) noexcept
   : data(std::move(other.data))
   , pos(other.pos)
+  , used(other.used)
 {
-    other.pos = 0;
+    other.pos  = 0;
+    other.used = 0;
 }
 
 memory& memory::operator=(memory&& other) noexcept
 {
-    data      = std::move(other.data);
-    pos       = other.pos;
-    other.pos = 0;
+    data       = std::move(other.data);
+    pos        = other.pos;
+    used       = other.used;
+    other.pos  = 0;
+    other.used = 0;
 
     return *this;
 }
 
-bool memory::is_open() const noexcept { return data.capacity() == 0; }
+bool memory::is_open() const noexcept
+{
+    return data.capacity() == 0 || data.data() != nullptr;
+}
 
-i64 memory::length() const noexcept { return data.capacity(); }
+i64 memory::length() const noexcept { return used; }
 
 i64 memory::tell() const noexcept { return pos; }
 
-void memory::flush() const noexcept {}
+bool memory::flush() noexcept { return true; }
 
 i64 memory::seek(i64 offset, seek_origin origin) noexcept
 {
-    switch (origin) {
-    case seek_origin::current:
-        pos += offset;
-        break;
-    case seek_origin::end:
-        pos = data.capacity() - offset;
-        break;
-    case seek_origin::set:
-        pos = offset;
-        break;
-    }
+    const auto new_pos = origin == seek_origin::current ? pos + offset
+                         : origin == seek_origin::end   ? used + offset
+                                                        : offset;
 
-    return pos;
+    if (new_pos < 0 || new_pos > used)
+        return -1;
+
+    pos = new_pos;
+    return 0;
 }
 
 void memory::rewind() noexcept { pos = 0; }
 
-bool memory::read(u8& value) noexcept { return write_to_file(*this, value); }
+bool memory::reserve(i64 capacity) noexcept
+{
+    if (capacity <= data.ssize())
+        return true;
 
-bool memory::read(u16& value) noexcept { return write_to_file(*this, value); }
+    if (capacity > std::numeric_limits<i32>::max())
+        return false;
 
-bool memory::read(u32& value) noexcept { return write_to_file(*this, value); }
+    // The vector does not initialize the bytes: only the content is copied.
+    const auto  new_capacity = static_cast<i32>(capacity);
+    vector<u8> grown(new_capacity, new_capacity);
+    if (!grown.data())
+        return false;
 
-bool memory::read(u64& value) noexcept { return write_to_file(*this, value); }
+    if (used > 0)
+        std::memcpy(grown.data(), data.data(), static_cast<size_t>(used));
 
-bool memory::read(i8& value) noexcept { return write_to_file(*this, value); }
+    data = std::move(grown);
+    return true;
+}
 
-bool memory::read(i16& value) noexcept { return write_to_file(*this, value); }
+void memory::shrink_to_fit() noexcept
+{
+    if (used == data.ssize())
+        return;
 
-bool memory::read(i32& value) noexcept { return write_to_file(*this, value); }
+    if (used == 0) {
+        data = vector<u8>();
+        return;
+    }
+
+    const auto size = static_cast<i32>(used);
+    vector<u8> shrunk(size, size);
+    if (shrunk.data()) {
+        std::memcpy(shrunk.data(), data.data(), static_cast<size_t>(used));
+        data = std::move(shrunk);
+    }
+}
+
+std::span<u8> memory::bytes() noexcept
+{
+    if (used == 0)
+        return {};
+
+    return { data.data(), static_cast<size_t>(used) };
+}
+
+std::span<const u8> memory::bytes() const noexcept
+{
+    if (used == 0)
+        return {};
+
+    return { data.data(), static_cast<size_t>(used) };
+}
+
+std::span<const u8> memory::view(i64 length) noexcept
+{
+    if (length <= 0 || length > used - pos)
+        return {};
+
+    const auto* first = data.data() + pos;
+    pos += length;
+
+    return { first, static_cast<size_t>(length) };
+}
+
+bool memory::read(u8& value) noexcept { return read_from_file(*this, value); }
+
+bool memory::read(u16& value) noexcept { return read_from_file(*this, value); }
+
+bool memory::read(u32& value) noexcept { return read_from_file(*this, value); }
+
+bool memory::read(u64& value) noexcept { return read_from_file(*this, value); }
+
+bool memory::read(i8& value) noexcept { return read_from_file(*this, value); }
+
+bool memory::read(i16& value) noexcept { return read_from_file(*this, value); }
+
+bool memory::read(i32& value) noexcept { return read_from_file(*this, value); }
 
-bool memory::read(i64& value) noexcept { return write_to_file(*this, value); }
+bool memory::read(i64& value) noexcept { return read_from_file(*this, value); }
 
 bool memory::write(const u8 value) noexcept
 {
@@ -569,17 +911,13 @@ bool memory::read(void* buffer, i64 length) noexcept
     irt_assert(buffer);
     irt_assert(length > 0);
 
-    if (pos + length < static_cast<i64>(data.capacity())) {
-        std::copy_n(data.data() + pos,
-                    static_cast<size_t>(length),
-                    reinterpret_cast<u8*>(buffer));
-
-        pos += length;
+    if (length > used - pos)
+        return false;
 
-        return true;
-    }
+    std::memcpy(buffer, data.data() + pos, static_cast<size_t>(length));
+    pos += length;
 
-    return false;
+    return true;
 }
 
 bool memory::write(const void* buffer, i64 length) noexcept
@@ -588,17 +926,21 @@ bool memory::write(const void* buffer, i64 length) noexcept
     irt_assert(buffer);
     irt_assert(length > 0);
 
-    if (pos + length < static_cast<i64>(data.capacity())) {
-        std::copy_n(reinterpret_cast<const u8*>(buffer),
-                    static_cast<size_t>(length),
-                    data.data() + pos);
+    const auto end = pos + length;
 
-        pos += length;
+    if (end > data.ssize()) {
+        const auto twice = std::min(static_cast<i64>(data.ssize()) * 2,
+                                    static_cast<i64>(INT32_MAX));
 
-        return true;
+        if (!reserve(std::max(end, twice)))
+            return false;
     }
 
-    return false;
+    std::memcpy(data.data() + pos, buffer, static_cast<size_t>(length));
+    pos  = end;
+    used = std::max(used, end);
+
+    return true;
 }
 
 } // namespace irt
\ No newline at end of file
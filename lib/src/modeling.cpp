@@ -4,8 +4,11 @@
 
 #include <irritator/io.hpp>
 #include <irritator/modeling.hpp>
+#include <irritator/thread.hpp>
 
 #include <filesystem>
+#include <sstream>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -514,321 +517,6 @@ status add_seir_nonlineaire(modeling& mod, component& com) noexcept
     return status::success;
 }
 
-// static status build_models_recursively(const modeling& /*mod*/,
-//                                        component& /*comp_ref*/,
-//                                        simulation& /*sim*/)
-// {
-//     // comp_ref.mappers.data.clear();
-
-//     // auto* comp = mod.components.try_to_get(comp_ref.id);
-//     // if (!comp)
-//     //     return status::success; /* @TODO certainly an error in API */
-
-//     // for (i32 i = 0, e = comp->children.ssize(); i != e; ++i) {
-//     //     auto* child = mod.children.try_to_get(comp->children[i]);
-//     //     if (!child)
-//     //         continue;
-
-//     //     u64 id = child->id;
-
-//     //     if (child->type == child_type::model) {
-//     //         auto  src_id = enum_cast<model_id>(id);
-//     //         auto* src    = mod.models.try_to_get(src_id);
-//     //         if (!src)
-//     //             continue;
-
-//     //         irt_return_if_fail(sim.models.can_alloc(1),
-//     //                            status::simulation_not_enough_model);
-
-//     //         auto& dst    = sim.clone(*src);
-//     //         auto  dst_id = sim.models.get_id(dst);
-//     //         comp_ref.mappers.data.emplace_back(src_id, dst_id);
-//     //     } else {
-//     //         auto  src_id = enum_cast<component_ref_id>(id);
-//     //         auto* src    = mod.component_refs.try_to_get(src_id);
-//     //         if (!src)
-//     //             continue;
-
-//     //         irt_return_if_bad(build_models_recursively(mod, *src, sim));
-//     //     }
-//     // }
-
-//     return status::success;
-// }
-
-// static status build_model_to_model_connection(component& /*comp_ref*/,
-//                                               simulation& /*sim*/,
-//                                               model_id /*src*/,
-//                                               i8 /*port_src*/,
-//                                               model_id /*dst*/,
-//                                               i8 /*port_dst*/) noexcept
-// {
-//     // auto* src_mdl_id = comp_ref.mappers.get(enum_cast<model_id>(src));
-//     // auto* dst_mdl_id = comp_ref.mappers.get(enum_cast<model_id>(dst));
-//     // irt_assert(src_mdl_id && !dst_mdl_id);
-
-//     // auto* mdl_src = sim.models.try_to_get(*src_mdl_id);
-//     // auto* mdl_dst = sim.models.try_to_get(*dst_mdl_id);
-//     // irt_assert(mdl_src && mdl_dst);
-
-//     // return global_connect(sim, *mdl_src, port_src, *dst_mdl_id, port_dst);
-
-//     return status::success;
-// }
-
-// static bool found_input_port(const modeling& /*mod*/,
-//                              component_id /*compo_ref*/,
-//                              i8 /*port*/,
-//                              model_id& /*model_found*/,
-//                              i8& /*port_found*/)
-// {
-//     // for (;;) {
-//     //     auto* c_ref = mod.component_refs.try_to_get(compo_ref);
-//     //     if (!c_ref)
-//     //         return false;
-
-//     //     auto* c = mod.components.try_to_get(c_ref->id);
-//     //     if (!c)
-//     //         return false;
-
-//     //     if (!(0 <= port && port < c->x.ssize()))
-//     //         return false;
-
-//     //     auto* child = mod.children.try_to_get(c->x[port].id);
-//     //     if (!child)
-//     //         return false;
-
-//     //     if (child->type == child_type::model) {
-//     //         auto  id        = enum_cast<model_id>(child->id);
-//     //         auto* mapped_id = c_ref->mappers.get(id);
-
-//     //         if (mapped_id) {
-//     //             model_found = *mapped_id;
-//     //             port_found  = c->x[port].index;
-//     //             return true;
-//     //         } else {
-//     //             return false;
-//     //         }
-//     //     }
-
-//     //     compo_ref = enum_cast<component_ref_id>(child->id);
-//     //     port      = c->x[port].index;
-//     // }
-
-//     return true;
-// }
-
-// static bool found_output_port(const modeling& /*mod*/,
-//                               component_id /*compo_ref*/,
-//                               i8 /*port*/,
-//                               model_id& /*model_found*/,
-//                               i8& /*port_found*/)
-// {
-//     // for (;;) {
-//     //     auto* c_ref = mod.component_refs.try_to_get(compo_ref);
-//     //     if (!c_ref)
-//     //         return false;
-
-//     //     auto* c = mod.components.try_to_get(c_ref->id);
-//     //     if (!c)
-//     //         return false;
-
-//     //     if (!(0 <= port && port < c->y.ssize()))
-//     //         return false;
-
-//     //     auto* child = mod.children.try_to_get(c->y[port].id);
-//     //     if (!child)
-//     //         return false;
-
-//     //     if (child->type == child_type::model) {
-//     //         auto  id        = enum_cast<model_id>(child->id);
-//     //         auto* mapped_id = c_ref->mappers.get(id);
-
-//     //         if (mapped_id) {
-//     //             model_found = *mapped_id;
-//     //             port_found  = c->y[port].index;
-//     //             return true;
-//     //         } else {
-//     //             return false;
-//     //         }
-//     //     }
-
-//     //     compo_ref = enum_cast<component_ref_id>(child->id);
-//     //     port      = c->y[port].index;
-//     // }
-
-//     return true;
-// }
-
-// static status build_model_to_component_connection(
-//   const modeling& /*mod*/,
-//   const component& /*compo_ref*/,
-//   simulation& /*sim*/,
-//   model_id /*src*/,
-//   i8 /*port_src*/,
-//   component_id /*dst*/,
-//   i8 /*port_dst*/)
-// {
-//     // model_id model_found;
-//     // i8       port_found;
-
-//     // if (found_input_port(mod, dst, port_dst, model_found, port_found))
-//     //     if (auto* src_mdl_id = compo_ref.mappers.get(src); src_mdl_id)
-//     //         if (auto* src_mdl = sim.models.try_to_get(*src_mdl_id);
-//     src_mdl)
-//     //             return global_connect(
-//     //               sim, *src_mdl, port_src, model_found, port_found);
-
-//     return status::success; // @todo fail
-// }
-
-// static status build_component_to_model_connection(
-//   const modeling& /*mod*/,
-//   const component& /*compo_ref*/,
-//   simulation& /*sim*/,
-//   component_id /*src*/,
-//   i8 /*port_src*/,
-//   model_id /*dst*/,
-//   i8 /*port_dst*/)
-// {
-//     // model_id model_found;
-//     // i8       port_found;
-
-//     // if (found_output_port(mod, src, port_src, model_found, port_found)) {
-//     //     auto* dst_mdl_id = compo_ref.mappers.get(dst);
-//     //     irt_return_if_fail(
-//     //       dst_mdl_id,
-//     //       status::model_connect_bad_dynamics); // @todo Fix connection
-
-//     //     if (auto* src_mdl_id = compo_ref.mappers.get(model_found);
-//     //     src_mdl_id)
-//     //         if (auto* src_mdl = sim.models.try_to_get(*src_mdl_id);
-//     src_mdl)
-
-//     //             return global_connect(
-//     //               sim, *src_mdl, port_found, *dst_mdl_id, port_dst);
-//     // }
-
-//     return status::success;
-// }
-
-// static status build_component_to_component_connection(const modeling&
-// /*mod*/,
-//                                                       simulation& /*sim*/,
-//                                                       component_id /*src*/,
-//                                                       i8 /*port_src*/,
-//                                                       component_id /*dst*/,
-//                                                       i8 /*port_dst*/)
-// {
-//     // model_id src_model_found, dst_model_found;
-//     // i8       src_port_found, dst_port_found;
-
-//     // model* src_mdl = nullptr;
-
-//     // if (found_input_port(mod, dst, port_dst, dst_model_found,
-//     // dst_port_found))
-//     //     if (found_output_port(
-//     //           mod, src, port_src, src_model_found, src_port_found))
-//     //         if (src_mdl = sim.models.try_to_get(src_model_found); src_mdl)
-//     //             return global_connect(sim,
-//     //                                   *src_mdl,
-//     //                                   src_port_found,
-//     //                                   dst_model_found,
-//     //                                   dst_port_found);
-
-//     // return status::model_connect_bad_dynamics; // @todo Fix connection
-
-//     return status::success;
-// }
-
-// static status build_connections_recursively(modeling& /*mod*/,
-//                                             component& /*c_ref*/,
-//                                             simulation& /*sim*/)
-// {
-//     // auto* compo = mod.components.try_to_get(c_ref.id);
-//     // if (!compo)
-//     //     return status::success; // @todo certainly an error
-
-//     // // Build connections from the leaf to the head of the component
-//     // // hierarchy.
-//     // for (i32 i = 0, e = compo->children.ssize(); i != e; ++i) {
-//     //     if (auto* child = mod.children.try_to_get(compo->children[i]);
-//     child)
-//     //     {
-//     //         if (child->type == child_type::component) {
-//     //             u64   id       = child->id;
-//     //             auto  child_id = enum_cast<component_ref_id>(id);
-//     //             auto* child    = mod.component_refs.try_to_get(child_id);
-//     //             if (!child)
-//     //                 continue;
-
-//     //             build_connections_recursively(mod, *child, sim);
-//     //         }
-//     //     }
-//     // }
-
-//     // for (i32 i = 0, e = compo->connections.ssize(); i != e; ++i) {
-//     //     auto* con = mod.connections.try_to_get(compo->connections[i]);
-//     //     if (!con)
-//     //         continue;
-
-//     //     auto* src = mod.children.try_to_get(con->src);
-//     //     auto* dst = mod.children.try_to_get(con->dst);
-
-//     //     if (src->type == child_type::model) {
-//     //         if (dst->type == child_type::model) {
-//     //             irt_return_if_bad(
-//     //               build_model_to_model_connection(c_ref,
-//     //                                               sim,
-//     // enum_cast<model_id>(src->id),
-//     //                                               con->index_src,
-//     // enum_cast<model_id>(dst->id),
-//     //                                               con->index_dst));
-//     //         } else {
-//     //             irt_return_if_bad(build_model_to_component_connection(
-//     //               mod,
-//     //               c_ref,
-//     //               sim,
-//     //               enum_cast<model_id>(src->id),
-//     //               con->index_src,
-//     //               enum_cast<component_ref_id>(dst->id),
-//     //               con->index_dst));
-//     //         }
-//     //     } else {
-//     //         if (dst->type == child_type::model) {
-//     //             irt_return_if_bad(build_component_to_model_connection(
-//     //               mod,
-//     //               c_ref,
-//     //               sim,
-//     //               enum_cast<component_ref_id>(src->id),
-//     //               con->index_src,
-//     //               enum_cast<model_id>(dst->id),
-//     //               con->index_dst));
-//     //         } else {
-//     //             irt_return_if_bad(build_component_to_component_connection(
-//     //               mod,
-//     //               sim,
-//     //               enum_cast<component_ref_id>(src->id),
-//     //               con->index_src,
-//     //               enum_cast<component_ref_id>(dst->id),
-//     //               con->index_dst));
-//     //         }
-//     //     }
-//     // }
-
-//     return status::success;
-// }
-
-// static status build_models(modeling& /*mod*/,
-//                            component& /*compo*/,
-//                            simulation& /*sim*/)
-// {
-//     // irt_return_if_bad(build_models_recursively(mod, c_ref, sim));
-//     // irt_return_if_bad(build_connections_recursively(mod, c_ref, sim));
-
-//     irt_bad_return(status::success);
-// }
-
 static bool get_component_type(const char*     type_string,
                                component_type* type_found) noexcept
 {
@@ -1137,145 +825,635 @@ status modeling::fill_internal_components() noexcept
     return status::success;
 }
 
-static void prepare_component_loading(modeling&              mod,
-                                      dir_path_id            path_id,
-                                      std::filesystem::path& file) noexcept
+static void free_child(data_array<child, child_id>& children,
+                       data_array<model, model_id>& models,
+                       child&                       c) noexcept
 {
-    auto& file_path  = mod.file_paths.alloc();
-    file_path.parent = path_id;
-    file_path.path   = std::string_view(file.string());
+    if (c.type == child_type::model) {
+        auto id = enum_cast<model_id>(c.id);
+        if (auto* mdl = models.try_to_get(id); mdl)
+            models.free(*mdl);
+    }
 
-    auto& compo = mod.components.alloc();
-    compo.name.assign(file.filename().string().c_str());
-    compo.dir    = path_id;
-    compo.file   = mod.file_paths.get_id(file_path);
-    compo.type   = component_type::file;
-    compo.status = component_status::unread;
+    children.free(c);
+}
 
-    try {
-        auto desc_file = file;
-        desc_file.replace_extension(".desc");
-        std::error_code ec;
-        if (std::filesystem::exists(desc_file, ec)) {
-            auto& desc  = mod.descriptions.alloc();
-            desc.status = description_status::unread;
-            compo.desc  = mod.descriptions.get_id(desc);
-        }
-    } catch (const std::exception& /*e*/) {
+static void free_connection(data_array<connection, connection_id>& connections,
+                            connection&                            con) noexcept
+{
+    connections.free(con);
+}
+
+//! Free children, connections and ports of the component @c c.
+static void clear_component(modeling& mod, component& c) noexcept
+{
+    for (int i = 0, e = c.children.ssize(); i != e; ++i)
+        if (auto* child = mod.children.try_to_get(c.children[i]); child)
+            free_child(mod.children, mod.models, *child);
+    c.children.clear();
+
+    for (int i = 0, e = c.connections.ssize(); i != e; ++i)
+        if (auto* cnt = mod.connections.try_to_get(c.connections[i]); cnt)
+            free_connection(mod.connections, *cnt);
+    c.connections.clear();
+
+    c.x.clear();
+    c.y.clear();
+}
+
+//! FNV-1a hash used by the component index cache.
+static u64 hash_buffer(const std::string_view buffer,
+                       u64 hash = 14695981039346656037u) noexcept
+{
+    for (const auto c : buffer) {
+        hash ^= static_cast<u8>(c);
+        hash *= 1099511628211u;
     }
+
+    return hash;
+}
+
+static u64 hash_file_path(const dir_path_id      dir,
+                          const std::string_view path) noexcept
+{
+    return hash_buffer(path, 14695981039346656037u ^ ordinal(dir));
 }
 
-static void prepare_component_loading(modeling&              mod,
-                                      dir_path&              d_path,
-                                      std::filesystem::path& path) noexcept
+//! Name and first line of the component index cache file of a directory.
+static constexpr const char* component_index_name   = ".irritator-index";
+static constexpr const char* component_index_header = "irritator-index-1";
+
+//! An entry of the component index cache file of a directory.
+struct component_index_entry
+{
+    std::string path; // relative to the directory
+    u64         last_write_time;
+    u64         hash;
+};
+
+//! Staging area filled by a worker with the component files of a directory
+//! and the entries of its component index cache file.
+struct component_dir_scanner
 {
-    namespace fs   = std::filesystem;
-    auto d_path_id = mod.dir_paths.get_id(d_path);
+    struct entry
+    {
+        std::filesystem::path path; // relative to the directory
+        std::string           name; // @c path as string
+        u64                   last_write_time;
+    };
 
-    std::error_code ec;
-    if (fs::is_directory(path, ec)) {
-        auto it = fs::recursive_directory_iterator{ path, ec };
-        auto et = fs::recursive_directory_iterator{};
+    std::filesystem::path              root;
+    dir_path_id                        dir;
+    std::vector<entry>                 files; // sorted by name
+    std::vector<component_index_entry> index; // sorted by path
+    bool                               scanned = false;
+};
 
-        while (it != et) {
-            if (it->is_regular_file() && it->path().extension() == ".irt") {
-                if (mod.components.can_alloc()) {
-                    auto file = it->path();
-                    file      = std::filesystem::relative(file, path, ec);
-                    prepare_component_loading(mod, d_path_id, file);
+//! Staging area filled by a worker with the content of a component file
+//! and its decoding.
+struct component_file_loader
+{
+    std::filesystem::path path; // relative to the directory
+    std::filesystem::path full_path;
+    std::string           buffer;
+    std::string           description;
+    component_file_data   data;
+    dir_path_id           dir;
+    file_path_id          file  = undefined<file_path_id>();
+    component_id          compo = undefined<component_id>();
+    u64                   last_write_time = 0;
+    u64                   known_hash      = 0; // hash of the index cache
+    u64                   hash            = 0;
+    status                parsed          = status::io_file_format_error;
+    bool                  read            = false;
+    bool                  has_description = false;
+
+    //! The content is the same than the content known by the index cache.
+    bool is_unchanged() const noexcept { return read && hash == known_hash; }
+};
+
+static void read_component_index(component_dir_scanner& scan)
+{
+    std::ifstream ifs(scan.root / component_index_name);
+    std::string   header;
+    if (!(ifs >> header) || header != component_index_header)
+        return;
+
+    component_index_entry entry;
+    while (ifs >> entry.last_write_time >> entry.hash >>
+           std::quoted(entry.path))
+        scan.index.emplace_back(entry);
+
+    std::sort(scan.index.begin(),
+              scan.index.end(),
+              [](const auto& lhs, const auto& rhs) noexcept {
+                  return lhs.path < rhs.path;
+              });
+}
+
+static const component_index_entry* find_index_entry(
+  const component_dir_scanner& scan,
+  const std::string_view       path) noexcept
+{
+    auto it = std::lower_bound(
+      scan.index.begin(),
+      scan.index.end(),
+      path,
+      [](const auto& entry, const std::string_view p) noexcept {
+          return entry.path < p;
+      });
+
+    return it != scan.index.end() && it->path == path ? &*it : nullptr;
+}
+
+static bool is_scanned(const component_dir_scanner& scan,
+                       const std::string_view       path) noexcept
+{
+    auto it = std::lower_bound(
+      scan.files.begin(),
+      scan.files.end(),
+      path,
+      [](const auto& entry, const std::string_view p) noexcept {
+          return entry.name < p;
+      });
+
+    return it != scan.files.end() && it->name == path;
+}
+
+static void scan_component_dir(void* param) noexcept
+{
+    namespace fs = std::filesystem;
+    auto* scan   = reinterpret_cast<component_dir_scanner*>(param);
+
+    try {
+        std::error_code ec;
+        if (fs::is_directory(scan->root, ec)) {
+            auto it = fs::recursive_directory_iterator{ scan->root, ec };
+            auto et = fs::recursive_directory_iterator{};
+
+            while (!ec && it != et) {
+                if (it->is_regular_file(ec) &&
+                    it->path().extension() == ".irt") {
+                    auto file = fs::relative(it->path(), scan->root, ec);
+                    auto time = it->last_write_time(ec);
+                    auto name = file.string();
+
+                    scan->files.emplace_back(component_dir_scanner::entry{
+                      std::move(file),
+                      std::move(name),
+                      static_cast<u64>(time.time_since_epoch().count()) });
                 }
+
+                it = it.increment(ec);
             }
 
-            it = it.increment(ec);
+            // Without a full walk, the missing files are not deleted files.
+            scan->scanned = !ec;
         }
+
+        std::sort(scan->files.begin(),
+                  scan->files.end(),
+                  [](const auto& lhs, const auto& rhs) noexcept {
+                      return lhs.name < rhs.name;
+                  });
+
+        read_component_index(*scan);
+    } catch (...) {
+        scan->scanned = false;
     }
 }
 
-static void prepare_component_loading(modeling& mod, dir_path& dir) noexcept
+static void read_component_file(void* param) noexcept
 {
+    auto* loader = reinterpret_cast<component_file_loader*>(param);
+
     try {
-        std::filesystem::path p(dir.path.c_str());
-        std::error_code       ec;
+        if (std::ifstream ifs(loader->full_path, std::ios::binary); ifs) {
+            loader->buffer.assign(std::istreambuf_iterator<char>(ifs),
+                                  std::istreambuf_iterator<char>());
+            loader->hash = hash_buffer(loader->buffer);
+            loader->read = true;
+        }
 
-        if (std::filesystem::exists(p, ec)) {
-            prepare_component_loading(mod, dir, p);
-            dir.status = dir_path::status_option::read;
+        if (loader->read && !loader->is_unchanged()) {
+            std::istringstream is(loader->buffer);
+            reader             r(is);
+
+            loader->parsed = r(loader->data);
+        }
+
+        auto desc_file = loader->full_path;
+        desc_file.replace_extension(".desc");
+        if (std::ifstream ifs(desc_file, std::ios::binary); ifs) {
+            loader->description.assign(std::istreambuf_iterator<char>(ifs),
+                                       std::istreambuf_iterator<char>());
+            loader->has_description = true;
         }
     } catch (...) {
+        loader->read = false;
     }
 }
 
-static void prepare_component_loading(modeling& mod) noexcept
+//! Run the function @c f for each element of @c jobs on the first task list
+//! of @c tm and wait for the end of all jobs. Without a started task
+//! manager, the jobs run in the calling thread.
+template<typename Job>
+static void run_parallel_jobs(task_manager*     tm,
+                              std::vector<Job>& jobs,
+                              task_function     f) noexcept
 {
-    for (auto id : mod.component_repertories)
-        if (auto* dir = mod.dir_paths.try_to_get(id); dir)
-            prepare_component_loading(mod, *dir);
+    if (!tm || tm->task_lists.empty() || tm->workers.empty() ||
+        !tm->workers[0].thread.joinable()) {
+        for (auto& job : jobs)
+            f(&job);
+        return;
+    }
+
+    task_counter counter;
+    for (auto& job : jobs)
+        tm->task_lists[0].add(f, &job, counter);
+
+    counter.wait();
 }
 
-static void load_component(modeling& mod, component& compo) noexcept
+//! Allocate into @c compo the children, ports and connections decoded into
+//! @c data. Run in the calling thread since it allocates into @c mod.
+static status commit_component_data(modeling&                  mod,
+                                    const component_file_data& data,
+                                    component&                 compo) noexcept
+{
+    table<int, child_id> mapping;
+    mapping.data.reserve(static_cast<int>(data.children.size()));
+
+    for (const auto& elem : data.children) {
+        if (elem.is_component) {
+            const auto id =
+              mod.search_component(elem.name.c_str(), elem.hint.c_str());
+            irt_return_if_fail(mod.components.try_to_get(id),
+                               status::io_file_format_error);
+            irt_return_if_fail(mod.children.can_alloc(),
+                               status::io_not_enough_memory);
+
+            auto& child = mod.children.alloc(id);
+            compo.children.emplace_back(mod.children.get_id(child));
+        } else {
+            irt_return_if_fail(mod.models.can_alloc() &&
+                                 mod.children.can_alloc(),
+                               status::io_not_enough_memory);
+
+            auto& child = mod.alloc(compo, elem.mdl.type);
+            mod.models.get(enum_cast<model_id>(child.id)) = elem.mdl;
+        }
+
+        const auto id    = compo.children.back();
+        auto&      child = mod.children.get(id);
+        child.x          = elem.x;
+        child.y          = elem.y;
+        mapping.data.emplace_back(elem.id, id);
+    }
+
+    mapping.sort();
+
+    for (const auto& p : data.y) {
+        auto* id = mapping.get(p.child);
+        irt_return_if_fail(id, status::io_file_format_model_error);
+        compo.y.emplace_back(*id, p.index);
+    }
+
+    for (const auto& p : data.x) {
+        auto* id = mapping.get(p.child);
+        irt_return_if_fail(id, status::io_file_format_model_error);
+        compo.x.emplace_back(*id, p.index);
+    }
+
+    for (const auto& c : data.connections) {
+        auto* src = mapping.get(c.src);
+        auto* dst = mapping.get(c.dst);
+        irt_return_if_fail(src && dst, status::io_file_format_model_unknown);
+        irt_return_if_bad(
+          mod.connect(compo, *src, c.index_src, *dst, c.index_dst));
+    }
+
+    return status::success;
+}
+
+//! Clear the component @c compo then fill it with the content read by
+//! @c loader. On success the status of @c compo is @c unmodified. On error
+//! @c compo is left empty.
+static status commit_component(modeling&              mod,
+                               component_file_loader& loader,
+                               component&             compo) noexcept
+{
+    clear_component(mod, compo);
+
+    auto ret = status::success;
+    if (loader.data.has_sources) {
+        try {
+            std::istringstream is(loader.buffer);
+            reader             r(is);
+
+            ret = r(mod, compo, mod.srcs);
+        } catch (...) {
+            ret = status::io_not_enough_memory;
+        }
+    } else {
+        ret = commit_component_data(mod, loader.data, compo);
+    }
+
+    if (is_bad(ret)) {
+        clear_component(mod, compo);
+        return ret;
+    }
+
+    if (loader.has_description) {
+        auto* desc = mod.descriptions.try_to_get(compo.desc);
+        if (!desc && mod.descriptions.can_alloc()) {
+            desc       = &mod.descriptions.alloc();
+            compo.desc = mod.descriptions.get_id(*desc);
+        }
+
+        if (desc) {
+            desc->data   = std::string_view(loader.description);
+            desc->status = description_status::unmodified;
+        }
+    }
+
+    compo.status = component_status::unmodified;
+
+    return status::success;
+}
+
+//! Allocate the file @c path of the directory @c dir and its component. The
+//! component is @c unread until @c modeling::load or @c commit_component.
+static component* add_file_component(modeling&                    mod,
+                                     const dir_path_id            dir,
+                                     const std::filesystem::path& path)
+{
+    if (!mod.file_paths.can_alloc() || !mod.components.can_alloc())
+        return nullptr;
+
+    auto& file  = mod.file_paths.alloc();
+    file.parent = dir;
+    file.path   = std::string_view(path.string());
+
+    auto& compo = mod.components.alloc();
+    compo.name.assign(path.filename().string().c_str());
+    compo.dir    = dir;
+    compo.file   = mod.file_paths.get_id(file);
+    compo.type   = component_type::file;
+    compo.status = component_status::unread;
+
+    return &compo;
+}
+
+//! Drop the files of the directory of @c scan not found by the scan. The
+//! never read components are freed, the others become memory components.
+static void remove_deleted_files(modeling&                    mod,
+                                 const component_dir_scanner& scan) noexcept
+{
+    vector<file_path_id> deleted;
+
+    file_path* file = nullptr;
+    while (mod.file_paths.next(file))
+        if (file->parent == scan.dir && !is_scanned(scan, file->path.sv()))
+            deleted.emplace_back(mod.file_paths.get_id(*file));
+
+    for (const auto id : deleted) {
+        component* compo = nullptr;
+        while (mod.components.next(compo))
+            if (compo->file == id)
+                break;
+
+        if (compo && compo->status == component_status::unread) {
+            mod.free(*compo);
+        } else {
+            if (compo) {
+                compo->type   = component_type::memory;
+                compo->status = component_status::modified;
+                compo->file   = undefined<file_path_id>();
+            }
+
+            mod.file_paths.free(id);
+        }
+    }
+}
+
+//! Write the index cache of the files of the directory of @c scan. Files
+//! never read successfully (without hash) are not written.
+static void write_component_index(modeling&                    mod,
+                                  const component_dir_scanner& scan)
+{
+    std::ofstream ofs(scan.root / component_index_name);
+    if (!ofs)
+        return;
+
+    ofs << component_index_header << '\n';
+
+    file_path* file = nullptr;
+    while (mod.file_paths.next(file))
+        if (file->parent == scan.dir && file->hash != 0)
+            ofs << file->last_write_time << ' ' << file->hash << ' '
+                << std::quoted(file->path.sv()) << '\n';
+}
+
+//! Scan the directories @c dirs and load new or modified component files.
+//! Directory walks, file reads and decoding run in parallel on
+//! @c modeling::task_mgr into staging buffers then the components are
+//! committed into @c mod in this thread. Files with the same last write time
+//! or the same hash than the index cache (stored into @c file_path and in the
+//! index file of the directory) are not decoded again.
+static status load_components(modeling&                 mod,
+                              const vector<dir_path_id>& dirs) noexcept
 {
     try {
-        auto& dir  = mod.dir_paths.get(compo.dir);
-        auto& file = mod.file_paths.get(compo.file);
+        std::vector<component_dir_scanner> scanners;
+        for (auto id : dirs) {
+            if (auto* dir = mod.dir_paths.try_to_get(id); dir) {
+                auto& scan = scanners.emplace_back();
+                scan.root  = dir->path.c_str();
+                scan.dir   = id;
+            }
+        }
 
-        std::filesystem::path file_path(dir.path.c_str());
-        file_path /= file.path.c_str();
-        bool read_description = false;
+        run_parallel_jobs(mod.task_mgr, scanners, &scan_component_dir);
 
+        for (auto& scan : scanners)
+            if (scan.scanned)
+                remove_deleted_files(mod, scan);
+
+        table<u64, file_path_id> index;
         {
-            std::ifstream ifs(file_path);
-            if (ifs.is_open()) {
-                reader r(ifs);
-                if (auto ret = r(mod, compo, mod.srcs); is_success(ret)) {
-                    read_description = true;
-                    compo.status     = component_status::unmodified;
+            file_path* file = nullptr;
+            while (mod.file_paths.next(file))
+                index.data.emplace_back(
+                  hash_file_path(file->parent, file->path.sv()),
+                  mod.file_paths.get_id(*file));
+            index.sort();
+        }
+
+        table<file_path_id, component_id> file_to_component;
+        {
+            component* compo = nullptr;
+            while (mod.components.next(compo))
+                if (is_defined(compo->file))
+                    file_to_component.data.emplace_back(
+                      compo->file, mod.components.get_id(*compo));
+            file_to_component.sort();
+        }
+
+        std::vector<component_file_loader> loaders;
+        for (auto& scan : scanners) {
+            if (auto* dir = mod.dir_paths.try_to_get(scan.dir); dir)
+                dir->status = dir_path::status_option::read;
+
+            for (auto& entry : scan.files) {
+                const auto key = hash_file_path(scan.dir, entry.name);
+
+                auto* file_id = index.get(key);
+                auto* file    = file_id ? mod.file_paths.try_to_get(*file_id)
+                                        : nullptr;
+
+                if (file && (file->parent != scan.dir ||
+                             file->path.sv() != entry.name))
+                    file = nullptr;
+
+                if (file && file->last_write_time == entry.last_write_time)
+                    continue;
+
+                // Unchanged since the previous run: read on first use.
+                const auto* cached =
+                  file ? nullptr : find_index_entry(scan, entry.name);
+                if (cached &&
+                    cached->last_write_time == entry.last_write_time) {
+                    auto* compo = add_file_component(mod, scan.dir, entry.path);
+                    irt_return_if_fail(compo,
+                                       status::data_array_not_enough_memory);
+
+                    auto& new_file           = mod.file_paths.get(compo->file);
+                    new_file.last_write_time = cached->last_write_time;
+                    new_file.hash            = cached->hash;
+                    continue;
+                }
+
+                auto& loader           = loaders.emplace_back();
+                loader.path            = entry.path;
+                loader.full_path       = scan.root / entry.path;
+                loader.dir             = scan.dir;
+                loader.last_write_time = entry.last_write_time;
+                loader.known_hash      = file     ? file->hash
+                                         : cached ? cached->hash
+                                                  : 0u;
+
+                if (file) {
+                    loader.file = mod.file_paths.get_id(*file);
+                    if (auto* id = file_to_component.get(loader.file); id)
+                        loader.compo = *id;
                 }
             }
         }
 
-        if (read_description) {
-            std::filesystem::path desc_file(file_path);
-            desc_file.replace_extension(".desc");
+        run_parallel_jobs(mod.task_mgr, loaders, &read_component_file);
+
+        // Register all the new files first: the components of this load can
+        // use each other.
+        for (auto& loader : loaders) {
+            if (is_defined(loader.file) || !loader.read)
+                continue;
 
-            if (std::ifstream ifs{ desc_file }; ifs) {
-                auto& desc = mod.descriptions.get(compo.desc);
+            if (!loader.is_unchanged() && is_bad(loader.parsed))
+                continue;
 
-                if (!ifs.read(desc.data.begin(), desc.data.capacity())) {
-                    mod.descriptions.free(desc);
-                    compo.desc  = undefined<description_id>();
-                    desc.status = description_status::unmodified;
-                }
+            auto* compo = add_file_component(mod, loader.dir, loader.path);
+            irt_return_if_fail(compo, status::data_array_not_enough_memory);
+
+            loader.file  = compo->file;
+            loader.compo = mod.components.get_id(*compo);
+        }
+
+        for (auto& loader : loaders) {
+            auto* file = mod.file_paths.try_to_get(loader.file);
+            if (!file || !loader.read)
+                continue;
+
+            if (loader.is_unchanged()) {
+                file->last_write_time = loader.last_write_time;
+                file->hash            = loader.hash;
+                continue;
+            }
+
+            // Keep the previous component and index if the file is invalid.
+            if (is_bad(loader.parsed))
+                continue;
+
+            auto* compo = mod.components.try_to_get(loader.compo);
+            if (!compo) {
+                irt_return_if_fail(mod.components.can_alloc(),
+                                   status::data_array_not_enough_memory);
+
+                compo = &mod.components.alloc();
+                compo->name.assign(loader.path.filename().string().c_str());
+                compo->dir  = loader.dir;
+                compo->file = loader.file;
+                compo->type = component_type::file;
+            }
+
+            if (is_success(commit_component(mod, loader, *compo))) {
+                file->last_write_time = loader.last_write_time;
+                file->hash            = loader.hash;
+            } else if (compo->status == component_status::unread) {
+                mod.free(*compo);
+            } else {
+                compo->status         = component_status::unread;
+                file->last_write_time = 0;
+                file->hash            = 0;
             }
         }
+
+        for (auto& scan : scanners)
+            if (scan.scanned)
+                write_component_index(mod, scan);
     } catch (...) {
+        return status::gui_not_enough_memory;
     }
+
+    return status::success;
 }
 
 status modeling::fill_components() noexcept
 {
-    prepare_component_loading(*this);
+    return load_components(*this, component_repertories);
+}
 
-    component* compo = nullptr;
-    while (components.next(compo)) {
-        if (compo->status == component_status::unread) {
-            load_component(*this, *compo);
-        }
-    }
+status modeling::fill_components(dir_path& path) noexcept
+{
+    vector<dir_path_id> dirs;
+    dirs.emplace_back(dir_paths.get_id(path));
 
-    return status::success;
+    return load_components(*this, dirs);
 }
 
-status modeling::fill_components(dir_path& path) noexcept
+status modeling::load(component& c) noexcept
 {
+    if (c.status != component_status::unread)
+        return status::success;
+
+    auto* dir  = dir_paths.try_to_get(c.dir);
+    auto* file = file_paths.try_to_get(c.file);
+    irt_return_if_fail(dir && file, status::io_file_format_error);
+
     try {
-        std::filesystem::path p(path.path.c_str());
-        std::error_code       ec;
+        component_file_loader loader;
+        loader.full_path = std::filesystem::path{ dir->path.c_str() };
+        loader.full_path /= file->path.c_str();
 
-        if (std::filesystem::exists(p, ec) &&
-            std::filesystem::is_directory(p, ec)) {
-            prepare_component_loading(*this, path, p);
-        }
+        read_component_file(&loader);
+        irt_return_if_fail(loader.read, status::io_file_format_error);
+        irt_return_if_bad(loader.parsed);
+        irt_return_if_bad(commit_component(*this, loader, c));
+
+        file->hash = loader.hash;
     } catch (...) {
+        irt_bad_return(status::io_not_enough_memory);
     }
 
     return status::success;
@@ -1330,45 +1508,9 @@ status modeling::connect(component& parent,
 //     return status::success;
 // }
 
-status build_simulation(modeling& /*mod*/, simulation& /*sim*/) noexcept
-{
-    // if (auto* c_ref = mod.component_refs.try_to_get(mod.head); c_ref)
-    //     if (auto* compo = mod.components.try_to_get(c_ref->id); compo)
-    //         return build_models(mod, *compo, sim);
-
-    irt_bad_return(status::success);
-}
-
-static void free_child(data_array<child, child_id>& children,
-                       data_array<model, model_id>& models,
-                       child&                       c) noexcept
-{
-    if (c.type == child_type::model) {
-        auto id = enum_cast<model_id>(c.id);
-        if (auto* mdl = models.try_to_get(id); mdl)
-            models.free(*mdl);
-    }
-
-    children.free(c);
-}
-
-static void free_connection(data_array<connection, connection_id>& connections,
-                            connection&                            con) noexcept
-{
-    connections.free(con);
-}
-
 void modeling::free(component& c) noexcept
 {
-    for (int i = 0, e = c.children.ssize(); i != e; ++i)
-        if (auto* child = children.try_to_get(c.children[i]); child)
-            free_child(children, models, *child);
-    c.children.clear();
-
-    for (int i = 0, e = c.connections.ssize(); i != e; ++i)
-        if (auto* cnt = connections.try_to_get(c.connections[i]); cnt)
-            free_connection(connections, *cnt);
-    c.connections.clear();
+    clear_component(*this, c);
 
     if (auto* desc = descriptions.try_to_get(c.desc); desc)
         descriptions.free(*desc);
@@ -1414,6 +1556,8 @@ void modeling::free(component& parent, connection& c) noexcept
 
 status modeling::copy(component& src, component& dst) noexcept
 {
+    irt_return_if_bad(load(src));
+
     table<child_id, child_id> mapping;
 
     for (i32 i = 0, e = src.children.ssize(); i != e; ++i) {
@@ -1468,32 +1612,31 @@ status modeling::copy(component& src, component& dst) noexcept
     return status::success;
 }
 
-static status make_tree_recursive(
-  data_array<child, child_id>&         children,
-  data_array<component, component_id>& components,
-  data_array<tree_node, tree_node_id>& trees,
-  tree_node&                           parent,
-  component_id                         child) noexcept
+static status make_tree_recursive(modeling&    mod,
+                                  tree_node&   parent,
+                                  child_id     from,
+                                  component_id child) noexcept
 {
-    if (auto* compo = components.try_to_get(child); compo) {
-        irt_return_if_fail(trees.can_alloc(),
+    if (auto* compo = mod.components.try_to_get(child); compo) {
+        irt_return_if_bad(mod.load(*compo));
+        irt_return_if_fail(mod.tree_nodes.can_alloc(),
                            status::data_array_not_enough_memory);
 
-        auto& new_tree = trees.alloc(child);
+        auto& new_tree      = mod.tree_nodes.alloc(child);
+        new_tree.from_child = from;
         new_tree.tree.set_id(&new_tree);
         new_tree.tree.parent_to(parent.tree);
 
         for (i32 i = 0, e = compo->children.ssize(); i != e; ++i) {
             auto child_id = compo->children[i];
 
-            if (auto* child = children.try_to_get(child_id); child) {
-                if (child->type == child_type::component) {
+            if (auto* c = mod.children.try_to_get(child_id); c) {
+                if (c->type == child_type::component) {
                     irt_return_if_bad(
-                      make_tree_recursive(children,
-                                          components,
-                                          trees,
+                      make_tree_recursive(mod,
                                           new_tree,
-                                          enum_cast<component_id>(child->id)));
+                                          child_id,
+                                          enum_cast<component_id>(c->id)));
                 }
             }
         }
@@ -1504,6 +1647,7 @@ static status make_tree_recursive(
 
 status modeling::make_tree_from(component& parent, tree_node_id* out) noexcept
 {
+    irt_return_if_bad(load(parent));
     irt_return_if_fail(tree_nodes.can_alloc(),
                        status::data_array_not_enough_memory);
 
@@ -1518,10 +1662,9 @@ status modeling::make_tree_from(component& parent, tree_node_id* out) noexcept
         if (auto* child = children.try_to_get(child_id); child) {
             if (child->type == child_type::component) {
                 irt_return_if_bad(
-                  make_tree_recursive(children,
-                                      components,
-                                      tree_nodes,
+                  make_tree_recursive(*this,
                                       tree_parent,
+                                      child_id,
                                       enum_cast<component_id>(child->id)));
             }
         }
@@ -1532,6 +1675,496 @@ status modeling::make_tree_from(component& parent, tree_node_id* out) noexcept
     return status::success;
 }
 
+static tree_node* find_tree_node(tree_node& parent, child_id id) noexcept
+{
+    for (auto* c = parent.tree.get_child(); c; c = c->tree.get_sibling())
+        if (c->from_child == id)
+            return c;
+
+    return nullptr;
+}
+
+static bool found_input_port(modeling&  mod,
+                             tree_node* node,
+                             i8         port,
+                             model_id&  model_found,
+                             i8&        port_found) noexcept
+{
+    while (node) {
+        auto* compo = mod.components.try_to_get(node->id);
+        if (!compo || !(0 <= port && port < compo->x.ssize()))
+            return false;
+
+        const auto& p     = compo->x[port];
+        auto*       child = mod.children.try_to_get(p.id);
+        if (!child)
+            return false;
+
+        if (child->type == child_type::model) {
+            auto* mapped_id = node->sim.get(enum_cast<model_id>(child->id));
+            if (!mapped_id)
+                return false;
+
+            model_found = *mapped_id;
+            port_found  = p.index;
+            return true;
+        }
+
+        node = find_tree_node(*node, p.id);
+        port = p.index;
+    }
+
+    return false;
+}
+
+static bool found_output_port(modeling&  mod,
+                              tree_node* node,
+                              i8         port,
+                              model_id&  model_found,
+                              i8&        port_found) noexcept
+{
+    while (node) {
+        auto* compo = mod.components.try_to_get(node->id);
+        if (!compo || !(0 <= port && port < compo->y.ssize()))
+            return false;
+
+        const auto& p     = compo->y[port];
+        auto*       child = mod.children.try_to_get(p.id);
+        if (!child)
+            return false;
+
+        if (child->type == child_type::model) {
+            auto* mapped_id = node->sim.get(enum_cast<model_id>(child->id));
+            if (!mapped_id)
+                return false;
+
+            model_found = *mapped_id;
+            port_found  = p.index;
+            return true;
+        }
+
+        node = find_tree_node(*node, p.id);
+        port = p.index;
+    }
+
+    return false;
+}
+
+//! Search the simulation model and output port connected to the output port
+//! @c port of the child @c id of the @c node component.
+static bool found_source(modeling&  mod,
+                         tree_node& node,
+                         child_id   id,
+                         i8         port,
+                         model_id&  model_found,
+                         i8&        port_found) noexcept
+{
+    auto* child = mod.children.try_to_get(id);
+    if (!child)
+        return false;
+
+    if (child->type == child_type::component)
+        return found_output_port(
+          mod, find_tree_node(node, id), port, model_found, port_found);
+
+    auto* mapped_id = node.sim.get(enum_cast<model_id>(child->id));
+    if (!mapped_id)
+        return false;
+
+    model_found = *mapped_id;
+    port_found  = port;
+    return true;
+}
+
+//! Search the simulation model and input port connected to the input port
+//! @c port of the child @c id of the @c node component.
+static bool found_destination(modeling&  mod,
+                              tree_node& node,
+                              child_id   id,
+                              i8         port,
+                              model_id&  model_found,
+                              i8&        port_found) noexcept
+{
+    auto* child = mod.children.try_to_get(id);
+    if (!child)
+        return false;
+
+    if (child->type == child_type::component)
+        return found_input_port(
+          mod, find_tree_node(node, id), port, model_found, port_found);
+
+    auto* mapped_id = node.sim.get(enum_cast<model_id>(child->id));
+    if (!mapped_id)
+        return false;
+
+    model_found = *mapped_id;
+    port_found  = port;
+    return true;
+}
+
+//! Call @c f for each connection of the @c node component which can be
+//! resolved into a connection between two simulation models. Connections
+//! to unconnected component ports are ignored.
+template<typename Function>
+static status for_each_connection(modeling&  mod,
+                                  tree_node& node,
+                                  Function&& f) noexcept
+{
+    auto* compo = mod.components.try_to_get(node.id);
+    if (!compo)
+        return status::success;
+
+    for (i32 i = 0, e = compo->connections.ssize(); i != e; ++i) {
+        auto* con = mod.connections.try_to_get(compo->connections[i]);
+        if (!con)
+            continue;
+
+        model_id src, dst;
+        i8       port_src, port_dst;
+
+        if (found_source(mod, node, con->src, con->index_src, src, port_src) &&
+            found_destination(
+              mod, node, con->dst, con->index_dst, dst, port_dst))
+            irt_return_if_bad(f(*con, src, port_src, dst, port_dst));
+    }
+
+    return status::success;
+}
+
+//! Call @c f with the ancestor for each connection of the ancestors of
+//! @c node which goes through the component ports of @c node or of one of
+//! its parents.
+template<typename Function>
+static status for_each_boundary_connection(modeling&  mod,
+                                           tree_node& node,
+                                           Function&& f) noexcept
+{
+    tree_node* child = &node;
+
+    while (auto* parent = child->tree.get_parent()) {
+        const auto id = child->from_child;
+
+        irt_return_if_bad(for_each_connection(
+          mod,
+          *parent,
+          [&f, parent, id](const connection& con,
+                           model_id          src,
+                           i8                port_src,
+                           model_id          dst,
+                           i8                port_dst) noexcept -> status {
+              if (con.src == id || con.dst == id)
+                  return f(*parent, src, port_src, dst, port_dst);
+
+              return status::success;
+          }));
+
+        child = parent;
+    }
+
+    return status::success;
+}
+
+//! Connects the two simulation models and records the connection in the
+//! @c node which owns the component connection.
+static status build_connection(simulation& sim,
+                               tree_node&  node,
+                               model_id    src,
+                               i8          port_src,
+                               model_id    dst,
+                               i8          port_dst) noexcept
+{
+    auto* src_mdl = sim.models.try_to_get(src);
+    auto* dst_mdl = sim.models.try_to_get(dst);
+    irt_return_if_fail(src_mdl && dst_mdl, status::unknown_dynamics);
+
+    irt_return_if_bad(sim.connect(*src_mdl, port_src, *dst_mdl, port_dst));
+    node.sim_connections.emplace_back(src, dst, port_src, port_dst);
+
+    return status::success;
+}
+
+static status build_models_recursively(modeling&   mod,
+                                       tree_node&  node,
+                                       simulation& sim) noexcept
+{
+    node.sim.data.clear();
+
+    if (auto* compo = mod.components.try_to_get(node.id); compo) {
+        for (i32 i = 0, e = compo->children.ssize(); i != e; ++i) {
+            auto* child = mod.children.try_to_get(compo->children[i]);
+            if (!child || child->type != child_type::model)
+                continue;
+
+            auto  src_id = enum_cast<model_id>(child->id);
+            auto* src    = mod.models.try_to_get(src_id);
+            if (!src)
+                continue;
+
+            irt_return_if_fail(sim.models.can_alloc(1),
+                               status::simulation_not_enough_model);
+
+            auto& dst = sim.clone(*src);
+            node.sim.data.emplace_back(src_id, sim.models.get_id(dst));
+        }
+    }
+
+    node.sim.sort();
+
+    for (auto* c = node.tree.get_child(); c; c = c->tree.get_sibling())
+        irt_return_if_bad(build_models_recursively(mod, *c, sim));
+
+    return status::success;
+}
+
+static status build_connections_recursively(modeling&   mod,
+                                            tree_node&  node,
+                                            simulation& sim) noexcept
+{
+    node.sim_connections.clear();
+
+    irt_return_if_bad(for_each_connection(
+      mod,
+      node,
+      [&sim, &node](const connection& /*con*/,
+                    model_id src,
+                    i8       port_src,
+                    model_id dst,
+                    i8       port_dst) noexcept -> status {
+          return build_connection(sim, node, src, port_src, dst, port_dst);
+      }));
+
+    for (auto* c = node.tree.get_child(); c; c = c->tree.get_sibling())
+        irt_return_if_bad(build_connections_recursively(mod, *c, sim));
+
+    return status::success;
+}
+
+static void collect_models(tree_node& node, vector<model_id>& out) noexcept
+{
+    for (i32 i = 0, e = node.sim.data.ssize(); i != e; ++i)
+        out.emplace_back(node.sim.data[i].value);
+
+    for (auto* c = node.tree.get_child(); c; c = c->tree.get_sibling())
+        collect_models(*c, out);
+}
+
+static bool contains(const vector<model_id>& sorted, model_id id) noexcept
+{
+    return std::binary_search(sorted.begin(), sorted.end(), id);
+}
+
+static void free_tree_recursively(modeling& mod, tree_node& node) noexcept
+{
+    while (auto* c = node.tree.get_child())
+        free_tree_recursively(mod, *c);
+
+    mod.free(node);
+}
+
+//! Synchronizes the children of @c node with the component children of the
+//! @c node component: removed children are freed and new children are
+//! allocated.
+static status sync_tree_node(modeling& mod, tree_node& node) noexcept
+{
+    auto* compo = mod.components.try_to_get(node.id);
+    if (!compo)
+        return status::success;
+
+    auto* c = node.tree.get_child();
+    while (c) {
+        auto* next  = c->tree.get_sibling();
+        auto* child = mod.children.try_to_get(c->from_child);
+
+        if (!child || child->type != child_type::component ||
+            enum_cast<component_id>(child->id) != c->id ||
+            compo->children.find(c->from_child) >= compo->children.ssize())
+            free_tree_recursively(mod, *c);
+
+        c = next;
+    }
+
+    for (i32 i = 0, e = compo->children.ssize(); i != e; ++i) {
+        const auto child_id = compo->children[i];
+        auto*      child    = mod.children.try_to_get(child_id);
+
+        if (child && child->type == child_type::component &&
+            !find_tree_node(node, child_id))
+            irt_return_if_bad(make_tree_recursive(
+              mod, node, child_id, enum_cast<component_id>(child->id)));
+    }
+
+    return status::success;
+}
+
+//! Rebuilds the models of the @c node instance then rewires the connections
+//! inside the instance and the connections from the ancestors that reach the
+//! instance through the component ports. The new models are initialized at
+//! @c t.
+static status update_tree_node(modeling&   mod,
+                               simulation& sim,
+                               tree_node&  node,
+                               time        t) noexcept
+{
+    irt_return_if_bad(unbuild_simulation(sim, node, t));
+    irt_return_if_bad(sync_tree_node(mod, node));
+    irt_return_if_bad(build_models_recursively(mod, node, sim));
+    irt_return_if_bad(build_connections_recursively(mod, node, sim));
+
+    vector<model_id> models;
+    collect_models(node, models);
+    std::sort(models.begin(), models.end());
+
+    for (i32 i = 0, e = models.ssize(); i != e; ++i)
+        if (auto* mdl = sim.models.try_to_get(models[i]); mdl)
+            irt_return_if_bad(sim.make_initialize(*mdl, t));
+
+    return for_each_boundary_connection(
+      mod,
+      node,
+      [&sim, &models](tree_node& parent,
+                      model_id   src,
+                      i8         port_src,
+                      model_id   dst,
+                      i8         port_dst) noexcept -> status {
+          if (contains(models, src) || contains(models, dst))
+              return build_connection(
+                sim, parent, src, port_src, dst, port_dst);
+
+          return status::success;
+      });
+}
+
+static status update_instances_recursively(modeling&    mod,
+                                           simulation&  sim,
+                                           tree_node&   node,
+                                           component_id id,
+                                           time         t) noexcept
+{
+    if (node.id == id)
+        return update_tree_node(mod, sim, node, t);
+
+    for (auto* c = node.tree.get_child(); c; c = c->tree.get_sibling())
+        irt_return_if_bad(update_instances_recursively(mod, sim, *c, id, t));
+
+    return status::success;
+}
+
+status build_simulation(modeling& mod, simulation& sim) noexcept
+{
+    auto* head = mod.tree_nodes.try_to_get(mod.head);
+    irt_return_if_fail(head, status::unknown_dynamics);
+
+    irt_return_if_bad(build_models_recursively(mod, *head, sim));
+
+    return build_connections_recursively(mod, *head, sim);
+}
+
+status update_simulation(modeling&    mod,
+                         simulation&  sim,
+                         component_id id,
+                         time         t) noexcept
+{
+    auto* head = mod.tree_nodes.try_to_get(mod.head);
+    irt_return_if_fail(head, status::unknown_dynamics);
+
+    return update_instances_recursively(mod, sim, *head, id, t);
+}
+
+//! Removes from the output port of @c c.src its connection to @c c.dst.
+static void remove_connection(simulation&           sim,
+                              const sim_connection& c) noexcept
+{
+    auto* mdl = sim.models.try_to_get(c.src);
+    if (!mdl)
+        return;
+
+    dispatch(*mdl, [&sim, &c]<typename Dynamics>(Dynamics& dyn) -> void {
+        if constexpr (is_detected_v<has_output_port_t, Dynamics>) {
+            auto list = append_node(sim, dyn.y[c.port_src]);
+            for (auto it = list.begin(), end = list.end(); it != end; ++it) {
+                if (it->model == c.dst && it->port_index == c.port_dst) {
+                    list.erase(it);
+                    return;
+                }
+            }
+        }
+    });
+}
+
+//! Removes the connections recorded by the ancestors of @c node from the
+//! models outside @c models to the models of @c models. The connections
+//! from @c models are removed with their source models and are forgotten.
+static void disconnect_inputs(simulation&             sim,
+                              tree_node&              node,
+                              const vector<model_id>& models) noexcept
+{
+    for (auto* p = node.tree.get_parent(); p; p = p->tree.get_parent()) {
+        auto& cons = p->sim_connections;
+
+        for (i32 i = 0; i < cons.ssize();) {
+            const bool from_models = contains(models, cons[i].src);
+            const bool to_models   = contains(models, cons[i].dst);
+
+            if (!from_models && !to_models) {
+                ++i;
+                continue;
+            }
+
+            if (!from_models)
+                remove_connection(sim, cons[i]);
+
+            cons.swap_pop_back(i);
+        }
+    }
+}
+
+//! Finalizes at @c t and deallocates the models of @c node and its children.
+//! All the models are deallocated, the first failure is returned.
+static status deallocate_recursively(simulation& sim,
+                                     tree_node&  node,
+                                     time        t) noexcept
+{
+    status ret = status::success;
+
+    for (i32 i = 0, e = node.sim.data.ssize(); i != e; ++i) {
+        auto* mdl = sim.models.try_to_get(node.sim.data[i].value);
+        if (!mdl)
+            continue;
+
+        auto finalized =
+          dispatch(*mdl, [&sim, mdl, t]<typename Dynamics>(Dynamics& dyn) {
+              return sim.make_finalize(
+                *mdl, dyn, sim.observers.try_to_get(mdl->obs_id), t);
+          });
+
+        if (is_bad(finalized) && is_success(ret))
+            ret = finalized;
+
+        sim.deallocate(node.sim.data[i].value);
+    }
+
+    node.sim.data.clear();
+    node.sim_connections.clear();
+
+    for (auto* c = node.tree.get_child(); c; c = c->tree.get_sibling())
+        if (auto child_ret = deallocate_recursively(sim, *c, t);
+            is_bad(child_ret) && is_success(ret))
+            ret = child_ret;
+
+    return ret;
+}
+
+status unbuild_simulation(simulation& sim, tree_node& node, time t) noexcept
+{
+    vector<model_id> models;
+    collect_models(node, models);
+    std::sort(models.begin(), models.end());
+
+    disconnect_inputs(sim, node, models);
+
+    return deallocate_recursively(sim, node, t);
+}
+
 status modeling::clean(component& c) noexcept
 {
     int  i              = 0;
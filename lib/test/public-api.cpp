@@ -3,11 +3,17 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 
 #include <irritator/core.hpp>
+#include <irritator/distributed.hpp>
+#include <irritator/ensemble.hpp>
 #include <irritator/examples.hpp>
 #include <irritator/ext.hpp>
 #include <irritator/external_source.hpp>
 #include <irritator/file.hpp>
 #include <irritator/io.hpp>
+#include <irritator/modeling.hpp>
+#include <irritator/partition.hpp>
+#include <irritator/timewarp.hpp>
+#include <irritator/trace.hpp>
 
 #include <fmt/format.h>
 
@@ -16,6 +22,7 @@
 #include <numeric>
 #include <random>
 #include <sstream>
+#include <thread>
 
 #include <cstdio>
 
@@ -809,6 +816,98 @@ int main()
         }
     };
 
+    "heap"_test = [] {
+        irt::block_allocator<irt::list_view_node<irt::dated_message>>
+          allocator;
+        expect(is_success(allocator.init(256)));
+
+        irt::u32       id = static_cast<irt::u32>(-1);
+        irt::heap_view heap(allocator, id);
+        expect(heap.empty());
+
+        std::mt19937                              gen(1234);
+        std::uniform_real_distribution<irt::real> dist(0, 100);
+
+        for (int i = 0; i != 200; ++i)
+            heap.emplace(dist(gen), irt::real(i), irt::zero, irt::zero);
+
+        irt::real last = 0;
+        for (int i = 0; i != 100; ++i) {
+            expect(heap.top()[0] >= last);
+            last = heap.top()[0];
+            heap.pop();
+        }
+
+        for (int i = 0; i != 50; ++i)
+            heap.emplace(last + dist(gen), irt::zero, irt::zero, irt::zero);
+
+        int popped = 0;
+        for (; !heap.empty(); ++popped) {
+            expect(heap.top()[0] >= last);
+            last = heap.top()[0];
+            heap.pop();
+        }
+
+        expect(popped == 150);
+        expect(allocator.used() == 0u);
+
+        for (int i = 0; i != 100; ++i)
+            heap.emplace(dist(gen), irt::zero, irt::zero, irt::zero);
+
+        heap.clear();
+        expect(heap.empty());
+        expect(allocator.used() == 0u);
+    };
+
+    "queue_same_date_order"_test = [] {
+        // The messages of the same release date leave the queues in their
+        // arrival order.
+        const auto check = []<typename Dynamics>() noexcept {
+            irt::simulation      sim;
+            irt::external_source srcs;
+            sim.source_dispatch = srcs;
+
+            expect(irt::is_success(sim.init(64lu, 256lu)));
+            expect(irt::is_success(srcs.init(4lu)));
+
+            auto& cst = srcs.constant_sources.alloc();
+            expect(irt::is_success(cst.init(32)));
+            cst.buffer = { 1. };
+
+            auto& queue = sim.alloc<Dynamics>();
+            auto& cnt   = sim.alloc<irt::counter>();
+            queue.default_source_ta.id =
+              irt::ordinal(srcs.constant_sources.get_id(cst));
+            queue.default_source_ta.type =
+              irt::ordinal(irt::external_source_type::constant);
+            expect(sim.connect(queue, 0, cnt, 0) == irt::status::success);
+            expect(irt::is_success(queue.initialize(sim)));
+
+            for (int round = 0; round != 2; ++round) {
+                auto inputs = irt::append_message(sim, queue.x[0]);
+                for (int i = 0; i != 16; ++i)
+                    inputs.emplace_back(irt::real(i), irt::zero, irt::zero);
+
+                expect(irt::is_success(queue.transition(sim, 0, 0, 0)));
+                inputs.clear();
+
+                sim.emitting_output_ports.clear();
+                expect(irt::is_success(queue.lambda(sim)));
+                expect(sim.emitting_output_ports.ssize() == 16);
+
+                for (int i = 0, e = sim.emitting_output_ports.ssize(); i != e;
+                     ++i)
+                    expect(sim.emitting_output_ports[i].msg[0] ==
+                           irt::real(i));
+            }
+
+            expect(irt::is_success(queue.finalize(sim)));
+        };
+
+        check.template operator()<irt::dynamic_queue>();
+        check.template operator()<irt::priority_queue>();
+    };
+
     "vector"_test = [] {
         struct position
         {
@@ -993,6 +1092,81 @@ int main()
         }
     };
 
+    "data_array_dense"_test = [] {
+        irt::data_array<int, irt::model_id> array;
+        expect(irt::is_success(array.init(1000)));
+
+        for (int i = 0; i != 1000; ++i)
+            array.alloc(i);
+
+        for (int i = 0; i < 1000; i += 3)
+            array.free(irt::make_id<irt::model_id>(
+              static_cast<irt::u32>(i + 1), static_cast<irt::u32>(i)));
+
+        expect(array.size() == 666_ul);
+        expect(array.max_used() == 1000_u);
+
+        int  number = 0;
+        int* value  = nullptr;
+        while (array.next(value)) {
+            expect(*value % 3 != 0);
+            ++number;
+        }
+
+        expect(number == 666);
+
+        array.sort();
+
+        int previous = -1;
+        number       = 0;
+        value        = nullptr;
+        while (array.next(value)) {
+            expect(*value > previous);
+            previous = *value;
+            ++number;
+        }
+
+        expect(number == 666);
+
+        array.clear();
+        value = nullptr;
+        expect(!array.next(value));
+    };
+
+    "data_array_free_during_next"_test = [] {
+        irt::data_array<int, irt::model_id> array;
+        expect(irt::is_success(array.init(100)));
+
+        for (int i = 0; i != 100; ++i)
+            array.alloc(i);
+
+        int  visited = 0;
+        int* value   = nullptr;
+        while (array.next(value)) {
+            ++visited;
+            if (*value % 2 == 0)
+                array.free(*value);
+        }
+
+        expect(visited == 100);
+        expect(array.size() == 50_ul);
+
+        int number = 0;
+        value      = nullptr;
+        while (array.next(value)) {
+            expect(*value % 2 != 0);
+            ++number;
+        }
+
+        expect(number == 50);
+
+        value = nullptr;
+        while (array.next(value))
+            array.free(*value);
+
+        expect(array.size() == 0_ul);
+    };
+
     "message"_test = [] {
         using namespace irt::literals;
 
@@ -1370,6 +1544,27 @@ int main()
             expect(sim.models.size() == 51);
         }
 
+        {
+            std::istringstream is(str);
+
+            irt::simulation      sim;
+            irt::external_source srcs;
+            expect(irt::is_success(srcs.init(64u)));
+
+            irt::reader r(is);
+            expect(irt::is_success(r.read_header(srcs)));
+            expect(r.model_count() == 51);
+
+            expect(irt::is_success(sim.init(r.model_count(), 32lu)));
+            expect(irt::is_success(r.read_models(sim)));
+            expect(sim.models.size() == 51);
+
+            for (int i = 0; i != 51; ++i)
+                expect(sim.models.try_to_get(r.get_model(i)) != nullptr);
+
+            expect(irt::is_undefined(r.get_model(51)));
+        }
+
         {
             std::string string_error{
                 "0 0 0 0\n1\n0 5 6 qss1_integrator A B C\n"
@@ -1504,6 +1699,1086 @@ int main()
         expect(cnt.number == static_cast<irt::i64>(10));
     };
 
+    "ensemble_generator_counter"_test = [] {
+        fmt::print("ensemble_generator_counter\n");
+        irt::simulation      sim;
+        irt::external_source srcs;
+        sim.source_dispatch = srcs;
+
+        expect(irt::is_success(sim.init(16lu, 256lu)));
+        expect(irt::is_success(srcs.init(4lu)));
+
+        auto& cst_value = srcs.constant_sources.alloc();
+        expect(irt::is_success(cst_value.init(32)));
+        cst_value.buffer = { 1. };
+
+        auto& rnd_ta = srcs.random_sources.alloc();
+        expect(irt::is_success(rnd_ta.init(srcs.block_size, 4)));
+        rnd_ta.distribution = irt::distribution_type::uniform_real;
+        rnd_ta.a            = 0.5;
+        rnd_ta.b            = 1.5;
+
+        auto& gen = sim.alloc<irt::generator>();
+        auto& cnt = sim.alloc<irt::counter>();
+
+        gen.default_source_value.id =
+          irt::ordinal(srcs.constant_sources.get_id(cst_value));
+        gen.default_source_value.type =
+          irt::ordinal(irt::external_source_type::constant);
+        gen.default_source_ta.id =
+          irt::ordinal(srcs.random_sources.get_id(rnd_ta));
+        gen.default_source_ta.type =
+          irt::ordinal(irt::external_source_type::random);
+
+        expect(sim.connect(gen, 0, cnt, 0) == irt::status::success);
+
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        expect(irt::is_success(tm.init(init)));
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        irt::ensemble ens;
+        expect(irt::is_success(
+          ens.init({ .replicates = 16, .workers = 2, .seed = 42 })));
+        ens.observe(sim.get_id(cnt));
+        expect(irt::is_success(ens.run(
+          tm.task_lists[0], sim, srcs, 0, 100, nullptr, nullptr)));
+        expect(ens.workers.size() == 2u);
+
+        expect(ens.statistics.ssize() == 1);
+        expect(ens.statistics[0].count == 16);
+        expect(ens.statistics[0].mean > 80.0);
+        expect(ens.statistics[0].mean < 120.0);
+        expect(ens.statistics[0].min < ens.statistics[0].max);
+
+        // Other workers and copy-on-write: the replicates keep their values.
+        irt::ensemble same;
+        expect(irt::is_success(same.init({ .replicates    = 16,
+                                           .workers       = 3,
+                                           .seed          = 42,
+                                           .copy_on_write = true })));
+        same.observe(sim.get_id(cnt));
+        expect(irt::is_success(same.run(
+          tm.task_lists[0],
+          sim,
+          srcs,
+          0,
+          100,
+          [](irt::ensemble_replicate& rep, void* param) noexcept {
+              auto* cnt_id = reinterpret_cast<irt::model_id*>(param);
+              auto* mdl    = rep.get(*cnt_id);
+              return mdl ? irt::status::success
+                         : irt::status::unknown_dynamics;
+          },
+          &ens.observed[0])));
+
+        for (int i = 0; i < 16; ++i)
+            expect(same.value(i, 0) == ens.value(i, 0));
+
+        tm.finalize();
+    };
+
+    "checkpoint_restore"_test = [] {
+        fmt::print("checkpoint_restore\n");
+
+        // A Lotka-Volterra model and a generator with a random time advance
+        // feeding a queue and a counter.
+        const auto build = [](irt::simulation&      sim,
+                              irt::external_source& srcs) noexcept {
+            sim.source_dispatch = srcs;
+            expect(irt::is_success(sim.init(64lu, 256lu)));
+            expect(irt::is_success(srcs.init(4lu)));
+            expect(irt::is_success(irt::example_qss_lotka_volterra<2>(
+              sim, [](irt::model_id) noexcept {})));
+
+            auto& cst = srcs.constant_sources.alloc();
+            expect(irt::is_success(cst.init(32)));
+            cst.buffer = { 1., 2., 3. };
+
+            // Small blocks to regenerate the random values after restore.
+            auto& rnd = srcs.random_sources.alloc();
+            expect(irt::is_success(rnd.init(8, 4)));
+            rnd.distribution = irt::distribution_type::uniform_real;
+            rnd.a            = 0.1;
+            rnd.b            = 1.0;
+
+            auto& gen = sim.alloc<irt::generator>();
+            auto& que = sim.alloc<irt::queue>();
+            auto& cnt = sim.alloc<irt::counter>();
+
+            gen.default_source_value.id =
+              irt::ordinal(srcs.constant_sources.get_id(cst));
+            gen.default_source_value.type =
+              irt::ordinal(irt::external_source_type::constant);
+            gen.default_source_ta.id =
+              irt::ordinal(srcs.random_sources.get_id(rnd));
+            gen.default_source_ta.type =
+              irt::ordinal(irt::external_source_type::random);
+            que.default_ta = 0.5;
+
+            expect(sim.connect(gen, 0, que, 0) == irt::status::success);
+            expect(sim.connect(que, 0, cnt, 0) == irt::status::success);
+        };
+
+        // The date of each bag then the dates of the models.
+        const auto run = [](irt::simulation&        sim,
+                            irt::time&              t,
+                            irt::time               end,
+                            std::vector<irt::real>& out) noexcept {
+            do {
+                expect(irt::is_success(sim.run(t)));
+                out.emplace_back(t);
+            } while (t < end);
+
+            irt::model* mdl = nullptr;
+            while (sim.models.next(mdl)) {
+                out.emplace_back(mdl->tl);
+                out.emplace_back(mdl->tn);
+            }
+        };
+
+        std::error_code ec;
+        auto            file_path = std::filesystem::temp_directory_path(ec);
+        file_path /= "irritator-checkpoint.bin";
+
+        std::vector<irt::real> expected, restored;
+        irt::time              checkpoint_t = 0;
+
+        {
+            irt::simulation      sim;
+            irt::external_source srcs;
+            build(sim, srcs);
+
+            irt::time t = 0;
+            expect(irt::is_success(sim.initialize(t)));
+            run(sim, t, 10, expected);
+            expected.clear();
+
+            {
+                irt::file f(file_path.string().c_str(), irt::open_mode::write);
+                expect(irt::is_success(srcs.checkpoint(f)));
+                expect(irt::is_success(sim.checkpoint(f, t)));
+            }
+
+            checkpoint_t = t;
+            run(sim, t, 30, expected);
+        }
+
+        {
+            irt::simulation      sim;
+            irt::external_source srcs;
+            build(sim, srcs);
+
+            irt::time t = 0;
+            {
+                irt::file f(file_path.string().c_str(), irt::open_mode::read);
+                expect(irt::is_success(srcs.restore(f)));
+                expect(irt::is_success(sim.restore(f, t)));
+            }
+
+            expect(t == checkpoint_t);
+            run(sim, t, 30, restored);
+        }
+
+        expect(expected.size() > 100u);
+        expect(expected == restored);
+    };
+
+    "run_until"_test = [] {
+        const auto build = [](irt::simulation& sim) noexcept {
+            expect(irt::is_success(sim.init(32lu, 256lu)));
+            expect(irt::is_success(irt::example_qss_lotka_volterra<2>(
+              sim, [](irt::model_id) noexcept {})));
+        };
+
+        std::vector<irt::real> expected, found;
+
+        {
+            irt::simulation sim;
+            build(sim);
+
+            irt::time t = 0;
+            expect(irt::is_success(sim.initialize(t)));
+            while (t < 10) {
+                expect(irt::is_success(sim.run(t)));
+                if (t < 10)
+                    expected.emplace_back(t);
+            }
+        }
+
+        {
+            irt::simulation sim;
+            build(sim);
+
+            irt::time t = 0;
+            expect(irt::is_success(sim.initialize(t)));
+
+            irt::i64 events = 0;
+            expect(irt::is_success(sim.run_until(t, 10, events)));
+            expect(t == 0);
+
+            while (t < 10) {
+                events = 3;
+                expect(irt::is_success(sim.run_until(t, 10, events)));
+                expect(events <= 0 || t >= 10);
+                if (t < 10)
+                    found.emplace_back(t);
+            }
+        }
+
+        // The run_until calls stop on the budget at the end of a bag.
+        expect(expected.size() > 100u);
+        expect(found.size() <= expected.size());
+        expect(std::includes(expected.begin(),
+                             expected.end(),
+                             found.begin(),
+                             found.end()));
+    };
+
+    "timewarp"_test = [] {
+        fmt::print("timewarp\n");
+        irt::simulation sim;
+        expect(irt::is_success(sim.init(32lu, 256lu)));
+
+        // Two Lotka-Volterra models: the feedback loops cross the processes.
+        for (int i = 0; i < 2; ++i)
+            expect(irt::is_success(irt::example_qss_lotka_volterra<2>(
+              sim, [](irt::model_id) noexcept {})));
+
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        expect(irt::is_success(tm.init(init)));
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        irt::timewarp tw;
+        expect(irt::is_success(tw.init({ .processes        = 3,
+                                         .bags_per_round   = 8,
+                                         .state_period     = 3,
+                                         .message_capacity = 256 })));
+        expect(irt::is_success(tw.build(tm.task_lists[0], sim)));
+        expect(irt::is_success(tw.run(tm.task_lists[0], 0, 30)));
+        expect(!(tw.gvt.t < 30));
+        expect(tw.rollbacks() > 0);
+
+        tm.finalize();
+
+        irt::time t      = 0;
+        irt::i64  events = std::numeric_limits<irt::i64>::max();
+        expect(irt::is_success(sim.initialize(t)));
+        expect(irt::is_success(sim.run_until(t, 30, events)));
+
+        // The optimistic run gives the same models as the sequential run.
+        irt::model* mdl = nullptr;
+        while (sim.models.next(mdl)) {
+            auto* copied = tw.get(sim.models.get_id(*mdl));
+            expect(copied != nullptr);
+            if (!copied)
+                continue;
+
+            expect(copied->tl == mdl->tl);
+            expect(copied->tn == mdl->tn);
+
+            irt::dispatch(
+              *mdl, [copied]<typename Dynamics>(const Dynamics& dyn) {
+                  if constexpr (irt::is_detected_v<irt::observation_function_t,
+                                                   Dynamics>) {
+                      const auto& other = irt::get_dyn<Dynamics>(*copied);
+                      expect(dyn.observation(0)[0] == other.observation(0)[0]);
+                  }
+              });
+        }
+    };
+
+    "partition"_test = [] {
+        irt::simulation sim;
+        expect(irt::is_success(sim.init(64lu, 256lu)));
+
+        // Four Lotka-Volterra models in a ring of counters: each counter
+        // receives from two neighbor models.
+        std::vector<irt::model_id> integrators;
+        for (int i = 0; i < 4; ++i) {
+            int index = 0;
+            expect(irt::is_success(irt::example_qss_lotka_volterra<1>(
+              sim, [&](irt::model_id id) noexcept {
+                  if (index++ == 3)
+                      integrators.emplace_back(id);
+              })));
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            auto& cnt = sim.alloc<irt::counter>();
+            expect(irt::is_success(global_connect(
+              sim, sim.models.get(integrators[i]), 0, sim.get_id(cnt), 0)));
+            expect(irt::is_success(
+              global_connect(sim,
+                             sim.models.get(integrators[(i + 1) % 4]),
+                             0,
+                             sim.get_id(cnt),
+                             0)));
+        }
+
+        irt::partitioner part;
+        expect(irt::is_success(part.build(sim)));
+        expect(part.graph.vertices() == 24);
+        expect(part.graph.edges() == 4 * 6 + 8);
+
+        expect(irt::is_success(part.partition({ .parts = 4 })));
+        expect(part.cut == 4);
+
+        // The balance allows the average weight plus the heaviest vertex.
+        for (const auto w : part.part_weights)
+            expect(5 <= w && w <= 7);
+
+        // The warm-up weights the edges of the integrators by their traffic.
+        expect(irt::is_success(part.warm_up(sim, 0, 10)));
+        expect(irt::is_success(part.build(sim)));
+        const auto v = part.find(integrators[0]);
+        expect(v >= 0);
+        expect(part.graph.vertex_weights[v] > 1);
+
+        expect(irt::is_success(part.partition({ .parts = 2 })));
+        expect(part.part_weights[0] + part.part_weights[1] ==
+               part.graph.total_weight());
+
+        std::ostringstream os;
+        expect(irt::is_success(part.write_metis(os)));
+
+        std::istringstream is(os.str());
+        std::string        comment;
+        int                n = 0, m = 0;
+        std::string        format;
+        std::getline(is, comment);
+        is >> n >> m >> format;
+        expect(comment[0] == '%');
+        expect(n == 24);
+        expect(m == part.graph.edges());
+        expect(format == "011");
+
+        irt::timewarp tw;
+        expect(irt::is_success(tw.init({ .processes = 2 })));
+        part.assign(tw);
+        tw.partition.sort();
+        for (irt::i32 i = 0; i != part.models.ssize(); ++i) {
+            const auto* process = tw.partition.get(part.models[i]);
+            expect(process && *process == part.parts[i]);
+        }
+    };
+
+#if !defined(_WIN32)
+    "distributed"_test = [] {
+        fmt::print("distributed\n");
+        std::string str;
+
+        {
+            irt::simulation      sim;
+            irt::external_source srcs;
+            expect(irt::is_success(sim.init(32lu, 256lu)));
+            expect(irt::is_success(srcs.init(4u)));
+
+            for (int i = 0; i < 2; ++i)
+                expect(irt::is_success(irt::example_qss_lotka_volterra<2>(
+                  sim, [](irt::model_id) noexcept {})));
+
+            std::ostringstream os;
+            irt::writer        w(os);
+            expect(irt::is_success(w(sim, srcs)));
+            str = os.str();
+        }
+
+        {
+            irt::simulation sim;
+            expect(irt::is_success(sim.init(4lu, 16lu)));
+
+            auto& cst    = sim.alloc<irt::constant>();
+            auto& q      = sim.alloc<irt::queue>();
+            auto& cnt    = sim.alloc<irt::counter>();
+            q.default_ta = 2;
+
+            expect(irt::time_domain<irt::time>::is_infinity(
+              irt::lookahead(get_model(cst))));
+            expect(irt::lookahead(get_model(q)) == 2);
+            expect(irt::lookahead(get_model(cnt)) == 0);
+        }
+
+        constexpr int processes = 3;
+        const auto    prefix =
+          (std::filesystem::temp_directory_path() /
+           fmt::format("irritator-test-{}",
+                       std::chrono::steady_clock::now()
+                         .time_since_epoch()
+                         .count()))
+            .string();
+
+        irt::distributed dists[processes];
+        irt::status      results[processes];
+
+        {
+            std::vector<std::thread> threads;
+            for (int rank = 0; rank < processes; ++rank) {
+                threads.emplace_back([&, rank]() {
+                    irt::simulation            whole;
+                    irt::external_source       srcs;
+                    irt::unix_socket_transport sockets;
+                    std::istringstream         is(str);
+                    auto&                      d = dists[rank];
+
+                    auto st = whole.init(32lu, 256lu);
+                    if (irt::is_success(st))
+                        st = srcs.init(4u);
+                    if (irt::is_success(st))
+                        st = sockets.open(rank, processes, prefix.c_str());
+                    if (irt::is_success(st))
+                        st = d.init({ .rank             = rank,
+                                      .processes        = processes,
+                                      .message_capacity = 256 },
+                                    sockets.get());
+                    if (irt::is_success(st))
+                        st = d.load(is, whole, srcs);
+                    if (irt::is_success(st))
+                        st = d.run(0, 30);
+
+                    results[rank] = st;
+                });
+            }
+
+            for (auto& t : threads)
+                t.join();
+        }
+
+        irt::i64 messages = 0;
+        for (int rank = 0; rank < processes; ++rank) {
+            expect(irt::is_success(results[rank]));
+            expect(!(dists[rank].gvt.t < 30));
+            expect(dists[rank].rounds > 0);
+            messages += dists[rank].messages;
+        }
+        expect(messages > 0);
+
+        irt::simulation      sim;
+        irt::external_source srcs;
+        expect(irt::is_success(sim.init(32lu, 256lu)));
+        expect(irt::is_success(srcs.init(4u)));
+
+        std::istringstream is(str);
+        irt::reader        r(is);
+        expect(irt::is_success(r(sim, srcs)));
+
+        irt::time t      = 0;
+        irt::i64  events = std::numeric_limits<irt::i64>::max();
+        expect(irt::is_success(sim.initialize(t)));
+        expect(irt::is_success(sim.run_until(t, 30, events)));
+
+        // Each model belongs to one process and ends as in the sequential
+        // run.
+        irt::model* mdl = nullptr;
+        while (sim.models.next(mdl)) {
+            irt::model* copied = nullptr;
+            int         owners = 0;
+            for (auto& d : dists) {
+                if (auto* found = d.get(sim.models.get_id(*mdl)); found) {
+                    copied = found;
+                    ++owners;
+                }
+            }
+
+            expect(owners == 1);
+            if (!copied)
+                continue;
+
+            expect(copied->tl == mdl->tl);
+            expect(copied->tn == mdl->tn);
+
+            irt::dispatch(
+              *mdl, [copied]<typename Dynamics>(const Dynamics& dyn) {
+                  if constexpr (irt::is_detected_v<irt::observation_function_t,
+                                                   Dynamics>) {
+                      const auto& other = irt::get_dyn<Dynamics>(*copied);
+                      expect(dyn.observation(0)[0] == other.observation(0)[0]);
+                  }
+              });
+        }
+    };
+#endif
+
+    "simulation_of"_test = [] {
+        using lotka_volterra = irt::simulation_of<irt::qss2_integrator,
+                                                  irt::qss2_multiplier,
+                                                  irt::qss2_wsum_2>;
+
+        irt::simulation sim;
+        lotka_volterra  spe;
+        expect(irt::is_success(sim.init(16lu, 256lu)));
+        expect(irt::is_success(spe.init(16lu, 256lu)));
+
+        expect(irt::is_success(irt::example_qss_lotka_volterra<2>(
+          sim, [](irt::model_id) noexcept {})));
+        expect(irt::is_success(irt::example_qss_lotka_volterra<2>(
+          spe, [](irt::model_id) noexcept {})));
+
+        static_assert(lotka_volterra::dispatcher::accepts(
+          irt::dynamics_type::qss2_wsum_2));
+        static_assert(!lotka_volterra::dispatcher::accepts(
+          irt::dynamics_type::qss2_wsum_3));
+
+        irt::time t1 = 0, t2 = 0;
+        irt::i64  events1 = std::numeric_limits<irt::i64>::max();
+        irt::i64  events2 = events1;
+        expect(irt::is_success(sim.initialize(t1)));
+        expect(irt::is_success(spe.initialize(t2)));
+        expect(irt::is_success(sim.run_until(t1, 30, events1)));
+        expect(irt::is_success(spe.run_until(t2, 30, events2)));
+        expect(t1 == t2);
+        expect(events1 == events2);
+
+        irt::model* mdl = nullptr;
+        while (sim.models.next(mdl)) {
+            const auto& other = spe.models.get(sim.models.get_id(*mdl));
+            expect(other.tl == mdl->tl);
+            expect(other.tn == mdl->tn);
+
+            irt::dispatch(
+              *mdl, [&other]<typename Dynamics>(const Dynamics& dyn) {
+                  if constexpr (irt::is_detected_v<irt::observation_function_t,
+                                                   Dynamics>) {
+                      const auto& d = irt::get_dyn<Dynamics>(other);
+                      expect(dyn.observation(0)[0] == d.observation(0)[0]);
+                  }
+              });
+        }
+
+        expect(irt::is_success(spe.finalize(t2)));
+
+        // A model of another type, allocated through the simulation, stops
+        // the initialization.
+        irt::simulation& base = spe;
+        base.alloc<irt::counter>();
+        irt::is_fatal_breakpoint = false;
+        expect(spe.initialize(0) == irt::status::unknown_dynamics);
+        irt::is_fatal_breakpoint = true;
+    };
+
+    "simulation_copy"_test = [] {
+        irt::simulation sim;
+        expect(irt::is_success(sim.init(16lu, 256lu)));
+
+        std::vector<irt::model_id> ids;
+        expect(irt::is_success(irt::example_qss_lotka_volterra<2>(
+          sim, [&ids](irt::model_id id) noexcept { ids.emplace_back(id); })));
+
+        // A hole in the models: the copies keep the identifiers.
+        auto& cnt = sim.alloc<irt::counter>();
+        auto& tmp = sim.alloc<irt::constant>();
+        expect(irt::is_success(sim.deallocate(sim.get_id(tmp))));
+        expect(irt::is_success(
+          sim.connect(sim.models.get(ids[0]), 0, get_model(cnt), 0)));
+
+        irt::simulation deep, shared, small;
+        expect(irt::is_success(deep.init(16lu, 256lu)));
+        expect(irt::is_success(shared.init(16lu, 256lu)));
+        expect(irt::is_success(small.init(4lu, 256lu)));
+
+        expect(!small.can_copy(sim));
+        expect(deep.can_copy(sim));
+        expect(irt::is_success(deep.copy(sim)));
+        expect(irt::is_success(shared.copy(sim, true)));
+        expect(!deep.node_alloc.is_shared());
+        expect(shared.node_alloc.is_shared());
+        expect(deep.models.size() == sim.models.size());
+
+        const auto run = [](irt::simulation& s) noexcept {
+            irt::time t      = 0;
+            irt::i64  events = std::numeric_limits<irt::i64>::max();
+            expect(irt::is_success(s.initialize(t)));
+            expect(irt::is_success(s.run_until(t, 30, events)));
+        };
+
+        run(sim);
+        run(deep);
+        run(shared);
+
+        // Running does not write the shared connections.
+        expect(shared.node_alloc.is_shared());
+
+        irt::model* mdl = nullptr;
+        while (sim.models.next(mdl)) {
+            const auto  id = sim.models.get_id(*mdl);
+            const auto* d  = deep.models.try_to_get(id);
+            const auto* s  = shared.models.try_to_get(id);
+            expect(d != nullptr && s != nullptr);
+            if (!d || !s)
+                continue;
+
+            expect(d->type == mdl->type && s->type == mdl->type);
+            expect(d->tl == mdl->tl && s->tl == mdl->tl);
+            expect(d->tn == mdl->tn && s->tn == mdl->tn);
+        }
+
+        expect(irt::get_dyn<irt::counter>(deep.models.get(sim.get_id(cnt)))
+                 .number == cnt.number);
+        expect(cnt.number > 0);
+
+        // The first connection change copies the connections.
+        auto& src_mdl  = shared.models.get(ids[3]);
+        auto& cnt_copy = shared.models.get(sim.get_id(cnt));
+        expect(irt::is_success(shared.connect(src_mdl, 0, cnt_copy, 0)));
+        expect(!shared.node_alloc.is_shared());
+
+        const auto connections = [](const irt::simulation& s,
+                                    irt::model_id          id) noexcept {
+            const auto& dyn =
+              irt::get_dyn<irt::qss2_integrator>(s.models.get(id));
+
+            int number = 0;
+            for ([[maybe_unused]] const auto& elem :
+                 irt::get_node(s, dyn.y[0]))
+                ++number;
+
+            return number;
+        };
+
+        expect(connections(shared, ids[3]) == connections(sim, ids[3]) + 1);
+    };
+
+    "coalescing"_test = [] {
+        irt::simulation sim;
+        expect(irt::is_success(sim.init(16lu, 256lu)));
+
+        auto& sum = sim.alloc<irt::adder_2>();
+        auto& acc = sim.alloc<irt::accumulator_2>();
+        auto& cnt = sim.alloc<irt::counter>();
+
+        // Only the last message of a port is kept by the adder, the first
+        // one by the accumulator, the counter keeps all of them.
+        for (const irt::real value : { 1.0, 2.0, 3.0 }) {
+            const irt::message msg{ value };
+            expect(irt::is_success(irt::push_message(sim, sum, 0, msg)));
+            expect(irt::is_success(irt::push_message(sim, acc, 2, msg)));
+            expect(irt::is_success(irt::push_message(sim, cnt, 0, msg)));
+        }
+
+        const auto size = [&sim](const irt::input_port port) noexcept {
+            int number = 0;
+            for ([[maybe_unused]] const auto& elem :
+                 irt::get_message(sim, port))
+                ++number;
+            return number;
+        };
+
+        expect(size(sum.x[0]) == 1);
+        expect(irt::get_message(sim, sum.x[0]).front()[0] == 3.0);
+        expect(size(acc.x[2]) == 1);
+        expect(irt::get_message(sim, acc.x[2]).front()[0] == 1.0);
+        expect(size(cnt.x[0]) == 3);
+        expect(sim.message_alloc.used() == 5);
+
+        irt::simulation run;
+        expect(irt::is_success(run.init(16lu, 256lu)));
+
+        auto& adder   = run.alloc<irt::adder_2>();
+        auto& counter = run.alloc<irt::counter>();
+        adder.default_input_coeffs[0] = 1.0;
+
+        for (const irt::real value : { 1.0, 2.0, 3.0, 4.0 }) {
+            auto& c         = run.alloc<irt::constant>();
+            c.default_value = value;
+            expect(irt::is_success(run.connect(c, 0, adder, 0)));
+            expect(irt::is_success(run.connect(c, 0, counter, 0)));
+        }
+
+        irt::time t = 0;
+        expect(irt::is_success(run.initialize(t)));
+        do {
+            expect(irt::is_success(run.run(t)));
+        } while (!irt::time_domain<irt::time>::is_infinity(t));
+
+        expect(counter.number == 4);
+        expect(adder.values[0] >= 1.0 && adder.values[0] <= 4.0);
+    };
+
+    "modeling_update_simulation"_test = [] {
+        irt::modeling mod;
+        expect(irt::is_success(
+          mod.init({ .model_capacity              = 64,
+                     .tree_capacity               = 16,
+                     .description_capacity        = 16,
+                     .component_capacity          = 16,
+                     .observer_capacity           = 16,
+                     .dir_path_capacity           = 16,
+                     .file_path_capacity          = 16,
+                     .children_capacity           = 64,
+                     .connection_capacity         = 64,
+                     .port_capacity               = 64,
+                     .constant_source_capacity    = 4,
+                     .binary_file_source_capacity = 4,
+                     .text_file_source_capacity   = 4,
+                     .random_source_capacity      = 4,
+                     .random_generator_seed       = 1 })));
+
+        // A constant of the top component sends to a counter of the inner
+        // component through the input port of the inner component.
+        auto& inner    = mod.components.alloc();
+        auto  inner_id = mod.components.get_id(inner);
+        auto& cnt      = mod.alloc(inner, irt::dynamics_type::counter);
+        inner.x.emplace_back(mod.children.get_id(cnt), static_cast<irt::i8>(0));
+
+        auto& top      = mod.components.alloc();
+        auto  top_id   = mod.components.get_id(top);
+        auto& cst      = mod.alloc(top, irt::dynamics_type::constant);
+        auto  cst_id   = mod.children.get_id(cst);
+        auto& instance = mod.children.alloc(inner_id);
+        auto  inst_id  = mod.children.get_id(instance);
+        top.children.emplace_back(inst_id);
+        expect(irt::is_success(mod.connect(top, cst_id, 0, inst_id, 0)));
+
+        irt::tree_node_id head;
+        expect(irt::is_success(mod.make_tree_from(top, &head)));
+        mod.head = head;
+
+        irt::simulation sim;
+        expect(irt::is_success(sim.init(64lu, 256lu)));
+        expect(irt::is_success(irt::build_simulation(mod, sim)));
+        expect(sim.models.size() == 2);
+
+        auto& head_node = mod.tree_nodes.get(head);
+        const auto* cst_sim =
+          head_node.sim.get(irt::enum_cast<irt::model_id>(cst.id));
+        expect(cst_sim != nullptr);
+        if (!cst_sim)
+            return;
+
+        const auto cst_sim_id = *cst_sim;
+        const auto run        = [&sim]() noexcept {
+            irt::time t = 0;
+            expect(irt::is_success(sim.initialize(t)));
+            do {
+                expect(irt::is_success(sim.run(t)));
+            } while (!irt::time_domain<irt::time>::is_infinity(t));
+        };
+
+        const auto destinations = [&sim, cst_sim_id]() noexcept {
+            auto& dyn =
+              irt::get_dyn<irt::constant>(sim.models.get(cst_sim_id));
+
+            irt::vector<irt::model_id> ret;
+            for (const auto& elem : irt::get_node(sim, dyn.y[0]))
+                ret.emplace_back(elem.model);
+            return ret;
+        };
+
+        run();
+        expect(destinations().ssize() == 1);
+
+        // Replace the counter of the inner component: the constant keeps
+        // its model and is connected to the new counter only.
+        mod.free(inner, cnt);
+        auto& cnt2 = mod.alloc(inner, irt::dynamics_type::counter);
+        inner.x[0] = irt::port(mod.children.get_id(cnt2), 0);
+
+        expect(irt::is_success(irt::update_simulation(mod, sim, inner_id, 1)));
+        expect(sim.models.size() == 2);
+        expect(sim.models.try_to_get(cst_sim_id) != nullptr);
+
+        const auto dst = destinations();
+        expect(dst.ssize() == 1);
+        if (dst.ssize() == 1) {
+            auto* mdl = sim.models.try_to_get(dst[0]);
+            expect(mdl != nullptr);
+            if (mdl) {
+                expect(mdl->type == irt::dynamics_type::counter);
+                expect(mdl->tl == 1);
+                expect(mdl->handle != nullptr);
+            }
+        }
+
+        run();
+        if (dst.ssize() == 1)
+            expect(irt::get_dyn<irt::counter>(sim.models.get(dst[0])).number ==
+                   1);
+
+        // Remove the instance: its models are finalized and removed with
+        // the connections to them.
+        int finalized = 0;
+        if (dst.ssize() == 1) {
+            auto& obs = sim.observers.alloc(
+              "cnt",
+              [](const irt::observer& obs,
+                 const irt::dynamics_type /*type*/,
+                 const irt::time /*tl*/,
+                 const irt::time /*t*/,
+                 const irt::observer::status s) noexcept {
+                  if (s == irt::observer::status::finalize)
+                      ++*reinterpret_cast<int*>(obs.user_data);
+              },
+              &finalized);
+            sim.observe(sim.models.get(dst[0]), obs);
+        }
+
+        mod.free(top, instance);
+        expect(irt::is_success(irt::update_simulation(mod, sim, top_id, 2)));
+        expect(finalized == 1);
+        expect(sim.observers.size() == 0u);
+        expect(sim.models.size() == 1);
+        expect(head_node.tree.get_child() == nullptr);
+        expect(destinations().empty());
+    };
+
+    "component_index"_test = [] {
+        namespace fs = std::filesystem;
+
+        std::error_code ec;
+        const auto dir = fs::temp_directory_path() / "irritator-index-test";
+        fs::remove_all(dir, ec);
+        fs::create_directories(dir, ec);
+
+        const irt::modeling_initializer mod_init{
+            .model_capacity              = 64,
+            .tree_capacity               = 16,
+            .description_capacity        = 16,
+            .component_capacity          = 16,
+            .observer_capacity           = 16,
+            .dir_path_capacity           = 16,
+            .file_path_capacity          = 16,
+            .children_capacity           = 64,
+            .connection_capacity         = 64,
+            .port_capacity               = 64,
+            .constant_source_capacity    = 4,
+            .binary_file_source_capacity = 4,
+            .text_file_source_capacity   = 4,
+            .random_source_capacity      = 4,
+            .random_generator_seed       = 1
+        };
+
+        // A constant connected to a counter.
+        const auto write_component = [&](const char* name) noexcept {
+            irt::modeling mod;
+            expect(irt::is_success(mod.init(mod_init)));
+
+            auto& compo = mod.components.alloc();
+            auto& cst   = mod.alloc(compo, irt::dynamics_type::constant);
+            auto& cnt   = mod.alloc(compo, irt::dynamics_type::counter);
+            expect(irt::is_success(mod.connect(compo,
+                                               mod.children.get_id(cst),
+                                               0,
+                                               mod.children.get_id(cnt),
+                                               0)));
+
+            std::ofstream ofs(dir / name);
+            irt::writer   w(ofs);
+            expect(irt::is_success(w(mod, compo, mod.srcs)));
+        };
+
+        const auto init_modeling = [&](irt::modeling& mod) noexcept {
+            expect(irt::is_success(mod.init(mod_init)));
+            auto& d = mod.dir_paths.alloc();
+            d.path  = dir.string().c_str();
+            mod.component_repertories.emplace_back(mod.dir_paths.get_id(d));
+        };
+
+        const auto find = [](irt::modeling& mod, const char* name) noexcept {
+            irt::component* compo = nullptr;
+            while (mod.components.next(compo))
+                if (compo->name == name)
+                    break;
+            return compo;
+        };
+
+        write_component("a.irt");
+        {
+            std::ofstream ofs(dir / "b.irt");
+            ofs << "0\n0\n0\n0\n1\n0 0 0 unknown\n";
+        }
+
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        expect(irt::is_success(tm.init(init)));
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        // The invalid b.irt is neither loaded nor indexed.
+        irt::modeling first;
+        init_modeling(first);
+        first.task_mgr = &tm;
+
+        irt::is_fatal_breakpoint = false;
+        expect(irt::is_success(first.fill_components()));
+        irt::is_fatal_breakpoint = true;
+
+        auto* a = find(first, "a.irt");
+        expect(a != nullptr);
+        expect(first.components.size() == 1);
+        expect(first.file_paths.size() == 1);
+        if (!a)
+            return;
+
+        expect(a->status == irt::component_status::unmodified);
+        expect(a->children.ssize() == 2);
+        expect(a->connections.ssize() == 1);
+        const auto hash = first.file_paths.get(a->file).hash;
+        expect(hash != 0u);
+
+        // The next run registers the unchanged a.irt from the index file and
+        // reads it on first use.
+        irt::modeling second;
+        init_modeling(second);
+
+        irt::is_fatal_breakpoint = false;
+        expect(irt::is_success(second.fill_components()));
+        irt::is_fatal_breakpoint = true;
+
+        auto* b = find(second, "a.irt");
+        expect(b != nullptr);
+        if (!b)
+            return;
+
+        expect(b->status == irt::component_status::unread);
+        expect(b->children.empty());
+        expect(second.file_paths.get(b->file).hash == hash);
+
+        irt::tree_node_id head;
+        expect(irt::is_success(second.make_tree_from(*b, &head)));
+        expect(b->status == irt::component_status::unmodified);
+        expect(b->children.ssize() == 2);
+        expect(b->connections.ssize() == 1);
+
+        // A deleted file leaves a memory component, a fixed file is read.
+        fs::remove(dir / "a.irt", ec);
+        write_component("b.irt");
+        expect(irt::is_success(second.fill_components()));
+
+        expect(b->type == irt::component_type::memory);
+        expect(irt::is_undefined(b->file));
+        expect(second.file_paths.size() == 1);
+
+        auto* fixed = find(second, "b.irt");
+        expect(fixed != nullptr);
+        if (fixed) {
+            expect(fixed->status == irt::component_status::unmodified);
+            expect(fixed->children.ssize() == 2);
+        }
+
+        int lines = 0;
+        {
+            std::ifstream ifs(dir / ".irritator-index");
+            for (std::string line; std::getline(ifs, line);)
+                ++lines;
+        }
+        expect(lines == 2);
+
+        tm.finalize();
+        fs::remove_all(dir, ec);
+    };
+
+    "structural_changes"_test = [] {
+        irt::simulation sim;
+        expect(irt::is_success(sim.init(16lu, 64lu)));
+
+        auto& c1          = sim.alloc<irt::constant>();
+        auto& c2          = sim.alloc<irt::constant>();
+        auto& cnt         = sim.alloc<irt::counter>();
+        c1.default_offset = 1;
+        c2.default_offset = 2;
+
+        expect(sim.connect(c1, 0, cnt, 0) == irt::status::success);
+        expect(sim.connect(c2, 0, cnt, 0) == irt::status::success);
+
+        const auto c2_id  = sim.get_id(c2);
+        const auto cnt_id = sim.get_id(cnt);
+
+        irt::time t = 0;
+        expect(irt::is_success(sim.initialize(t)));
+
+        // Applied at the end of the first bag: the clone misses the message
+        // of c1 but receives the message of c2.
+        expect(irt::is_success(sim.request_clone(cnt_id)));
+        expect(irt::is_success(
+          sim.request_connect(c2_id, 0, irt::simulation::cloned_model, 0)));
+        expect(sim.models.size() == 3u);
+
+        expect(irt::is_success(sim.run(t)));
+        expect(t == 1);
+        expect(sim.models.size() == 4u);
+        expect(sim.structural_changes.empty());
+
+        while (!irt::time_domain<irt::time>::is_infinity(t))
+            expect(irt::is_success(sim.run(t)));
+
+        irt::counter* clone = nullptr;
+        irt::model*   mdl   = nullptr;
+        while (sim.models.next(mdl))
+            if (mdl->type == irt::dynamics_type::counter &&
+                sim.models.get_id(*mdl) != cnt_id)
+                clone = &irt::get_dyn<irt::counter>(*mdl);
+
+        expect(clone != nullptr);
+        expect(cnt.number == 2);
+        expect(clone->number == 1);
+
+        // Requests on a deleted model are ignored.
+        const auto clone_id = sim.get_id(*clone);
+        expect(irt::is_success(sim.request_deallocate(clone_id)));
+        expect(
+          irt::is_success(sim.request_connect(c2_id, 0, clone_id, 0)));
+        expect(irt::is_success(sim.run_bag(t)));
+        expect(sim.models.size() == 3u);
+        expect(sim.models.try_to_get(clone_id) == nullptr);
+    };
+
+    "checkpoint_clone_memory"_test = [] {
+        fmt::print("checkpoint_clone_memory\n");
+
+        irt::simulation sim, clone;
+        for (auto* s : { &sim, &clone }) {
+            expect(irt::is_success(s->init(32lu, 256lu)));
+            expect(irt::is_success(irt::example_qss_lotka_volterra<3>(
+              *s, [](irt::model_id) noexcept {})));
+        }
+
+        irt::time t = 0;
+        expect(irt::is_success(sim.initialize(t)));
+        do {
+            expect(irt::is_success(sim.run(t)));
+        } while (t < 5);
+
+        // Clone the state through a growable memory buffer.
+        irt::memory mem(0, irt::open_mode::write);
+        expect(irt::is_success(sim.checkpoint(mem, t)));
+        expect(mem.length() > 0);
+
+        irt::time t_clone = 0;
+        mem.rewind();
+        expect(irt::is_success(clone.restore(mem, t_clone)));
+        expect(t_clone == t);
+        expect(mem.tell() == mem.length());
+
+        bool same = true;
+        do {
+            expect(irt::is_success(sim.run(t)));
+            expect(irt::is_success(clone.run(t_clone)));
+            same = same && t == t_clone;
+        } while (t < 20);
+
+        irt::model* a = nullptr;
+        irt::model* b = nullptr;
+        while (sim.models.next(a) && clone.models.next(b))
+            same = same && a->tl == b->tl && a->tn == b->tn;
+
+        expect(same);
+    };
+
     "time_func"_test = [] {
         fmt::print("time_func\n");
         irt::simulation sim;
@@ -2877,6 +4152,91 @@ int main()
         } while (t < irt::time(100.0));
     };
 
+#ifdef IRRITATOR_ENABLE_STATS
+    "simulation_stats"_test = [] {
+        irt::simulation sim;
+        expect(sim.init(30u, 30u) == irt::status::success);
+        expect(irt::example_qss_lotka_volterra<1>(sim, empty_fun) ==
+               irt::status::success);
+
+        irt::time t = 0;
+        expect(sim.initialize(t) == irt::status::success);
+
+        irt::i64 bags = 0, transitions = 0;
+        do {
+            expect(sim.run(t) == irt::status::success);
+            ++bags;
+            transitions += sim.immediate_models.ssize();
+        } while (t < 30.0);
+
+        const auto& integrator =
+          sim.stats[irt::dynamics_type::qss1_integrator];
+        expect(integrator.inserts == 2);
+        expect(integrator.transitions > 0);
+        expect(integrator.lambdas > 0);
+        expect(integrator.messages_sent >= integrator.lambdas);
+
+        irt::i64 pops = 0, sent = 0, received = 0, histogram = 0;
+        for (const auto& c : sim.stats.types) {
+            pops += c.pops;
+            sent += c.messages_sent;
+            received += c.messages_received;
+        }
+
+        for (const auto bag : sim.stats.bags)
+            histogram += bag;
+
+        expect(pops == transitions);
+        expect(sent == received);
+        expect(histogram == bags);
+        expect(sim.stats.node_peak == 8u);
+    };
+#endif
+
+    "tracer_simulation"_test = [] {
+        irt::simulation sim;
+        expect(sim.init(30u, 30u) == irt::status::success);
+        expect(irt::example_qss_lotka_volterra<1>(sim, empty_fun) ==
+               irt::status::success);
+
+        irt::tracer tr;
+        expect(irt::is_success(tr.init(1, 64)));
+        tr.attach(sim);
+
+        irt::time t = 0;
+        expect(sim.initialize(t) == irt::status::success);
+
+        int bags = 0;
+        for (; bags < 10; ++bags)
+            expect(sim.run(t) == irt::status::success);
+
+        tr.detach(sim);
+        expect(sim.run(t) == irt::status::success);
+
+        const auto& buffer = tr.buffers()[0];
+        expect((buffer.events.ssize() == 4 * bags) >> fatal);
+
+        for (int i = 0; i < bags; ++i) {
+            const auto& run        = buffer.events[4 * i];
+            const auto& pop        = buffer.events[4 * i + 1];
+            const auto& transition = buffer.events[4 * i + 2];
+            const auto& delivery   = buffer.events[4 * i + 3];
+
+            expect(run.name == std::string_view("run"));
+            expect(run.bag > 0);
+            expect(pop.begin == run.begin);
+            expect(transition.begin == pop.begin + pop.duration);
+            expect(delivery.begin == transition.begin + transition.duration);
+            expect(delivery.begin + delivery.duration ==
+                   run.begin + run.duration);
+        }
+
+        std::ostringstream os;
+        expect(irt::is_success(tr.write(os)));
+        expect(os.str().starts_with("{\"displayTimeUnit\""));
+        expect(os.str().find("\"name\":\"delivery\"") != std::string::npos);
+    };
+
     "all"_test = [] {
         {
             irt::simulation sim;
@@ -2988,6 +4348,82 @@ int main()
         }
     };
 
+    "block_vector"_test = [] {
+        irt::block_vector vec;
+        expect(irt::is_success(vec.init(4, 8)));
+
+        double* blocks[8];
+        for (int i = 0; i != 8; ++i) {
+            expect(vec.can_alloc());
+            blocks[i] = vec.alloc();
+            std::fill_n(blocks[i], 4, static_cast<double>(i));
+        }
+
+        expect(!vec.can_alloc());
+        expect(blocks[7] == vec.buffer + 7 * 4);
+
+        vec.free(blocks[5]);
+        vec.free(blocks[2]);
+        expect(vec.can_alloc());
+        expect(vec.alloc() == blocks[2]);
+        expect(vec.alloc() == blocks[5]);
+        expect(!vec.can_alloc());
+
+        for (int i = 0; i != 8; ++i)
+            if (i != 2 && i != 5)
+                expect(blocks[i][3] == static_cast<double>(i));
+    };
+
+    "binary_file_source"_test = [] {
+        std::error_code ec;
+        auto path = std::filesystem::temp_directory_path(ec);
+        path /= "irritator-binary-file-source.data";
+
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            for (int i = 0; i != 16; ++i) {
+                const double value = static_cast<double>(i);
+                ofs.write(reinterpret_cast<const char*>(&value),
+                          sizeof(value));
+            }
+        }
+
+        irt::binary_file_source src;
+        expect(irt::is_success(src.init(4, 2)));
+        src.file_path = path;
+        src.ifs.open(path, std::ios::binary);
+        expect(irt::is_success(src.start_or_restart()));
+        expect(src.buffer.capacity == 2);
+
+        irt::source s;
+        expect(irt::is_success(src(s, irt::source::operation_type::update)));
+        expect(s.size == 4);
+        expect(s.buffer[0] == 0.0 && s.buffer[3] == 3.0);
+
+        expect(irt::is_success(src(s, irt::source::operation_type::update)));
+        expect(s.buffer[0] == 4.0 && s.buffer[3] == 7.0);
+
+        expect(irt::is_success(src(s, irt::source::operation_type::finalize)));
+        src.ifs.close();
+        std::filesystem::remove(path, ec);
+    };
+
+    "random_source"_test = [] {
+        irt::random_source src;
+        expect(irt::is_success(src.init(4, 2)));
+
+        irt::source s;
+        expect(
+          irt::is_success(src(s, irt::source::operation_type::initialize)));
+        expect(s.buffer != nullptr && s.size == 4 && s.index == 0);
+
+        s.index = s.size;
+        expect(irt::is_success(src(s, irt::source::operation_type::update)));
+        expect(s.index == 0);
+
+        expect(irt::is_success(src(s, irt::source::operation_type::finalize)));
+    };
+
     "memory"_test = [] {
         global_alloc g_a;
         global_free  g_b;
@@ -3017,6 +4453,8 @@ int main()
         expect(sim.init(30u, 30u) != irt::status::success);
 
         irt::is_fatal_breakpoint = true;
+        irt::g_alloc_fn          = irt::malloc_wrapper;
+        irt::g_free_fn           = irt::free_wrapper;
     };
 
     "external_source"_test = [] {
@@ -3078,6 +4516,106 @@ int main()
         assert(f.tell() == 0);
     };
 
+    "binary-memory-growth"_test = [] {
+        irt::memory f(0, irt::open_mode::write);
+        expect(f.is_open());
+        expect(f.length() == 0);
+
+        irt::u64 v = 0;
+        expect(!f.read(v));
+
+        std::vector<irt::u64> values(10000);
+        std::iota(values.begin(), values.end(), irt::u64{ 1 });
+
+        expect(f.write(irt::u32{ 7 }));
+        expect(f.write(std::span(values)));
+        expect(f.length() == 4 + 8 * 10000);
+        expect(f.data.ssize() >= f.length());
+
+        f.shrink_to_fit();
+        expect(f.data.ssize() == f.length());
+        expect(f.bytes().size() == static_cast<size_t>(f.length()));
+
+        f.rewind();
+        irt::u32 first = 0;
+        expect(f.read(first) && first == 7u);
+
+        // Zero-copy access of the first value.
+        const auto view = f.view(8);
+        expect(view.size() == 8u);
+        expect(view.data() == f.data.data() + 4);
+
+        std::vector<irt::u64> values_r(values.size() - 1);
+        expect(f.read(std::span(values_r)));
+        expect(
+          std::equal(values_r.begin(), values_r.end(), values.begin() + 1));
+        expect(!f.read(v));
+
+        expect(f.seek(-8, irt::seek_origin::end) == 0);
+        expect(f.read(v) && v == 10000u);
+        expect(f.seek(1, irt::seek_origin::end) == -1);
+    };
+
+    "serializer"_test = [] {
+        irt::memory mem(0, irt::open_mode::write);
+
+        irt::vector<irt::real> reals(8, 3);
+        reals[0] = 1.5;
+        reals[1] = -2.;
+        reals[2] = 4.25;
+
+        const irt::u64                id     = 0x0123456789abcdef;
+        const irt::status             st     = irt::status::io_file_source_full;
+        const irt::message            msg    = { 1., 2., 3. };
+        const irt::i32                arr[3] = { -1, 2, -3 };
+        const irt::vector<irt::real>& cref   = reals;
+
+        {
+            irt::serializer<irt::memory, irt::serialize_mode::write> out(mem);
+            expect(out(id, st, msg, arr, cref));
+        }
+
+        irt::u64               id_r = 0;
+        irt::status            st_r = irt::status::success;
+        irt::message           msg_r;
+        irt::i32               arr_r[3] = {};
+        irt::vector<irt::real> reals_r;
+
+        mem.rewind();
+        {
+            irt::serializer<irt::memory, irt::serialize_mode::read> in(mem);
+            expect(in(id_r, st_r, msg_r, arr_r, reals_r));
+            expect(!in(id_r));
+        }
+
+        expect(id_r == id);
+        expect(st_r == st);
+        expect(msg_r[0] == 1. && msg_r[1] == 2. && msg_r[2] == 3.);
+        expect(arr_r[0] == -1 && arr_r[1] == 2 && arr_r[2] == -3);
+        expect(reals_r.ssize() == 3);
+        expect(reals_r[0] == 1.5 && reals_r[1] == -2. && reals_r[2] == 4.25);
+
+        // The same bytes through a file.
+        std::error_code ec;
+        auto            file_path = std::filesystem::temp_directory_path(ec);
+        file_path /= "irritator-serializer.bin";
+
+        {
+            irt::file f(file_path.string().c_str(), irt::open_mode::write);
+            irt::serializer<irt::file, irt::serialize_mode::write> out(f);
+            expect(out(id, st, msg, arr, cref));
+        }
+
+        {
+            irt::file f(file_path.string().c_str(), irt::open_mode::map);
+            expect(f.mapped().size() == mem.bytes().size());
+            expect(std::equal(
+              f.mapped().begin(), f.mapped().end(), mem.bytes().begin()));
+        }
+
+        std::filesystem::remove(file_path, ec);
+    };
+
     "binary-file-io"_test = [] {
         std::error_code ec;
         auto            file_path = std::filesystem::temp_directory_path(ec);
@@ -3133,4 +4671,84 @@ int main()
 
         std::filesystem::remove(file_path, ec);
     };
+
+    "binary-file-buffered-io"_test = [] {
+        std::error_code ec;
+        auto            file_path = std::filesystem::temp_directory_path(ec);
+
+        file_path /= "irritator-buffered.bin";
+
+        // More values than the internal buffer to check the flushes and the
+        // large writes which bypass the buffer.
+        std::vector<double>   values(3 * irt::file::buffer_size / 8 + 17);
+        std::vector<irt::u32> ids(irt::file::buffer_size + 3);
+        std::iota(values.begin(), values.end(), 0.5);
+        std::iota(ids.begin(), ids.end(), 0u);
+
+        {
+            irt::file f(file_path.string().c_str(), irt::open_mode::write);
+            expect(f.is_open());
+
+            for (irt::u32 i = 0; i != 1000; ++i)
+                expect(f.write(i));
+
+            expect(f.write(std::span(values)));
+            expect(f.write(std::span<const irt::u32>(ids)));
+            expect(f.tell() == 4000 + static_cast<irt::i64>(values.size() * 8 +
+                                                            ids.size() * 4));
+            expect(f.length() == f.tell());
+            expect(f.flush());
+        }
+
+        {
+            irt::file f(file_path.string().c_str(), irt::open_mode::read);
+            expect(f.is_open());
+
+            bool     same = true;
+            irt::u32 v    = 0;
+            for (irt::u32 i = 0; i != 1000; ++i)
+                same = same && f.read(v) && v == i;
+            expect(same);
+
+            std::vector<double>   values_r(values.size());
+            std::vector<irt::u32> ids_r(ids.size());
+            expect(f.read(std::span(values_r)));
+            expect(f.read(std::span(ids_r)));
+            expect(values == values_r);
+            expect(ids == ids_r);
+            expect(!f.read(v));
+
+            expect(f.seek(4, irt::seek_origin::set) == 0);
+            expect(f.tell() == 4);
+            expect(f.read(v) && v == 1u);
+            expect(f.seek(8, irt::seek_origin::current) == 0);
+            expect(f.read(v) && v == 4u);
+        }
+
+        {
+            irt::file f(file_path.string().c_str(), irt::open_mode::map);
+            expect(f.is_open());
+            expect(f.mapped().size() ==
+                   static_cast<size_t>(f.length()));
+
+            irt::u32 v = 0;
+            expect(f.read(v) && v == 0u);
+
+            const auto view = f.view(999 * 4);
+            expect(view.size() == 999u * 4u);
+            expect(view.data() == f.mapped().data() + 4);
+            expect(f.tell() == 4000);
+
+            std::vector<double> values_r(values.size());
+            expect(f.read(std::span(values_r)));
+            expect(values == values_r);
+
+            expect(f.view(f.length()).empty());
+            expect(f.seek(0, irt::seek_origin::end) == 0);
+            expect(f.tell() == f.length());
+            expect(!f.read(v));
+        }
+
+        std::filesystem::remove(file_path, ec);
+    };
 }
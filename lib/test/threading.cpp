@@ -4,11 +4,15 @@
 
 #include <irritator/core.hpp>
 #include <irritator/thread.hpp>
+#include <irritator/trace.hpp>
 
 #include <fmt/format.h>
 
 #include <boost/ut.hpp>
 
+#include <sstream>
+#include <vector>
+
 void function_1(void* param) noexcept
 {
     auto* counter = reinterpret_cast<int*>(param);
@@ -194,4 +198,280 @@ int main()
         assert(counter_1 == 4);
         assert(counter_2 == 400);
     };
+
+    "parallel-for"_test = [] {
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        irt::status       ret = tm.init(init);
+        assert(irt::is_success(ret));
+
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        std::vector<int> values(1000, 0);
+        irt::parallel_for(
+          tm.task_lists[0], 0, 1000, 64, [&](int first, int last) {
+              for (int i = first; i < last; ++i)
+                  values[i] = i;
+          });
+
+        tm.finalize();
+
+        for (int i = 0; i < 1000; ++i)
+            expect(values[i] == i);
+    };
+
+    "tracer-per-thread-buffers"_test = [] {
+        irt::tracer tr;
+        expect(irt::is_success(tr.init(4, 1024)));
+
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        irt::status       ret = tm.init(init);
+        assert(irt::is_success(ret));
+
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        irt::parallel_for(
+          tm.task_lists[0], 0, 1024, 16, [&tr](int first, int last) {
+              irt::trace_scope scope(tr, "range");
+              volatile int sum = 0;
+              for (int i = first; i < last; ++i)
+                  sum = sum + i;
+          });
+
+        tm.finalize();
+
+        irt::i64 events = 0;
+        for (const auto& buffer : tr.buffers()) {
+            events += buffer.events.ssize();
+            for (const auto& ev : buffer.events)
+                expect(ev.name == std::string_view("range"));
+        }
+
+        expect(events == 1024 / 16);
+        expect(tr.dropped() == 0);
+
+        std::ostringstream os;
+        expect(irt::is_success(tr.write(os)));
+        expect(os.str().find("\"ph\":\"X\"") != std::string::npos);
+    };
+
+    "fork-join-continuation"_test = [] {
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        irt::status       ret = tm.init(init);
+        assert(irt::is_success(ret));
+
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        std::atomic_int counter      = 0;
+        std::atomic_int continuation = 0;
+
+        irt::task_counter join;
+        join.then(
+          tm.task_lists[0],
+          [](void* param) noexcept {
+              reinterpret_cast<std::atomic_int*>(param)->fetch_add(1);
+          },
+          &continuation);
+
+        for (int i = 0; i < 100; ++i)
+            tm.task_lists[0].add(
+              [](void* param) noexcept {
+                  reinterpret_cast<std::atomic_int*>(param)->fetch_add(1);
+              },
+              &counter,
+              join);
+
+        join.wait();
+        tm.task_lists[0].wait();
+        tm.finalize();
+
+        expect(counter == 100);
+        expect(continuation == 1);
+    };
+
+    "task-counter-lifetime"_test = [] {
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        irt::status       ret = tm.init(init);
+        assert(irt::is_success(ret));
+
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        // Each counter is destroyed as soon as its wait returns, the next
+        // one reuses its stack storage. The outer ranges run nested
+        // parallel_for waiting in the workers.
+        std::atomic_int sum = 0;
+        for (int i = 0; i < 200; ++i) {
+            irt::parallel_for(
+              tm.task_lists[0], 0, 4, 1, [&](int /*first*/, int /*last*/) {
+                  irt::parallel_for(
+                    tm.task_lists[0], 0, 4, 1, [&](int first, int last) {
+                        sum.fetch_add(last - first);
+                    });
+              });
+        }
+
+        tm.finalize();
+
+        expect(sum == 200 * 4 * 4);
+    };
+
+    "task-graph"_test = [] {
+        irt::task_manager_parameters init{ .thread_number           = 2,
+                                           .simple_task_list_number = 1,
+                                           .multi_task_list_number  = 0 };
+
+        irt::task_manager tm;
+        irt::status       ret = tm.init(init);
+        assert(irt::is_success(ret));
+
+        tm.workers[0].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.workers[1].task_lists.emplace_back(&tm.task_lists[0]);
+        tm.start();
+
+        struct reduction
+        {
+            int             values[64];
+            std::atomic_int done    = 0;
+            int             sum     = -1;
+            bool            ordered = true;
+        } data;
+
+        irt::task_graph graph;
+        expect(irt::is_success(graph.init(65)));
+
+        auto reduce = graph.add(
+          [](void* param) noexcept {
+              auto* d    = reinterpret_cast<reduction*>(param);
+              d->ordered = d->done == 64;
+              d->sum     = 0;
+              for (auto v : d->values)
+                  d->sum += v;
+          },
+          &data);
+
+        for (int i = 0; i < 64; ++i) {
+            data.values[i] = 0;
+            auto map       = graph.add(
+              [](void* param) noexcept {
+                  auto* d      = reinterpret_cast<reduction*>(param);
+                  auto  i      = d->done.fetch_add(1);
+                  d->values[i] = 1;
+              },
+              &data);
+            graph.precede(map, reduce);
+        }
+
+        for (int round = 0; round < 2; ++round) {
+            data.done = 0;
+            data.sum  = -1;
+            for (auto& v : data.values)
+                v = 0;
+
+            graph.submit(tm.task_lists[0]);
+            graph.wait();
+
+            expect(data.ordered);
+            expect(data.sum == 64);
+        }
+
+        tm.task_lists[0].wait();
+        tm.finalize();
+    };
+
+    "spsc-queue"_test = [] {
+        irt::spsc_queue<int> queue;
+        expect(irt::is_success(queue.init(1000)));
+        expect(queue.capacity() == 1024);
+        expect(queue.empty());
+
+        constexpr int number = 1000000;
+        std::jthread  producer([&queue]() {
+            for (int i = 0; i < number; ++i)
+                while (!queue.push(i))
+                    std::this_thread::yield();
+        });
+
+        // The values arrive in order and none is lost.
+        int  expected = 0;
+        bool ordered  = true;
+        while (expected != number) {
+            int value;
+            if (queue.pop(value)) {
+                ordered = ordered && value == expected;
+                ++expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        producer.join();
+        expect(ordered);
+        expect(queue.empty());
+    };
+
+    "triple-buffer"_test = [] {
+        struct state
+        {
+            int a = 0;
+            int b = 0;
+        };
+
+        irt::triple_buffer<state> buffer;
+        expect(!buffer.update());
+
+        constexpr int     number = 100000;
+        std::atomic<bool> done   = false;
+
+        std::jthread writer([&]() {
+            for (int i = 1; i <= number; ++i) {
+                auto& s = buffer.write_buffer();
+                s.a     = i;
+                s.b     = -i;
+                buffer.publish();
+            }
+            done = true;
+        });
+
+        // The reader sees complete and increasing states and the last one.
+        int  last       = 0;
+        bool consistent = true;
+        for (;;) {
+            const bool finished = done.load();
+            if (buffer.update()) {
+                const auto& s = buffer.read_buffer();
+                consistent    = consistent && s.a == -s.b && s.a > last;
+                last          = s.a;
+            }
+
+            if (finished && !buffer.update())
+                break;
+        }
+
+        writer.join();
+        expect(consistent);
+        expect(last == number);
+    };
 }